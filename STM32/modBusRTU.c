@@ -14,9 +14,14 @@
 /* Includes ------------------------------------------------------------------*/
 
 /* 1. System Header Files */
-#include "stm32f1xx_hal.h"
 /* 2. Project Header Files */
-
+#include "modBusRTUCrc.h"
+#ifdef MODBUS_RTU_USE_RTOS
+#include "modBusRTUOs.h"
+#endif
+#ifdef MODBUS_RTU_USE_POOL
+#include "modBusRTUPool.h"
+#endif
 /* 3. Module Header File */
 #include <modBusRTU.h>
 
@@ -26,6 +31,18 @@
  * @defgroup
  * @brief Constants and macros available globally.
  */
+/*! @def Frame of a ring slot, a pool block or stored in place */
+#ifdef MODBUS_RTU_USE_POOL
+#define MODBUS_RTU_SLOT_PACKET(slot) ((slot)->packet)
+#else
+#define MODBUS_RTU_SLOT_PACKET(slot) (&(slot)->packet)
+#endif
+/*! @def Bytes of the circular DMA buffer, given by the caller or in the handle */
+#ifdef MODBUS_RTU_USE_POOL
+#define MODBUS_RTU_RX_DMA_SIZE(modbus) ((modbus)->rxDmaSize)
+#else
+#define MODBUS_RTU_RX_DMA_SIZE(modbus) MODBUS_RTU_RX_DMA_BUFFER_SIZE
+#endif
 
 /* Typedefs ------------------------------------------------------------------*/
 
@@ -34,52 +51,297 @@
  * @brief Typedefs for global use.
  */
 
-/*!
- * @typedef @struct _modeBusPacket
- * @brief modBus packet structure
- */
-typedef struct _modeBusPacket{
-	uint8_t slaveId;
-	uint8_t functionCode;
-	uint8_t data[MODBUS_RTU_MAX_DATA_SIZE + 2]; // + 2 =  for CRC
-} modBusPacket_t;
-
 /* Variables -----------------------------------------------------------------*/
 
 /* 1. Global Variables */
 
 /* 2. Static Variables */
 
-/*! @var @brief Global TX/RX variables for modBus RTU communication */
-static modBusPacket_t txPacket = { 0 };
-static modBusPacket_t rxPacket = { 0 };
 
 /* Function Declarations -----------------------------------------------------*/
 
 /* 1. Local Prototype Functions */
 
 /*! @fn @private */
-static uint16_t ModbusRTU_CalculateCRC(uint8_t *data, size_t length);
+static void ModbusRTU_CopyFromDmaBuffer(ModbusRTU_HandleT *modbus,
+		uint16_t head);
+static size_t ModbusRTU_BuildFrame(ModbusRTU_HandleT *modbus,
+		uint8_t functionCode, size_t dataSize);
+static void ModbusRTU_TxRelease(ModbusRTU_HandleT *modbus);
+static void ModbusRTU_SetDe(ModbusRTU_HandleT *modbus, bool isTransmit);
+static void ModbusRTU_TimerArm(ModbusRTU_HandleT *modbus,
+		ModbusRTU_TimerPhaseT phase, uint32_t ticks);
+static void ModbusRTU_TimerArmGuard(ModbusRTU_HandleT *modbus);
+static void ModbusRTU_TimerStart(ModbusRTU_HandleT *modbus, uint32_t ticks);
+static void ModbusRTU_TimerStop(ModbusRTU_HandleT *modbus);
+static void ModbusRTU_NotifyEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event);
+static void ModbusRTU_RxReset(ModbusRTU_HandleT *modbus);
+static void ModbusRTU_RxFlush(ModbusRTU_HandleT *modbus);
+static bool ModbusRTU_RxRestart(ModbusRTU_HandleT *modbus);
+static void ModbusRTU_RxComplete(ModbusRTU_HandleT *modbus);
+static ModbusRTU_ErrorT ModbusRTU_CheckFrame(ModbusRTU_HandleT *modbus,
+		const modBusPacket_t *packet, uint16_t length, uint16_t crc,
+		bool isFrameError, ModbusRTU_FrameViewT *frame);
+static void ModbusRTU_StatsTxStart(ModbusRTU_HandleT *modbus, size_t length);
+static void ModbusRTU_StatsTxEnd(ModbusRTU_HandleT *modbus);
+static void ModbusRTU_StatsRxEnd(ModbusRTU_HandleT *modbus);
+static void ModbusRTU_StatsTimeout(ModbusRTU_HandleT *modbus);
+#ifdef MODBUS_RTU_ENABLE_STATS
+static uint32_t ModbusRTU_StatsMicros(uint32_t cycles);
+static ModbusRTU_RttHistogramT* ModbusRTU_StatsSlave(
+		ModbusRTU_HandleT *modbus);
+#endif
 
 /* 2. Global Function Declarations */
 
 /*!
- * @fn    void modbusRTUInit(ModbusRTU_HandleT *modbus, UART_HandleTypeDef *huart, TIM_HandleTypeDef *htim, uint8_t slaveId)
+ * @fn    void modbusRTUInit(ModbusRTU_HandleT *modbus, ModbusRTU_PortUartT *huart, ModbusRTU_PortTimerT *htim, uint8_t slaveId)
  * @brief Initialize the modBus RTU instance.
  *
  * @param modBus Pointer to the ModbusRTU instance.
- * @param huart Pointer to the UART handle.
- * @param htim Pointer to the timer handle.
+ * @param huart UART of the port (UART_HandleTypeDef on STM32).
+ * @param htim One shot timer of the port (TIM_HandleTypeDef on STM32).
  * @param slaveId The modBus slave ID.
  * @param baudRate The UART baud rate.
  */
-void modbusRTUInit(ModbusRTU_HandleT *modbus, UART_HandleTypeDef *huart,
-		TIM_HandleTypeDef *htim, uint8_t slaveId) {
+void modbusRTUInit(ModbusRTU_HandleT *modbus, ModbusRTU_PortUartT *huart,
+		ModbusRTU_PortTimerT *htim, uint8_t slaveId) {
 	modbus->huart = huart;
 	modbus->htim = htim;
 	modbus->slaveId = slaveId;
-	/* Start the timer in interrupt mode */
-	HAL_TIM_Base_Start_IT(modbus->htim);
+	modbus->isRxDataReceived = false;
+	modbus->rxCrc = modbusRTUCrcInit();
+	modbus->rxLength = 0;
+	modbus->rxFrame = &modbus->rxPacket;
+	modbus->rxQueue = NULL;
+	modbus->rxMode = MODBUS_RTU_RX_MODE_IT;
+	modbus->txState = MODBUS_RTU_TX_IDLE;
+#ifdef MODBUS_RTU_USE_POOL
+	modbus->txFrame = NULL; /* taken from the pool per frame */
+	modbus->txCapacity = 0;
+	modbus->rxDmaBuffer = NULL; /* modbusRTUSetRxDmaBuffer, DMA engine only */
+	modbus->rxDmaSize = 0;
+#else
+	modbus->txFrame = &modbus->txPacket;
+	modbus->txCapacity = MODBUS_RTU_MAX_FRAME_SIZE;
+#endif
+	modbus->txCpltCallback = NULL;
+	modbus->dePort = NULL;
+	modbus->eventCallback = NULL;
+	modbus->userContext = NULL;
+#ifdef MODBUS_RTU_USE_RTOS
+	modbus->os = NULL;
+#endif
+	modbus->responseTimeoutMs = MODBUS_RTU_RECEIVED_TIMEOUT;
+	modbus->turnaroundMs = MODBUS_RTU_TURNAROUND_DELAY;
+	modbus->isResponseExpected = false;
+	modbus->isRxTimeout = false;
+	modbus->rxFrameError = false;
+	modbus->rxDiscarding = false;
+	modbus->isAddressFilter = false;
+	modbus->isPromiscuous = false;
+	modbus->isLowPower = false;
+#ifdef MODBUS_RTU_ENABLE_STATS
+	modbus->statsIsRttPending = false;
+	modbus->statsIsTurnaround = false;
+	modbusRTUResetStats(modbus);
+	/* enable the cycle counter for the timing */
+	modbusRTUPortCyclesInit();
+#endif
+	modbusRTUUpdateTimings(modbus);
+
+	/* htim runs as one shot, every expiry is one end of frame / timeout event */
+	modbus->timerRemaining = 0;
+	modbusRTUPortTimerInit(modbus->htim);
+	modbus->timerPhase = MODBUS_RTU_TIMER_IDLE;
+}
+
+/*!
+ * @fn    void modbusRTUUpdateTimings(ModbusRTU_HandleT *modbus)
+ * @brief Recompute t1.5 and t3.5 from the current UART baud rate.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call again after changing the baud rate of huart.
+ */
+void modbusRTUUpdateTimings(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	uint32_t baudRate = modbusRTUPortGetBaudRate(modbus->huart);
+
+	if ((0 == baudRate) || (baudRate > MODBUS_RTU_FIXED_TIMING_BAUD)) {
+		modbus->t15Ticks = (uint32_t) (((uint64_t) MODBUS_RTU_FIXED_T15_US
+				* MODBUS_RTU_TIMER_TICK_HZ) / 1000000u);
+		modbus->t35Ticks = (uint32_t) (((uint64_t) MODBUS_RTU_FIXED_T35_US
+				* MODBUS_RTU_TIMER_TICK_HZ) / 1000000u);
+	} else {
+		/* 1.5 and 3.5 character times, rounded up */
+		modbus->t15Ticks = (uint32_t) (((uint64_t) 3 * MODBUS_RTU_CHAR_BITS
+				* MODBUS_RTU_TIMER_TICK_HZ + 2 * baudRate - 1) / (2 * baudRate));
+		modbus->t35Ticks = (uint32_t) (((uint64_t) 7 * MODBUS_RTU_CHAR_BITS
+				* MODBUS_RTU_TIMER_TICK_HZ + 2 * baudRate - 1) / (2 * baudRate));
+	}
+
+	/* the IDLE line is raised one character after the last stop bit */
+	modbus->charTicks = 0;
+	if (0 != baudRate) {
+		modbus->charTicks = (uint32_t) (((uint64_t) MODBUS_RTU_CHAR_BITS
+				* MODBUS_RTU_TIMER_TICK_HZ + baudRate - 1) / baudRate);
+	}
+	if (modbus->charTicks >= modbus->t35Ticks) {
+		modbus->charTicks = 0;
+	}
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSetLine(ModbusRTU_HandleT *modbus, uint32_t baudRate, uint8_t parity)
+ * @brief Switch the UART to another baud rate and parity between two frames.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param baudRate The new baud rate.
+ * @param parity MODBUS_RTU_PARITY_NONE (2 stop bits), _EVEN or _ODD.
+ * @return MODBUS_RTU_RX_BUSY while a frame is sent or received or a response
+ *         is awaited, MODBUS_RTU_ERROR_RX_FAILED when the port refused the
+ *         setting or the reception did not restart.
+ *
+ * @note : t1.5 and t3.5 follow the new baud rate. A frame that waits for
+ *         modbusRTUGetRxFrame stays. The DMA engine goes on receiving, the
+ *         interrupt engine listens again with modbusRTUListen or the next
+ *         request.
+ */
+ModbusRTU_ErrorT modbusRTUSetLine(ModbusRTU_HandleT *modbus, uint32_t baudRate,
+		uint8_t parity) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	ModbusRTU_TimerPhaseT phase = modbus->timerPhase;
+
+	if ((MODBUS_RTU_TX_ACTIVE == modbus->txState)
+			|| (MODBUS_RTU_TIMER_CHAR == phase)
+			|| (MODBUS_RTU_TIMER_FRAME == phase)
+			|| (MODBUS_RTU_TIMER_RESPONSE == phase)) {
+		result = MODBUS_RTU_RX_BUSY; /* never cut a frame or a transaction */
+	} else {
+		if (false == modbusRTUPortSetLine(modbus->huart, baudRate, parity)) {
+			result = MODBUS_RTU_ERROR_RX_FAILED;
+		}
+		modbusRTUUpdateTimings(modbus);
+
+		/* the port stopped the reception */
+		if ((false == ModbusRTU_RxRestart(modbus))
+				&& (MODBUS_RTU_SUCCESS == result)) {
+			result = MODBUS_RTU_ERROR_RX_FAILED;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    bool modbusRTUIsBusIdle(ModbusRTU_HandleT *modbus)
+ * @brief Check that the bus was silent for t3.5 and no response is pending.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return true when the next frame may be sent.
+ */
+bool modbusRTUIsBusIdle(ModbusRTU_HandleT *modbus) {
+	return (MODBUS_RTU_TIMER_IDLE == modbus->timerPhase)
+			&& (MODBUS_RTU_TX_ACTIVE != modbus->txState);
+}
+
+/*!
+ * @fn    void modbusRTUSetLowPower(ModbusRTU_HandleT *modbus, bool isEnabled)
+ * @brief Sleep through the frames of other slaves and wake from STOP on a start bit.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param isEnabled true to mute the UART after the address of a foreign frame.
+ *
+ * @note : with the IT engine and the address filter (slave engine) the
+ *         first byte of a frame for another slave puts the UART in mute
+ *         mode, the rest of the frame raises no interrupt and the timer
+ *         stays stopped; the idle line before the next frame wakes it.
+ *         The DMA engine only wakes on the idle, half and full events.
+ */
+void modbusRTUSetLowPower(ModbusRTU_HandleT *modbus, bool isEnabled) {
+
+	modbus->isLowPower = isEnabled;
+	modbusRTUPortSetWakeUp(modbus->huart, isEnabled);
+}
+
+/*!
+ * @fn    bool modbusRTUIsSleepAllowed(ModbusRTU_HandleT *modbus)
+ * @brief Check that the bus needs no clock until the next start bit.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return true when STOP may be entered: no timer, frame or transmission runs.
+ *
+ * @note : SLEEP (WFI) is always allowed. Check with the interrupts masked,
+ *         then enter STOP and unmask, so a start bit in between still wakes
+ *         the core; the clocks are restored before the UART is served.
+ */
+bool modbusRTUIsSleepAllowed(ModbusRTU_HandleT *modbus) {
+	return (true == modbusRTUIsBusIdle(modbus)) && (0 == modbus->rxLength)
+			&& (false == modbusRTUIsRxFrameReady(modbus));
+}
+
+/*!
+ * @fn    void modbusRTUTimerCallback(ModbusRTU_HandleT *modbus)
+ * @brief htim one shot elapsed handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call from HAL_TIM_PeriodElapsedCallback() for the timer of this
+ *         instance. UART and timer IRQ must have the same priority.
+ */
+void modbusRTUTimerCallback(ModbusRTU_HandleT *modbus) {
+
+	if (modbus->timerRemaining > 0) {
+		/* long timeout, continue with the next 16 bit chunk */
+		ModbusRTU_TimerStart(modbus, modbus->timerRemaining);
+	} else {
+		switch (modbus->timerPhase) {
+		case MODBUS_RTU_TIMER_CHAR:
+			/* t1.5 silence: any further byte of this frame is an error */
+			ModbusRTU_TimerArm(modbus, MODBUS_RTU_TIMER_FRAME,
+					modbus->t35Ticks - modbus->t15Ticks);
+			break;
+		case MODBUS_RTU_TIMER_FRAME:
+			/* t3.5 silence: end of frame, the bus is free again */
+			modbus->timerPhase = MODBUS_RTU_TIMER_IDLE;
+			if ((MODBUS_RTU_RX_MODE_IT == modbus->rxMode)
+					&& (false == modbus->isRxDataReceived)
+					&& (modbus->rxLength > 0)) {
+				/* shorter than armed (exception response), stop waiting for more */
+				modbusRTUPortAbortReceive(modbus->huart);
+				if (true == modbus->rxDiscarding) {
+					/* frame for another slave, listen for the next one */
+					ModbusRTU_RxReset(modbus);
+					modbus->rxDiscarding = false;
+					modbusRTUPortReceiveIT(modbus->huart,
+							(uint8_t*) modbus->rxFrame, 1);
+				} else {
+					ModbusRTU_RxComplete(modbus);
+				}
+			}
+			ModbusRTU_NotifyEvent(modbus, MODBUS_RTU_EVENT_BUS_IDLE);
+			break;
+		case MODBUS_RTU_TIMER_RESPONSE:
+			/* no byte of the response arrived in time */
+			modbus->timerPhase = MODBUS_RTU_TIMER_IDLE;
+			if (MODBUS_RTU_RX_MODE_IT == modbus->rxMode) {
+				modbusRTUPortAbortReceive(modbus->huart);
+			}
+			modbus->isRxTimeout = true;
+			ModbusRTU_StatsTimeout(modbus);
+			ModbusRTU_NotifyEvent(modbus, MODBUS_RTU_EVENT_RX_TIMEOUT);
+			break;
+		default:
+			modbus->timerPhase = MODBUS_RTU_TIMER_IDLE;
+			ModbusRTU_NotifyEvent(modbus, MODBUS_RTU_EVENT_BUS_IDLE);
+			break;
+		}
+	}
 }
 
 /*!
@@ -97,29 +359,218 @@ ModbusRTU_ErrorT modbusRTUSendData(ModbusRTU_HandleT *modbus,
 		uint8_t functionCode, uint8_t *data, size_t dataSize) {
 
 	/* local variable */
-	uint16_t calCrc = 0;
 	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	uint8_t *pdu = NULL;
+	uint32_t start = MODBUS_RTU_STATS_CYCLES();
+
+	/* Validate data size */
+	if (dataSize > MODBUS_RTU_MAX_DATA_SIZE) {
+		result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	} else if (MODBUS_RTU_TX_ACTIVE == modbus->txState) {
+		result = MODBUS_RTU_TX_BUSY; /* txFrame still used by the DMA */
+	} else {
+		/* Construct the modBus RTU frame, already in place for zero copy callers */
+		if ((NULL == modbus->txFrame) || (data != modbus->txFrame->data)) {
+			pdu = modbusRTUAllocTxBuffer(modbus, dataSize);
+			if (NULL == pdu) {
+				result = MODBUS_RTU_ERROR_NO_BUFFER;
+			} else {
+				memcpy(pdu, data, dataSize);
+				MODBUS_RTU_STATS_ADD(modbus, txCopyCycles,
+						MODBUS_RTU_STATS_CYCLES() - start);
+			}
+		}
+		if (MODBUS_RTU_SUCCESS == result) {
+			result = modbusRTUCommitTx(modbus, functionCode, dataSize);
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSendDataDMA(ModbusRTU_HandleT *modbus,uint8_t functionCode, uint8_t *data, size_t dataSize)
+ * @brief Start sending a modBus RTU request with DMA and return immediately.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param functionCode The modBus function code (e.g., 0x03, 0x06).
+ * @param data Data to send to the device.
+ * @param dataSize Size of the data.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : completion is reported by txState and txCpltCallback.
+ */
+ModbusRTU_ErrorT modbusRTUSendDataDMA(ModbusRTU_HandleT *modbus,
+		uint8_t functionCode, uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	uint8_t *pdu = NULL;
+	uint32_t start = MODBUS_RTU_STATS_CYCLES();
 
 	/* Validate data size */
 	if (dataSize > MODBUS_RTU_MAX_DATA_SIZE) {
 		result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	} else if (MODBUS_RTU_TX_ACTIVE == modbus->txState) {
+		result = MODBUS_RTU_TX_BUSY;
 	} else {
+		/* Construct the modBus RTU frame, already in place for zero copy callers */
+		if ((NULL == modbus->txFrame) || (data != modbus->txFrame->data)) {
+			pdu = modbusRTUAllocTxBuffer(modbus, dataSize);
+			if (NULL == pdu) {
+				result = MODBUS_RTU_ERROR_NO_BUFFER;
+			} else {
+				memcpy(pdu, data, dataSize);
+				MODBUS_RTU_STATS_ADD(modbus, txCopyCycles,
+						MODBUS_RTU_STATS_CYCLES() - start);
+			}
+		}
+		if (MODBUS_RTU_SUCCESS == result) {
+			result = modbusRTUCommitTxDMA(modbus, functionCode, dataSize);
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    uint8_t* modbusRTUGetTxBuffer(ModbusRTU_HandleT *modbus)
+ * @brief Get the PDU data area of the TX frame to fill it in place.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return MODBUS_RTU_MAX_DATA_SIZE bytes after the function code, NULL while a DMA frame is on the wire
+ *         (or the pool has no full size block with MODBUS_RTU_USE_POOL).
+ */
+uint8_t* modbusRTUGetTxBuffer(ModbusRTU_HandleT *modbus) {
+	return modbusRTUAllocTxBuffer(modbus, MODBUS_RTU_MAX_DATA_SIZE);
+}
+
+/*!
+ * @fn    uint8_t* modbusRTUAllocTxBuffer(ModbusRTU_HandleT *modbus, size_t dataSize)
+ * @brief Get a PDU data area of at least dataSize bytes to fill it in place.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param dataSize PDU data bytes that will be committed.
+ * @return data area after the function code, NULL while a DMA frame is on
+ *         the wire or when the frame pool is exhausted.
+ *
+ * @note : with MODBUS_RTU_USE_POOL the frame takes the smallest block that
+ *         fits and returns it once sent, else this is modbusRTUGetTxBuffer.
+ */
+uint8_t* modbusRTUAllocTxBuffer(ModbusRTU_HandleT *modbus, size_t dataSize) {
+
+	/* local variable */
+	uint8_t *result = NULL;
+
+	if ((MODBUS_RTU_TX_ACTIVE != modbus->txState)
+			&& (dataSize <= MODBUS_RTU_MAX_DATA_SIZE)) {
+#ifdef MODBUS_RTU_USE_POOL
+		if ((NULL == modbus->txFrame) || (dataSize + 4 > modbus->txCapacity)) {
+			/* the frame taken earlier is too small for this one */
+			ModbusRTU_TxRelease(modbus);
+			modbus->txFrame = (modBusPacket_t*) modbusRTUPoolAlloc(dataSize + 4); /* +4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+			modbus->txCapacity = (uint16_t) modbusRTUPoolBlockSize(
+					modbus->txFrame);
+		}
+#endif
+		if (NULL != modbus->txFrame) {
+			result = modbus->txFrame->data;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUCommitTx(ModbusRTU_HandleT *modbus, uint8_t functionCode, size_t dataSize)
+ * @brief Send the frame filled through modbusRTUGetTxBuffer (blocking).
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param functionCode The modBus function code (e.g., 0x03, 0x06).
+ * @param dataSize Bytes written to the TX buffer.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ */
+ModbusRTU_ErrorT modbusRTUCommitTx(ModbusRTU_HandleT *modbus,
+		uint8_t functionCode, size_t dataSize) {
 
-		/* Construct the modBus RTU frame */
-		txPacket.slaveId = modbus->slaveId;
-		txPacket.functionCode = functionCode;
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
 
-		memcpy(txPacket.data, data, dataSize);
+	/* Validate data size */
+	if (dataSize > MODBUS_RTU_MAX_DATA_SIZE) {
+		result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	} else if (MODBUS_RTU_TX_ACTIVE == modbus->txState) {
+		result = MODBUS_RTU_TX_BUSY; /* txFrame still used by the DMA */
+	} else if ((NULL == modbus->txFrame)
+			|| (dataSize + 4 > modbus->txCapacity)) {
+		result = MODBUS_RTU_ERROR_NO_BUFFER; /* not filled through modbusRTUAllocTxBuffer */
+	} else {
 
-		/* Calculate CRC */
-		calCrc = ModbusRTU_CalculateCRC((uint8_t*) &txPacket, dataSize + 2); /* +2 = 1(slaveId) + 1(functionCode)) */
-		txPacket.data[dataSize] = calCrc & 0xFF; /* CRC low byte */
-		txPacket.data[dataSize + 1] = (calCrc >> 8) & 0xFF; /* CRC high byte */
+		/* Complete the modBus RTU frame */
+		ModbusRTU_BuildFrame(modbus, functionCode, dataSize);
 
 		/* Send the frame over UART */
-		if (HAL_OK
-				!= HAL_UART_Transmit(modbus->huart, (uint8_t*) &txPacket,
-						dataSize + 4, MODBUS_RTU_TRANSMIT_TIMEOUT)) { /* +4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+		ModbusRTU_SetDe(modbus, true);
+		ModbusRTU_StatsTxStart(modbus, dataSize + 4);
+		if (false
+				== modbusRTUPortTransmit(modbus->huart,
+						(uint8_t*) modbus->txFrame, dataSize + 4,
+						MODBUS_RTU_TRANSMIT_TIMEOUT)) { /* +4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+			result = MODBUS_RTU_ERROR_TX_FAILED;
+		}
+		ModbusRTU_StatsTxEnd(modbus);
+		ModbusRTU_TxRelease(modbus);
+		/* modbusRTUPortTransmit returns after TC, the line can be released */
+		ModbusRTU_SetDe(modbus, false);
+		/* keep the bus silent for t3.5 before the next frame */
+		ModbusRTU_TimerArmGuard(modbus);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUCommitTxDMA(ModbusRTU_HandleT *modbus, uint8_t functionCode, size_t dataSize)
+ * @brief Start sending the frame filled through modbusRTUGetTxBuffer with DMA.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param functionCode The modBus function code (e.g., 0x03, 0x06).
+ * @param dataSize Bytes written to the TX buffer.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : completion is reported by txState and txCpltCallback.
+ */
+ModbusRTU_ErrorT modbusRTUCommitTxDMA(ModbusRTU_HandleT *modbus,
+		uint8_t functionCode, size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+
+	/* Validate data size */
+	if (dataSize > MODBUS_RTU_MAX_DATA_SIZE) {
+		result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	} else if (MODBUS_RTU_TX_ACTIVE == modbus->txState) {
+		result = MODBUS_RTU_TX_BUSY;
+	} else if ((NULL == modbus->txFrame)
+			|| (dataSize + 4 > modbus->txCapacity)) {
+		result = MODBUS_RTU_ERROR_NO_BUFFER; /* not filled through modbusRTUAllocTxBuffer */
+	} else {
+
+		/* Complete the modBus RTU frame */
+		ModbusRTU_BuildFrame(modbus, functionCode, dataSize);
+
+		/* Start the DMA, DE is released in modbusRTUTxCpltCallback (TC) */
+		modbus->txState = MODBUS_RTU_TX_ACTIVE;
+		/* the DMA reads memory: write the frame out of the D-cache */
+		modbusRTUPortCacheClean(modbus->txFrame, dataSize + 4);
+		ModbusRTU_SetDe(modbus, true);
+		ModbusRTU_StatsTxStart(modbus, dataSize + 4);
+		if (false
+				== modbusRTUPortTransmitDMA(modbus->huart,
+						(uint8_t*) modbus->txFrame, dataSize + 4)) { /* +4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+			ModbusRTU_SetDe(modbus, false);
+			modbus->txState = MODBUS_RTU_TX_ERROR;
+			ModbusRTU_TxRelease(modbus);
 			result = MODBUS_RTU_ERROR_TX_FAILED;
 		}
 	}
@@ -127,6 +578,53 @@ ModbusRTU_ErrorT modbusRTUSendData(ModbusRTU_HandleT *modbus,
 	return result;
 }
 
+/*!
+ * @fn    void modbusRTUSetDePin(ModbusRTU_HandleT *modbus, ModbusRTU_PortGpioT *port, uint16_t pin)
+ * @brief Drive an RS485 DE/RE pin around every transmitted frame.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param port GPIO port of the DE/RE pin (NULL to disable).
+ * @param pin GPIO pin of the DE/RE pin.
+ */
+void modbusRTUSetDePin(ModbusRTU_HandleT *modbus, ModbusRTU_PortGpioT *port,
+		uint16_t pin) {
+	modbus->dePort = port;
+	modbus->dePin = pin;
+	/* start in receive direction */
+	ModbusRTU_SetDe(modbus, false);
+}
+
+/*!
+ * @fn    void modbusRTUTxCpltCallback(ModbusRTU_HandleT *modbus)
+ * @brief UART transmit complete (TC) handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call from HAL_UART_TxCpltCallback() for the UART of this instance.
+ */
+void modbusRTUTxCpltCallback(ModbusRTU_HandleT *modbus) {
+
+	/* last stop bit is out, turn the transceiver around */
+	ModbusRTU_SetDe(modbus, false);
+	modbus->txState = MODBUS_RTU_TX_DONE;
+	ModbusRTU_TxRelease(modbus);
+	ModbusRTU_StatsTxEnd(modbus);
+
+	if (true == modbus->isResponseExpected) {
+		/* modbusRTUReciveData was called while the request was on the wire */
+		modbus->isResponseExpected = false;
+		ModbusRTU_TimerArm(modbus, MODBUS_RTU_TIMER_RESPONSE,
+				modbus->responseTimeoutMs * (MODBUS_RTU_TIMER_TICK_HZ / 1000));
+	} else {
+		ModbusRTU_TimerArmGuard(modbus);
+	}
+
+	if (NULL != modbus->txCpltCallback) {
+		modbus->txCpltCallback(modbus);
+	}
+	ModbusRTU_NotifyEvent(modbus, MODBUS_RTU_EVENT_TX_COMPLETE);
+}
+
 /*!
  * @fn 	  ModbusRTU_ErrorT modbusRTUReciveData(ModbusRTU_HandleT *modbus, size_t dataSize)
  * @brief Receive a modBus RTU response.
@@ -139,13 +637,93 @@ ModbusRTU_ErrorT modbusRTUReciveData(ModbusRTU_HandleT *modbus, size_t dataSize)
 
 	/* local variable */
 	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	uint32_t lock = 0;
 
 	/* Validate data size */
 	if (dataSize > MODBUS_RTU_MAX_DATA_SIZE) {
 		result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	} else if (MODBUS_RTU_RX_MODE_DMA_IDLE == modbus->rxMode) {
+		/* DMA runs continuously, only drop a stale frame */
+		modbus->rxExpectedLength = dataSize + 4; /* +4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+		ModbusRTU_RxFlush(modbus);
 	} else {
-		/* start communicate for received data */
-		HAL_UART_Receive_IT(modbus->huart, (uint8_t*) &rxPacket, dataSize + 4); /* +4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+		if (NULL != modbus->rxQueue) {
+			/* the ring keeps receiving, restart it at the first byte */
+			modbusRTUPortAbortReceive(modbus->huart);
+		}
+		/* reset the streaming CRC */
+		ModbusRTU_RxFlush(modbus);
+		modbus->rxExpectedLength = dataSize + 4; /* +4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+
+		/* start communicate for received data, byte by byte so the CRC runs while the frame arrives */
+		modbusRTUPortReceiveIT(modbus->huart, (uint8_t*) modbus->rxFrame, 1);
+	}
+
+	if (MODBUS_RTU_SUCCESS == result) {
+#ifdef MODBUS_RTU_ENABLE_STATS
+		modbus->statsIsRttPending = true;
+#endif
+		/* response timeout runs from the end of the request */
+		modbus->isRxTimeout = false;
+		modbus->rxFrameError = false;
+		/* TC must not fire between the check and the flag, or no timeout is armed */
+		lock = modbusRTUPortEnterCritical();
+		if (MODBUS_RTU_TX_ACTIVE == modbus->txState) {
+			modbus->isResponseExpected = true;
+		} else {
+			ModbusRTU_TimerArm(modbus, MODBUS_RTU_TIMER_RESPONSE,
+					modbus->responseTimeoutMs * (MODBUS_RTU_TIMER_TICK_HZ / 1000));
+		}
+		modbusRTUPortExitCritical(lock);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUListen(ModbusRTU_HandleT *modbus)
+ * @brief Wait for the next request frame of any length, without response timeout.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : slave side counterpart of modbusRTUReciveData, the frame ends
+ *         after t3.5 of silence (IT mode) or at the IDLE line (DMA mode).
+ */
+ModbusRTU_ErrorT modbusRTUListen(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	bool isArm = (MODBUS_RTU_RX_MODE_IT == modbus->rxMode);
+
+	modbus->isRxTimeout = false;
+	modbus->isResponseExpected = false;
+	modbus->rxExpectedLength = MODBUS_RTU_MAX_RX_SIZE + 1; /* one past rxPacket, t3.5 ends the frame */
+#ifdef MODBUS_RTU_ENABLE_STATS
+	modbus->statsIsRttPending = false;
+#endif
+
+	if (NULL == modbus->rxQueue) {
+		modbusRTUReleaseRxFrame(modbus);
+	} else if ((0 != modbus->rxLength)
+			|| (MODBUS_RTU_TIMER_CHAR == modbus->timerPhase)
+			|| (MODBUS_RTU_TIMER_FRAME == modbus->timerPhase)) {
+		/* the ring keeps receiving, never cut the frame that arrives now */
+		isArm = false;
+	} else if (true == isArm) {
+		/* between frames, (re)start the reception at the first byte */
+		modbusRTUPortAbortReceive(modbus->huart);
+		ModbusRTU_RxReset(modbus);
+	}
+
+	if (true == isArm) {
+		/* byte by byte, t3.5 in modbusRTUTimerCallback ends the frame */
+		modbus->rxDiscarding = false;
+		if (false
+				== modbusRTUPortReceiveIT(modbus->huart,
+						(uint8_t*) modbus->rxFrame, 1)) {
+			result = MODBUS_RTU_ERROR_RX_FAILED;
+		}
 	}
 
 	return result;
@@ -164,74 +742,967 @@ ModbusRTU_ErrorT modbusRTUCheckRxState(ModbusRTU_HandleT *modbus, uint8_t *data,
 		size_t dataSize) {
 
 	/* local variable */
-	uint16_t calCrc = 0, receivedCRC = 0;
-	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	ModbusRTU_FrameViewT frame = { 0 };
+	ModbusRTU_ErrorT result = modbusRTUGetRxFrame(modbus, &frame);
+	uint32_t start = MODBUS_RTU_STATS_CYCLES();
 
-	if (true == modbus->isRxDataReceived) { /* if data received successfully */
-		/* check received data */
-		/* Validate the slave ID */
-		if (rxPacket.slaveId != modbus->slaveId) {
-			result = MODBUS_RTU_ERROR_INVALID_SLAVE_ID; /* Invalid slave ID */
+	if (MODBUS_RTU_SUCCESS == result) {
+		if (frame.dataSize != dataSize) {
+			result = MODBUS_RTU_ERROR_INVALID_FRAME;
 		} else {
-			/* Calculate the CRC for the received packet (excluding the last 2 bytes which are the CRC) */
-			calCrc = ModbusRTU_CalculateCRC((uint8_t*) &rxPacket, dataSize + 2); /* + 2 = 1(slaveId) + 1(functionCode) */
+			/* Unpack the received data*/
+			memcpy(data, frame.data, dataSize);
+			MODBUS_RTU_STATS_ADD(modbus, readCopyCycles,
+					MODBUS_RTU_STATS_CYCLES() - start);
+		}
+	} else if ((MODBUS_RTU_ERROR_EXCEPTION == result) && (dataSize > 0)) {
+		data[0] = frame.data[0]; /* exception code */
+	}
 
-			/* Extract the received CRC from the packet */
-			receivedCRC = (rxPacket.data[dataSize] << 8)
-					| rxPacket.data[dataSize + 1];
+	if (MODBUS_RTU_RX_BUSY != result) {
+		modbusRTUReleaseRxFrame(modbus);
+	}
 
-			/* Compare the calculated CRC with the received CRC */
-			if (calCrc != receivedCRC) {
-				result = MODBUS_RTU_ERROR_CRC; /* CRC mismatch */
-			} else {
-				/* Unpack the received data*/
-				memcpy(data, rxPacket.data, dataSize);
-			}
-		}
+	return result;
+}
 
-		/* reset flag */
-		modbus->isRxDataReceived = false;
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUGetRxFrame(ModbusRTU_HandleT *modbus, ModbusRTU_FrameViewT *frame)
+ * @brief Validate the received frame and return a view into the RX buffer, no copy.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param frame Filled with the view on MODBUS_RTU_SUCCESS and MODBUS_RTU_ERROR_EXCEPTION.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the view stays valid (and the RX buffer owned) until
+ *         modbusRTUReleaseRxFrame or the next modbusRTUReciveData.
+ *         Invalid frames are released here.
+ */
+ModbusRTU_ErrorT modbusRTUGetRxFrame(ModbusRTU_HandleT *modbus,
+		ModbusRTU_FrameViewT *frame) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	ModbusRTU_RxQueueT *queue = modbus->rxQueue;
+	const ModbusRTU_RxSlotT *slot = NULL;
+	bool isReady = false;
+
+	if (NULL != queue) {
+		if (queue->head != queue->tail) { /* oldest waiting frame of the ring */
+			/* read the slot only after the ISR published it */
+			__DMB();
+			slot = &queue->slots[queue->tail % MODBUS_RTU_RX_QUEUE_DEPTH];
+			result = ModbusRTU_CheckFrame(modbus, MODBUS_RTU_SLOT_PACKET(slot), slot->length,
+					slot->crc, slot->isFrameError, frame);
+			isReady = true;
+		}
+	} else if (true == modbus->isRxDataReceived) { /* if data received successfully */
+		result = ModbusRTU_CheckFrame(modbus, &modbus->rxPacket,
+				modbus->rxLength, modbus->rxCrc, modbus->rxFrameError, frame);
+		isReady = true;
+	}
 
-	} else if (false) { /* TODO timeOut */
+	if (true == isReady) {
+		if ((MODBUS_RTU_SUCCESS != result)
+				&& (MODBUS_RTU_ERROR_EXCEPTION != result)) {
+			modbusRTUReleaseRxFrame(modbus);
+		}
+	} else if (true == modbus->isRxTimeout) { /* response timeout from htim */
 		result = MODBUS_RTU_ERROR_RX_TIMEOUT;
 		/* reset flag */
-		modbus->isRxDataReceived = false;
-	} else {
-		result = MODBUS_RTU_RX_BUSY;
+		modbus->isRxTimeout = false;
 	}
 
 	return result;
 }
 
-/* 3. Local Function Declarations */
+/*!
+ * @fn    void modbusRTUReleaseRxFrame(ModbusRTU_HandleT *modbus)
+ * @brief Hand the RX buffer back to the receive engine.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ */
+void modbusRTUReleaseRxFrame(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	ModbusRTU_RxQueueT *queue = modbus->rxQueue;
+
+	if (NULL == queue) {
+		/* release rxPacket for the next frame, flag last so the ISR never sees a half reset state */
+		ModbusRTU_RxReset(modbus);
+		/* reset flag */
+		modbus->isRxDataReceived = false;
+	} else if (queue->head != queue->tail) {
+		/* the slot is read completely before the ISR may refill it */
+		__DMB();
+#ifdef MODBUS_RTU_USE_POOL
+		modbusRTUPoolFree(
+				queue->slots[queue->tail % MODBUS_RTU_RX_QUEUE_DEPTH].packet);
+#endif
+		queue->tail++;
+	}
+}
 
 /*!
- * @fn    static uint16_t ModbusRTU_CalculateCRC(uint8_t *data, size_t length)
- * @brief Calculate the modBus RTU CRC-16.
+ * @fn    bool modbusRTUIsRxFrameReady(ModbusRTU_HandleT *modbus)
+ * @brief Check that a received frame waits for modbusRTUGetRxFrame.
  *
- * @param data Pointer to the data buffer.
- * @param length Length of the data.
- * @return The calculated CRC-16 value.
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return true when a frame (valid or not) is waiting.
+ */
+bool modbusRTUIsRxFrameReady(ModbusRTU_HandleT *modbus) {
+	return (NULL == modbus->rxQueue) ?
+			modbus->isRxDataReceived :
+			(modbus->rxQueue->head != modbus->rxQueue->tail);
+}
+
+/*!
+ * @fn    size_t modbusRTUPeekRxFrame(ModbusRTU_HandleT *modbus, const uint8_t **bytes)
+ * @brief Raw bytes of the waiting frame, as received.
  *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param bytes Set to the first byte (address), the CRC included.
+ * @return received bytes, 0 when no frame waits.
  *
- * @note : TODO : you can use your hardware calculator CRC in your MCU.
+ * @note : the frame stays, modbusRTUGetRxFrame validates and releases it.
  */
-static uint16_t ModbusRTU_CalculateCRC(uint8_t *data, size_t length) {
-	uint16_t crc = 0xFFFF; /* Initial CRC value */
+size_t modbusRTUPeekRxFrame(ModbusRTU_HandleT *modbus, const uint8_t **bytes) {
 
-	for (size_t i = 0; i < length; i++) {
-		crc ^= data[i];
-		for (uint8_t j = 0; j < 8; j++) {
-			if (crc & 0x0001) {
-				crc >>= 1;
-				crc ^= 0xA001; /* Polynomial for modBus RTU */
-			} else {
-				crc >>= 1;
-			}
-		}
+	/* local variable */
+	ModbusRTU_RxQueueT *queue = modbus->rxQueue;
+	const ModbusRTU_RxSlotT *slot = NULL;
+	size_t result = 0;
+
+	if (NULL != queue) {
+		if (queue->head != queue->tail) {
+			/* read the slot only after the ISR published it */
+			__DMB();
+			slot = &queue->slots[queue->tail % MODBUS_RTU_RX_QUEUE_DEPTH];
+			*bytes = (const uint8_t*) MODBUS_RTU_SLOT_PACKET(slot);
+			result = slot->length;
+		}
+	} else if (true == modbus->isRxDataReceived) {
+		*bytes = (const uint8_t*) &modbus->rxPacket;
+		result = modbus->rxLength;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    void modbusRTUSetRxQueue(ModbusRTU_HandleT *modbus, ModbusRTU_RxQueueT *queue)
+ * @brief Receive into a ring of frames instead of the single rxPacket.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param queue Frame ring owned by the caller (static), NULL for the single rxPacket.
+ *
+ * @note : call before the reception starts. Reception then never stops:
+ *         frames that arrive while earlier ones are still processed wait
+ *         in the ring, modbusRTUGetRxFrame returns the oldest and
+ *         modbusRTUReleaseRxFrame frees its slot.
+ */
+void modbusRTUSetRxQueue(ModbusRTU_HandleT *modbus, ModbusRTU_RxQueueT *queue) {
+	if (NULL != queue) {
+		queue->head = 0;
+		queue->tail = 0;
+		queue->overflows = 0;
+	}
+	modbus->rxQueue = queue;
+	modbus->rxFrame = &modbus->rxPacket;
+	modbus->isRxDataReceived = false;
+	ModbusRTU_RxReset(modbus);
+}
+
+#ifdef MODBUS_RTU_USE_POOL
+/*!
+ * @fn    void modbusRTUSetRxDmaBuffer(ModbusRTU_HandleT *modbus, uint8_t *buffer, uint16_t size)
+ * @brief Give the circular DMA buffer of the IDLE line receive engine.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param buffer Buffer owned by the caller (static), MODBUS_RTU_DMA_ALIGNED,
+ *        in MODBUS_RTU_DMA_SECTION memory where the part needs it.
+ * @param size Bytes of buffer, a multiple of MODBUS_RTU_DMA_ALIGN
+ *        (MODBUS_RTU_RX_DMA_BUFFER_SIZE is a good start).
+ *
+ * @note : MODBUS_RTU_USE_POOL only, call after modbusRTUInit and before
+ *         modbusRTUStartReceiveToIdle. Buses on the interrupt engine need
+ *         none, so the ring costs RAM only where DMA receives.
+ */
+void modbusRTUSetRxDmaBuffer(ModbusRTU_HandleT *modbus, uint8_t *buffer,
+		uint16_t size) {
+	modbus->rxDmaBuffer = buffer;
+	modbus->rxDmaSize = size;
+}
+#endif
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUStartReceiveToIdle(ModbusRTU_HandleT *modbus)
+ * @brief Switch the instance to the circular DMA + IDLE line receive engine.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the UART RX DMA channel must be configured in circular mode.
+ *         Frames of any length (exception responses too) are delimited
+ *         without per byte interrupts, modbusRTUReciveData only drops a
+ *         stale frame in this mode. With MODBUS_RTU_USE_POOL it returns
+ *         MODBUS_RTU_ERROR_NO_BUFFER until modbusRTUSetRxDmaBuffer gave one.
+ */
+ModbusRTU_ErrorT modbusRTUStartReceiveToIdle(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+
+#ifdef MODBUS_RTU_USE_POOL
+	if (NULL == modbus->rxDmaBuffer) {
+		/* no ring given: stay on the interrupt engine */
+		result = MODBUS_RTU_ERROR_NO_BUFFER;
+	} else
+#endif
+	{
+		modbus->rxMode = MODBUS_RTU_RX_MODE_DMA_IDLE;
+		modbus->rxDmaTail = 0;
+		modbus->rxDiscarding = false;
+		modbus->isRxDataReceived = false;
+		ModbusRTU_RxReset(modbus);
+
+		if (false
+				== modbusRTUPortReceiveToIdle(modbus->huart, modbus->rxDmaBuffer,
+						MODBUS_RTU_RX_DMA_SIZE(modbus))) {
+			result = MODBUS_RTU_ERROR_RX_FAILED;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    void modbusRTURxEventCallback(ModbusRTU_HandleT *modbus, uint16_t size)
+ * @brief UART receive event (IDLE, DMA half/full) handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param size Position of the DMA in the circular buffer.
+ *
+ * @note : call from HAL_UARTEx_RxEventCallback() for the UART of this instance.
+ */
+void modbusRTURxEventCallback(ModbusRTU_HandleT *modbus, uint16_t size) {
+
+	/* local variable */
+	bool isIdle = modbusRTUPortIsIdleEvent(modbus->huart, size,
+			MODBUS_RTU_RX_DMA_SIZE(modbus));
+
+	/* half/full: move the bytes out and let the CRC run, IDLE: end of frame */
+	ModbusRTU_CopyFromDmaBuffer(modbus, size);
+
+	if (true == isIdle) {
+		if (true == modbus->rxDiscarding) {
+			modbus->rxDiscarding = false;
+			if (false == modbus->isRxDataReceived) {
+				ModbusRTU_RxReset(modbus);
+			}
+		} else if (modbus->rxLength > 0) {
+			ModbusRTU_RxComplete(modbus);
+		}
+		/* IDLE already delimits the frame, htim only guards the rest of t3.5 */
+		ModbusRTU_TimerArm(modbus, MODBUS_RTU_TIMER_GUARD,
+				modbus->t35Ticks - modbus->charTicks);
+	} else if (MODBUS_RTU_TIMER_RESPONSE == modbus->timerPhase) {
+		/* long response started (half/full event), cancel the timeout, IDLE ends it */
+		ModbusRTU_TimerStop(modbus);
+		modbus->timerPhase = MODBUS_RTU_TIMER_CHAR;
+	}
+}
+
+/*!
+ * @fn    void modbusRTUFeedRxData(ModbusRTU_HandleT *modbus, size_t rxLength)
+ * @brief Accumulate the CRC of the bytes that arrived since the previous call.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param rxLength Total bytes now present in the receive buffer.
+ *
+ * @note : call from ISR context only (DMA half/full callbacks, RX ISR).
+ *         A frame past MODBUS_RTU_MAX_RX_SIZE is discarded, not CRC checked.
+ */
+void modbusRTUFeedRxData(ModbusRTU_HandleT *modbus, size_t rxLength) {
+
+	/* local variable */
+	uint16_t processed = modbus->rxLength;
+	uint32_t start = MODBUS_RTU_STATS_CYCLES();
+
+	if ((rxLength > processed) && (rxLength <= MODBUS_RTU_MAX_RX_SIZE)) {
+		if ((0 == processed) && (true == modbus->isAddressFilter)
+				&& (false == modbus->isPromiscuous)
+				&& (modbus->rxFrame->slaveId != modbus->slaveId)
+				&& (MODBUS_RTU_BROADCAST_ID != modbus->rxFrame->slaveId)) {
+			/* not addressed to this slave, skip the CRC of the whole frame */
+			modbus->rxDiscarding = true;
+			MODBUS_RTU_STATS_ADD(modbus, rxFiltered, 1);
+		}
+		if (false == modbus->rxDiscarding) {
+			modbus->rxCrc = modbusRTUCrcUpdate(modbus->rxCrc,
+					(uint8_t*) modbus->rxFrame + processed,
+					rxLength - processed);
+			MODBUS_RTU_STATS_ADD(modbus, rxCrcCycles,
+					MODBUS_RTU_STATS_CYCLES() - start);
+		}
+		modbus->rxLength = rxLength;
+	} else if ((rxLength > MODBUS_RTU_MAX_RX_SIZE)
+			&& (false == modbus->rxDiscarding)) {
+		/* longer than rxPacket: no CRC over bytes outside it, drop the frame */
+		modbus->rxDiscarding = true;
+		MODBUS_RTU_STATS_ADD(modbus, rxOverruns, 1);
+	}
+}
+
+/*!
+ * @fn    void modbusRTURxCpltCallback(ModbusRTU_HandleT *modbus)
+ * @brief UART receive complete handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call from HAL_UART_RxCpltCallback() for the UART of this instance.
+ */
+void modbusRTURxCpltCallback(ModbusRTU_HandleT *modbus) {
+
+	/* a byte after t1.5 but before t3.5 of silence invalidates the frame */
+	if (MODBUS_RTU_TIMER_FRAME == modbus->timerPhase) {
+		modbus->rxFrameError = true;
+	}
+	/* re-arm the one shot on every byte */
+	ModbusRTU_TimerArm(modbus, MODBUS_RTU_TIMER_CHAR, modbus->t15Ticks);
+
+	/* one more byte landed in rxFrame */
+	modbusRTUFeedRxData(modbus, modbus->rxLength + 1);
+
+	if ((true == modbus->rxDiscarding) && (true == modbus->isLowPower)
+			&& (true == modbusRTUPortMute(modbus->huart))) {
+		/* frame for another slave: no interrupt until the idle line after it */
+		ModbusRTU_TimerStop(modbus);
+		modbus->timerPhase = MODBUS_RTU_TIMER_IDLE;
+		ModbusRTU_RxReset(modbus);
+		modbus->rxDiscarding = false;
+		modbusRTUPortReceiveIT(modbus->huart, (uint8_t*) modbus->rxFrame, 1);
+	} else if ((modbus->rxLength < modbus->rxExpectedLength)
+			&& (modbus->rxLength < MODBUS_RTU_MAX_RX_SIZE)) {
+		/* re-arm for the next byte */
+		modbusRTUPortReceiveIT(modbus->huart,
+				(uint8_t*) modbus->rxFrame + modbus->rxLength, 1);
+	} else if (modbus->rxLength < modbus->rxExpectedLength) {
+		/* rxPacket full while listening: a further byte lands on the last
+		 * one, it only tells that the frame is too long and gets discarded */
+		modbusRTUPortReceiveIT(modbus->huart,
+				(uint8_t*) modbus->rxFrame + MODBUS_RTU_MAX_RX_SIZE - 1, 1);
+	} else if (false == modbus->rxDiscarding) {
+		ModbusRTU_RxComplete(modbus);
+	}
+}
+
+/*!
+ * @fn    void modbusRTUErrorCallback(ModbusRTU_HandleT *modbus)
+ * @brief UART parity, framing and noise error handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call from HAL_UART_ErrorCallback() for the UART of this instance.
+ *         The frame the character belongs to is dropped, a stopped DMA
+ *         reception starts again.
+ */
+void modbusRTUErrorCallback(ModbusRTU_HandleT *modbus) {
+	MODBUS_RTU_STATS_ADD(modbus, lineErrors, 1);
+
+	if (MODBUS_RTU_RX_MODE_DMA_IDLE == modbus->rxMode) {
+		/* the HAL stops the DMA on any error, the frame is lost anyway */
+		ModbusRTU_RxRestart(modbus);
+	} else {
+		/* interrupt mode goes on, the frame ends as usual and is invalid */
+		modbus->rxFrameError = true;
+	}
+}
+
+#ifdef MODBUS_RTU_ENABLE_STATS
+/*!
+ * @fn    void modbusRTUGetStats(ModbusRTU_HandleT *modbus, ModbusRTU_StatsT *stats)
+ * @brief Take a consistent copy of the counters and timing of a bus.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param stats Filled with the copy.
+ */
+void modbusRTUGetStats(ModbusRTU_HandleT *modbus, ModbusRTU_StatsT *stats) {
+
+	/* local variable */
+	uint32_t lock = modbusRTUPortEnterCritical();
+
+	*stats = modbus->stats;
+	modbusRTUPortExitCritical(lock);
+}
+
+/*!
+ * @fn    void modbusRTUResetStats(ModbusRTU_HandleT *modbus)
+ * @brief Clear the counters, timing and histograms of a bus.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : also run by FC 0x08 sub functions 0x01 and 0x0A on a slave.
+ */
+void modbusRTUResetStats(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	uint32_t lock = modbusRTUPortEnterCritical();
+
+	memset(&modbus->stats, 0, sizeof(modbus->stats));
+	modbusRTUPortExitCritical(lock);
+}
+#endif
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static size_t ModbusRTU_BuildFrame(ModbusRTU_HandleT *modbus, uint8_t functionCode, size_t dataSize)
+ * @brief Add address, function code and CRC around the data already in txFrame.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param functionCode The modBus function code.
+ * @param dataSize Size of the data (already validated).
+ * @return frame length on the wire.
+ */
+static size_t ModbusRTU_BuildFrame(ModbusRTU_HandleT *modbus,
+		uint8_t functionCode, size_t dataSize) {
+
+	/* local variable */
+	uint16_t calCrc = 0;
+	uint32_t start = 0;
+
+	modbus->txFrame->slaveId = modbus->slaveId;
+	modbus->txFrame->functionCode = functionCode;
+
+	/* Calculate CRC */
+	start = MODBUS_RTU_STATS_CYCLES();
+	calCrc = modbusRTUCalculateCRC((uint8_t*) modbus->txFrame, dataSize + 2); /* +2 = 1(slaveId) + 1(functionCode)) */
+	MODBUS_RTU_STATS_ADD(modbus, txCrcCycles, MODBUS_RTU_STATS_CYCLES() - start);
+	modbus->txFrame->data[dataSize] = calCrc & 0xFF; /* CRC low byte */
+	modbus->txFrame->data[dataSize + 1] = (calCrc >> 8) & 0xFF; /* CRC high byte */
+
+	return dataSize + 4; /* +4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+}
+
+/*!
+ * @fn    static void ModbusRTU_TxRelease(ModbusRTU_HandleT *modbus)
+ * @brief Give the sent TX frame back to the pool.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : without MODBUS_RTU_USE_POOL txPacket stays with the bus.
+ */
+static void ModbusRTU_TxRelease(ModbusRTU_HandleT *modbus) {
+#ifdef MODBUS_RTU_USE_POOL
+	modbusRTUPoolFree(modbus->txFrame);
+	modbus->txFrame = NULL;
+	modbus->txCapacity = 0;
+#else
+	(void) modbus;
+#endif
+}
+
+/*!
+ * @fn    static void ModbusRTU_SetDe(ModbusRTU_HandleT *modbus, bool isTransmit)
+ * @brief Switch the RS485 transceiver direction, if a DE/RE pin is configured.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param isTransmit true to drive the bus, false to listen.
+ */
+static void ModbusRTU_SetDe(ModbusRTU_HandleT *modbus, bool isTransmit) {
+	if (NULL != modbus->dePort) {
+		modbusRTUPortSetDe(modbus->dePort, modbus->dePin, isTransmit);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TimerArm(ModbusRTU_HandleT *modbus, ModbusRTU_TimerPhaseT phase, uint32_t ticks)
+ * @brief (Re)start the htim one shot for the given phase.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param phase What the one shot is timing.
+ * @param ticks Duration in htim ticks, any length.
+ */
+static void ModbusRTU_TimerArm(ModbusRTU_HandleT *modbus,
+		ModbusRTU_TimerPhaseT phase, uint32_t ticks) {
+	modbus->timerPhase = phase;
+	ModbusRTU_TimerStart(modbus, (0 != ticks) ? ticks : 1);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TimerArmGuard(ModbusRTU_HandleT *modbus)
+ * @brief Time the silence after a sent frame that gets no response.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : t3.5, a broadcast holds the bus for the turnaround delay instead
+ *         of a response timeout.
+ */
+static void ModbusRTU_TimerArmGuard(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	uint32_t ticks = modbus->t35Ticks;
+	uint32_t turnaround = modbus->turnaroundMs
+			* (MODBUS_RTU_TIMER_TICK_HZ / 1000);
+
+	if ((MODBUS_RTU_BROADCAST_ID == modbus->slaveId) && (turnaround > ticks)) {
+		ticks = turnaround;
+	}
+	ModbusRTU_TimerArm(modbus, MODBUS_RTU_TIMER_GUARD, ticks);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TimerStart(ModbusRTU_HandleT *modbus, uint32_t ticks)
+ * @brief Load and start the one shot, longer durations are split in port sized chunks.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param ticks Duration in htim ticks (> 0).
+ */
+static void ModbusRTU_TimerStart(ModbusRTU_HandleT *modbus, uint32_t ticks) {
+
+	/* local variable */
+	uint32_t chunk = (ticks > MODBUS_RTU_PORT_TIMER_MAX_TICKS) ?
+			MODBUS_RTU_PORT_TIMER_MAX_TICKS : ticks;
+
+	modbus->timerRemaining = ticks - chunk;
+	modbusRTUPortTimerStart(modbus->htim, chunk);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TimerStop(ModbusRTU_HandleT *modbus)
+ * @brief Stop the one shot without an expiry event.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ */
+static void ModbusRTU_TimerStop(ModbusRTU_HandleT *modbus) {
+	modbusRTUPortTimerStop(modbus->htim);
+	modbus->timerRemaining = 0;
+}
+
+/*!
+ * @fn    static void ModbusRTU_NotifyEvent(ModbusRTU_HandleT *modbus, ModbusRTU_EventT event)
+ * @brief Report a bus event to the layer above (scheduler, slave engine).
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param event What happened.
+ */
+static void ModbusRTU_NotifyEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event) {
+#ifdef MODBUS_RTU_USE_RTOS
+	if (NULL != modbus->os) {
+		modbusRTUOsPostEvent(modbus->os, event); /* eventCallback from the worker task or here */
+	} else
+#endif
+	if (NULL != modbus->eventCallback) {
+		modbus->eventCallback(modbus, event);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_CopyFromDmaBuffer(ModbusRTU_HandleT *modbus, uint16_t head)
+ * @brief Append the circular DMA bytes up to head to rxFrame and feed the CRC.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param head Position of the DMA in the circular buffer.
+ */
+static void ModbusRTU_CopyFromDmaBuffer(ModbusRTU_HandleT *modbus,
+		uint16_t head) {
+
+	/* local variable */
+	uint16_t tail = modbus->rxDmaTail;
+	uint16_t chunk = 0;
+	uint32_t start = 0;
+
+	if (head >= MODBUS_RTU_RX_DMA_SIZE(modbus)) {
+		head = 0; /* full event, the DMA wrapped */
+	}
+
+	while (tail != head) {
+		/* contiguous part up to head or the end of the buffer */
+		chunk = (head > tail) ?
+				(head - tail) : (MODBUS_RTU_RX_DMA_SIZE(modbus) - tail);
+
+		if ((false == modbus->rxDiscarding)
+				&& ((true == modbus->isRxDataReceived)
+						|| (modbus->rxLength + chunk > MODBUS_RTU_MAX_RX_SIZE))) {
+			/* previous frame not read yet or longer than rxPacket: drop the frame */
+			modbus->rxDiscarding = true;
+			MODBUS_RTU_STATS_ADD(modbus, rxOverruns, 1);
+		}
+
+		/* the DMA wrote memory: drop the stale lines of just this chunk, also
+		 * when it is discarded, so no line survives until the next lap */
+		modbusRTUPortCacheInvalidate(&modbus->rxDmaBuffer[tail], chunk);
+
+		if (true == modbus->rxDiscarding) {
+			if (false == modbus->isRxDataReceived) {
+				ModbusRTU_RxReset(modbus);
+			}
+		} else {
+			if ((0 == modbus->rxLength) && (NULL != modbus->rxQueue)) {
+				/* new frame, a slot may have been released meanwhile */
+				ModbusRTU_RxReset(modbus);
+			}
+			start = MODBUS_RTU_STATS_CYCLES();
+			memcpy((uint8_t*) modbus->rxFrame + modbus->rxLength,
+					&modbus->rxDmaBuffer[tail], chunk);
+			MODBUS_RTU_STATS_ADD(modbus, rxCopyCycles,
+					MODBUS_RTU_STATS_CYCLES() - start);
+			modbusRTUFeedRxData(modbus, modbus->rxLength + chunk);
+		}
+
+		tail = (tail + chunk) % MODBUS_RTU_RX_DMA_SIZE(modbus);
+	}
+
+	modbus->rxDmaTail = tail;
+}
+
+/*!
+ * @fn    static void ModbusRTU_RxReset(ModbusRTU_HandleT *modbus)
+ * @brief Restart the frame being received, in the next free slot with a ring.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ */
+static void ModbusRTU_RxReset(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	ModbusRTU_RxQueueT *queue = modbus->rxQueue;
+
+	modbus->rxLength = 0;
+	modbus->rxCrc = modbusRTUCrcInit();
+	modbus->rxFrameError = false;
+
+#ifndef MODBUS_RTU_USE_POOL
+	if (NULL != queue) {
+		/* every slot waiting: receive into the scratch rxPacket and drop it */
+		modbus->rxFrame =
+				((uint8_t) (queue->head - queue->tail) < MODBUS_RTU_RX_QUEUE_DEPTH) ?
+						&queue->slots[queue->head % MODBUS_RTU_RX_QUEUE_DEPTH].packet :
+						&modbus->rxPacket;
+	}
+#else
+	(void) queue; /* frames are assembled in rxPacket and copied at the end */
+#endif
+}
+
+/*!
+ * @fn    static void ModbusRTU_RxFlush(ModbusRTU_HandleT *modbus)
+ * @brief Drop every waiting frame and the one being received.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ */
+static void ModbusRTU_RxFlush(ModbusRTU_HandleT *modbus) {
+	while (true == modbusRTUIsRxFrameReady(modbus)) {
+		modbusRTUReleaseRxFrame(modbus);
+	}
+	modbus->isRxDataReceived = false;
+	ModbusRTU_RxReset(modbus);
+}
+
+/*!
+ * @fn    static bool ModbusRTU_RxRestart(ModbusRTU_HandleT *modbus)
+ * @brief Start the reception again after the port stopped it, at a frame boundary.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return true when the reception runs (or is armed by the next listen).
+ *
+ * @note : the bytes of the frame being received are dropped, complete
+ *         frames stay.
+ */
+static bool ModbusRTU_RxRestart(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	bool result = true;
+	bool isFree = (NULL != modbus->rxQueue)
+			|| (false == modbus->isRxDataReceived);
+
+	modbus->rxDiscarding = false;
+	if (true == isFree) {
+		ModbusRTU_RxReset(modbus);
+	}
+
+	if (MODBUS_RTU_RX_MODE_DMA_IDLE == modbus->rxMode) {
+		modbus->rxDmaTail = 0;
+		result = modbusRTUPortReceiveToIdle(modbus->huart, modbus->rxDmaBuffer,
+				MODBUS_RTU_RX_DMA_SIZE(modbus));
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_RxComplete(ModbusRTU_HandleT *modbus)
+ * @brief Hand the frame in rxFrame to the application, ISR context.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : with a ring the frame is published and the reception goes on
+ *         in the next slot (pool: the frame is copied into a block of its
+ *         size), without a ring rxPacket is owned until
+ *         modbusRTUReleaseRxFrame.
+ */
+static void ModbusRTU_RxComplete(ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	ModbusRTU_RxQueueT *queue = modbus->rxQueue;
+	ModbusRTU_RxSlotT *slot = NULL;
+#ifdef MODBUS_RTU_USE_POOL
+	modBusPacket_t *packet = NULL;
+	uint32_t start = 0;
+#endif
+
+	ModbusRTU_StatsRxEnd(modbus);
+
+	if (NULL == queue) {
+		modbus->isRxDataReceived = true;
+		ModbusRTU_NotifyEvent(modbus, MODBUS_RTU_EVENT_FRAME_RECEIVED);
+	} else {
+#ifdef MODBUS_RTU_USE_POOL
+		if ((uint8_t) (queue->head - queue->tail) < MODBUS_RTU_RX_QUEUE_DEPTH) {
+			packet = (modBusPacket_t*) modbusRTUPoolAlloc(modbus->rxLength);
+		}
+		if (NULL == packet) {
+			queue->overflows++; /* ring full or pool exhausted */
+			MODBUS_RTU_STATS_ADD(modbus, rxOverruns, 1);
+		} else {
+			start = MODBUS_RTU_STATS_CYCLES();
+			memcpy(packet, &modbus->rxPacket, modbus->rxLength);
+			MODBUS_RTU_STATS_ADD(modbus, rxCopyCycles,
+					MODBUS_RTU_STATS_CYCLES() - start);
+			slot = &queue->slots[queue->head % MODBUS_RTU_RX_QUEUE_DEPTH];
+			slot->packet = packet;
+#else
+		if (&modbus->rxPacket == modbus->rxFrame) {
+			queue->overflows++; /* no slot was free when the frame started */
+			MODBUS_RTU_STATS_ADD(modbus, rxOverruns, 1);
+		} else {
+			slot = &queue->slots[queue->head % MODBUS_RTU_RX_QUEUE_DEPTH];
+#endif
+			slot->length = modbus->rxLength;
+			slot->crc = modbus->rxCrc;
+			slot->isFrameError = modbus->rxFrameError;
+			/* the slot is complete before the consumer can see it */
+			__DMB();
+			queue->head++;
+		}
+
+		ModbusRTU_RxReset(modbus);
+		if (MODBUS_RTU_RX_MODE_IT == modbus->rxMode) {
+			/* keep receiving, the next frame may follow after t3.5 */
+			modbusRTUPortReceiveIT(modbus->huart, (uint8_t*) modbus->rxFrame, 1);
+		}
+		if (NULL != slot) {
+			ModbusRTU_NotifyEvent(modbus, MODBUS_RTU_EVENT_FRAME_RECEIVED);
+		}
+	}
+}
+
+/*!
+ * @fn    static ModbusRTU_ErrorT ModbusRTU_CheckFrame(ModbusRTU_HandleT *modbus, const modBusPacket_t *packet, uint16_t length, uint16_t crc, bool isFrameError, ModbusRTU_FrameViewT *frame)
+ * @brief Validate one received frame and fill its view.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param packet The frame.
+ * @param length Bytes of the frame, CRC included.
+ * @param crc Running CRC of the whole frame.
+ * @param isFrameError t1.5 exceeded inside the frame.
+ * @param frame Filled on MODBUS_RTU_SUCCESS and MODBUS_RTU_ERROR_EXCEPTION.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ */
+static ModbusRTU_ErrorT ModbusRTU_CheckFrame(ModbusRTU_HandleT *modbus,
+		const modBusPacket_t *packet, uint16_t length, uint16_t crc,
+		bool isFrameError, ModbusRTU_FrameViewT *frame) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+
+	/* check received data */
+	if ((true == isFrameError) || (length < 4)) {
+		result = MODBUS_RTU_ERROR_INVALID_FRAME; /* t1.5 exceeded inside the frame or runt */
+		MODBUS_RTU_STATS_ADD(modbus, invalidFrames, 1);
+	} else if ((false == modbus->isPromiscuous)
+			&& (packet->slaveId != modbus->slaveId)
+			&& ((false == modbus->isAddressFilter)
+					|| (MODBUS_RTU_BROADCAST_ID != packet->slaveId))) { /* Validate the slave ID, slaves accept broadcasts */
+		result = MODBUS_RTU_ERROR_INVALID_SLAVE_ID; /* Invalid slave ID */
+		MODBUS_RTU_STATS_ADD(modbus, invalidSlaveId, 1);
+	} else if (MODBUS_RTU_CRC_RESIDUE != modbusRTUCrcFinal(crc)) { /* CRC already accumulated in ISR, frame + its CRC leaves the residue */
+		result = MODBUS_RTU_ERROR_CRC; /* CRC mismatch */
+		MODBUS_RTU_STATS_ADD(modbus, crcErrors, 1);
+	} else {
+		frame->slaveId = packet->slaveId;
+		frame->functionCode = packet->functionCode;
+		frame->data = packet->data;
+		frame->dataSize = length - 4; /* -4 = 1(slaveId) + 1(functionCode) + 2(CRC) */
+
+		if (packet->functionCode & 0x80) {
+			/* 5 = 1(slaveId) + 1(functionCode) + 1(exception) + 2(CRC) */
+			result = (5 == length) ?
+					MODBUS_RTU_ERROR_EXCEPTION : MODBUS_RTU_ERROR_INVALID_FRAME;
+			MODBUS_RTU_STATS_ADD(modbus, rxExceptions,
+					(MODBUS_RTU_ERROR_EXCEPTION == result) ? 1 : 0);
+			MODBUS_RTU_STATS_ADD(modbus, invalidFrames,
+					(MODBUS_RTU_ERROR_EXCEPTION == result) ? 0 : 1);
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_StatsTxStart(ModbusRTU_HandleT *modbus, size_t length)
+ * @brief Count a frame that starts on the wire, time the turnaround of a reply.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param length Bytes of the frame.
+ */
+static void ModbusRTU_StatsTxStart(ModbusRTU_HandleT *modbus, size_t length) {
+#ifdef MODBUS_RTU_ENABLE_STATS
+
+	/* local variable */
+	ModbusRTU_StatsT *stats = &modbus->stats;
+
+	stats->txFrames++;
+	stats->txBytes += length;
+	if (true == modbus->statsIsTurnaround) {
+		/* the reply of the request received last */
+		modbus->statsIsTurnaround = false;
+		stats->turnaroundUs = ModbusRTU_StatsMicros(
+				modbusRTUPortCycles() - modbus->statsRxEndCycles);
+		if (stats->turnaroundUs > stats->turnaroundMaxUs) {
+			stats->turnaroundMaxUs = stats->turnaroundUs;
+		}
+	}
+#else
+	(void) modbus;
+	(void) length;
+#endif
+}
+
+/*!
+ * @fn    static void ModbusRTU_StatsTxEnd(ModbusRTU_HandleT *modbus)
+ * @brief Timestamp the end of a sent frame, the round trip starts here.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ */
+static void ModbusRTU_StatsTxEnd(ModbusRTU_HandleT *modbus) {
+#ifdef MODBUS_RTU_ENABLE_STATS
+	modbus->statsTxEndCycles = modbusRTUPortCycles();
+#else
+	(void) modbus;
+#endif
+}
+
+/*!
+ * @fn    static void ModbusRTU_StatsRxEnd(ModbusRTU_HandleT *modbus)
+ * @brief Count a complete frame, record the round trip of a response, ISR context.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ */
+static void ModbusRTU_StatsRxEnd(ModbusRTU_HandleT *modbus) {
+#ifdef MODBUS_RTU_ENABLE_STATS
+
+	/* local variable */
+	ModbusRTU_StatsT *stats = &modbus->stats;
+	ModbusRTU_RttHistogramT *histogram = NULL;
+	uint32_t ratio = 0;
+	uint8_t bucket = 0;
+
+	modbus->statsRxEndCycles = modbusRTUPortCycles();
+	stats->rxFrames++;
+	stats->rxBytes += modbus->rxLength;
+
+	if (true == modbus->statsIsRttPending) {
+		/* response of the request to modbus->slaveId */
+		modbus->statsIsRttPending = false;
+		stats->responseTimeUs = ModbusRTU_StatsMicros(
+				modbus->statsRxEndCycles - modbus->statsTxEndCycles);
+		if (stats->responseTimeUs > stats->responseTimeMaxUs) {
+			stats->responseTimeMaxUs = stats->responseTimeUs;
+		}
+
+		histogram = ModbusRTU_StatsSlave(modbus);
+		if (NULL != histogram) {
+			ratio = stats->responseTimeUs / MODBUS_RTU_STATS_RTT_BASE_US;
+			bucket = (0 == ratio) ? 0 : (uint8_t) (32 - __CLZ(ratio));
+			if (bucket >= MODBUS_RTU_STATS_RTT_BUCKETS) {
+				bucket = MODBUS_RTU_STATS_RTT_BUCKETS - 1;
+			}
+			histogram->buckets[bucket]++;
+		}
+	} else {
+		modbus->statsIsTurnaround = true;
 	}
+#else
+	(void) modbus;
+#endif
+}
+
+/*!
+ * @fn    static void ModbusRTU_StatsTimeout(ModbusRTU_HandleT *modbus)
+ * @brief Count a response timeout of the bus and of its slave, ISR context.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ */
+static void ModbusRTU_StatsTimeout(ModbusRTU_HandleT *modbus) {
+#ifdef MODBUS_RTU_ENABLE_STATS
+
+	/* local variable */
+	ModbusRTU_RttHistogramT *histogram = ModbusRTU_StatsSlave(modbus);
 
-	return crc;
+	modbus->statsIsRttPending = false;
+	modbus->stats.timeouts++;
+	if (NULL != histogram) {
+		histogram->timeouts++;
+	}
+#else
+	(void) modbus;
+#endif
+}
+
+#ifdef MODBUS_RTU_ENABLE_STATS
+/*!
+ * @fn    static uint32_t ModbusRTU_StatsMicros(uint32_t cycles)
+ * @brief Convert cycle counter cycles to microseconds.
+ *
+ * @param cycles Core clock cycles.
+ * @return microseconds.
+ */
+static uint32_t ModbusRTU_StatsMicros(uint32_t cycles) {
+
+	/* local variable */
+	uint32_t cyclesPerUs = modbusRTUPortCoreHz() / 1000000u;
+
+	return (0 != cyclesPerUs) ? (cycles / cyclesPerUs) : cycles;
+}
+
+/*!
+ * @fn    static ModbusRTU_RttHistogramT* ModbusRTU_StatsSlave(ModbusRTU_HandleT *modbus)
+ * @brief Find the histogram of the addressed slave, claim a free one for a new slave.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return the histogram, NULL for broadcasts or when every entry is taken.
+ */
+static ModbusRTU_RttHistogramT* ModbusRTU_StatsSlave(
+		ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	ModbusRTU_RttHistogramT *result = NULL;
+	ModbusRTU_RttHistogramT *histogram = modbus->stats.rtt;
+
+	/* entries are claimed in order, the first free one ends the used ones */
+	for (uint8_t i = 0; (MODBUS_RTU_BROADCAST_ID != modbus->slaveId)
+			&& (NULL == result) && (i < MODBUS_RTU_STATS_SLAVES); i++) {
+		if ((modbus->slaveId == histogram[i].slaveId)
+				|| (0 == histogram[i].slaveId)) {
+			histogram[i].slaveId = modbus->slaveId;
+			result = &histogram[i];
+		}
+	}
+
+	return result;
 }
+#endif
 
 /************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -24,8 +24,8 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
-#include "stm32f1xx_hal.h"
 /* 2. Project Header Files */
+#include "modBusRTUPort.h"
 
 /* Defines & Macros ----------------------------------------------------------*/
 
@@ -37,9 +37,84 @@ extern "C" {
 #define MODBUS_RTU_MAX_DATA_SIZE 250
 /*! @def  Maximum frame size (including address, function code, data, and CRC) */
 #define MODBUS_RTU_MAX_FRAME_SIZE 256
+/*! @def Longest frame a handle receives, the size of its rxPacket */
+#define MODBUS_RTU_MAX_RX_SIZE sizeof(modBusPacket_t)
 /*! @defgroup Timeout in milliseconds */
 #define MODBUS_RTU_TRANSMIT_TIMEOUT -1  /* Transmit timeOut */
 #define MODBUS_RTU_RECEIVED_TIMEOUT 100 /* Received timeOut */
+/*! @def Silence in milliseconds after a broadcast, the slaves execute it meanwhile */
+#ifndef MODBUS_RTU_TURNAROUND_DELAY
+#define MODBUS_RTU_TURNAROUND_DELAY 10
+#endif
+/*! @def Tick rate of htim, configure the prescaler for it (1 tick = 1 us) */
+#ifndef MODBUS_RTU_TIMER_TICK_HZ
+#define MODBUS_RTU_TIMER_TICK_HZ 1000000
+#endif
+/*! @def Above this baud rate the spec fixes t1.5 = 750 us and t3.5 = 1750 us */
+#define MODBUS_RTU_FIXED_TIMING_BAUD 19200
+#define MODBUS_RTU_FIXED_T15_US 750
+#define MODBUS_RTU_FIXED_T35_US 1750
+/*! @def Bits of one RTU character (start + 8 data + parity/stop + stop) */
+#define MODBUS_RTU_CHAR_BITS 11
+/*! @def Slave address of a broadcast request, never answered */
+#define MODBUS_RTU_BROADCAST_ID 0
+/*! @defgroup Quantity limits of the spec */
+#define MODBUS_RTU_MAX_READ_BITS 2000
+#define MODBUS_RTU_MAX_READ_REGISTERS 125
+#define MODBUS_RTU_MAX_WRITE_BITS 1968
+#define MODBUS_RTU_MAX_WRITE_REGISTERS 123
+#define MODBUS_RTU_MAX_RW_WRITE_REGISTERS 121
+/*! @defgroup Quantity limits of a handle, request and response fit MODBUS_RTU_MAX_DATA_SIZE */
+#define MODBUS_RTU_HANDLE_MAX_READ_BITS ((MODBUS_RTU_MAX_DATA_SIZE - 1) * 8) /* 1992 */
+#define MODBUS_RTU_HANDLE_MAX_READ_REGISTERS ((MODBUS_RTU_MAX_DATA_SIZE - 1) / 2) /* 124 */
+#define MODBUS_RTU_HANDLE_MAX_WRITE_BITS ((MODBUS_RTU_MAX_DATA_SIZE - 5) * 8) /* 1960 */
+#define MODBUS_RTU_HANDLE_MAX_WRITE_REGISTERS ((MODBUS_RTU_MAX_DATA_SIZE - 5) / 2) /* 122 */
+#define MODBUS_RTU_HANDLE_MAX_RW_WRITE_REGISTERS ((MODBUS_RTU_MAX_DATA_SIZE - 9) / 2) /* 120 */
+#define MODBUS_RTU_MAX_FIFO_COUNT 31
+/*! @def Frames buffered by a ModbusRTU_RxQueueT, power of two up to 128 */
+#ifndef MODBUS_RTU_RX_QUEUE_DEPTH
+#define MODBUS_RTU_RX_QUEUE_DEPTH 4
+#endif
+#if (MODBUS_RTU_RX_QUEUE_DEPTH & (MODBUS_RTU_RX_QUEUE_DEPTH - 1)) \
+	|| (MODBUS_RTU_RX_QUEUE_DEPTH > 128)
+#error "MODBUS_RTU_RX_QUEUE_DEPTH must be a power of two up to 128"
+#endif
+/*! @def Size of the circular DMA buffer of the IDLE line receive mode (supplied by the caller with MODBUS_RTU_USE_POOL) */
+#ifndef MODBUS_RTU_RX_DMA_BUFFER_SIZE
+#define MODBUS_RTU_RX_DMA_BUFFER_SIZE 256
+#endif
+/*! @def Alignment of the DMA buffers (32 = Cortex-M7 D-cache line) */
+#ifndef MODBUS_RTU_DMA_ALIGN
+#define MODBUS_RTU_DMA_ALIGN MODBUS_RTU_PORT_DMA_ALIGN
+#endif
+#if (MODBUS_RTU_RX_DMA_BUFFER_SIZE % MODBUS_RTU_DMA_ALIGN)
+#error "MODBUS_RTU_RX_DMA_BUFFER_SIZE must be a multiple of MODBUS_RTU_DMA_ALIGN"
+#endif
+/*! @def Attributes of a DMA buffer, it owns its cache lines */
+#define MODBUS_RTU_DMA_ALIGNED __attribute__((aligned(MODBUS_RTU_DMA_ALIGN)))
+/*! @def Section of the library DMA buffers, e.g. __attribute__((section(".dma_buffer"))) */
+#ifndef MODBUS_RTU_DMA_SECTION
+#define MODBUS_RTU_DMA_SECTION
+#endif
+/*! @def Slaves with a round trip histogram in ModbusRTU_StatsT */
+#ifndef MODBUS_RTU_STATS_SLAVES
+#define MODBUS_RTU_STATS_SLAVES 8
+#endif
+/*! @def Round trip histogram: bucket 0 < base, bucket n < base << n, the last one open */
+#ifndef MODBUS_RTU_STATS_RTT_BUCKETS
+#define MODBUS_RTU_STATS_RTT_BUCKETS 8
+#endif
+#ifndef MODBUS_RTU_STATS_RTT_BASE_US
+#define MODBUS_RTU_STATS_RTT_BASE_US 1000
+#endif
+/*! @defgroup Statistics hooks, compiled out without MODBUS_RTU_ENABLE_STATS */
+#ifdef MODBUS_RTU_ENABLE_STATS
+#define MODBUS_RTU_STATS_ADD(modbus, counter, value) ((modbus)->stats.counter += (value))
+#define MODBUS_RTU_STATS_CYCLES() modbusRTUPortCycles()
+#else
+#define MODBUS_RTU_STATS_ADD(modbus, counter, value) ((void) (value))
+#define MODBUS_RTU_STATS_CYCLES() (0u)
+#endif
 
 /*! @defgroup Function codes */
 /* single bit access */
@@ -65,6 +140,16 @@ extern "C" {
 #define MODBUS_FUNC_GET_COM_EVENT_LOG  0x0C
 #define MODBUS_FUNC_REPORT_SERVER_ID  0x11
 
+/*! @defgroup Exception codes */
+#define MODBUS_EXCEPTION_NONE 0x00
+#define MODBUS_EXCEPTION_ILLEGAL_FUNCTION 0x01
+#define MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS 0x02
+#define MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE 0x03
+#define MODBUS_EXCEPTION_SERVER_DEVICE_FAILURE 0x04
+#define MODBUS_EXCEPTION_SERVER_DEVICE_BUSY 0x06
+#define MODBUS_EXCEPTION_GATEWAY_PATH_UNAVAILABLE 0x0A
+#define MODBUS_EXCEPTION_GATEWAY_TARGET_FAILED 0x0B
+
 /* Typedefs ------------------------------------------------------------------*/
 /*!
  * @typedef
@@ -82,18 +167,233 @@ typedef enum _modBusRtuErrors{
 	MODBUS_RTU_ERROR_TX_FAILED, /*!< MODBUS_RTU_ERROR_TX_FAILED (UART send data failed)*/
 	MODBUS_RTU_ERROR_INVALID_SLAVE_ID,/*!< MODBUS_RTU_ERROR_INVALID_SLAVE_ID */
 	MODBUS_RTU_ERROR_INVALID_FRAME, /*!< MODBUS_RTU_ERROR_INVALID_FRAME */
-	MODBUS_RTU_RX_BUSY /*!< MODBUS_RTU_RX_BUSY */
+	MODBUS_RTU_RX_BUSY, /*!< MODBUS_RTU_RX_BUSY */
+	MODBUS_RTU_ERROR_EXCEPTION, /*!< MODBUS_RTU_ERROR_EXCEPTION (slave answered with an exception, code in data[0]) */
+	MODBUS_RTU_ERROR_RX_FAILED, /*!< MODBUS_RTU_ERROR_RX_FAILED (UART receive start failed) */
+	MODBUS_RTU_TX_BUSY, /*!< MODBUS_RTU_TX_BUSY (previous frame still on the wire) */
+	MODBUS_RTU_ERROR_QUEUE_FULL, /*!< MODBUS_RTU_ERROR_QUEUE_FULL (no free slot for the request) */
+	MODBUS_RTU_ERROR_OS, /*!< MODBUS_RTU_ERROR_OS (RTOS object could not be created) */
+	MODBUS_RTU_ERROR_NO_BUFFER, /*!< MODBUS_RTU_ERROR_NO_BUFFER (frame pool exhausted) */
+	MODBUS_RTU_ERROR_SLAVE_OFFLINE, /*!< MODBUS_RTU_ERROR_SLAVE_OFFLINE (slave skipped after repeated timeouts) */
+	MODBUS_RTU_ERROR_LATE /*!< MODBUS_RTU_ERROR_LATE (request would miss its deadline, not sent) */
 } ModbusRTU_ErrorT;
 
+/*!
+ * @typedef @enum  _modBusRtuRxMode
+ * @brief modBus receive engine selection.
+ */
+typedef enum _modBusRtuRxMode{
+	MODBUS_RTU_RX_MODE_IT, /*!< HAL_UART_Receive_IT, one interrupt per byte */
+	MODBUS_RTU_RX_MODE_DMA_IDLE /*!< circular DMA, frames delimited by the IDLE line */
+} ModbusRTU_RxModeT;
+
+/*!
+ * @typedef @struct _modeBusPacket
+ * @brief modBus packet structure
+ */
+typedef struct _modeBusPacket{
+	uint8_t slaveId;
+	uint8_t functionCode;
+	uint8_t data[MODBUS_RTU_MAX_DATA_SIZE + 2]; // + 2 =  for CRC
+} modBusPacket_t;
+
+/*!
+ * @typedef @struct _modbusFrameView
+ * @brief read only view of a received frame inside the RX buffer of a handle.
+ */
+typedef struct _modbusFrameView{
+	uint8_t slaveId; /*! address of the sender */
+	uint8_t functionCode; /*! function code (bit 7 set for exceptions) */
+	const uint8_t *data; /*! PDU data after the function code */
+	size_t dataSize; /*! PDU data length (without address, function code, CRC) */
+} ModbusRTU_FrameViewT;
+
+/*!
+ * @typedef @struct _modbusRxSlot
+ * @brief one complete frame of a ModbusRTU_RxQueueT, validated when consumed.
+ */
+typedef struct _modbusRxSlot{
+#ifdef MODBUS_RTU_USE_POOL
+	modBusPacket_t *packet; /*! the frame, a pool block of its length */
+#else
+	modBusPacket_t packet; /*! the frame */
+#endif
+	uint16_t length; /*! bytes of the frame, CRC included */
+	uint16_t crc; /*! running CRC of the whole frame, the residue when valid */
+	bool isFrameError; /*! t1.5 exceeded inside the frame */
+} ModbusRTU_RxSlotT;
+
+/*!
+ * @typedef @struct _modbusRxQueue
+ * @brief lock free single producer (ISR) / single consumer ring of received frames.
+ *
+ * @note : head and tail run freely, head - tail frames are waiting. The
+ *         ISR fills slots[head % depth] (in place, or copies the frame
+ *         into a pool block with MODBUS_RTU_USE_POOL) and only writes
+ *         head, the application only writes tail.
+ */
+typedef struct _modbusRxQueue{
+	ModbusRTU_RxSlotT slots[MODBUS_RTU_RX_QUEUE_DEPTH]; /*! frame pool */
+	volatile uint8_t head; /*! frames published by the ISR */
+	volatile uint8_t tail; /*! frames released by the application */
+	volatile uint32_t overflows; /*! frames dropped because every slot was waiting */
+} ModbusRTU_RxQueueT;
+
+#ifdef MODBUS_RTU_ENABLE_STATS
+/*!
+ * @typedef @struct _modbusRttHistogram
+ * @brief master side round trips of one slave.
+ */
+typedef struct _modbusRttHistogram{
+	uint8_t slaveId; /*! slave of the entry, 0 = free */
+	uint32_t timeouts; /*! requests without response */
+	uint32_t buckets[MODBUS_RTU_STATS_RTT_BUCKETS]; /*! responses per round trip class */
+} ModbusRTU_RttHistogramT;
+
+/*!
+ * @typedef @struct _modbusStats
+ * @brief counters and timing of one bus.
+ *
+ * @note : every field has a single writer (RX ISR, or the context that
+ *         sends, or the one that reads the frames), cycles are counted by
+ *         modbusRTUPortCycles (DWT on STM32).
+ */
+typedef struct _modbusStats{
+	uint32_t txFrames; /*! frames sent */
+	uint32_t txBytes; /*! bytes sent, address and CRC included */
+	uint32_t rxFrames; /*! complete frames received */
+	uint32_t rxBytes; /*! bytes of rxFrames */
+	uint32_t rxFiltered; /*! frames for other slaves dropped by the address filter */
+	uint32_t rxOverruns; /*! frames lost: too long, previous frame or every ring slot still waiting */
+	uint32_t crcErrors; /*! frames with a wrong CRC */
+	uint32_t invalidSlaveId; /*! frames of another address */
+	uint32_t invalidFrames; /*! runts and t1.5 violations */
+	uint32_t lineErrors; /*! characters with a parity, framing or noise error */
+	uint32_t rxExceptions; /*! exception responses received */
+	uint32_t timeouts; /*! responses that did not arrive in time */
+	uint32_t serverMessages; /*! slave: requests for this address or broadcast */
+	uint32_t txExceptions; /*! slave: exception responses sent */
+	uint32_t noResponses; /*! slave: requests not answered (broadcasts) */
+	uint16_t commEventCount; /*! slave: FC 0x0B counter, requests completed without exception */
+	uint64_t txCrcCycles; /*! CRC of the sent frames */
+	uint64_t rxCrcCycles; /*! CRC of the received bytes, ISR */
+	uint64_t txCopyCycles; /*! copy into the TX frame, modbusRTUSendData */
+	uint64_t rxCopyCycles; /*! copy out of the DMA buffer (and into ring blocks), ISR */
+	uint64_t readCopyCycles; /*! copy to the caller, modbusRTUCheckRxState */
+	uint32_t responseTimeUs; /*! master: end of the last request to its complete response */
+	uint32_t responseTimeMaxUs; /*! master: longest responseTimeUs */
+	uint32_t turnaroundUs; /*! slave: end of the last request to the start of its reply */
+	uint32_t turnaroundMaxUs; /*! slave: longest turnaroundUs */
+	ModbusRTU_RttHistogramT rtt[MODBUS_RTU_STATS_SLAVES]; /*! master: round trips per slave, first come */
+} ModbusRTU_StatsT;
+#endif
+
+/*!
+ * @typedef @enum  _modBusRtuTxState
+ * @brief modBus transmit state, written from the UART TC interrupt.
+ */
+typedef enum _modBusRtuTxState{
+	MODBUS_RTU_TX_IDLE, /*!< nothing sent yet */
+	MODBUS_RTU_TX_ACTIVE, /*!< frame on the wire */
+	MODBUS_RTU_TX_DONE, /*!< last frame completely sent (TC) */
+	MODBUS_RTU_TX_ERROR /*!< last frame failed */
+} ModbusRTU_TxStateT;
+
+/*!
+ * @typedef @enum  _modBusRtuTimerPhase
+ * @brief what the one shot htim is currently timing.
+ */
+typedef enum _modBusRtuTimerPhase{
+	MODBUS_RTU_TIMER_IDLE, /*!< bus silent for t3.5, free to transmit */
+	MODBUS_RTU_TIMER_CHAR, /*!< inside a frame, t1.5 since the last byte */
+	MODBUS_RTU_TIMER_FRAME, /*!< t1.5 passed, rest of t3.5 to end of frame */
+	MODBUS_RTU_TIMER_RESPONSE, /*!< waiting for the first byte of a response */
+	MODBUS_RTU_TIMER_GUARD /*!< t3.5 after the end of a frame */
+} ModbusRTU_TimerPhaseT;
+
+/*!
+ * @typedef @enum  _modBusRtuEvent
+ * @brief bus events reported through eventCallback, from ISR context.
+ */
+typedef enum _modBusRtuEvent{
+	MODBUS_RTU_EVENT_FRAME_RECEIVED, /*!< a complete frame waits in rxPacket */
+	MODBUS_RTU_EVENT_RX_TIMEOUT, /*!< the response timeout expired */
+	MODBUS_RTU_EVENT_TX_COMPLETE, /*!< a DMA frame left the UART (TC) */
+	MODBUS_RTU_EVENT_BUS_IDLE /*!< t3.5 silence, the next frame may be sent */
+} ModbusRTU_EventT;
+
 /*!
  * @typedef @struct  _modbusClassHandller
  * @brief modBus RTU handle structure.
+ *
+ * @note : every handle owns its TX/RX buffers, so each UART runs
+ *         independently of the others without any global lock. The DMA
+ *         buffers (txPacket, rxDmaBuffer) own whole cache lines; place the
+ *         handle in MODBUS_RTU_DMA_SECTION memory to skip the maintenance.
+ *         With MODBUS_RTU_USE_POOL the TX frame comes from the pool and the
+ *         DMA ring from the caller (modbusRTUSetRxDmaBuffer), so the only
+ *         frame buffer left per bus is rxPacket (MODBUS_RTU_MAX_RX_SIZE =
+ *         MODBUS_RTU_MAX_DATA_SIZE + 4 bytes), where the ISR assembles the
+ *         frame being received. Longer frames are dropped as overruns.
+ *         That is 2 bytes short of the 256 byte frame of the spec: a read
+ *         stops at 124 registers or 1992 bits instead of 125 and 2000, see
+ *         the MODBUS_RTU_HANDLE_MAX_* limits.
  */
 typedef struct _modbusClassHandller{
-	UART_HandleTypeDef *huart; /*! UART handle */
-	TIM_HandleTypeDef *htim; /*! Timer handle */
+	ModbusRTU_PortUartT *huart; /*! UART of the port */
+	ModbusRTU_PortTimerT *htim; /*! one shot timer of the port */
 	uint8_t slaveId; /*! modBus slave ID */
-	bool isRxDataReceived;
+	volatile bool isRxDataReceived; /*! set by the ISR, cleared by the owner of the frame */
+	volatile uint16_t rxCrc; /*! running CRC of the bytes received so far */
+	volatile uint16_t rxLength; /*! bytes received (and fed to rxCrc) so far */
+	uint16_t rxExpectedLength; /*! frame length armed by modbusRTUReciveData */
+	ModbusRTU_RxModeT rxMode; /*! receive engine */
+	uint16_t rxDmaTail; /*! circular DMA buffer position already copied out */
+	volatile bool rxDiscarding; /*! drop bytes until the end of the frame */
+	bool isAddressFilter; /*! slave side: drop frames for other addresses before the CRC */
+	bool isPromiscuous; /*! accept frames of every slave ID (autobaud, bus monitors) */
+	bool isLowPower; /*! IT engine: mute the UART for frames of other slaves, see modbusRTUSetLowPower */
+	volatile ModbusRTU_TxStateT txState; /*! transmit state, poll after modbusRTUSendDataDMA */
+	void (*txCpltCallback)(struct _modbusClassHandller *modbus); /*! optional, called from the TC interrupt */
+	void (*eventCallback)(struct _modbusClassHandller *modbus,
+			ModbusRTU_EventT event); /*! optional, bus events for the layer above */
+	void *userContext; /*! owner of eventCallback (scheduler, slave engine) */
+#ifdef MODBUS_RTU_USE_RTOS
+	struct _modbusOs *os; /*! RTOS objects of the bus, NULL = events run in the ISR */
+#endif
+	ModbusRTU_PortGpioT *dePort; /*! RS485 DE/RE port, NULL when not used */
+	uint16_t dePin; /*! RS485 DE/RE pin */
+	uint32_t t15Ticks; /*! inter character timeout in htim ticks */
+	uint32_t t35Ticks; /*! inter frame delay in htim ticks */
+	uint32_t charTicks; /*! one character time in htim ticks */
+	uint32_t responseTimeoutMs; /*! response timeout, MODBUS_RTU_RECEIVED_TIMEOUT by default */
+	uint32_t turnaroundMs; /*! bus silence after a broadcast (at least t3.5), MODBUS_RTU_TURNAROUND_DELAY by default */
+	volatile ModbusRTU_TimerPhaseT timerPhase; /*! current one shot of htim */
+	volatile uint32_t timerRemaining; /*! ticks left beyond the 16 bit one shot */
+	volatile bool isResponseExpected; /*! arm the response timeout once TX completes */
+	volatile bool isRxTimeout; /*! response timeout expired */
+	volatile bool rxFrameError; /*! gap between t1.5 and t3.5 inside the frame */
+#ifndef MODBUS_RTU_USE_POOL
+	modBusPacket_t txPacket MODBUS_RTU_DMA_ALIGNED; /*! TX frame of this bus */
+#endif
+	modBusPacket_t *txFrame; /*! TX frame: txPacket or a pool block, NULL = none */
+	uint16_t txCapacity; /*! frame bytes txFrame can hold */
+	modBusPacket_t rxPacket; /*! RX frame of this bus, overflow scratch with rxQueue */
+	modBusPacket_t *rxFrame; /*! frame being received: rxPacket or a slot of rxQueue */
+	ModbusRTU_RxQueueT *rxQueue; /*! optional frame ring, NULL = single rxPacket */
+#ifdef MODBUS_RTU_USE_POOL
+	uint8_t *rxDmaBuffer; /*! circular DMA buffer of the IDLE line receive mode, owned by the caller, NULL = none */
+	uint16_t rxDmaSize; /*! bytes of rxDmaBuffer */
+#else
+	uint8_t rxDmaBuffer[MODBUS_RTU_RX_DMA_BUFFER_SIZE] MODBUS_RTU_DMA_ALIGNED; /*! circular DMA buffer of the IDLE line receive mode */
+#endif
+#ifdef MODBUS_RTU_ENABLE_STATS
+	ModbusRTU_StatsT stats; /*! read with modbusRTUGetStats */
+	uint32_t statsTxEndCycles; /*! cycle counter at the end of the last sent frame */
+	uint32_t statsRxEndCycles; /*! cycle counter at the end of the last received frame */
+	volatile bool statsIsRttPending; /*! modbusRTUReciveData waits for a response */
+	volatile bool statsIsTurnaround; /*! a request arrived, the next frame sent is its reply */
+#endif
 } ModbusRTU_HandleT;
 
 /* Exported Variables --------------------------------------------------------*/
@@ -106,17 +406,92 @@ typedef struct _modbusClassHandller{
 
 
 /*!
- * @fn    void modbusRTUInit(ModbusRTU_HandleT *modbus, UART_HandleTypeDef *huart, TIM_HandleTypeDef *htim, uint8_t slaveId)
+ * @fn    void modbusRTUInit(ModbusRTU_HandleT *modbus, ModbusRTU_PortUartT *huart, ModbusRTU_PortTimerT *htim, uint8_t slaveId)
  * @brief Initialize the modBus RTU instance.
  *
  * @param modBus Pointer to the ModbusRTU instance.
- * @param huart Pointer to the UART handle.
- * @param htim Pointer to the timer handle.
+ * @param huart UART of the port (UART_HandleTypeDef on STM32).
+ * @param htim One shot timer of the port (TIM_HandleTypeDef on STM32).
  * @param slaveId The modBus slave ID.
  * @param baudRate The UART baud rate.
  */
-void modbusRTUInit(ModbusRTU_HandleT *modbus, UART_HandleTypeDef *huart,
-		TIM_HandleTypeDef *htim, uint8_t slaveId);
+void modbusRTUInit(ModbusRTU_HandleT *modbus, ModbusRTU_PortUartT *huart,
+		ModbusRTU_PortTimerT *htim, uint8_t slaveId);
+
+/*!
+ * @fn    void modbusRTUUpdateTimings(ModbusRTU_HandleT *modbus)
+ * @brief Recompute t1.5 and t3.5 from the current UART baud rate.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call again after changing the baud rate of huart.
+ */
+void modbusRTUUpdateTimings(ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSetLine(ModbusRTU_HandleT *modbus, uint32_t baudRate, uint8_t parity)
+ * @brief Switch the UART to another baud rate and parity between two frames.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param baudRate The new baud rate.
+ * @param parity MODBUS_RTU_PARITY_NONE (2 stop bits), _EVEN or _ODD.
+ * @return MODBUS_RTU_RX_BUSY while a frame is sent or received or a response
+ *         is awaited, MODBUS_RTU_ERROR_RX_FAILED when the port refused the
+ *         setting or the reception did not restart.
+ *
+ * @note : t1.5 and t3.5 follow the new baud rate. A frame that waits for
+ *         modbusRTUGetRxFrame stays, the reception goes on.
+ */
+ModbusRTU_ErrorT modbusRTUSetLine(ModbusRTU_HandleT *modbus, uint32_t baudRate,
+		uint8_t parity);
+
+/*!
+ * @fn    bool modbusRTUIsBusIdle(ModbusRTU_HandleT *modbus)
+ * @brief Check that the bus was silent for t3.5 and no response is pending.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return true when the next frame may be sent.
+ */
+bool modbusRTUIsBusIdle(ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    void modbusRTUSetLowPower(ModbusRTU_HandleT *modbus, bool isEnabled)
+ * @brief Sleep through the frames of other slaves and wake from STOP on a start bit.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param isEnabled true to mute the UART after the address of a foreign frame.
+ *
+ * @note : with the IT engine and the address filter (slave engine) the
+ *         first byte of a frame for another slave puts the UART in mute
+ *         mode, the rest of the frame raises no interrupt and the timer
+ *         stays stopped; the idle line before the next frame wakes it.
+ *         The DMA engine only wakes on the idle, half and full events.
+ */
+void modbusRTUSetLowPower(ModbusRTU_HandleT *modbus, bool isEnabled);
+
+/*!
+ * @fn    bool modbusRTUIsSleepAllowed(ModbusRTU_HandleT *modbus)
+ * @brief Check that the bus needs no clock until the next start bit.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return true when STOP may be entered: no timer, frame or transmission runs.
+ *
+ * @note : SLEEP (WFI) is always allowed. Check with the interrupts masked,
+ *         then enter STOP and unmask, so a start bit in between still wakes
+ *         the core; the clocks are restored before the UART is served.
+ */
+bool modbusRTUIsSleepAllowed(ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    void modbusRTUTimerCallback(ModbusRTU_HandleT *modbus)
+ * @brief htim one shot elapsed handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call from HAL_TIM_PeriodElapsedCallback() for the timer of this
+ *         instance. UART and timer IRQ must have the same priority.
+ */
+void modbusRTUTimerCallback(ModbusRTU_HandleT *modbus);
 
 /*!
  * @fn    ModbusRTU_ErrorT modbusRTUSendData(ModbusRTU_HandleT *modbus,uint8_t functionCode, uint8_t *data, size_t dataSize)
@@ -132,6 +507,92 @@ void modbusRTUInit(ModbusRTU_HandleT *modbus, UART_HandleTypeDef *huart,
 ModbusRTU_ErrorT modbusRTUSendData(ModbusRTU_HandleT *modbus,
 		uint8_t functionCode, uint8_t *data, size_t dataSize);
 
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSendDataDMA(ModbusRTU_HandleT *modbus,uint8_t functionCode, uint8_t *data, size_t dataSize)
+ * @brief Start sending a modBus RTU request with DMA and return immediately.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param functionCode The modBus function code (e.g., 0x03, 0x06).
+ * @param data Data to send to the device.
+ * @param dataSize Size of the data.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : completion is reported by txState and txCpltCallback.
+ */
+ModbusRTU_ErrorT modbusRTUSendDataDMA(ModbusRTU_HandleT *modbus,
+		uint8_t functionCode, uint8_t *data, size_t dataSize);
+
+/*!
+ * @fn    uint8_t* modbusRTUGetTxBuffer(ModbusRTU_HandleT *modbus)
+ * @brief Get the PDU data area of the TX frame to fill it in place.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return MODBUS_RTU_MAX_DATA_SIZE bytes after the function code, NULL while a DMA frame is on the wire
+ *         (or the pool has no full size block with MODBUS_RTU_USE_POOL).
+ */
+uint8_t* modbusRTUGetTxBuffer(ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    uint8_t* modbusRTUAllocTxBuffer(ModbusRTU_HandleT *modbus, size_t dataSize)
+ * @brief Get a PDU data area of at least dataSize bytes to fill it in place.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param dataSize PDU data bytes that will be committed.
+ * @return data area after the function code, NULL while a DMA frame is on
+ *         the wire or when the frame pool is exhausted.
+ *
+ * @note : with MODBUS_RTU_USE_POOL the frame takes the smallest block that
+ *         fits and returns it once sent, else this is modbusRTUGetTxBuffer.
+ */
+uint8_t* modbusRTUAllocTxBuffer(ModbusRTU_HandleT *modbus, size_t dataSize);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUCommitTx(ModbusRTU_HandleT *modbus, uint8_t functionCode, size_t dataSize)
+ * @brief Send the frame filled through modbusRTUGetTxBuffer (blocking).
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param functionCode The modBus function code (e.g., 0x03, 0x06).
+ * @param dataSize Bytes written to the TX buffer.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ */
+ModbusRTU_ErrorT modbusRTUCommitTx(ModbusRTU_HandleT *modbus,
+		uint8_t functionCode, size_t dataSize);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUCommitTxDMA(ModbusRTU_HandleT *modbus, uint8_t functionCode, size_t dataSize)
+ * @brief Start sending the frame filled through modbusRTUGetTxBuffer with DMA.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param functionCode The modBus function code (e.g., 0x03, 0x06).
+ * @param dataSize Bytes written to the TX buffer.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : completion is reported by txState and txCpltCallback.
+ */
+ModbusRTU_ErrorT modbusRTUCommitTxDMA(ModbusRTU_HandleT *modbus,
+		uint8_t functionCode, size_t dataSize);
+
+/*!
+ * @fn    void modbusRTUSetDePin(ModbusRTU_HandleT *modbus, ModbusRTU_PortGpioT *port, uint16_t pin)
+ * @brief Drive an RS485 DE/RE pin around every transmitted frame.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param port GPIO port of the DE/RE pin (NULL to disable).
+ * @param pin GPIO pin of the DE/RE pin.
+ */
+void modbusRTUSetDePin(ModbusRTU_HandleT *modbus, ModbusRTU_PortGpioT *port,
+		uint16_t pin);
+
+/*!
+ * @fn    void modbusRTUTxCpltCallback(ModbusRTU_HandleT *modbus)
+ * @brief UART transmit complete (TC) handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call from HAL_UART_TxCpltCallback() for the UART of this instance.
+ */
+void modbusRTUTxCpltCallback(ModbusRTU_HandleT *modbus);
+
 /*!
  * @fn 	  ModbusRTU_ErrorT modbusRTUReciveData(ModbusRTU_HandleT *modbus, size_t dataSize)
  * @brief Receive a modBus RTU response.
@@ -142,6 +603,18 @@ ModbusRTU_ErrorT modbusRTUSendData(ModbusRTU_HandleT *modbus,
  */
 ModbusRTU_ErrorT modbusRTUReciveData(ModbusRTU_HandleT *modbus, size_t dataSize);
 
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUListen(ModbusRTU_HandleT *modbus)
+ * @brief Wait for the next request frame of any length, without response timeout.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : slave side counterpart of modbusRTUReciveData, the frame ends
+ *         after t3.5 of silence (IT mode) or at the IDLE line (DMA mode).
+ */
+ModbusRTU_ErrorT modbusRTUListen(ModbusRTU_HandleT *modbus);
+
 /*!
  * @fn    ModbusRTU_ErrorT modbusRTUCheckRxState(ModbusRTU_HandleT *modbus, uint8_t *data,size_t dataSize)
  * @brief check state and validation of received data.
@@ -154,6 +627,164 @@ ModbusRTU_ErrorT modbusRTUReciveData(ModbusRTU_HandleT *modbus, size_t dataSize)
 ModbusRTU_ErrorT modbusRTUCheckRxState(ModbusRTU_HandleT *modbus, uint8_t *data,
 		size_t dataSize);
 
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUGetRxFrame(ModbusRTU_HandleT *modbus, ModbusRTU_FrameViewT *frame)
+ * @brief Validate the received frame and return a view into the RX buffer, no copy.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param frame Filled with the view on MODBUS_RTU_SUCCESS and MODBUS_RTU_ERROR_EXCEPTION.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the view stays valid (and the RX buffer owned) until
+ *         modbusRTUReleaseRxFrame or the next modbusRTUReciveData.
+ *         Invalid frames are released here.
+ */
+ModbusRTU_ErrorT modbusRTUGetRxFrame(ModbusRTU_HandleT *modbus,
+		ModbusRTU_FrameViewT *frame);
+
+/*!
+ * @fn    void modbusRTUReleaseRxFrame(ModbusRTU_HandleT *modbus)
+ * @brief Hand the RX buffer back to the receive engine.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ */
+void modbusRTUReleaseRxFrame(ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    bool modbusRTUIsRxFrameReady(ModbusRTU_HandleT *modbus)
+ * @brief Check that a received frame waits for modbusRTUGetRxFrame.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return true when a frame (valid or not) is waiting.
+ */
+bool modbusRTUIsRxFrameReady(ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    size_t modbusRTUPeekRxFrame(ModbusRTU_HandleT *modbus, const uint8_t **bytes)
+ * @brief Raw bytes of the waiting frame, as received.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param bytes Set to the first byte (address), the CRC included.
+ * @return received bytes, 0 when no frame waits.
+ *
+ * @note : the frame stays, modbusRTUGetRxFrame validates and releases it.
+ */
+size_t modbusRTUPeekRxFrame(ModbusRTU_HandleT *modbus, const uint8_t **bytes);
+
+/*!
+ * @fn    void modbusRTUSetRxQueue(ModbusRTU_HandleT *modbus, ModbusRTU_RxQueueT *queue)
+ * @brief Receive into a ring of frames instead of the single rxPacket.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param queue Frame ring owned by the caller (static), NULL for the single rxPacket.
+ *
+ * @note : call before the reception starts. Reception then never stops:
+ *         frames that arrive while earlier ones are still processed wait
+ *         in the ring, modbusRTUGetRxFrame returns the oldest and
+ *         modbusRTUReleaseRxFrame frees its slot.
+ */
+void modbusRTUSetRxQueue(ModbusRTU_HandleT *modbus, ModbusRTU_RxQueueT *queue);
+
+#ifdef MODBUS_RTU_USE_POOL
+/*!
+ * @fn    void modbusRTUSetRxDmaBuffer(ModbusRTU_HandleT *modbus, uint8_t *buffer, uint16_t size)
+ * @brief Give the circular DMA buffer of the IDLE line receive engine.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param buffer Buffer owned by the caller (static), MODBUS_RTU_DMA_ALIGNED,
+ *        in MODBUS_RTU_DMA_SECTION memory where the part needs it.
+ * @param size Bytes of buffer, a multiple of MODBUS_RTU_DMA_ALIGN
+ *        (MODBUS_RTU_RX_DMA_BUFFER_SIZE is a good start).
+ *
+ * @note : MODBUS_RTU_USE_POOL only, call after modbusRTUInit and before
+ *         modbusRTUStartReceiveToIdle. Buses on the interrupt engine need
+ *         none, so the ring costs RAM only where DMA receives.
+ */
+void modbusRTUSetRxDmaBuffer(ModbusRTU_HandleT *modbus, uint8_t *buffer,
+		uint16_t size);
+#endif
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUStartReceiveToIdle(ModbusRTU_HandleT *modbus)
+ * @brief Switch the instance to the circular DMA + IDLE line receive engine.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the UART RX DMA channel must be configured in circular mode.
+ *         Frames of any length (exception responses too) are delimited
+ *         without per byte interrupts, modbusRTUReciveData only drops a
+ *         stale frame in this mode. With MODBUS_RTU_USE_POOL it returns
+ *         MODBUS_RTU_ERROR_NO_BUFFER until modbusRTUSetRxDmaBuffer gave one.
+ */
+ModbusRTU_ErrorT modbusRTUStartReceiveToIdle(ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    void modbusRTURxEventCallback(ModbusRTU_HandleT *modbus, uint16_t size)
+ * @brief UART receive event (IDLE, DMA half/full) handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param size Position of the DMA in the circular buffer.
+ *
+ * @note : call from HAL_UARTEx_RxEventCallback() for the UART of this instance.
+ */
+void modbusRTURxEventCallback(ModbusRTU_HandleT *modbus, uint16_t size);
+
+/*!
+ * @fn    void modbusRTUFeedRxData(ModbusRTU_HandleT *modbus, size_t rxLength)
+ * @brief Accumulate the CRC of the bytes that arrived since the previous call.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param rxLength Total bytes now present in the receive buffer.
+ *
+ * @note : call from ISR context only (DMA half/full callbacks, RX ISR).
+ *         A frame past MODBUS_RTU_MAX_RX_SIZE is discarded, not CRC checked.
+ */
+void modbusRTUFeedRxData(ModbusRTU_HandleT *modbus, size_t rxLength);
+
+/*!
+ * @fn    void modbusRTURxCpltCallback(ModbusRTU_HandleT *modbus)
+ * @brief UART receive complete handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call from HAL_UART_RxCpltCallback() for the UART of this instance.
+ */
+void modbusRTURxCpltCallback(ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    void modbusRTUErrorCallback(ModbusRTU_HandleT *modbus)
+ * @brief UART parity, framing and noise error handler of the modBus RTU instance.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : call from HAL_UART_ErrorCallback() for the UART of this instance.
+ *         The frame the character belongs to is dropped, a stopped DMA
+ *         reception starts again.
+ */
+void modbusRTUErrorCallback(ModbusRTU_HandleT *modbus);
+
+#ifdef MODBUS_RTU_ENABLE_STATS
+/*!
+ * @fn    void modbusRTUGetStats(ModbusRTU_HandleT *modbus, ModbusRTU_StatsT *stats)
+ * @brief Take a consistent copy of the counters and timing of a bus.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ * @param stats Filled with the copy.
+ */
+void modbusRTUGetStats(ModbusRTU_HandleT *modbus, ModbusRTU_StatsT *stats);
+
+/*!
+ * @fn    void modbusRTUResetStats(ModbusRTU_HandleT *modbus)
+ * @brief Clear the counters, timing and histograms of a bus.
+ *
+ * @param modBus Pointer to the ModbusRTU instance.
+ *
+ * @note : also run by FC 0x08 sub functions 0x01 and 0x0A on a slave.
+ */
+void modbusRTUResetStats(ModbusRTU_HandleT *modbus);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,189 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUAutobaud.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU baud rate and parity detection.
+ ******************************************************************************
+ *
+ * This file provides the line detection. Frames are judged in the bus
+ * events (ISR context) as they end, the main loop only moves on to the
+ * next candidate after a dwell time without a valid frame. Every valid
+ * frame restarts the dwell, so a correct line with sparse traffic is kept
+ * until it locks; a bad frame only restarts the count to lockFrames.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+/* 3. Module Header File */
+#include <modBusRTUAutobaud.h>
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_AutobaudEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event);
+static ModbusRTU_ErrorT ModbusRTU_AutobaudSet(ModbusRTU_AutobaudT *autobaud,
+		uint8_t lineIndex);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUAutobaudStart(ModbusRTU_AutobaudT *autobaud, ModbusRTU_HandleT *modbus, const ModbusRTU_LineT *lines, uint8_t lineCount)
+ * @brief Listen on the first candidate, e.g. modbusRTUAutobaudStart(&autobaud, &modbus, MODBUS_RTU_AUTOBAUD_LINES(lines)).
+ *
+ * @param autobaud Pointer to the detection.
+ * @param modbus Pointer to the ModbusRTU instance (uses its eventCallback).
+ * @param lines Candidates, must stay valid while the detection runs.
+ * @param lineCount Entries of lines.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : before the slave engine or scheduler is attached. For the DMA
+ *         engine call modbusRTUStartReceiveToIdle first; the interrupt
+ *         engine also counts the frames its parity checks reject.
+ */
+ModbusRTU_ErrorT modbusRTUAutobaudStart(ModbusRTU_AutobaudT *autobaud,
+		ModbusRTU_HandleT *modbus, const ModbusRTU_LineT *lines,
+		uint8_t lineCount) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_ERROR_INVALID_FRAME;
+
+	autobaud->modbus = modbus;
+	autobaud->lines = lines;
+	autobaud->lineCount = lineCount;
+	autobaud->lineIndex = 0;
+	autobaud->lockFrames = MODBUS_RTU_AUTOBAUD_LOCK_FRAMES;
+	autobaud->validFrames = 0;
+	autobaud->dwellMs = MODBUS_RTU_AUTOBAUD_DWELL;
+	autobaud->frames = 0;
+	autobaud->badFrames = 0;
+	autobaud->isLocked = false;
+	autobaud->startMs = modbusRTUPortGetTickMs();
+
+	if ((NULL != lines) && (0 != lineCount)) {
+		/* every frame on the bus counts, whatever its address */
+		modbus->userContext = autobaud;
+		modbus->eventCallback = ModbusRTU_AutobaudEvent;
+		modbus->isPromiscuous = true;
+		result = ModbusRTU_AutobaudSet(autobaud, 0);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUAutobaudProcess(ModbusRTU_AutobaudT *autobaud)
+ * @brief Move to the next candidate once dwellMs passed without a valid frame on it.
+ *
+ * @param autobaud Pointer to the detection.
+ * @return MODBUS_RTU_SUCCESS once locked, MODBUS_RTU_RX_BUSY while searching.
+ *
+ * @note : call from the main loop. Once locked the handle is released:
+ *         no eventCallback, frames of other addresses are dropped again.
+ */
+ModbusRTU_ErrorT modbusRTUAutobaudProcess(ModbusRTU_AutobaudT *autobaud) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	uint32_t lock = modbusRTUPortEnterCritical();
+
+	if (true == autobaud->isLocked) {
+		result = MODBUS_RTU_SUCCESS;
+	} else if (modbusRTUPortGetTickMs() - autobaud->startMs
+			>= autobaud->dwellMs) {
+		/* dwellMs of silence since the last valid frame, e.g. one stray
+		 * frame and nothing after it; busy: a frame is on its way, the
+		 * candidate stays with its count and is tried on the next call */
+		ModbusRTU_AutobaudSet(autobaud,
+				(uint8_t) ((autobaud->lineIndex + 1) % autobaud->lineCount));
+	}
+	modbusRTUPortExitCritical(lock);
+
+	return result;
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_AutobaudEvent(ModbusRTU_HandleT *modbus, ModbusRTU_EventT event)
+ * @brief eventCallback of the bus: judge the frames of the candidate, lock on the right one.
+ *
+ * @param modbus Pointer to the ModbusRTU instance.
+ * @param event What happened.
+ */
+static void ModbusRTU_AutobaudEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event) {
+
+	/* local variable */
+	ModbusRTU_AutobaudT *autobaud = (ModbusRTU_AutobaudT*) modbus->userContext;
+	ModbusRTU_FrameViewT frame = { 0 };
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	bool isJudged = false;
+
+	(void) event;
+
+	while ((false == autobaud->isLocked)
+			&& (true == modbusRTUIsRxFrameReady(modbus))) {
+		isJudged = true;
+		result = modbusRTUGetRxFrame(modbus, &frame);
+		if ((MODBUS_RTU_SUCCESS == result)
+				|| (MODBUS_RTU_ERROR_EXCEPTION == result)) {
+			/* CRC over the whole frame, no parity or framing error */
+			modbusRTUReleaseRxFrame(modbus);
+			autobaud->frames++;
+			autobaud->validFrames++;
+			/* the dwell counts the silence since the last valid frame */
+			autobaud->startMs = modbusRTUPortGetTickMs();
+		} else {
+			/* already released by modbusRTUGetRxFrame */
+			autobaud->badFrames++;
+			autobaud->validFrames = 0;
+		}
+
+		if (autobaud->validFrames >= autobaud->lockFrames) {
+			autobaud->isLocked = true;
+			modbus->isPromiscuous = false;
+			modbus->eventCallback = NULL;
+			modbus->userContext = NULL;
+		}
+	}
+
+	if ((true == isJudged) && (false == autobaud->isLocked)) {
+		modbusRTUListen(modbus);
+	}
+}
+
+/*!
+ * @fn    static ModbusRTU_ErrorT ModbusRTU_AutobaudSet(ModbusRTU_AutobaudT *autobaud, uint8_t lineIndex)
+ * @brief Listen on a candidate.
+ *
+ * @param autobaud Pointer to the detection.
+ * @param lineIndex Entry of lines.
+ * @return result @ref modbusRTUSetLine, then @ref modbusRTUListen
+ */
+static ModbusRTU_ErrorT ModbusRTU_AutobaudSet(ModbusRTU_AutobaudT *autobaud,
+		uint8_t lineIndex) {
+
+	/* local variable */
+	const ModbusRTU_LineT *line = &autobaud->lines[lineIndex];
+	ModbusRTU_ErrorT result = modbusRTUSetLine(autobaud->modbus,
+			line->baudRate, line->parity);
+
+	if (MODBUS_RTU_SUCCESS == result) {
+		autobaud->lineIndex = lineIndex;
+		autobaud->validFrames = 0;
+		autobaud->startMs = modbusRTUPortGetTickMs();
+		result = modbusRTUListen(autobaud->modbus);
+	}
+
+	return result;
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -0,0 +1,123 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUAutobaud.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU baud rate and parity detection.
+ ******************************************************************************
+ *
+ * This file provides the line detection of a device that joins a bus of
+ * unknown settings. The bus listens to every frame on it, whatever its
+ * address, on one candidate baud rate / parity after the other. The CRC
+ * the receive ISR runs anyway and the parity and framing errors of the
+ * UART reject wrong candidates, a few valid frames in a row lock the
+ * right one. The line stays set, t1.5 / t3.5 follow it, and the slave
+ * engine or scheduler is started on the handle afterwards.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_AUTOBAUD_H
+#define MODBUS_RTU_AUTOBAUD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Valid frames in a row that lock a candidate */
+#ifndef MODBUS_RTU_AUTOBAUD_LOCK_FRAMES
+#define MODBUS_RTU_AUTOBAUD_LOCK_FRAMES 2
+#endif
+/*! @def Default ms without a valid frame before the next candidate */
+#ifndef MODBUS_RTU_AUTOBAUD_DWELL
+#define MODBUS_RTU_AUTOBAUD_DWELL 1000
+#endif
+/*! @def Candidate table of a constant array */
+#define MODBUS_RTU_AUTOBAUD_LINES(lines) \
+	(lines), (uint8_t) (sizeof(lines) / sizeof((lines)[0]))
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusLine
+ * @brief baud rate and parity of a bus.
+ */
+typedef struct _modbusLine{
+	uint32_t baudRate;
+	uint8_t parity; /*! MODBUS_RTU_PARITY_xxx */
+} ModbusRTU_LineT;
+
+/*!
+ * @typedef @struct  _modbusAutobaud
+ * @brief line detection of one bus.
+ */
+typedef struct _modbusAutobaud{
+	ModbusRTU_HandleT *modbus; /*! bus that listens */
+	const ModbusRTU_LineT *lines; /*! candidates, tried in turn */
+	uint8_t lineCount; /*! entries of lines */
+	volatile uint8_t lineIndex; /*! candidate listened to, the found line once locked */
+	uint8_t lockFrames; /*! valid frames in a row that lock, MODBUS_RTU_AUTOBAUD_LOCK_FRAMES by default */
+	volatile uint8_t validFrames; /*! valid frames in a row on lines[lineIndex] */
+	uint32_t dwellMs; /*! ms without a valid frame before the next candidate */
+	uint32_t startMs; /*! modbusRTUPortGetTickMs() the candidate was set or its last valid frame ended */
+	uint32_t frames; /*! valid frames on every candidate */
+	uint32_t badFrames; /*! frames with a CRC, parity or framing error */
+	volatile bool isLocked; /*! lines[lineIndex] is the line of the bus */
+} ModbusRTU_AutobaudT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUAutobaudStart(ModbusRTU_AutobaudT *autobaud, ModbusRTU_HandleT *modbus, const ModbusRTU_LineT *lines, uint8_t lineCount)
+ * @brief Listen on the first candidate, e.g. modbusRTUAutobaudStart(&autobaud, &modbus, MODBUS_RTU_AUTOBAUD_LINES(lines)).
+ *
+ * @param autobaud Pointer to the detection.
+ * @param modbus Pointer to the ModbusRTU instance (uses its eventCallback).
+ * @param lines Candidates, must stay valid while the detection runs.
+ * @param lineCount Entries of lines.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : before the slave engine or scheduler is attached. For the DMA
+ *         engine call modbusRTUStartReceiveToIdle first; the interrupt
+ *         engine also counts the frames its parity checks reject.
+ */
+ModbusRTU_ErrorT modbusRTUAutobaudStart(ModbusRTU_AutobaudT *autobaud,
+		ModbusRTU_HandleT *modbus, const ModbusRTU_LineT *lines,
+		uint8_t lineCount);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUAutobaudProcess(ModbusRTU_AutobaudT *autobaud)
+ * @brief Move to the next candidate once dwellMs passed without a valid frame on it.
+ *
+ * @param autobaud Pointer to the detection.
+ * @return MODBUS_RTU_SUCCESS once locked, MODBUS_RTU_RX_BUSY while searching.
+ *
+ * @note : call from the main loop. Once locked the handle is released:
+ *         no eventCallback, frames of other addresses are dropped again.
+ */
+ModbusRTU_ErrorT modbusRTUAutobaudProcess(ModbusRTU_AutobaudT *autobaud);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_AUTOBAUD_H
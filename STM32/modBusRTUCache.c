@@ -0,0 +1,340 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUCache.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU read response cache.
+ ******************************************************************************
+ *
+ * This file provides the response cache. Values are kept in blocks of
+ * MODBUS_RTU_CACHE_BLOCK_SIZE aligned coils or registers with one time
+ * stamp each: a response that refreshes part of a block forgets the older
+ * rest, so every cached value is exactly as old as its block.
+ *
+ ******************************************************************************
+ */
+
+#ifdef MODBUS_RTU_USE_CACHE
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUFrame.h"
+/* 3. Module Header File */
+#include <modBusRTUCache.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def First address of the block holding an address */
+#define MODBUS_RTU_CACHE_BASE(address) \
+	((uint16_t) ((address) & ~(MODBUS_RTU_CACHE_BLOCK_SIZE - 1)))
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+/* 2. Static Variables */
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static ModbusRTU_CacheBlockT* ModbusRTU_CacheFind(ModbusRTU_CacheT *cache,
+		uint8_t slaveId, uint8_t functionCode, uint16_t base);
+static ModbusRTU_CacheBlockT* ModbusRTU_CacheVictim(ModbusRTU_CacheT *cache);
+static uint32_t ModbusRTU_CacheTtl(const ModbusRTU_CacheT *cache,
+		uint8_t slaveId, uint8_t functionCode, uint16_t address);
+static bool ModbusRTU_IsBitFunction(uint8_t functionCode);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUCacheInit(ModbusRTU_CacheT *cache, uint32_t ttlMs)
+ * @brief Initialize an empty cache without TTL rules.
+ *
+ * @param cache Pointer to the cache.
+ * @param ttlMs TTL of every value.
+ */
+void modbusRTUCacheInit(ModbusRTU_CacheT *cache, uint32_t ttlMs) {
+	memset(cache, 0, sizeof(*cache));
+	cache->ttlMs = ttlMs;
+}
+
+/*!
+ * @fn    void modbusRTUCacheSetTtls(ModbusRTU_CacheT *cache, const ModbusRTU_CacheTtlT *ttls, uint8_t ttlCount)
+ * @brief Give ranges their own TTL, e.g. modbusRTUCacheSetTtls(&cache, MODBUS_RTU_CACHE_TTLS(rules)).
+ *
+ * @param cache Pointer to the cache.
+ * @param ttls Rules, must stay valid while the cache is used.
+ * @param ttlCount Entries of ttls.
+ */
+void modbusRTUCacheSetTtls(ModbusRTU_CacheT *cache,
+		const ModbusRTU_CacheTtlT *ttls, uint8_t ttlCount) {
+	cache->ttls = ttls;
+	cache->ttlCount = ttlCount;
+}
+
+/*!
+ * @fn    bool modbusRTUCacheRead(ModbusRTU_CacheT *cache, uint8_t slaveId, uint8_t functionCode, uint16_t address, uint16_t quantity, uint32_t nowMs, size_t *dataSize)
+ * @brief Look a read up, fill cache->data when every value is fresh.
+ *
+ * @param cache Pointer to the cache.
+ * @param slaveId The modBus slave ID.
+ * @param functionCode FC 0x01-0x04.
+ * @param address First coil/register.
+ * @param quantity Coils/registers.
+ * @param nowMs modbusRTUPortGetTickMs().
+ * @param dataSize Bytes of cache->data on a hit: big endian registers or packed bits.
+ * @return true on a hit.
+ */
+bool modbusRTUCacheRead(ModbusRTU_CacheT *cache, uint8_t slaveId,
+		uint8_t functionCode, uint16_t address, uint16_t quantity,
+		uint32_t nowMs, size_t *dataSize) {
+
+	/* local variable */
+	bool result = (quantity > 0);
+	bool isBits = ModbusRTU_IsBitFunction(functionCode);
+	size_t size = (true == isBits) ? (quantity + 7u) / 8u : 2u * quantity;
+	ModbusRTU_CacheBlockT *block = NULL;
+	uint32_t item = 0;
+	uint16_t value = 0;
+
+	if (size > sizeof(cache->data)) {
+		result = false;
+	} else if (true == isBits) {
+		memset(cache->data, 0, size);
+	}
+
+	for (uint32_t i = 0; (true == result) && (i < quantity); i++) {
+		item = (uint32_t) address + i;
+		if ((NULL == block) || (0 == (item % MODBUS_RTU_CACHE_BLOCK_SIZE))) {
+			block = ModbusRTU_CacheFind(cache, slaveId, functionCode,
+					MODBUS_RTU_CACHE_BASE(item));
+		}
+		if ((NULL == block)
+				|| (0 == (block->validMask
+						& (1u << (item % MODBUS_RTU_CACHE_BLOCK_SIZE))))
+				|| ((nowMs - block->stampMs)
+						> ModbusRTU_CacheTtl(cache, slaveId, functionCode,
+								(uint16_t) item))) {
+			result = false;
+		} else {
+			value = block->values[item % MODBUS_RTU_CACHE_BLOCK_SIZE];
+			if (true == isBits) {
+				cache->data[i / 8] |= (uint8_t) ((value & 0x01) << (i % 8));
+			} else {
+				modbusRTUPutU16(&cache->data[2 * i], value);
+			}
+		}
+	}
+
+	if (true == result) {
+		*dataSize = size;
+		cache->hits++;
+	} else {
+		cache->misses++;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    void modbusRTUCacheStore(ModbusRTU_CacheT *cache, uint8_t slaveId, uint8_t functionCode, uint16_t address, uint16_t quantity, const uint8_t *data, uint32_t nowMs)
+ * @brief Keep the values of a read response.
+ *
+ * @param cache Pointer to the cache.
+ * @param slaveId The modBus slave ID.
+ * @param functionCode FC 0x01-0x04.
+ * @param address First coil/register.
+ * @param quantity Coils/registers.
+ * @param data Response values after the byte count.
+ * @param nowMs modbusRTUPortGetTickMs() of the response.
+ */
+void modbusRTUCacheStore(ModbusRTU_CacheT *cache, uint8_t slaveId,
+		uint8_t functionCode, uint16_t address, uint16_t quantity,
+		const uint8_t *data, uint32_t nowMs) {
+
+	/* local variable */
+	bool isBits = ModbusRTU_IsBitFunction(functionCode);
+	ModbusRTU_CacheBlockT *block = NULL;
+	uint32_t item = 0;
+	uint16_t base = 0;
+
+	for (uint32_t i = 0; i < quantity; i++) {
+		item = (uint32_t) address + i;
+		if ((NULL == block) || (0 == (item % MODBUS_RTU_CACHE_BLOCK_SIZE))) {
+			base = MODBUS_RTU_CACHE_BASE(item);
+			block = ModbusRTU_CacheFind(cache, slaveId, functionCode, base);
+			if (NULL == block) {
+				block = ModbusRTU_CacheVictim(cache);
+				block->slaveId = slaveId;
+				block->functionCode = functionCode;
+				block->address = base;
+				block->validMask = 0;
+			} else if (nowMs != block->stampMs) {
+				/* one time stamp per block: forget the older values */
+				block->validMask = 0;
+			}
+			block->stampMs = nowMs;
+		}
+
+		if (true == isBits) {
+			block->values[item % MODBUS_RTU_CACHE_BLOCK_SIZE] = (data[i / 8]
+					>> (i % 8)) & 0x01;
+		} else {
+			block->values[item % MODBUS_RTU_CACHE_BLOCK_SIZE] = modbusRTUGetU16(
+					&data[2 * i]);
+		}
+		block->validMask |= (uint16_t) (1u << (item % MODBUS_RTU_CACHE_BLOCK_SIZE));
+	}
+}
+
+/*!
+ * @fn    void modbusRTUCacheInvalidate(ModbusRTU_CacheT *cache, uint8_t slaveId, uint8_t functionCode, uint16_t address, uint16_t quantity)
+ * @brief Drop cached values.
+ *
+ * @param cache Pointer to the cache.
+ * @param slaveId The modBus slave ID, MODBUS_RTU_BROADCAST_ID drops them on every slave.
+ * @param functionCode Read function of the values, FC 0x01-0x04.
+ * @param address First coil/register.
+ * @param quantity Coils/registers.
+ */
+void modbusRTUCacheInvalidate(ModbusRTU_CacheT *cache, uint8_t slaveId,
+		uint8_t functionCode, uint16_t address, uint16_t quantity) {
+
+	/* local variable */
+	ModbusRTU_CacheBlockT *block = NULL;
+	uint32_t start = address, end = (uint32_t) address + quantity;
+	uint32_t first = 0, last = 0;
+
+	for (uint8_t i = 0; i < MODBUS_RTU_CACHE_BLOCKS; i++) {
+		block = &cache->blocks[i];
+		if ((0 != block->validMask) && (functionCode == block->functionCode)
+				&& ((MODBUS_RTU_BROADCAST_ID == slaveId)
+						|| (slaveId == block->slaveId))
+				&& (start < (uint32_t) block->address + MODBUS_RTU_CACHE_BLOCK_SIZE)
+				&& (end > block->address)) {
+			first = (start > block->address) ? start - block->address : 0;
+			last = (end < (uint32_t) block->address + MODBUS_RTU_CACHE_BLOCK_SIZE) ?
+					end - block->address : MODBUS_RTU_CACHE_BLOCK_SIZE;
+			for (uint32_t j = first; j < last; j++) {
+				block->validMask &= (uint16_t) ~(1u << j);
+			}
+		}
+	}
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static ModbusRTU_CacheBlockT* ModbusRTU_CacheFind(ModbusRTU_CacheT *cache, uint8_t slaveId, uint8_t functionCode, uint16_t base)
+ * @brief Find the block of a slave, function and first address.
+ *
+ * @param cache Pointer to the cache.
+ * @param slaveId The modBus slave ID.
+ * @param functionCode FC 0x01-0x04.
+ * @param base First address of the block.
+ * @return the block, NULL when not cached.
+ */
+static ModbusRTU_CacheBlockT* ModbusRTU_CacheFind(ModbusRTU_CacheT *cache,
+		uint8_t slaveId, uint8_t functionCode, uint16_t base) {
+
+	/* local variable */
+	ModbusRTU_CacheBlockT *result = NULL;
+
+	for (uint8_t i = 0; (i < MODBUS_RTU_CACHE_BLOCKS) && (NULL == result); i++) {
+		if ((0 != cache->blocks[i].validMask)
+				&& (slaveId == cache->blocks[i].slaveId)
+				&& (functionCode == cache->blocks[i].functionCode)
+				&& (base == cache->blocks[i].address)) {
+			result = &cache->blocks[i];
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static ModbusRTU_CacheBlockT* ModbusRTU_CacheVictim(ModbusRTU_CacheT *cache)
+ * @brief Pick the block to reuse: a free one, else the oldest.
+ *
+ * @param cache Pointer to the cache.
+ * @return the block.
+ */
+static ModbusRTU_CacheBlockT* ModbusRTU_CacheVictim(ModbusRTU_CacheT *cache) {
+
+	/* local variable */
+	ModbusRTU_CacheBlockT *result = &cache->blocks[0];
+
+	for (uint8_t i = 0; (i < MODBUS_RTU_CACHE_BLOCKS)
+			&& (0 != result->validMask); i++) {
+		if ((0 == cache->blocks[i].validMask)
+				|| ((int32_t) (cache->blocks[i].stampMs - result->stampMs) < 0)) {
+			result = &cache->blocks[i];
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint32_t ModbusRTU_CacheTtl(const ModbusRTU_CacheT *cache, uint8_t slaveId, uint8_t functionCode, uint16_t address)
+ * @brief TTL of one value: the first matching rule, else the default.
+ *
+ * @param cache Pointer to the cache.
+ * @param slaveId The modBus slave ID.
+ * @param functionCode FC 0x01-0x04.
+ * @param address The coil/register.
+ * @return TTL in milliseconds.
+ */
+static uint32_t ModbusRTU_CacheTtl(const ModbusRTU_CacheT *cache,
+		uint8_t slaveId, uint8_t functionCode, uint16_t address) {
+
+	/* local variable */
+	uint32_t result = cache->ttlMs;
+	const ModbusRTU_CacheTtlT *rule = NULL;
+
+	for (uint8_t i = 0; i < cache->ttlCount; i++) {
+		rule = &cache->ttls[i];
+		if (((0 == rule->slaveId) || (slaveId == rule->slaveId))
+				&& ((0 == rule->functionCode)
+						|| (functionCode == rule->functionCode))
+				&& (address >= rule->address)
+				&& ((uint32_t) address < (uint32_t) rule->address + rule->quantity)) {
+			result = rule->ttlMs;
+			break;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static bool ModbusRTU_IsBitFunction(uint8_t functionCode)
+ * @brief Check for a coil/discrete input read.
+ *
+ * @param functionCode The modBus function code.
+ * @return true for FC 0x01/0x02.
+ */
+static bool ModbusRTU_IsBitFunction(uint8_t functionCode) {
+	return (MODBUS_FUNC_READ_COILS == functionCode)
+			|| (MODBUS_FUNC_READ_DISCRETE_INPUTS == functionCode);
+}
+
+#endif // MODBUS_RTU_USE_CACHE
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -0,0 +1,173 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUCache.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU read response cache.
+ ******************************************************************************
+ *
+ * This file provides a read-through cache of coil and register values,
+ * keyed by slave ID, read function code and address. A scheduler with a
+ * cache answers due reads whose every value is younger than its TTL
+ * without a bus transaction, fills the cache from every read response and
+ * drops the values its own writes change. Requests waiting behind a read
+ * of the same range are therefore answered from that one transaction.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_CACHE_H
+#define MODBUS_RTU_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef MODBUS_RTU_USE_CACHE
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Blocks of one cache */
+#ifndef MODBUS_RTU_CACHE_BLOCKS
+#define MODBUS_RTU_CACHE_BLOCKS 16
+#endif
+/*! @def Coils or registers of one block, aligned on their address */
+#define MODBUS_RTU_CACHE_BLOCK_SIZE 16
+/*! @def TTL table of a cache from a constant array */
+#define MODBUS_RTU_CACHE_TTLS(rules) \
+	(rules), (uint8_t) (sizeof(rules) / sizeof((rules)[0]))
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusCacheTtl
+ * @brief TTL of a range of values, the first matching rule wins.
+ */
+typedef struct _modbusCacheTtl{
+	uint8_t slaveId; /*! 0 = every slave */
+	uint8_t functionCode; /*! read function MODBUS_FUNC_READ_xxx, 0 = every one */
+	uint16_t address; /*! first coil/register */
+	uint16_t quantity; /*! coils/registers */
+	uint32_t ttlMs; /*! age a value may have, 0 = only the transaction it came with */
+} ModbusRTU_CacheTtlT;
+
+/*!
+ * @typedef @struct  _modbusCacheBlock
+ * @brief values of one slave and read function, sampled at one time.
+ */
+typedef struct _modbusCacheBlock{
+	uint8_t slaveId;
+	uint8_t functionCode; /*! MODBUS_FUNC_READ_xxx */
+	uint16_t address; /*! first coil/register, multiple of MODBUS_RTU_CACHE_BLOCK_SIZE */
+	uint16_t validMask; /*! bit n: values[n] is cached, 0 = free block */
+	uint32_t stampMs; /*! modbusRTUPortGetTickMs() of the response */
+	uint16_t values[MODBUS_RTU_CACHE_BLOCK_SIZE]; /*! registers, or 0/1 per coil */
+} ModbusRTU_CacheBlockT;
+
+/*!
+ * @typedef @struct  _modbusCache
+ * @brief response cache of one scheduler.
+ */
+typedef struct _modbusCache{
+	ModbusRTU_CacheBlockT blocks[MODBUS_RTU_CACHE_BLOCKS];
+	uint32_t ttlMs; /*! TTL of values no rule matches */
+	const ModbusRTU_CacheTtlT *ttls; /*! optional TTL rules */
+	uint8_t ttlCount; /*! entries of ttls */
+	uint32_t hits; /*! reads answered from the cache */
+	uint32_t misses; /*! reads that went to the bus */
+	uint8_t data[MODBUS_RTU_MAX_DATA_SIZE]; /*! PDU values of the last hit */
+} ModbusRTU_CacheT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUCacheInit(ModbusRTU_CacheT *cache, uint32_t ttlMs)
+ * @brief Initialize an empty cache without TTL rules.
+ *
+ * @param cache Pointer to the cache.
+ * @param ttlMs TTL of every value.
+ */
+void modbusRTUCacheInit(ModbusRTU_CacheT *cache, uint32_t ttlMs);
+
+/*!
+ * @fn    void modbusRTUCacheSetTtls(ModbusRTU_CacheT *cache, const ModbusRTU_CacheTtlT *ttls, uint8_t ttlCount)
+ * @brief Give ranges their own TTL, e.g. modbusRTUCacheSetTtls(&cache, MODBUS_RTU_CACHE_TTLS(rules)).
+ *
+ * @param cache Pointer to the cache.
+ * @param ttls Rules, must stay valid while the cache is used.
+ * @param ttlCount Entries of ttls.
+ */
+void modbusRTUCacheSetTtls(ModbusRTU_CacheT *cache,
+		const ModbusRTU_CacheTtlT *ttls, uint8_t ttlCount);
+
+/*!
+ * @fn    bool modbusRTUCacheRead(ModbusRTU_CacheT *cache, uint8_t slaveId, uint8_t functionCode, uint16_t address, uint16_t quantity, uint32_t nowMs, size_t *dataSize)
+ * @brief Look a read up, fill cache->data when every value is fresh.
+ *
+ * @param cache Pointer to the cache.
+ * @param slaveId The modBus slave ID.
+ * @param functionCode FC 0x01-0x04.
+ * @param address First coil/register.
+ * @param quantity Coils/registers.
+ * @param nowMs modbusRTUPortGetTickMs().
+ * @param dataSize Bytes of cache->data on a hit: big endian registers or packed bits.
+ * @return true on a hit.
+ */
+bool modbusRTUCacheRead(ModbusRTU_CacheT *cache, uint8_t slaveId,
+		uint8_t functionCode, uint16_t address, uint16_t quantity,
+		uint32_t nowMs, size_t *dataSize);
+
+/*!
+ * @fn    void modbusRTUCacheStore(ModbusRTU_CacheT *cache, uint8_t slaveId, uint8_t functionCode, uint16_t address, uint16_t quantity, const uint8_t *data, uint32_t nowMs)
+ * @brief Keep the values of a read response.
+ *
+ * @param cache Pointer to the cache.
+ * @param slaveId The modBus slave ID.
+ * @param functionCode FC 0x01-0x04.
+ * @param address First coil/register.
+ * @param quantity Coils/registers.
+ * @param data Response values after the byte count.
+ * @param nowMs modbusRTUPortGetTickMs() of the response.
+ */
+void modbusRTUCacheStore(ModbusRTU_CacheT *cache, uint8_t slaveId,
+		uint8_t functionCode, uint16_t address, uint16_t quantity,
+		const uint8_t *data, uint32_t nowMs);
+
+/*!
+ * @fn    void modbusRTUCacheInvalidate(ModbusRTU_CacheT *cache, uint8_t slaveId, uint8_t functionCode, uint16_t address, uint16_t quantity)
+ * @brief Drop cached values.
+ *
+ * @param cache Pointer to the cache.
+ * @param slaveId The modBus slave ID, MODBUS_RTU_BROADCAST_ID drops them on every slave.
+ * @param functionCode Read function of the values, FC 0x01-0x04.
+ * @param address First coil/register.
+ * @param quantity Coils/registers.
+ */
+void modbusRTUCacheInvalidate(ModbusRTU_CacheT *cache, uint8_t slaveId,
+		uint8_t functionCode, uint16_t address, uint16_t quantity);
+
+#endif // MODBUS_RTU_USE_CACHE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_CACHE_H
@@ -0,0 +1,324 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUCrc.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU CRC-16 backends.
+ ******************************************************************************
+ *
+ * This file provides the bitwise, table, nibble and hardware CRC-16
+ * implementations. The backend is selected at compile time with
+ * MODBUS_RTU_CRC_BACKEND.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+/* 3. Module Header File */
+#include <modBusRTUCrc.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Polynomial for modBus RTU (reflected 0x8005) */
+#define MODBUS_RTU_CRC_POLY 0xA001
+
+/*! @def Which tables have to be linked in */
+#if (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_TABLE) || defined(MODBUS_RTU_CRC_BENCHMARK)
+#define MODBUS_RTU_CRC_NEED_TABLE
+#endif
+#if (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_NIBBLE) \
+	|| ((MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_HARDWARE) \
+		&& !(defined(CRC_CR_REV_IN) && defined(CRC_CR_POLYSIZE_0))) \
+	|| defined(MODBUS_RTU_CRC_BENCHMARK)
+#define MODBUS_RTU_CRC_NEED_NIBBLE
+#endif
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+/* 2. Static Variables */
+
+#ifdef MODBUS_RTU_CRC_NEED_TABLE
+/*! @var @brief CRC of every byte value, one step of 8 bits */
+static const uint16_t crcTable[256] = {
+	0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+	0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+	0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+	0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+	0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+	0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+	0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+	0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+	0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+	0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+	0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+	0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+	0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+	0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+	0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+	0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+	0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+	0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+	0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+	0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+	0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+	0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+	0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+	0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+	0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+	0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+	0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+	0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+	0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+	0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+	0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+	0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+#endif
+
+#ifdef MODBUS_RTU_CRC_NEED_NIBBLE
+/*! @var @brief CRC of every nibble value, one step of 4 bits */
+static const uint16_t crcNibbleTable[16] = {
+	0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+	0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+};
+#endif
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+#if (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_BITWISE) || defined(MODBUS_RTU_CRC_BENCHMARK)
+static uint16_t ModbusRTU_CrcBitwise(uint16_t crc, const uint8_t *data,
+		size_t length);
+#endif
+#ifdef MODBUS_RTU_CRC_NEED_TABLE
+static uint16_t ModbusRTU_CrcTable(uint16_t crc, const uint8_t *data,
+		size_t length);
+#endif
+#ifdef MODBUS_RTU_CRC_NEED_NIBBLE
+static uint16_t ModbusRTU_CrcNibble(uint16_t crc, const uint8_t *data,
+		size_t length);
+#endif
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    uint16_t modbusRTUCrcUpdate(uint16_t crc, const uint8_t *data, size_t length)
+ * @brief Continue a modBus RTU CRC-16 with the selected backend.
+ *
+ * @param crc CRC value of the previous bytes (@ref modbusRTUCrcInit to start).
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The updated CRC-16 value.
+ *
+ * @note : safe to call from the UART RX ISR or the DMA half/full callbacks
+ *         with the bytes received since the previous call. The software
+ *         backends keep their state in crc only; the hardware backend
+ *         shares one CRC unit and locks it, see modbusRTUHardwareCrcUpdate.
+ */
+uint16_t modbusRTUCrcUpdate(uint16_t crc, const uint8_t *data, size_t length) {
+#if (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_BITWISE)
+	return ModbusRTU_CrcBitwise(crc, data, length);
+#elif (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_TABLE)
+	return ModbusRTU_CrcTable(crc, data, length);
+#elif (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_NIBBLE)
+	return ModbusRTU_CrcNibble(crc, data, length);
+#elif (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_HARDWARE)
+	return modbusRTUHardwareCrcUpdate(crc, data, length);
+#else
+#error "modBusRTUCrc: unknown MODBUS_RTU_CRC_BACKEND"
+#endif
+}
+
+/*!
+ * @fn    uint16_t modbusRTUCalculateCRC(const uint8_t *data, size_t length)
+ * @brief Calculate the modBus RTU CRC-16 with the selected backend.
+ *
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The calculated CRC-16 value.
+ */
+uint16_t modbusRTUCalculateCRC(const uint8_t *data, size_t length) {
+	return modbusRTUCrcFinal(
+			modbusRTUCrcUpdate(modbusRTUCrcInit(), data, length));
+}
+
+/*!
+ * @fn    uint16_t modbusRTUHardwareCrcUpdate(uint16_t crc, const uint8_t *data, size_t length)
+ * @brief Continue a modBus RTU CRC-16 on the MCU hardware CRC unit.
+ *
+ * @param crc CRC value of the previous bytes (MODBUS_RTU_CRC_INIT to start).
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The updated CRC-16 value.
+ *
+ * @note : weak function. The default drives the programmable CRC unit
+ *         (F0/F3/F7/G0/G4/L4/H7) and falls back to the nibble table on parts
+ *         with a fixed CRC-32 unit (F1/F2/F4). The CRC clock must be enabled
+ *         by the application. The unit keeps POL, CR, INIT and DR across
+ *         calls while the RX ISR and the main loop of every bus use it, so
+ *         one run holds the critical section of the port: interrupts wait
+ *         up to one byte write per data byte (256 for a full frame).
+ */
+#if (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_HARDWARE) || defined(MODBUS_RTU_CRC_BENCHMARK)
+__weak uint16_t modbusRTUHardwareCrcUpdate(uint16_t crc, const uint8_t *data,
+		size_t length) {
+#if defined(CRC_CR_REV_IN) && defined(CRC_CR_POLYSIZE_0)
+	/* local variable */
+	uint32_t lock = 0;
+	uint16_t result = 0;
+
+	/* a CRC of the RX ISR must not land between INIT and the DR read */
+	lock = modbusRTUPortEnterCritical();
+
+	/* 16 bit polynomial 0x8005, input reversed by byte, output reversed,
+	 * so the unit computes the reflected modBus CRC directly */
+	CRC->POL = 0x8005;
+	CRC->CR = CRC_CR_POLYSIZE_0 | CRC_CR_REV_IN_0 | CRC_CR_REV_OUT;
+	/* the unit works on the non-reflected state: reverse the running CRC back */
+	CRC->INIT = __RBIT((uint32_t) crc) >> 16;
+	CRC->CR |= CRC_CR_RESET;
+
+	for (size_t i = 0; i < length; i++) {
+		*(__IO uint8_t*) &CRC->DR = data[i];
+	}
+
+	result = (uint16_t) CRC->DR;
+	modbusRTUPortExitCritical(lock);
+
+	return result;
+#else
+	/* fixed CRC-32 unit can not compute CRC-16/MODBUS */
+	return ModbusRTU_CrcNibble(crc, data, length);
+#endif
+}
+#endif
+
+#ifdef MODBUS_RTU_CRC_BENCHMARK
+/*!
+ * @fn    void modbusRTUCrcBenchmark(ModbusRTU_CrcBenchmarkT *results, size_t length)
+ * @brief Measure every CRC backend with the DWT cycle counter.
+ *
+ * @param results Array of MODBUS_RTU_CRC_BACKEND_COUNT results, indexed by backend.
+ * @param length Frame length to benchmark (up to MODBUS_RTU_MAX_FRAME_SIZE).
+ */
+void modbusRTUCrcBenchmark(ModbusRTU_CrcBenchmarkT *results, size_t length) {
+
+	/* local variable */
+	static uint8_t frame[MODBUS_RTU_MAX_FRAME_SIZE];
+	uint16_t (*const backend[MODBUS_RTU_CRC_BACKEND_COUNT])(uint16_t,
+			const uint8_t*, size_t) = { ModbusRTU_CrcBitwise,
+			ModbusRTU_CrcTable, ModbusRTU_CrcNibble, modbusRTUHardwareCrcUpdate };
+	volatile uint16_t sink = 0;
+	uint32_t start = 0;
+
+	if (length > MODBUS_RTU_MAX_FRAME_SIZE) {
+		length = MODBUS_RTU_MAX_FRAME_SIZE;
+	}
+
+	/* pseudo random payload, the CRC cost does not depend on the content */
+	for (size_t i = 0; i < length; i++) {
+		frame[i] = (uint8_t) (i * 37u + 11u);
+	}
+
+	/* enable the cycle counter */
+	modbusRTUPortCyclesInit();
+
+	for (uint8_t i = 0; i < MODBUS_RTU_CRC_BACKEND_COUNT; i++) {
+		start = modbusRTUPortCycles();
+		sink = backend[i](MODBUS_RTU_CRC_INIT, frame, length);
+		results[i].cycles = modbusRTUPortCycles() - start;
+		results[i].cyclesPerByteX100 =
+				(0 != length) ? (results[i].cycles * 100u) / length : 0;
+	}
+
+	(void) sink;
+}
+#endif
+
+/* 3. Local Function Declarations */
+
+#if (MODBUS_RTU_CRC_BACKEND == MODBUS_RTU_CRC_BACKEND_BITWISE) || defined(MODBUS_RTU_CRC_BENCHMARK)
+/*!
+ * @fn    static uint16_t ModbusRTU_CrcBitwise(uint16_t crc, const uint8_t *data, size_t length)
+ * @brief Bitwise CRC-16, 8 shift/XOR iterations per byte.
+ *
+ * @param crc CRC value of the previous bytes.
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The updated CRC-16 value.
+ */
+static uint16_t ModbusRTU_CrcBitwise(uint16_t crc, const uint8_t *data,
+		size_t length) {
+
+	for (size_t i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (uint8_t j = 0; j < 8; j++) {
+			if (crc & 0x0001) {
+				crc >>= 1;
+				crc ^= MODBUS_RTU_CRC_POLY;
+			} else {
+				crc >>= 1;
+			}
+		}
+	}
+
+	return crc;
+}
+#endif
+
+#ifdef MODBUS_RTU_CRC_NEED_TABLE
+/*!
+ * @fn    static uint16_t ModbusRTU_CrcTable(uint16_t crc, const uint8_t *data, size_t length)
+ * @brief Table driven CRC-16, one lookup per byte.
+ *
+ * @param crc CRC value of the previous bytes.
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The updated CRC-16 value.
+ */
+static uint16_t ModbusRTU_CrcTable(uint16_t crc, const uint8_t *data,
+		size_t length) {
+
+	for (size_t i = 0; i < length; i++) {
+		crc = (crc >> 8) ^ crcTable[(crc ^ data[i]) & 0xFF];
+	}
+
+	return crc;
+}
+#endif
+
+#ifdef MODBUS_RTU_CRC_NEED_NIBBLE
+/*!
+ * @fn    static uint16_t ModbusRTU_CrcNibble(uint16_t crc, const uint8_t *data, size_t length)
+ * @brief Nibble table CRC-16, two lookups per byte for flash constrained parts.
+ *
+ * @param crc CRC value of the previous bytes.
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The updated CRC-16 value.
+ */
+static uint16_t ModbusRTU_CrcNibble(uint16_t crc, const uint8_t *data,
+		size_t length) {
+
+	for (size_t i = 0; i < length; i++) {
+		crc ^= data[i];
+		crc = (crc >> 4) ^ crcNibbleTable[crc & 0x0F];
+		crc = (crc >> 4) ^ crcNibbleTable[crc & 0x0F];
+	}
+
+	return crc;
+}
+#endif
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
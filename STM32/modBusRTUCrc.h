@@ -0,0 +1,158 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUCrc.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU CRC-16 backends.
+ ******************************************************************************
+ *
+ * This file provides the selectable CRC-16 (poly 0xA001, init 0xFFFF)
+ * backends used by the modBus RTU library: bitwise, 256-entry table,
+ * 16-entry nibble table and the MCU hardware CRC unit.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_CRC_H
+#define MODBUS_RTU_CRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stddef.h>
+/* 2. Project Header Files */
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @defgroup CRC backends */
+#define MODBUS_RTU_CRC_BACKEND_BITWISE 0  /* 8 shift/XOR per byte, no table */
+#define MODBUS_RTU_CRC_BACKEND_TABLE 1    /* 256 x 16 bit table (512 byte flash) */
+#define MODBUS_RTU_CRC_BACKEND_NIBBLE 2   /* 16 x 16 bit table (32 byte flash) */
+#define MODBUS_RTU_CRC_BACKEND_HARDWARE 3 /* MCU CRC unit, see modbusRTUHardwareCrcUpdate */
+#define MODBUS_RTU_CRC_BACKEND_COUNT 4
+
+/*! @def Selected CRC backend (override from the compiler command line) */
+#ifndef MODBUS_RTU_CRC_BACKEND
+#define MODBUS_RTU_CRC_BACKEND MODBUS_RTU_CRC_BACKEND_TABLE
+#endif
+
+/*! @def Initial CRC value of modBus RTU */
+#define MODBUS_RTU_CRC_INIT 0xFFFF
+/*! @def CRC over a whole frame including its own (low byte first) CRC */
+#define MODBUS_RTU_CRC_RESIDUE 0x0000
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+#ifdef MODBUS_RTU_CRC_BENCHMARK
+/*!
+ * @typedef @struct  _modbusCrcBenchmark
+ * @brief result of one CRC backend benchmark run.
+ */
+typedef struct _modbusCrcBenchmark{
+	uint32_t cycles; /*! total DWT cycles for the run */
+	uint32_t cyclesPerByteX100; /*! cycles per byte, scaled by 100 */
+} ModbusRTU_CrcBenchmarkT;
+#endif
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    uint16_t modbusRTUCrcUpdate(uint16_t crc, const uint8_t *data, size_t length)
+ * @brief Continue a modBus RTU CRC-16 with the selected backend.
+ *
+ * @param crc CRC value of the previous bytes (@ref modbusRTUCrcInit to start).
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The updated CRC-16 value.
+ *
+ * @note : safe to call from the UART RX ISR or the DMA half/full callbacks
+ *         with the bytes received since the previous call. The software
+ *         backends keep their state in crc only; the hardware backend
+ *         shares one CRC unit and locks it, see modbusRTUHardwareCrcUpdate.
+ */
+uint16_t modbusRTUCrcUpdate(uint16_t crc, const uint8_t *data, size_t length);
+
+/*!
+ * @fn    static inline uint16_t modbusRTUCrcInit(void)
+ * @brief Start a streaming modBus RTU CRC-16.
+ *
+ * @return The initial CRC-16 value.
+ */
+static inline uint16_t modbusRTUCrcInit(void) {
+	return MODBUS_RTU_CRC_INIT;
+}
+
+/*!
+ * @fn    static inline uint16_t modbusRTUCrcFinal(uint16_t crc)
+ * @brief Finish a streaming modBus RTU CRC-16.
+ *
+ * @param crc CRC value of all bytes.
+ * @return The CRC-16 value to append (low byte first) or compare.
+ *
+ * @note : modBus RTU has no final XOR, fed with a whole frame including its
+ *         CRC the result is MODBUS_RTU_CRC_RESIDUE.
+ */
+static inline uint16_t modbusRTUCrcFinal(uint16_t crc) {
+	return crc;
+}
+
+/*!
+ * @fn    uint16_t modbusRTUCalculateCRC(const uint8_t *data, size_t length)
+ * @brief Calculate the modBus RTU CRC-16 with the selected backend.
+ *
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The calculated CRC-16 value.
+ */
+uint16_t modbusRTUCalculateCRC(const uint8_t *data, size_t length);
+
+/*!
+ * @fn    uint16_t modbusRTUHardwareCrcUpdate(uint16_t crc, const uint8_t *data, size_t length)
+ * @brief Continue a modBus RTU CRC-16 on the MCU hardware CRC unit.
+ *
+ * @param crc CRC value of the previous bytes (MODBUS_RTU_CRC_INIT to start).
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data.
+ * @return The updated CRC-16 value.
+ *
+ * @note : weak function. The default drives the programmable CRC unit
+ *         (F0/F3/F7/G0/G4/L4/H7) and falls back to the nibble table on parts
+ *         with a fixed CRC-32 unit (F1/F2/F4). The CRC clock must be enabled
+ *         by the application. The unit keeps POL, CR, INIT and DR across
+ *         calls while the RX ISR and the main loop of every bus use it, so
+ *         one run holds the critical section of the port: interrupts wait
+ *         up to one byte write per data byte (256 for a full frame).
+ */
+uint16_t modbusRTUHardwareCrcUpdate(uint16_t crc, const uint8_t *data,
+		size_t length);
+
+#ifdef MODBUS_RTU_CRC_BENCHMARK
+/*!
+ * @fn    void modbusRTUCrcBenchmark(ModbusRTU_CrcBenchmarkT *results, size_t length)
+ * @brief Measure every CRC backend with the DWT cycle counter.
+ *
+ * @param results Array of MODBUS_RTU_CRC_BACKEND_COUNT results, indexed by backend.
+ * @param length Frame length to benchmark (up to MODBUS_RTU_MAX_FRAME_SIZE).
+ */
+void modbusRTUCrcBenchmark(ModbusRTU_CrcBenchmarkT *results, size_t length);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_CRC_H
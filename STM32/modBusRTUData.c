@@ -0,0 +1,347 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUData.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU register and coil data helpers.
+ ******************************************************************************
+ *
+ * This file provides the wire <-> host conversions of registers and coils
+ * used by the slave engine, the frame builders and the application.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTUPort.h"
+/* 3. Module Header File */
+#include <modBusRTUData.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @defgroup SWAR multipliers, 4 coils per 32 bit multiply */
+#define MODBUS_RTU_PACK_MUL 0x01020408u   /* bytes 0/1 -> bits 24..27 */
+#define MODBUS_RTU_UNPACK_MUL 0x00204081u /* bits 0..3 -> bytes 0..3 */
+#define MODBUS_RTU_UNPACK_MASK 0x01010101u
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+/* 2. Static Variables */
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static uint8_t ModbusRTU_PackNibble(const uint8_t *src);
+static uint32_t ModbusRTU_UnpackNibble(uint8_t bits);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTURegistersFromWire(uint16_t *dst, const uint8_t *src, size_t count)
+ * @brief Convert big endian registers of a PDU to host values.
+ *
+ * @param dst Host registers.
+ * @param src PDU data, any alignment (e.g. after the byte count of FC 0x03).
+ * @param count Registers.
+ */
+void modbusRTURegistersFromWire(uint16_t *dst, const uint8_t *src,
+		size_t count) {
+
+	/* local variable */
+	size_t i = 0;
+
+#ifdef MODBUS_RTU_DATA_WORD_SWAP
+	uint32_t word = 0, next = 0;
+
+#ifdef __ARM_ARCH_7EM__
+	/* M4/M7: two words per turn, the loads of the second overlap the first REV16 */
+	for (; i + 4 <= count; i += 4) {
+		memcpy(&word, &src[2 * i], 4);
+		memcpy(&next, &src[2 * i + 4], 4);
+		word = __REV16(word);
+		next = __REV16(next);
+		memcpy(&dst[i], &word, 4);
+		memcpy(&dst[i + 2], &next, 4);
+	}
+#endif
+	/* one word = two registers per REV16, unaligned LDR/STR are allowed */
+	for (; i + 2 <= count; i += 2) {
+		memcpy(&word, &src[2 * i], 4);
+		word = __REV16(word);
+		memcpy(&dst[i], &word, 4);
+	}
+	(void) next;
+#endif
+
+	for (; i < count; i++) {
+		dst[i] = (uint16_t) ((src[2 * i] << 8) | src[2 * i + 1]);
+	}
+}
+
+/*!
+ * @fn    void modbusRTURegistersToWire(uint8_t *dst, const uint16_t *src, size_t count)
+ * @brief Convert host registers to big endian PDU data.
+ *
+ * @param dst PDU data, any alignment.
+ * @param src Host registers.
+ * @param count Registers.
+ */
+void modbusRTURegistersToWire(uint8_t *dst, const uint16_t *src, size_t count) {
+
+	/* local variable */
+	size_t i = 0;
+
+#ifdef MODBUS_RTU_DATA_WORD_SWAP
+	uint32_t word = 0, next = 0;
+
+#ifdef __ARM_ARCH_7EM__
+	for (; i + 4 <= count; i += 4) {
+		memcpy(&word, &src[i], 4);
+		memcpy(&next, &src[i + 2], 4);
+		word = __REV16(word);
+		next = __REV16(next);
+		memcpy(&dst[2 * i], &word, 4);
+		memcpy(&dst[2 * i + 4], &next, 4);
+	}
+#endif
+	for (; i + 2 <= count; i += 2) {
+		memcpy(&word, &src[i], 4);
+		word = __REV16(word);
+		memcpy(&dst[2 * i], &word, 4);
+	}
+	(void) next;
+#endif
+
+	for (; i < count; i++) {
+		dst[2 * i] = src[i] >> 8;
+		dst[2 * i + 1] = src[i] & 0xFF;
+	}
+}
+
+/*!
+ * @fn    void modbusRTUPackBits(uint8_t *dst, const uint8_t *src, size_t count)
+ * @brief Pack one byte per coil (0 or 1) into PDU bits, LSB first.
+ *
+ * @param dst (count + 7) / 8 bytes, unused high bits cleared.
+ * @param src One byte per coil, 0 or 1.
+ * @param count Coils.
+ */
+void modbusRTUPackBits(uint8_t *dst, const uint8_t *src, size_t count) {
+
+	/* local variable */
+	size_t i = 0;
+	uint8_t last = 0;
+
+	/* 8 coils per output byte, 4 per multiply */
+	for (; i + 8 <= count; i += 8) {
+		dst[i / 8] = ModbusRTU_PackNibble(&src[i])
+				| (uint8_t) (ModbusRTU_PackNibble(&src[i + 4]) << 4);
+	}
+
+	if (i < count) {
+		for (uint8_t j = 0; i + j < count; j++) {
+			last |= (uint8_t) ((src[i + j] & 0x01) << j);
+		}
+		dst[i / 8] = last;
+	}
+}
+
+/*!
+ * @fn    void modbusRTUUnpackBits(uint8_t *dst, const uint8_t *src, size_t count)
+ * @brief Unpack PDU bits, LSB first, into one byte per coil (0 or 1).
+ *
+ * @param dst One byte per coil.
+ * @param src Packed bits (e.g. after the byte count of FC 0x01).
+ * @param count Coils.
+ */
+void modbusRTUUnpackBits(uint8_t *dst, const uint8_t *src, size_t count) {
+
+	/* local variable */
+	size_t i = 0;
+	uint32_t low = 0, high = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		low = ModbusRTU_UnpackNibble(src[i / 8] & 0x0F);
+		high = ModbusRTU_UnpackNibble(src[i / 8] >> 4);
+		memcpy(&dst[i], &low, 4);
+		memcpy(&dst[i + 4], &high, 4);
+	}
+
+	for (; i < count; i++) {
+		dst[i] = (src[i / 8] >> (i % 8)) & 0x01;
+	}
+}
+
+/*!
+ * @fn    void modbusRTUCopyBits(uint8_t *dst, size_t dstBit, const uint8_t *src, size_t srcBit, size_t count)
+ * @brief Copy packed bits between any bit offsets, whole bytes when dst is aligned.
+ *
+ * @param dst Packed destination bits, bits outside the range are kept.
+ * @param dstBit Bit offset in dst.
+ * @param src Packed source bits.
+ * @param srcBit Bit offset in src.
+ * @param count Bits to copy.
+ */
+void modbusRTUCopyBits(uint8_t *dst, size_t dstBit, const uint8_t *src,
+		size_t srcBit, size_t count) {
+
+	/* local variable */
+	const uint8_t *bytes = &src[srcBit / 8];
+	uint8_t shift = srcBit % 8;
+	size_t i = 0;
+	size_t from = 0, to = 0;
+
+	if (0 == (dstBit % 8)) {
+		if (0 == shift) {
+			memcpy(&dst[dstBit / 8], bytes, count / 8);
+			i = count & ~(size_t) 7;
+		} else {
+			/* full bytes, both source bytes hold bits of the range */
+			for (; i + 8 <= count; i += 8, bytes++) {
+				dst[(dstBit + i) / 8] = (uint8_t) ((bytes[0] >> shift)
+						| (bytes[1] << (8 - shift)));
+			}
+		}
+	}
+
+	/* unaligned destination and the tail, bit by bit */
+	for (; i < count; i++) {
+		from = srcBit + i;
+		to = dstBit + i;
+		if (src[from / 8] & (1u << (from % 8))) {
+			dst[to / 8] |= (uint8_t) (1u << (to % 8));
+		} else {
+			dst[to / 8] &= (uint8_t) ~(1u << (to % 8));
+		}
+	}
+}
+
+#ifdef MODBUS_RTU_DATA_BENCHMARK
+/*!
+ * @fn    void modbusRTUDataBenchmark(ModbusRTU_DataBenchmarkT *results)
+ * @brief Measure every helper against the naive loop with the DWT cycle counter.
+ *
+ * @param results Array of MODBUS_RTU_DATA_BENCH_COUNT results.
+ */
+void modbusRTUDataBenchmark(ModbusRTU_DataBenchmarkT *results) {
+
+	/* local variable */
+	static uint8_t wire[2 * 125 + 1];
+	static uint16_t registers[125];
+	static uint8_t coils[2000];
+	static uint8_t bits[2000 / 8];
+	uint32_t start = 0;
+
+	/* odd offset like the registers after the byte count of an FC 0x03 response */
+	for (size_t i = 0; i < sizeof(wire); i++) {
+		wire[i] = (uint8_t) (i * 37u + 11u);
+	}
+	for (size_t i = 0; i < sizeof(coils); i++) {
+		coils[i] = (i * 7u) % 3u == 0;
+	}
+
+	/* enable the cycle counter */
+	modbusRTUPortCyclesInit();
+
+	start = modbusRTUPortCycles();
+	for (size_t i = 0; i < 125; i++) {
+		registers[i] = (uint16_t) ((wire[1 + 2 * i] << 8) | wire[2 + 2 * i]);
+	}
+	results[MODBUS_RTU_DATA_BENCH_FROM_WIRE].naiveCycles = modbusRTUPortCycles() - start;
+	start = modbusRTUPortCycles();
+	modbusRTURegistersFromWire(registers, &wire[1], 125);
+	results[MODBUS_RTU_DATA_BENCH_FROM_WIRE].helperCycles = modbusRTUPortCycles() - start;
+
+	start = modbusRTUPortCycles();
+	for (size_t i = 0; i < 125; i++) {
+		wire[1 + 2 * i] = registers[i] >> 8;
+		wire[2 + 2 * i] = registers[i] & 0xFF;
+	}
+	results[MODBUS_RTU_DATA_BENCH_TO_WIRE].naiveCycles = modbusRTUPortCycles() - start;
+	start = modbusRTUPortCycles();
+	modbusRTURegistersToWire(&wire[1], registers, 125);
+	results[MODBUS_RTU_DATA_BENCH_TO_WIRE].helperCycles = modbusRTUPortCycles() - start;
+
+	start = modbusRTUPortCycles();
+	memset(bits, 0, sizeof(bits));
+	for (size_t i = 0; i < sizeof(coils); i++) {
+		bits[i / 8] |= (uint8_t) (coils[i] << (i % 8));
+	}
+	results[MODBUS_RTU_DATA_BENCH_PACK].naiveCycles = modbusRTUPortCycles() - start;
+	start = modbusRTUPortCycles();
+	modbusRTUPackBits(bits, coils, sizeof(coils));
+	results[MODBUS_RTU_DATA_BENCH_PACK].helperCycles = modbusRTUPortCycles() - start;
+
+	start = modbusRTUPortCycles();
+	for (size_t i = 0; i < sizeof(coils); i++) {
+		coils[i] = (bits[i / 8] >> (i % 8)) & 0x01;
+	}
+	results[MODBUS_RTU_DATA_BENCH_UNPACK].naiveCycles = modbusRTUPortCycles() - start;
+	start = modbusRTUPortCycles();
+	modbusRTUUnpackBits(coils, bits, sizeof(coils));
+	results[MODBUS_RTU_DATA_BENCH_UNPACK].helperCycles = modbusRTUPortCycles() - start;
+}
+#endif
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static uint8_t ModbusRTU_PackNibble(const uint8_t *src)
+ * @brief Pack 4 coil bytes (0 or 1) with one multiply.
+ *
+ * @param src 4 coil bytes.
+ * @return coil 0 in bit 0 .. coil 3 in bit 3.
+ *
+ * @note : the 4 shifted copies land on disjoint bits, no carry reaches bits 24..27.
+ */
+static uint8_t ModbusRTU_PackNibble(const uint8_t *src) {
+
+	/* local variable */
+	uint32_t word = 0;
+
+	memcpy(&word, src, 4);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	word = __builtin_bswap32(word);
+#endif
+	return (uint8_t) (((word & MODBUS_RTU_UNPACK_MASK) * MODBUS_RTU_PACK_MUL)
+			>> 24) & 0x0F;
+}
+
+/*!
+ * @fn    static uint32_t ModbusRTU_UnpackNibble(uint8_t bits)
+ * @brief Spread 4 bits to 4 coil bytes (0 or 1) with one multiply.
+ *
+ * @param bits coil 0 in bit 0 .. coil 3 in bit 3.
+ * @return coil bytes in memory order.
+ */
+static uint32_t ModbusRTU_UnpackNibble(uint8_t bits) {
+
+	/* local variable */
+	uint32_t word = ((uint32_t) bits * MODBUS_RTU_UNPACK_MUL)
+			& MODBUS_RTU_UNPACK_MASK;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	word = __builtin_bswap32(word);
+#endif
+	return word;
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
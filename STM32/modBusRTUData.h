@@ -0,0 +1,141 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUData.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU register and coil data helpers.
+ ******************************************************************************
+ *
+ * This file provides the conversions between the wire format and host
+ * data: big endian registers <-> uint16_t, packed coils <-> one byte per
+ * coil, and packed bit copies at any bit offset. Cortex-M3/M4/M7 swap a
+ * word (two registers) per REV16, other cores use the scalar loops.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_DATA_H
+#define MODBUS_RTU_DATA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stddef.h>
+/* 2. Project Header Files */
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Word at a time path: unaligned LDR/STR and REV16 (define MODBUS_RTU_DATA_SCALAR to disable) */
+#if !defined(MODBUS_RTU_DATA_SCALAR) \
+	&& (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) \
+			|| defined(__ARM_ARCH_8M_MAIN__))
+#define MODBUS_RTU_DATA_WORD_SWAP
+#endif
+
+#ifdef MODBUS_RTU_DATA_BENCHMARK
+/*! @defgroup Benchmark entries */
+#define MODBUS_RTU_DATA_BENCH_FROM_WIRE 0 /* 125 registers, wire -> host */
+#define MODBUS_RTU_DATA_BENCH_TO_WIRE 1   /* 125 registers, host -> wire */
+#define MODBUS_RTU_DATA_BENCH_PACK 2      /* 2000 coils, bytes -> bits */
+#define MODBUS_RTU_DATA_BENCH_UNPACK 3    /* 2000 coils, bits -> bytes */
+#define MODBUS_RTU_DATA_BENCH_COUNT 4
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+#ifdef MODBUS_RTU_DATA_BENCHMARK
+/*!
+ * @typedef @struct  _modbusDataBenchmark
+ * @brief DWT cycles of one helper against the naive loop.
+ */
+typedef struct _modbusDataBenchmark{
+	uint32_t naiveCycles; /*! byte/bit at a time loop */
+	uint32_t helperCycles; /*! modBusRTUData helper */
+} ModbusRTU_DataBenchmarkT;
+#endif
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTURegistersFromWire(uint16_t *dst, const uint8_t *src, size_t count)
+ * @brief Convert big endian registers of a PDU to host values.
+ *
+ * @param dst Host registers.
+ * @param src PDU data, any alignment (e.g. after the byte count of FC 0x03).
+ * @param count Registers.
+ */
+void modbusRTURegistersFromWire(uint16_t *dst, const uint8_t *src,
+		size_t count);
+
+/*!
+ * @fn    void modbusRTURegistersToWire(uint8_t *dst, const uint16_t *src, size_t count)
+ * @brief Convert host registers to big endian PDU data.
+ *
+ * @param dst PDU data, any alignment.
+ * @param src Host registers.
+ * @param count Registers.
+ */
+void modbusRTURegistersToWire(uint8_t *dst, const uint16_t *src, size_t count);
+
+/*!
+ * @fn    void modbusRTUPackBits(uint8_t *dst, const uint8_t *src, size_t count)
+ * @brief Pack one byte per coil (0 or 1) into PDU bits, LSB first.
+ *
+ * @param dst (count + 7) / 8 bytes, unused high bits cleared.
+ * @param src One byte per coil, 0 or 1.
+ * @param count Coils.
+ */
+void modbusRTUPackBits(uint8_t *dst, const uint8_t *src, size_t count);
+
+/*!
+ * @fn    void modbusRTUUnpackBits(uint8_t *dst, const uint8_t *src, size_t count)
+ * @brief Unpack PDU bits, LSB first, into one byte per coil (0 or 1).
+ *
+ * @param dst One byte per coil.
+ * @param src Packed bits (e.g. after the byte count of FC 0x01).
+ * @param count Coils.
+ */
+void modbusRTUUnpackBits(uint8_t *dst, const uint8_t *src, size_t count);
+
+/*!
+ * @fn    void modbusRTUCopyBits(uint8_t *dst, size_t dstBit, const uint8_t *src, size_t srcBit, size_t count)
+ * @brief Copy packed bits between any bit offsets, whole bytes when dst is aligned.
+ *
+ * @param dst Packed destination bits, bits outside the range are kept.
+ * @param dstBit Bit offset in dst.
+ * @param src Packed source bits.
+ * @param srcBit Bit offset in src.
+ * @param count Bits to copy.
+ */
+void modbusRTUCopyBits(uint8_t *dst, size_t dstBit, const uint8_t *src,
+		size_t srcBit, size_t count);
+
+#ifdef MODBUS_RTU_DATA_BENCHMARK
+/*!
+ * @fn    void modbusRTUDataBenchmark(ModbusRTU_DataBenchmarkT *results)
+ * @brief Measure every helper against the naive loop with the DWT cycle counter.
+ *
+ * @param results Array of MODBUS_RTU_DATA_BENCH_COUNT results.
+ */
+void modbusRTUDataBenchmark(ModbusRTU_DataBenchmarkT *results);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_DATA_H
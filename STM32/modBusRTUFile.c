@@ -0,0 +1,367 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUFile.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU file record streaming.
+ ******************************************************************************
+ *
+ * This file provides the file record transfer. The frame request of a
+ * transfer is queued once per frame: its callback (scheduler context)
+ * takes the response, fills the next frame and queues it again, which the
+ * same scheduler pass sends as soon as the bus is idle. A timeout or bad
+ * response sends the frame again, the records of a write are still in
+ * the frame.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUFrame.h"
+/* 3. Module Header File */
+#include <modBusRTUFile.h>
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static ModbusRTU_ErrorT ModbusRTU_FileStart(ModbusRTU_FileTransferT *transfer,
+		uint8_t functionCode, uint32_t size);
+static ModbusRTU_ErrorT ModbusRTU_FileQueue(ModbusRTU_FileTransferT *transfer);
+static void ModbusRTU_FileOnResult(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+static ModbusRTU_ErrorT ModbusRTU_FileStore(ModbusRTU_FileTransferT *transfer,
+		const uint8_t *data, size_t dataSize);
+static void ModbusRTU_FileEnd(ModbusRTU_FileTransferT *transfer,
+		ModbusRTU_ErrorT result);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUFileInit(ModbusRTU_FileTransferT *transfer, ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, uint16_t fileNumber, uint16_t recordNumber)
+ * @brief Prepare a transfer, callbacks empty, default priority and retries.
+ *
+ * @param transfer Pointer to the transfer.
+ * @param scheduler Pointer to the scheduler of the bus.
+ * @param slaveId The modBus slave ID.
+ * @param fileNumber File of the first record (1..0xFFFF).
+ * @param recordNumber First record (0..9999).
+ */
+void modbusRTUFileInit(ModbusRTU_FileTransferT *transfer,
+		ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, uint16_t fileNumber,
+		uint16_t recordNumber) {
+	memset(transfer, 0, sizeof(*transfer));
+	transfer->scheduler = scheduler;
+	transfer->slaveId = slaveId;
+	transfer->fileNumber = fileNumber;
+	transfer->recordNumber = recordNumber;
+	transfer->retries = MODBUS_RTU_FILE_RETRIES;
+	transfer->result = MODBUS_RTU_SUCCESS;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUFileWrite(ModbusRTU_FileTransferT *transfer, const uint8_t *source, uint32_t size)
+ * @brief Stream a blob into the file records with FC 0x15.
+ *
+ * @param transfer Pointer to the transfer, initialized by modbusRTUFileInit.
+ * @param source The blob, e.g. in flash, NULL to take it from the fillCallback.
+ * @param size Bytes of the blob (> 0).
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the transfer and source must stay valid until the doneCallback.
+ */
+ModbusRTU_ErrorT modbusRTUFileWrite(ModbusRTU_FileTransferT *transfer,
+		const uint8_t *source, uint32_t size) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_TX_BUSY;
+
+	if (MODBUS_RTU_RX_BUSY != transfer->result) {
+		transfer->source = source;
+		transfer->destination = NULL;
+		result = ModbusRTU_FileStart(transfer, MODBUS_FUNC_WRITE_FILE_RECORD,
+				size);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUFileRead(ModbusRTU_FileTransferT *transfer, uint8_t *destination, uint32_t size)
+ * @brief Stream a blob out of the file records with FC 0x14.
+ *
+ * @param transfer Pointer to the transfer, initialized by modbusRTUFileInit.
+ * @param destination Buffer of the blob, NULL to hand it to the storeCallback.
+ * @param size Bytes of the blob (> 0).
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the transfer and destination must stay valid until the doneCallback.
+ */
+ModbusRTU_ErrorT modbusRTUFileRead(ModbusRTU_FileTransferT *transfer,
+		uint8_t *destination, uint32_t size) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_TX_BUSY;
+
+	if (MODBUS_RTU_RX_BUSY != transfer->result) {
+		transfer->source = NULL;
+		transfer->destination = destination;
+		result = ModbusRTU_FileStart(transfer, MODBUS_FUNC_READ_FILE_RECORD,
+				size);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    uint32_t modbusRTUFileGetThroughput(const ModbusRTU_FileTransferT *transfer)
+ * @brief Blob bytes per second, so far or of the ended transfer.
+ *
+ * @param transfer Pointer to the transfer.
+ * @return bytes per second, 0 before the first millisecond.
+ *
+ * @note : frames, retried and elapsedMs of the transfer tell the rest, the
+ *         record headers, addresses and CRCs are not counted.
+ */
+uint32_t modbusRTUFileGetThroughput(const ModbusRTU_FileTransferT *transfer) {
+
+	/* local variable */
+	uint32_t elapsedMs = transfer->elapsedMs;
+	uint32_t result = 0;
+
+	if (MODBUS_RTU_RX_BUSY == transfer->result) {
+		elapsedMs = modbusRTUPortGetTickMs() - transfer->startMs;
+	}
+	if (0 != elapsedMs) {
+		result = (uint32_t) ((uint64_t) transfer->offset * 1000u / elapsedMs);
+	}
+
+	return result;
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static ModbusRTU_ErrorT ModbusRTU_FileStart(ModbusRTU_FileTransferT *transfer, uint8_t functionCode, uint32_t size)
+ * @brief Check the transfer and queue its first frame.
+ *
+ * @param transfer Pointer to the transfer.
+ * @param functionCode MODBUS_FUNC_READ_FILE_RECORD or MODBUS_FUNC_WRITE_FILE_RECORD.
+ * @param size Bytes of the blob.
+ * @return result @ref ModbusRTU_FileQueue
+ */
+static ModbusRTU_ErrorT ModbusRTU_FileStart(ModbusRTU_FileTransferT *transfer,
+		uint8_t functionCode, uint32_t size) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	bool isSourced = true;
+
+	if ((MODBUS_FUNC_WRITE_FILE_RECORD == functionCode)
+			&& (NULL == transfer->source)) {
+		isSourced = (NULL != transfer->fillCallback);
+	} else if (MODBUS_FUNC_READ_FILE_RECORD == functionCode) {
+		isSourced = (NULL != transfer->destination)
+				|| (NULL != transfer->storeCallback);
+	}
+
+	if ((0 != size) && (true == isSourced)
+			&& (MODBUS_RTU_BROADCAST_ID != transfer->slaveId)
+			&& (0 != transfer->fileNumber)
+			&& (transfer->recordNumber < MODBUS_RTU_FILE_RECORDS)) {
+		memset(&transfer->request, 0, sizeof(transfer->request));
+		transfer->request.slaveId = transfer->slaveId;
+		transfer->request.functionCode = functionCode;
+		transfer->request.callback = ModbusRTU_FileOnResult;
+		transfer->request.context = transfer;
+		transfer->size = size;
+		transfer->offset = 0;
+		transfer->frames = 0;
+		transfer->retried = 0;
+		transfer->tries = 0;
+		transfer->elapsedMs = 0;
+		transfer->startMs = modbusRTUPortGetTickMs();
+		transfer->result = MODBUS_RTU_RX_BUSY;
+
+		result = ModbusRTU_FileQueue(transfer);
+		if (MODBUS_RTU_SUCCESS != result) {
+			transfer->result = result;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static ModbusRTU_ErrorT ModbusRTU_FileQueue(ModbusRTU_FileTransferT *transfer)
+ * @brief Fill the largest frame from the current offset and queue it.
+ *
+ * @param transfer Pointer to the transfer.
+ * @return result @ref modbusRTUSchedulerAdd, MODBUS_RTU_ERROR_INVALID_FRAME past file 0xFFFF.
+ */
+static ModbusRTU_ErrorT ModbusRTU_FileQueue(ModbusRTU_FileTransferT *transfer) {
+
+	/* local variable */
+	ModbusRTU_RequestT *request = &transfer->request;
+	bool isWrite = (MODBUS_FUNC_WRITE_FILE_RECORD == request->functionCode);
+	uint8_t *bytes = (uint8_t*) transfer->records;
+	uint32_t position = transfer->recordNumber + transfer->offset / 2;
+	uint32_t file = transfer->fileNumber + position / MODBUS_RTU_FILE_RECORDS;
+	uint16_t record = (uint16_t) (position % MODBUS_RTU_FILE_RECORDS);
+	uint32_t size = transfer->size - transfer->offset;
+	uint16_t quantity = modbusRTUFileRecordsFit(isWrite, record,
+			(size + 1) / 2);
+	ModbusRTU_ErrorT result = MODBUS_RTU_ERROR_INVALID_FRAME;
+
+	if (file + (record + quantity - 1) / MODBUS_RTU_FILE_RECORDS <= 0xFFFF) {
+		request->address = (uint16_t) file;
+		request->writeAddress = record;
+		request->quantity = quantity;
+		request->priority = transfer->priority;
+		request->values = NULL;
+		transfer->tries = 0;
+
+		if (true == isWrite) {
+			/* the next bytes of the blob, then the records in place */
+			size = (size < 2u * quantity) ? size : 2u * quantity;
+			bytes[2 * quantity - 1] = 0;
+			if (NULL != transfer->source) {
+				memcpy(bytes, &transfer->source[transfer->offset], size);
+			} else {
+				transfer->fillCallback(transfer, transfer->offset, bytes,
+						(uint16_t) size);
+			}
+			for (uint16_t i = 0; i < quantity; i++) {
+				transfer->records[i] = modbusRTUGetU16(&bytes[2 * i]);
+			}
+			request->values = transfer->records;
+		}
+
+		result = modbusRTUSchedulerAdd(transfer->scheduler, request);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_FileOnResult(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Callback of a frame: store it, then queue the next one, the same one again or end.
+ *
+ * @param request The frame request of a transfer.
+ * @param result Result of the transaction.
+ * @param data FC 0x14: the sub-responses, FC 0x15: the echo.
+ * @param dataSize Size of data.
+ */
+static void ModbusRTU_FileOnResult(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_FileTransferT *transfer =
+			(ModbusRTU_FileTransferT*) request->context;
+	uint32_t size = transfer->size - transfer->offset;
+
+	if (MODBUS_RTU_ERROR_SLAVE_OFFLINE != result) {
+		transfer->frames++;
+	}
+	if ((MODBUS_RTU_SUCCESS == result)
+			&& (MODBUS_FUNC_READ_FILE_RECORD == request->functionCode)) {
+		result = ModbusRTU_FileStore(transfer, data, dataSize);
+	} else if (MODBUS_RTU_SUCCESS == result) {
+		transfer->offset += (size < 2u * request->quantity) ?
+				size : 2u * request->quantity;
+	}
+
+	if ((MODBUS_RTU_SUCCESS == result) && (transfer->offset < transfer->size)) {
+		result = ModbusRTU_FileQueue(transfer);
+		if (MODBUS_RTU_SUCCESS != result) {
+			ModbusRTU_FileEnd(transfer, result);
+		}
+	} else if (MODBUS_RTU_SUCCESS == result) {
+		ModbusRTU_FileEnd(transfer, result);
+	} else if (((MODBUS_RTU_ERROR_RX_TIMEOUT == result)
+			|| (MODBUS_RTU_ERROR_CRC == result)
+			|| (MODBUS_RTU_ERROR_INVALID_FRAME == result)
+			|| (MODBUS_RTU_ERROR_TX_FAILED == result))
+			&& (transfer->tries < transfer->retries)
+			&& (MODBUS_RTU_SUCCESS
+					== modbusRTUSchedulerAdd(transfer->scheduler, request))) {
+		/* the frame is unchanged, a write still holds its records */
+		transfer->tries++;
+		transfer->retried++;
+	} else {
+		/* exceptions, an offline slave and the last try end the transfer */
+		ModbusRTU_FileEnd(transfer, result);
+	}
+}
+
+/*!
+ * @fn    static ModbusRTU_ErrorT ModbusRTU_FileStore(ModbusRTU_FileTransferT *transfer, const uint8_t *data, size_t dataSize)
+ * @brief Check the sub-responses of a read frame and hand their records to the blob.
+ *
+ * @param transfer Pointer to the transfer.
+ * @param data Sub-responses: length, reference type, records.
+ * @param dataSize Size of data.
+ * @return MODBUS_RTU_SUCCESS, MODBUS_RTU_ERROR_INVALID_FRAME when they do not match the request.
+ */
+static ModbusRTU_ErrorT ModbusRTU_FileStore(ModbusRTU_FileTransferT *transfer,
+		const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	uint32_t records = 0;
+	uint32_t size = 0;
+	size_t i = 0;
+
+	/* the whole frame first, a bad one leaves the blob untouched */
+	for (i = 0; (MODBUS_RTU_SUCCESS == result) && (i < dataSize);
+			i += 1 + data[i]) {
+		if ((i + 1 + data[i] > dataSize) || (0 == (data[i] & 0x01))
+				|| (MODBUS_RTU_FILE_REFERENCE_TYPE != data[i + 1])) {
+			result = MODBUS_RTU_ERROR_INVALID_FRAME;
+		} else {
+			records += data[i] / 2u;
+		}
+	}
+	if (records != transfer->request.quantity) {
+		result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	}
+
+	for (i = 0; (MODBUS_RTU_SUCCESS == result) && (i < dataSize)
+			&& (transfer->offset < transfer->size); i += 1 + data[i]) {
+		size = transfer->size - transfer->offset;
+		size = (size < data[i] - 1u) ? size : data[i] - 1u;
+		if (NULL != transfer->destination) {
+			memcpy(&transfer->destination[transfer->offset], &data[i + 2], size);
+		} else {
+			transfer->storeCallback(transfer, transfer->offset, &data[i + 2],
+					(uint16_t) size);
+		}
+		transfer->offset += size;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_FileEnd(ModbusRTU_FileTransferT *transfer, ModbusRTU_ErrorT result)
+ * @brief Stop the clock and report the end of a transfer.
+ *
+ * @param transfer Pointer to the transfer.
+ * @param result Result of the transfer.
+ */
+static void ModbusRTU_FileEnd(ModbusRTU_FileTransferT *transfer,
+		ModbusRTU_ErrorT result) {
+	transfer->elapsedMs = modbusRTUPortGetTickMs() - transfer->startMs;
+	transfer->result = result;
+
+	if (NULL != transfer->doneCallback) {
+		transfer->doneCallback(transfer, result);
+	}
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
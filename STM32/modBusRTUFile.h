@@ -0,0 +1,194 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUFile.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU file record streaming.
+ ******************************************************************************
+ *
+ * This file provides the transfer of a large blob, e.g. a configuration
+ * or a firmware image, with FC 0x14 read / FC 0x15 write file record.
+ * The blob is cut into the largest frames the spec allows (121 records,
+ * 242 bytes), record after record and into the next file after record
+ * 9999. Each frame is a one shot request of a scheduler that queues the
+ * next one from its callback, so frames follow each other t3.5 apart
+ * while the polls of the bus keep their priorities. Only the frame on the
+ * bus is held in RAM: the blob is read from or written to a memory region
+ * (e.g. memory mapped flash) or a callback, one frame at a time.
+ *
+ * Record n of the blob holds bytes 2n (high) and 2n + 1 (low), the blob
+ * goes on the wire byte for byte; an odd size pads the last record with 0.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_FILE_H
+#define MODBUS_RTU_FILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUMaster.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Records of the largest frame, the spec limit of one sub-request */
+#define MODBUS_RTU_FILE_FRAME_RECORDS 121
+/*! @def Default tries of a frame after a timeout or a bad response */
+#ifndef MODBUS_RTU_FILE_RETRIES
+#define MODBUS_RTU_FILE_RETRIES 3
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+struct _modbusFileTransfer;
+
+/*!
+ * @typedef ModbusRTU_FileFillCallbackT
+ * @brief bytes of the blob for the next write frame.
+ *
+ * @param transfer The transfer.
+ * @param offset First byte of data in the blob.
+ * @param data Fill with the bytes, inside the frame.
+ * @param size Bytes of data.
+ *
+ * @note : runs on the context of the scheduler (ISR included).
+ */
+typedef void (*ModbusRTU_FileFillCallbackT)(
+		struct _modbusFileTransfer *transfer, uint32_t offset, uint8_t *data,
+		uint16_t size);
+
+/*!
+ * @typedef ModbusRTU_FileStoreCallbackT
+ * @brief bytes of the blob a read frame brought.
+ *
+ * @param transfer The transfer.
+ * @param offset First byte of data in the blob.
+ * @param data The bytes, inside the received frame.
+ * @param size Bytes of data.
+ *
+ * @note : runs on the context of the scheduler (ISR included), a flash
+ *         page erase belongs in the main loop: erase ahead of the transfer.
+ */
+typedef void (*ModbusRTU_FileStoreCallbackT)(
+		struct _modbusFileTransfer *transfer, uint32_t offset,
+		const uint8_t *data, uint16_t size);
+
+/*!
+ * @typedef ModbusRTU_FileDoneCallbackT
+ * @brief the transfer ended.
+ *
+ * @param transfer The transfer, see modbusRTUFileGetThroughput.
+ * @param result MODBUS_RTU_SUCCESS, or the error of the frame that failed.
+ */
+typedef void (*ModbusRTU_FileDoneCallbackT)(
+		struct _modbusFileTransfer *transfer, ModbusRTU_ErrorT result);
+
+/*!
+ * @typedef @struct  _modbusFileTransfer
+ * @brief one blob streamed to or from the file records of a slave.
+ */
+typedef struct _modbusFileTransfer{
+	ModbusRTU_SchedulerT *scheduler; /*! bus of the transfer */
+	uint8_t slaveId; /*! modBus slave ID, not a broadcast */
+	uint16_t fileNumber; /*! file of the first record, 1..0xFFFF */
+	uint16_t recordNumber; /*! first record, 0..9999 */
+	uint8_t priority; /*! of the frames among the other requests, 0 = most urgent */
+	uint8_t retries; /*! tries of a frame after a timeout or bad response, MODBUS_RTU_FILE_RETRIES by default */
+	ModbusRTU_FileFillCallbackT fillCallback; /*! blob source of a write without a region */
+	ModbusRTU_FileStoreCallbackT storeCallback; /*! blob sink of a read without a region */
+	ModbusRTU_FileDoneCallbackT doneCallback; /*! optional, at the end */
+	void *context; /*! free for the application */
+	const uint8_t *source; /*! private: write region, NULL = fillCallback */
+	uint8_t *destination; /*! private: read region, NULL = storeCallback */
+	uint32_t size; /*! bytes of the blob */
+	uint32_t offset; /*! bytes transferred */
+	uint32_t frames; /*! frames on the bus, retries included */
+	uint32_t retried; /*! frames sent again */
+	uint32_t startMs; /*! modbusRTUPortGetTickMs() of the first frame */
+	uint32_t elapsedMs; /*! duration of the ended transfer */
+	ModbusRTU_ErrorT result; /*! MODBUS_RTU_RX_BUSY while running */
+	uint8_t tries; /*! private: failed tries of the current frame */
+	ModbusRTU_RequestT request; /*! private: the frame, re-queued for the next one */
+	uint16_t records[MODBUS_RTU_FILE_FRAME_RECORDS]; /*! private: records of a write frame */
+} ModbusRTU_FileTransferT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUFileInit(ModbusRTU_FileTransferT *transfer, ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, uint16_t fileNumber, uint16_t recordNumber)
+ * @brief Prepare a transfer, callbacks empty, default priority and retries.
+ *
+ * @param transfer Pointer to the transfer.
+ * @param scheduler Pointer to the scheduler of the bus.
+ * @param slaveId The modBus slave ID.
+ * @param fileNumber File of the first record (1..0xFFFF).
+ * @param recordNumber First record (0..9999).
+ */
+void modbusRTUFileInit(ModbusRTU_FileTransferT *transfer,
+		ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, uint16_t fileNumber,
+		uint16_t recordNumber);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUFileWrite(ModbusRTU_FileTransferT *transfer, const uint8_t *source, uint32_t size)
+ * @brief Stream a blob into the file records with FC 0x15.
+ *
+ * @param transfer Pointer to the transfer, initialized by modbusRTUFileInit.
+ * @param source The blob, e.g. in flash, NULL to take it from the fillCallback.
+ * @param size Bytes of the blob (> 0).
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the transfer and source must stay valid until the doneCallback.
+ */
+ModbusRTU_ErrorT modbusRTUFileWrite(ModbusRTU_FileTransferT *transfer,
+		const uint8_t *source, uint32_t size);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUFileRead(ModbusRTU_FileTransferT *transfer, uint8_t *destination, uint32_t size)
+ * @brief Stream a blob out of the file records with FC 0x14.
+ *
+ * @param transfer Pointer to the transfer, initialized by modbusRTUFileInit.
+ * @param destination Buffer of the blob, NULL to hand it to the storeCallback.
+ * @param size Bytes of the blob (> 0).
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the transfer and destination must stay valid until the doneCallback.
+ */
+ModbusRTU_ErrorT modbusRTUFileRead(ModbusRTU_FileTransferT *transfer,
+		uint8_t *destination, uint32_t size);
+
+/*!
+ * @fn    uint32_t modbusRTUFileGetThroughput(const ModbusRTU_FileTransferT *transfer)
+ * @brief Blob bytes per second, so far or of the ended transfer.
+ *
+ * @param transfer Pointer to the transfer.
+ * @return bytes per second, 0 before the first millisecond.
+ *
+ * @note : frames, retried and elapsedMs of the transfer tell the rest, the
+ *         record headers, addresses and CRCs are not counted.
+ */
+uint32_t modbusRTUFileGetThroughput(const ModbusRTU_FileTransferT *transfer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_FILE_H
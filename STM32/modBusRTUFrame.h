@@ -0,0 +1,378 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUFrame.h
+ * @author         : keyhanSalehi
+ * @brief          : typed modBus RTU request builders and frame sizes.
+ ******************************************************************************
+ *
+ * This file provides one static inline builder per function code. Each
+ * writes the big endian fields of the request straight into the TX buffer
+ * (modbusRTUGetTxBuffer) and returns the PDU data size for
+ * modbusRTUCommitTx/modbusRTUCommitTxDMA. The size macros give the request
+ * and the expected response lengths at compile time, the latter is what
+ * modbusRTUReciveData needs to arm the receive.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_FRAME_H
+#define MODBUS_RTU_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTUData.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @defgroup Request PDU data sizes (after the function code) */
+#define MODBUS_RTU_READ_REQUEST_SIZE 4 /* FC 0x01-0x04: address + quantity */
+#define MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE 4 /* FC 0x05/0x06: address + value */
+#define MODBUS_RTU_WRITE_COILS_REQUEST_SIZE(quantity) \
+	(5 + ((quantity) + 7) / 8) /* FC 0x0F */
+#define MODBUS_RTU_WRITE_REGISTERS_REQUEST_SIZE(quantity) \
+	(5 + 2 * (quantity)) /* FC 0x10 */
+#define MODBUS_RTU_MASK_WRITE_REQUEST_SIZE 6 /* FC 0x16: address + and + or */
+#define MODBUS_RTU_READ_WRITE_REQUEST_SIZE(writeQuantity) \
+	(9 + 2 * (writeQuantity)) /* FC 0x17 */
+#define MODBUS_RTU_DIAG_REQUEST_SIZE 4 /* FC 0x08: sub function + data */
+#define MODBUS_RTU_READ_FILE_REQUEST_SIZE(groups) \
+	(1 + 7 * (groups)) /* FC 0x14: byte count + references */
+#define MODBUS_RTU_WRITE_FILE_REQUEST_SIZE(groups, quantity) \
+	(1 + 7 * (groups) + 2 * (quantity)) /* FC 0x15: byte count + references + records */
+#define MODBUS_RTU_READ_FIFO_REQUEST_SIZE 2 /* FC 0x18: FIFO pointer address */
+
+/*! @defgroup Response PDU data sizes, the dataSize of modbusRTUReciveData */
+#define MODBUS_RTU_READ_BITS_RESPONSE_SIZE(quantity) \
+	(1 + ((quantity) + 7) / 8) /* FC 0x01/0x02: byte count + bits */
+#define MODBUS_RTU_READ_REGISTERS_RESPONSE_SIZE(quantity) \
+	(1 + 2 * (quantity)) /* FC 0x03/0x04/0x17: byte count + registers */
+#define MODBUS_RTU_WRITE_RESPONSE_SIZE 4 /* FC 0x05/0x06/0x0F/0x10: echo */
+#define MODBUS_RTU_MASK_WRITE_RESPONSE_SIZE 6 /* FC 0x16: echo */
+#define MODBUS_RTU_READ_FILE_RESPONSE_SIZE(groups, quantity) \
+	(1 + 2 * (groups) + 2 * (quantity)) /* FC 0x14: data length + sub responses */
+#define MODBUS_RTU_READ_FIFO_RESPONSE_SIZE(count) \
+	(4 + 2 * (count)) /* FC 0x18: byte count + FIFO count + registers */
+#define MODBUS_RTU_COMM_EVENT_COUNTER_RESPONSE_SIZE 4 /* FC 0x0B: status + count */
+#define MODBUS_RTU_EXCEPTION_RESPONSE_SIZE 1 /* exception code */
+
+/*! @defgroup File records (FC 0x14/0x15) */
+#define MODBUS_RTU_FILE_REFERENCE_TYPE 6 /* reference type of every sub-request */
+#define MODBUS_RTU_FILE_RECORDS 10000 /* records 0..9999 per file */
+#define MODBUS_RTU_MAX_FILE_READ_SIZE 245 /* FC 0x14: largest response data length */
+#define MODBUS_RTU_MAX_FILE_WRITE_SIZE 249 /* FC 0x15: largest request data length of a TX buffer */
+
+/*! @def Frame length on the wire for a PDU data size (+ address, function code, CRC) */
+#define MODBUS_RTU_FRAME_SIZE(dataSize) ((dataSize) + 4)
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    static inline void modbusRTUPutU16(uint8_t *data, uint16_t value)
+ * @brief Write a big endian 16 bit PDU field.
+ *
+ * @param data First (high) byte.
+ * @param value The value.
+ */
+static inline void modbusRTUPutU16(uint8_t *data, uint16_t value) {
+	data[0] = value >> 8;
+	data[1] = value & 0xFF;
+}
+
+/*!
+ * @fn    static inline uint16_t modbusRTUGetU16(const uint8_t *data)
+ * @brief Read a big endian 16 bit PDU field.
+ *
+ * @param data First (high) byte.
+ * @return The value.
+ */
+static inline uint16_t modbusRTUGetU16(const uint8_t *data) {
+	return (uint16_t) ((data[0] << 8) | data[1]);
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameRead(uint8_t *pdu, uint16_t address, uint16_t quantity)
+ * @brief FC 0x01/0x02/0x03/0x04 read coils, discrete inputs or registers.
+ *
+ * @param pdu TX buffer data area.
+ * @param address First coil/register.
+ * @param quantity Coils (1..2000) or registers (1..125).
+ * @return PDU data size, MODBUS_RTU_READ_REQUEST_SIZE.
+ */
+static inline size_t modbusRTUFrameRead(uint8_t *pdu, uint16_t address,
+		uint16_t quantity) {
+	modbusRTUPutU16(&pdu[0], address);
+	modbusRTUPutU16(&pdu[2], quantity);
+	return MODBUS_RTU_READ_REQUEST_SIZE;
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameWriteSingleCoil(uint8_t *pdu, uint16_t address, bool isOn)
+ * @brief FC 0x05 write single coil.
+ *
+ * @param pdu TX buffer data area.
+ * @param address The coil.
+ * @param isOn New state.
+ * @return PDU data size, MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE.
+ */
+static inline size_t modbusRTUFrameWriteSingleCoil(uint8_t *pdu,
+		uint16_t address, bool isOn) {
+	modbusRTUPutU16(&pdu[0], address);
+	modbusRTUPutU16(&pdu[2], (true == isOn) ? 0xFF00 : 0x0000);
+	return MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE;
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameWriteSingleRegister(uint8_t *pdu, uint16_t address, uint16_t value)
+ * @brief FC 0x06 write single register.
+ *
+ * @param pdu TX buffer data area.
+ * @param address The register.
+ * @param value New value.
+ * @return PDU data size, MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE.
+ */
+static inline size_t modbusRTUFrameWriteSingleRegister(uint8_t *pdu,
+		uint16_t address, uint16_t value) {
+	modbusRTUPutU16(&pdu[0], address);
+	modbusRTUPutU16(&pdu[2], value);
+	return MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE;
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameWriteMultipleCoils(uint8_t *pdu, uint16_t address, uint16_t quantity, const uint8_t *bits)
+ * @brief FC 0x0F write multiple coils.
+ *
+ * @param pdu TX buffer data area.
+ * @param address First coil.
+ * @param quantity Coils (1..1968).
+ * @param bits Packed states, LSB = first coil.
+ * @return PDU data size, MODBUS_RTU_WRITE_COILS_REQUEST_SIZE(quantity).
+ */
+static inline size_t modbusRTUFrameWriteMultipleCoils(uint8_t *pdu,
+		uint16_t address, uint16_t quantity, const uint8_t *bits) {
+	modbusRTUPutU16(&pdu[0], address);
+	modbusRTUPutU16(&pdu[2], quantity);
+	pdu[4] = (quantity + 7) / 8; /* byte count */
+	memcpy(&pdu[5], bits, pdu[4]);
+	return MODBUS_RTU_WRITE_COILS_REQUEST_SIZE(quantity);
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameWriteMultipleRegisters(uint8_t *pdu, uint16_t address, uint16_t quantity, const uint16_t *values)
+ * @brief FC 0x10 write multiple registers.
+ *
+ * @param pdu TX buffer data area.
+ * @param address First register.
+ * @param quantity Registers (1..123).
+ * @param values New values, host order.
+ * @return PDU data size, MODBUS_RTU_WRITE_REGISTERS_REQUEST_SIZE(quantity).
+ */
+static inline size_t modbusRTUFrameWriteMultipleRegisters(uint8_t *pdu,
+		uint16_t address, uint16_t quantity, const uint16_t *values) {
+	modbusRTUPutU16(&pdu[0], address);
+	modbusRTUPutU16(&pdu[2], quantity);
+	pdu[4] = 2 * quantity; /* byte count */
+	modbusRTURegistersToWire(&pdu[5], values, quantity);
+	return MODBUS_RTU_WRITE_REGISTERS_REQUEST_SIZE(quantity);
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameMaskWriteRegister(uint8_t *pdu, uint16_t address, uint16_t andMask, uint16_t orMask)
+ * @brief FC 0x16 mask write register: (reg AND andMask) OR (orMask AND NOT andMask).
+ *
+ * @param pdu TX buffer data area.
+ * @param address The register.
+ * @param andMask Bits to keep.
+ * @param orMask Bits to set among the cleared ones.
+ * @return PDU data size, MODBUS_RTU_MASK_WRITE_REQUEST_SIZE.
+ */
+static inline size_t modbusRTUFrameMaskWriteRegister(uint8_t *pdu,
+		uint16_t address, uint16_t andMask, uint16_t orMask) {
+	modbusRTUPutU16(&pdu[0], address);
+	modbusRTUPutU16(&pdu[2], andMask);
+	modbusRTUPutU16(&pdu[4], orMask);
+	return MODBUS_RTU_MASK_WRITE_REQUEST_SIZE;
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameReadWriteRegisters(uint8_t *pdu, uint16_t readAddress, uint16_t readQuantity, uint16_t writeAddress, uint16_t writeQuantity, const uint16_t *values)
+ * @brief FC 0x17 write then read multiple registers in one transaction.
+ *
+ * @param pdu TX buffer data area.
+ * @param readAddress First register to read.
+ * @param readQuantity Registers to read (1..125).
+ * @param writeAddress First register to write.
+ * @param writeQuantity Registers to write (1..121).
+ * @param values New values, host order.
+ * @return PDU data size, MODBUS_RTU_READ_WRITE_REQUEST_SIZE(writeQuantity).
+ */
+static inline size_t modbusRTUFrameReadWriteRegisters(uint8_t *pdu,
+		uint16_t readAddress, uint16_t readQuantity, uint16_t writeAddress,
+		uint16_t writeQuantity, const uint16_t *values) {
+	modbusRTUPutU16(&pdu[0], readAddress);
+	modbusRTUPutU16(&pdu[2], readQuantity);
+	modbusRTUPutU16(&pdu[4], writeAddress);
+	modbusRTUPutU16(&pdu[6], writeQuantity);
+	pdu[8] = 2 * writeQuantity; /* byte count */
+	modbusRTURegistersToWire(&pdu[9], values, writeQuantity);
+	return MODBUS_RTU_READ_WRITE_REQUEST_SIZE(writeQuantity);
+}
+
+/*!
+ * @fn    static inline uint16_t modbusRTUFileGroups(uint16_t record, uint16_t quantity)
+ * @brief Sub-requests of a record range, one per file it touches.
+ *
+ * @param record First record (0..9999) of the first file.
+ * @param quantity Records of the range (> 0).
+ * @return sub-requests, the files that follow take over at record 0.
+ */
+static inline uint16_t modbusRTUFileGroups(uint16_t record, uint16_t quantity) {
+	return (uint16_t) ((record + quantity - 1) / MODBUS_RTU_FILE_RECORDS + 1);
+}
+
+/*!
+ * @fn    static inline uint16_t modbusRTUFileRecordsFit(bool isWrite, uint16_t record, uint32_t quantity)
+ * @brief Records of a range that fit one FC 0x14/0x15 frame.
+ *
+ * @param isWrite FC 0x15 (records in the request) or FC 0x14 (in the response).
+ * @param record First record (0..9999) of the first file.
+ * @param quantity Records left of the range.
+ * @return records of the frame, up to quantity.
+ *
+ * @note : a frame holds up to 121 records of one file, a range that
+ *         crosses into the next file pays one sub-request header more.
+ */
+static inline uint16_t modbusRTUFileRecordsFit(bool isWrite, uint16_t record,
+		uint32_t quantity) {
+
+	/* local variable */
+	size_t budget = (true == isWrite) ? MODBUS_RTU_MAX_FILE_WRITE_SIZE :
+			MODBUS_RTU_MAX_FILE_READ_SIZE;
+	size_t header = (true == isWrite) ? 7 : 2;
+	uint32_t count = 0;
+	uint16_t result = 0;
+
+	while ((0 != quantity) && (budget >= header + 2)) {
+		count = (budget - header) / 2;
+		count = (count < quantity) ? count : quantity;
+		count = (count < (uint32_t) (MODBUS_RTU_FILE_RECORDS - record)) ?
+				count : (uint32_t) (MODBUS_RTU_FILE_RECORDS - record);
+		result += (uint16_t) count;
+		quantity -= count;
+		budget -= header + 2 * count;
+		record = 0;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameReadFileRecord(uint8_t *pdu, uint16_t file, uint16_t record, uint16_t quantity)
+ * @brief FC 0x14 read file record, one sub-request per file of the range.
+ *
+ * @param pdu TX buffer data area.
+ * @param file File of the first record (1..0xFFFF).
+ * @param record First record (0..9999).
+ * @param quantity Records, see modbusRTUFileRecordsFit.
+ * @return PDU data size, MODBUS_RTU_READ_FILE_REQUEST_SIZE(groups).
+ */
+static inline size_t modbusRTUFrameReadFileRecord(uint8_t *pdu, uint16_t file,
+		uint16_t record, uint16_t quantity) {
+
+	/* local variable */
+	uint16_t count = 0;
+	size_t size = 1;
+
+	while (0 != quantity) {
+		count = MODBUS_RTU_FILE_RECORDS - record;
+		count = (count < quantity) ? count : quantity;
+		pdu[size] = MODBUS_RTU_FILE_REFERENCE_TYPE;
+		modbusRTUPutU16(&pdu[size + 1], file++);
+		modbusRTUPutU16(&pdu[size + 3], record);
+		modbusRTUPutU16(&pdu[size + 5], count);
+		size += 7;
+		quantity -= count;
+		record = 0;
+	}
+	pdu[0] = (uint8_t) (size - 1); /* byte count */
+
+	return size;
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameWriteFileRecord(uint8_t *pdu, uint16_t file, uint16_t record, uint16_t quantity, const uint16_t *values)
+ * @brief FC 0x15 write file record, one sub-request per file of the range.
+ *
+ * @param pdu TX buffer data area.
+ * @param file File of the first record (1..0xFFFF).
+ * @param record First record (0..9999).
+ * @param quantity Records, see modbusRTUFileRecordsFit.
+ * @param values New records, host order.
+ * @return PDU data size, MODBUS_RTU_WRITE_FILE_REQUEST_SIZE(groups, quantity).
+ */
+static inline size_t modbusRTUFrameWriteFileRecord(uint8_t *pdu,
+		uint16_t file, uint16_t record, uint16_t quantity,
+		const uint16_t *values) {
+
+	/* local variable */
+	uint16_t count = 0;
+	size_t size = 1;
+
+	while (0 != quantity) {
+		count = MODBUS_RTU_FILE_RECORDS - record;
+		count = (count < quantity) ? count : quantity;
+		pdu[size] = MODBUS_RTU_FILE_REFERENCE_TYPE;
+		modbusRTUPutU16(&pdu[size + 1], file++);
+		modbusRTUPutU16(&pdu[size + 3], record);
+		modbusRTUPutU16(&pdu[size + 5], count);
+		modbusRTURegistersToWire(&pdu[size + 7], values, count);
+		size += 7 + 2 * count;
+		values += count;
+		quantity -= count;
+		record = 0;
+	}
+	pdu[0] = (uint8_t) (size - 1); /* request data length */
+
+	return size;
+}
+
+/*!
+ * @fn    static inline size_t modbusRTUFrameReadFifoQueue(uint8_t *pdu, uint16_t address)
+ * @brief FC 0x18 read FIFO queue.
+ *
+ * @param pdu TX buffer data area.
+ * @param address FIFO pointer address.
+ * @return PDU data size, MODBUS_RTU_READ_FIFO_REQUEST_SIZE.
+ */
+static inline size_t modbusRTUFrameReadFifoQueue(uint8_t *pdu,
+		uint16_t address) {
+	modbusRTUPutU16(&pdu[0], address);
+	return MODBUS_RTU_READ_FIFO_REQUEST_SIZE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_FRAME_H
@@ -0,0 +1,606 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUGateway.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus TCP / RTU over TCP to RTU gateway.
+ ******************************************************************************
+ *
+ * This file provides the gateway. A client ADU is checked, decoded into a
+ * one shot ModbusRTU_RequestT held in a free transaction slot and queued
+ * on the scheduler of its bus. The scheduler callback builds the answer
+ * in the same slot, in the framing of the request, and frees the slot.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUCrc.h"
+#include "modBusRTUData.h"
+#include "modBusRTUFrame.h"
+/* 3. Module Header File */
+#include <modBusRTUGateway.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @defgroup Offset of the PDU in an ADU */
+#define MODBUS_RTU_GATEWAY_MBAP_PDU 7 /* transaction, protocol, length, unit */
+#define MODBUS_RTU_GATEWAY_RTU_PDU 1 /* address */
+#define MODBUS_RTU_GATEWAY_PDU_OFFSET(isRtuFraming) \
+	((isRtuFraming) ? MODBUS_RTU_GATEWAY_RTU_PDU : MODBUS_RTU_GATEWAY_MBAP_PDU)
+/*! @def Function code bit of an exception response */
+#define MODBUS_RTU_GATEWAY_EXCEPTION_BIT 0x80
+/*! @def FC 0x05 values */
+#define MODBUS_RTU_GATEWAY_COIL_ON 0xFF00
+#define MODBUS_RTU_GATEWAY_COIL_OFF 0x0000
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusGatewayAdu
+ * @brief a client request with its framing removed.
+ */
+typedef struct _modbusGatewayAdu{
+	void *connection; /*! client */
+	bool isRtuFraming; /*! RTU over TCP */
+	uint16_t transactionId; /*! MBAP transaction ID, 0 for RTU */
+	uint8_t unitId; /*! unit ID / RTU address */
+	const uint8_t *pdu; /*! function code + data */
+	size_t pduSize; /*! size of pdu */
+} ModbusRTU_GatewayAduT;
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+/* 2. Static Variables */
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static ModbusRTU_ErrorT ModbusRTU_GatewayForward(ModbusRTU_GatewayT *gateway,
+		const ModbusRTU_GatewayAduT *adu);
+static uint8_t ModbusRTU_GatewayDecode(ModbusRTU_GatewayTransactionT *slot,
+		const uint8_t *pdu, size_t pduSize);
+static ModbusRTU_GatewayTransactionT* ModbusRTU_GatewayAlloc(
+		ModbusRTU_GatewayT *gateway);
+static void ModbusRTU_GatewayFree(ModbusRTU_GatewayTransactionT *slot);
+static void ModbusRTU_GatewayOnResult(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+static void ModbusRTU_GatewayException(ModbusRTU_GatewayT *gateway,
+		const ModbusRTU_GatewayAduT *adu, uint8_t exception);
+static size_t ModbusRTU_GatewayFrame(uint8_t *buffer, bool isRtuFraming,
+		uint16_t transactionId, uint8_t unitId, size_t pduSize);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUGatewayInit(ModbusRTU_GatewayT *gateway, ModbusRTU_GatewayReplyT replyCallback)
+ * @brief Initialize a gateway without buses.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param replyCallback Sends the answers to the connections.
+ */
+void modbusRTUGatewayInit(ModbusRTU_GatewayT *gateway,
+		ModbusRTU_GatewayReplyT replyCallback) {
+	memset(gateway, 0, sizeof(*gateway));
+	gateway->replyCallback = replyCallback;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUGatewayAddBus(ModbusRTU_GatewayT *gateway, ModbusRTU_SchedulerT *scheduler, uint8_t firstUnitId, uint8_t lastUnitId)
+ * @brief Route a range of unit IDs to the scheduler of an RTU bus.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param scheduler Scheduler of the bus, may carry its own polls as well.
+ * @param firstUnitId First unit ID of the range (0 routes broadcasts).
+ * @param lastUnitId Last unit ID of the range.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the first matching range wins.
+ */
+ModbusRTU_ErrorT modbusRTUGatewayAddBus(ModbusRTU_GatewayT *gateway,
+		ModbusRTU_SchedulerT *scheduler, uint8_t firstUnitId,
+		uint8_t lastUnitId) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	ModbusRTU_GatewayBusT *bus = NULL;
+
+	if (gateway->busCount >= MODBUS_RTU_GATEWAY_MAX_BUSES) {
+		result = MODBUS_RTU_ERROR_QUEUE_FULL;
+	} else {
+		bus = &gateway->buses[gateway->busCount++];
+		bus->scheduler = scheduler;
+		bus->firstUnitId = firstUnitId;
+		bus->lastUnitId = lastUnitId;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    size_t modbusRTUGatewayFrameSize(const uint8_t *data, size_t size)
+ * @brief Size of the MBAP ADU at the start of a TCP stream.
+ *
+ * @param data Received stream bytes.
+ * @param size Bytes in data.
+ * @return ADU size, 0 while the MBAP length field is incomplete.
+ */
+size_t modbusRTUGatewayFrameSize(const uint8_t *data, size_t size) {
+
+	/* local variable */
+	size_t result = 0;
+
+	if (size >= MODBUS_RTU_GATEWAY_MBAP_SIZE - 1) {
+		/* the length field counts the unit ID and the PDU */
+		result = MODBUS_RTU_GATEWAY_MBAP_SIZE - 1 + modbusRTUGetU16(&data[4]);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUGatewayRequest(ModbusRTU_GatewayT *gateway, void *connection, const uint8_t *adu, size_t size)
+ * @brief Forward one modBus TCP ADU (MBAP header + PDU) to its bus.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param connection Identifies the client, given back to replyCallback.
+ * @param adu The ADU, may be reused as soon as this returns.
+ * @param size Size of adu.
+ * @return MODBUS_RTU_SUCCESS when queued, MODBUS_RTU_ERROR_INVALID_FRAME when
+ *         dropped, else the reason it was answered with an exception.
+ */
+ModbusRTU_ErrorT modbusRTUGatewayRequest(ModbusRTU_GatewayT *gateway,
+		void *connection, const uint8_t *adu, size_t size) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	ModbusRTU_GatewayAduT request = { 0 };
+
+	/* a bad header is dropped without an answer, like the spec asks */
+	if ((size > MODBUS_RTU_GATEWAY_MBAP_SIZE)
+			&& (size <= MODBUS_RTU_GATEWAY_MAX_ADU_SIZE)
+			&& (MODBUS_RTU_GATEWAY_PROTOCOL_ID == modbusRTUGetU16(&adu[2]))
+			&& (size == modbusRTUGatewayFrameSize(adu, size))) {
+		request.connection = connection;
+		request.isRtuFraming = false;
+		request.transactionId = modbusRTUGetU16(&adu[0]);
+		request.unitId = adu[6];
+		request.pdu = &adu[MODBUS_RTU_GATEWAY_MBAP_PDU];
+		request.pduSize = size - MODBUS_RTU_GATEWAY_MBAP_PDU;
+		result = ModbusRTU_GatewayForward(gateway, &request);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUGatewayRequestRtu(ModbusRTU_GatewayT *gateway, void *connection, const uint8_t *adu, size_t size)
+ * @brief Forward one RTU over TCP ADU (address + PDU + CRC) to its bus.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param connection Identifies the client, given back to replyCallback.
+ * @param adu The ADU, may be reused as soon as this returns.
+ * @param size Size of adu.
+ * @return see @ref modbusRTUGatewayRequest, a bad CRC drops the ADU.
+ */
+ModbusRTU_ErrorT modbusRTUGatewayRequestRtu(ModbusRTU_GatewayT *gateway,
+		void *connection, const uint8_t *adu, size_t size) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	ModbusRTU_GatewayAduT request = { 0 };
+	uint16_t crc = 0;
+
+	if ((size >= MODBUS_RTU_FRAME_SIZE(0))
+			&& (size <= MODBUS_RTU_MAX_FRAME_SIZE)) {
+		crc = modbusRTUCalculateCRC(adu, size - 2);
+		if ((adu[size - 2] == (crc & 0xFF))
+				&& (adu[size - 1] == ((crc >> 8) & 0xFF))) {
+			request.connection = connection;
+			request.isRtuFraming = true;
+			request.unitId = adu[0];
+			request.pdu = &adu[MODBUS_RTU_GATEWAY_RTU_PDU];
+			request.pduSize = size - MODBUS_RTU_GATEWAY_RTU_PDU - 2;
+			result = ModbusRTU_GatewayForward(gateway, &request);
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    void modbusRTUGatewayDisconnect(ModbusRTU_GatewayT *gateway, void *connection)
+ * @brief Forget a closed connection, its transactions finish without a reply.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param connection The closed connection.
+ */
+void modbusRTUGatewayDisconnect(ModbusRTU_GatewayT *gateway,
+		void *connection) {
+
+	/* local variable */
+	uint32_t lock = 0;
+
+	/* a transaction on the wire cannot be taken back, it only loses its client */
+	lock = modbusRTUPortEnterCritical();
+	for (uint8_t i = 0; i < MODBUS_RTU_GATEWAY_MAX_TRANSACTIONS; i++) {
+		if ((0 != (gateway->busyMask & (1u << i)))
+				&& (connection == gateway->transactions[i].connection)) {
+			gateway->transactions[i].connection = NULL;
+		}
+	}
+	modbusRTUPortExitCritical(lock);
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static ModbusRTU_ErrorT ModbusRTU_GatewayForward(ModbusRTU_GatewayT *gateway, const ModbusRTU_GatewayAduT *adu)
+ * @brief Route a request, queue it on its bus or answer it with an exception.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param adu The request without its framing.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ */
+static ModbusRTU_ErrorT ModbusRTU_GatewayForward(ModbusRTU_GatewayT *gateway,
+		const ModbusRTU_GatewayAduT *adu) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	ModbusRTU_SchedulerT *scheduler = NULL;
+	ModbusRTU_GatewayTransactionT *slot = NULL;
+	uint8_t exception = MODBUS_EXCEPTION_NONE;
+
+	for (uint8_t i = 0; (i < gateway->busCount) && (NULL == scheduler); i++) {
+		if ((adu->unitId >= gateway->buses[i].firstUnitId)
+				&& (adu->unitId <= gateway->buses[i].lastUnitId)) {
+			scheduler = gateway->buses[i].scheduler;
+		}
+	}
+
+	if (0 == adu->pduSize) {
+		result = MODBUS_RTU_ERROR_INVALID_FRAME;
+	} else if (NULL == scheduler) {
+		result = MODBUS_RTU_ERROR_INVALID_SLAVE_ID;
+		exception = MODBUS_EXCEPTION_GATEWAY_PATH_UNAVAILABLE;
+	} else if (NULL == (slot = ModbusRTU_GatewayAlloc(gateway))) {
+		result = MODBUS_RTU_ERROR_QUEUE_FULL;
+		exception = MODBUS_EXCEPTION_SERVER_DEVICE_BUSY;
+	} else if (MODBUS_EXCEPTION_NONE
+			!= (exception = ModbusRTU_GatewayDecode(slot, adu->pdu,
+					adu->pduSize))) {
+		result = MODBUS_RTU_ERROR_EXCEPTION;
+		ModbusRTU_GatewayFree(slot);
+	} else {
+		slot->connection = adu->connection;
+		slot->transactionId = adu->transactionId;
+		slot->isRtuFraming = adu->isRtuFraming;
+		slot->request.slaveId = adu->unitId;
+		slot->request.priority = gateway->priority;
+		slot->request.callback = ModbusRTU_GatewayOnResult;
+		slot->request.context = slot;
+
+		result = modbusRTUSchedulerAdd(scheduler, &slot->request);
+		if (MODBUS_RTU_SUCCESS != result) {
+			exception = MODBUS_EXCEPTION_SERVER_DEVICE_BUSY;
+			ModbusRTU_GatewayFree(slot);
+		} else {
+			/* the bus may be idle, do not wait for the main loop */
+			modbusRTUSchedulerProcess(scheduler);
+		}
+	}
+
+	if (MODBUS_EXCEPTION_NONE != exception) {
+		ModbusRTU_GatewayException(gateway, adu, exception);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_GatewayDecode(ModbusRTU_GatewayTransactionT *slot, const uint8_t *pdu, size_t pduSize)
+ * @brief Turn a request PDU into the scheduler request of a slot.
+ *
+ * @param slot The transaction, its buffer takes the values to write.
+ * @param pdu Function code + data.
+ * @param pduSize Size of pdu, at least 1.
+ * @return MODBUS_EXCEPTION_NONE, else the exception to answer.
+ */
+static uint8_t ModbusRTU_GatewayDecode(ModbusRTU_GatewayTransactionT *slot,
+		const uint8_t *pdu, size_t pduSize) {
+
+	/* local variable */
+	ModbusRTU_RequestT *request = &slot->request;
+	const uint8_t *data = &pdu[1];
+	size_t dataSize = pduSize - 1;
+	uint8_t result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	uint16_t quantity = 0;
+	uint16_t value = 0;
+
+	memset(request, 0, sizeof(*request));
+	request->functionCode = pdu[0];
+	if (dataSize >= 4) {
+		request->address = modbusRTUGetU16(&data[0]);
+		quantity = modbusRTUGetU16(&data[2]);
+	}
+
+	switch (request->functionCode) {
+	case MODBUS_FUNC_READ_COILS:
+	case MODBUS_FUNC_READ_DISCRETE_INPUTS:
+		if ((MODBUS_RTU_READ_REQUEST_SIZE == dataSize) && (quantity > 0)
+				&& (quantity <= MODBUS_RTU_HANDLE_MAX_READ_BITS)) {
+			request->quantity = quantity;
+			result = MODBUS_EXCEPTION_NONE;
+		}
+		break;
+	case MODBUS_FUNC_READ_HOLDING_REGISTERS:
+	case MODBUS_FUNC_READ_INPUT_REGISTERS:
+		if ((MODBUS_RTU_READ_REQUEST_SIZE == dataSize) && (quantity > 0)
+				&& (quantity <= MODBUS_RTU_HANDLE_MAX_READ_REGISTERS)) {
+			request->quantity = quantity;
+			result = MODBUS_EXCEPTION_NONE;
+		}
+		break;
+	case MODBUS_FUNC_WRITE_SINGLE_COIL:
+		value = quantity;
+		if ((MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE == dataSize)
+				&& ((MODBUS_RTU_GATEWAY_COIL_ON == value)
+						|| (MODBUS_RTU_GATEWAY_COIL_OFF == value))) {
+			slot->buffer.bits[0] = (MODBUS_RTU_GATEWAY_COIL_ON == value) ? 1 : 0;
+			request->quantity = 1;
+			request->values = slot->buffer.bits;
+			result = MODBUS_EXCEPTION_NONE;
+		}
+		break;
+	case MODBUS_FUNC_WRITE_SINGLE_REGISTER:
+		if (MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE == dataSize) {
+			slot->buffer.registers[0] = quantity;
+			request->quantity = 1;
+			request->values = slot->buffer.registers;
+			result = MODBUS_EXCEPTION_NONE;
+		}
+		break;
+	case MODBUS_FUNC_WRITE_MULTY_COIL:
+		if ((dataSize >= MODBUS_RTU_WRITE_COILS_REQUEST_SIZE(1))
+				&& (quantity > 0) && (quantity <= MODBUS_RTU_HANDLE_MAX_WRITE_BITS)
+				&& (data[4] == (quantity + 7) / 8)
+				&& ((size_t) MODBUS_RTU_WRITE_COILS_REQUEST_SIZE(quantity) == dataSize)) {
+			memcpy(slot->buffer.bits, &data[5], data[4]);
+			request->quantity = quantity;
+			request->values = slot->buffer.bits;
+			result = MODBUS_EXCEPTION_NONE;
+		}
+		break;
+	case MODBUS_FUNC_WRITE_MULTY_REGISTER:
+		if ((dataSize >= MODBUS_RTU_WRITE_REGISTERS_REQUEST_SIZE(1))
+				&& (quantity > 0) && (quantity <= MODBUS_RTU_HANDLE_MAX_WRITE_REGISTERS)
+				&& (data[4] == 2 * quantity)
+				&& ((size_t) MODBUS_RTU_WRITE_REGISTERS_REQUEST_SIZE(quantity) == dataSize)) {
+			modbusRTURegistersFromWire(slot->buffer.registers, &data[5], quantity);
+			request->quantity = quantity;
+			request->values = slot->buffer.registers;
+			result = MODBUS_EXCEPTION_NONE;
+		}
+		break;
+	case MODBUS_FUNC_MASK_WRITE_REGISTER:
+		if (MODBUS_RTU_MASK_WRITE_REQUEST_SIZE == dataSize) {
+			modbusRTURegistersFromWire(slot->buffer.registers, &data[2], 2);
+			request->values = slot->buffer.registers;
+			result = MODBUS_EXCEPTION_NONE;
+		}
+		break;
+	case MODBUS_FUNC_READ_WRITE_MULTY_REGISTER:
+		if (dataSize >= MODBUS_RTU_READ_WRITE_REQUEST_SIZE(1)) {
+			request->quantity = quantity;
+			request->writeAddress = modbusRTUGetU16(&data[4]);
+			request->writeQuantity = modbusRTUGetU16(&data[6]);
+			if ((quantity > 0) && (quantity <= MODBUS_RTU_HANDLE_MAX_READ_REGISTERS)
+					&& (request->writeQuantity > 0)
+					&& (request->writeQuantity <= MODBUS_RTU_HANDLE_MAX_RW_WRITE_REGISTERS)
+					&& (data[8] == 2 * request->writeQuantity)
+					&& ((size_t) MODBUS_RTU_READ_WRITE_REQUEST_SIZE(
+							request->writeQuantity) == dataSize)) {
+				modbusRTURegistersFromWire(slot->buffer.registers, &data[9],
+						request->writeQuantity);
+				request->values = slot->buffer.registers;
+				result = MODBUS_EXCEPTION_NONE;
+			}
+		}
+		break;
+	default:
+		/* the scheduler builds no other request */
+		result = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+		break;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static ModbusRTU_GatewayTransactionT* ModbusRTU_GatewayAlloc(ModbusRTU_GatewayT *gateway)
+ * @brief Take a free transaction slot.
+ *
+ * @param gateway Pointer to the gateway.
+ * @return the slot, NULL when all are in flight.
+ */
+static ModbusRTU_GatewayTransactionT* ModbusRTU_GatewayAlloc(
+		ModbusRTU_GatewayT *gateway) {
+
+	/* local variable */
+	ModbusRTU_GatewayTransactionT *result = NULL;
+	uint32_t lock = 0;
+
+	/* the scheduler callbacks of every bus free slots from their own context */
+	lock = modbusRTUPortEnterCritical();
+	for (uint8_t i = 0; i < MODBUS_RTU_GATEWAY_MAX_TRANSACTIONS; i++) {
+		if (0 == (gateway->busyMask & (1u << i))) {
+			gateway->busyMask |= (1u << i);
+			result = &gateway->transactions[i];
+			break;
+		}
+	}
+	modbusRTUPortExitCritical(lock);
+
+	if (NULL != result) {
+		result->gateway = gateway;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_GatewayFree(ModbusRTU_GatewayTransactionT *slot)
+ * @brief Give a transaction slot back.
+ *
+ * @param slot The transaction.
+ */
+static void ModbusRTU_GatewayFree(ModbusRTU_GatewayTransactionT *slot) {
+
+	/* local variable */
+	ModbusRTU_GatewayT *gateway = slot->gateway;
+	uint32_t lock = 0;
+
+	lock = modbusRTUPortEnterCritical();
+	gateway->busyMask &= ~(1u << (slot - gateway->transactions));
+	modbusRTUPortExitCritical(lock);
+}
+
+/*!
+ * @fn    static void ModbusRTU_GatewayOnResult(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Scheduler callback: answer the client of a transaction and free it.
+ *
+ * @param request The request of the transaction.
+ * @param result Result of the bus transaction.
+ * @param data see @ref ModbusRTU_RequestCallbackT.
+ * @param dataSize Size of data.
+ */
+static void ModbusRTU_GatewayOnResult(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_GatewayTransactionT *slot =
+			(ModbusRTU_GatewayTransactionT*) request->context;
+	ModbusRTU_GatewayT *gateway = slot->gateway;
+	uint8_t *pdu = &slot->buffer.adu[MODBUS_RTU_GATEWAY_PDU_OFFSET(
+			slot->isRtuFraming)];
+	size_t pduSize = 0;
+	size_t size = 0;
+
+	/* the values were sent, the buffer takes the answer now */
+	if (MODBUS_RTU_SUCCESS == result) {
+		pdu[pduSize++] = request->functionCode;
+		if ((MODBUS_FUNC_READ_COILS == request->functionCode)
+				|| (MODBUS_FUNC_READ_DISCRETE_INPUTS == request->functionCode)
+				|| (MODBUS_FUNC_READ_HOLDING_REGISTERS == request->functionCode)
+				|| (MODBUS_FUNC_READ_INPUT_REGISTERS == request->functionCode)
+				|| (MODBUS_FUNC_READ_WRITE_MULTY_REGISTER
+						== request->functionCode)) {
+			pdu[pduSize++] = (uint8_t) dataSize; /* the callback skipped the byte count */
+		}
+		memcpy(&pdu[pduSize], data, dataSize);
+		pduSize += dataSize;
+	} else {
+		pdu[pduSize++] = request->functionCode | MODBUS_RTU_GATEWAY_EXCEPTION_BIT;
+		if (MODBUS_RTU_ERROR_EXCEPTION == result) {
+			pdu[pduSize++] = data[0];
+		} else if ((MODBUS_RTU_ERROR_RX_TIMEOUT == result)
+				|| (MODBUS_RTU_ERROR_SLAVE_OFFLINE == result)
+				|| (MODBUS_RTU_ERROR_CRC == result)
+				|| (MODBUS_RTU_ERROR_INVALID_FRAME == result)) {
+			pdu[pduSize++] = MODBUS_EXCEPTION_GATEWAY_TARGET_FAILED;
+		} else {
+			pdu[pduSize++] = MODBUS_EXCEPTION_GATEWAY_PATH_UNAVAILABLE;
+		}
+	}
+
+	/* nobody waits for a broadcast or on a closed connection */
+	if ((NULL != slot->connection) && (NULL != gateway->replyCallback)
+			&& (MODBUS_RTU_BROADCAST_ID != request->slaveId)) {
+		size = ModbusRTU_GatewayFrame(slot->buffer.adu, slot->isRtuFraming,
+				slot->transactionId, request->slaveId, pduSize);
+		gateway->replyCallback(gateway, slot->connection, slot->buffer.adu,
+				size);
+	}
+
+	ModbusRTU_GatewayFree(slot);
+}
+
+/*!
+ * @fn    static void ModbusRTU_GatewayException(ModbusRTU_GatewayT *gateway, const ModbusRTU_GatewayAduT *adu, uint8_t exception)
+ * @brief Answer a request the gateway cannot forward.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param adu The request.
+ * @param exception MODBUS_EXCEPTION_xxx
+ */
+static void ModbusRTU_GatewayException(ModbusRTU_GatewayT *gateway,
+		const ModbusRTU_GatewayAduT *adu, uint8_t exception) {
+
+	/* local variable */
+	uint8_t buffer[MODBUS_RTU_GATEWAY_MBAP_PDU + 2 + 2];
+	uint8_t *pdu = &buffer[MODBUS_RTU_GATEWAY_PDU_OFFSET(adu->isRtuFraming)];
+	size_t size = 0;
+
+	if ((NULL != gateway->replyCallback)
+			&& (MODBUS_RTU_BROADCAST_ID != adu->unitId)) {
+		pdu[0] = adu->pdu[0] | MODBUS_RTU_GATEWAY_EXCEPTION_BIT;
+		pdu[1] = exception;
+		size = ModbusRTU_GatewayFrame(buffer, adu->isRtuFraming,
+				adu->transactionId, adu->unitId, 2);
+		gateway->replyCallback(gateway, adu->connection, buffer, size);
+	}
+}
+
+/*!
+ * @fn    static size_t ModbusRTU_GatewayFrame(uint8_t *buffer, bool isRtuFraming, uint16_t transactionId, uint8_t unitId, size_t pduSize)
+ * @brief Put the MBAP header or the RTU address and CRC around a PDU.
+ *
+ * @param buffer ADU, the PDU already at MODBUS_RTU_GATEWAY_PDU_OFFSET.
+ * @param isRtuFraming RTU over TCP.
+ * @param transactionId MBAP transaction ID.
+ * @param unitId Unit ID / RTU address.
+ * @param pduSize Size of the PDU.
+ * @return ADU size.
+ */
+static size_t ModbusRTU_GatewayFrame(uint8_t *buffer, bool isRtuFraming,
+		uint16_t transactionId, uint8_t unitId, size_t pduSize) {
+
+	/* local variable */
+	size_t result = 0;
+	uint16_t crc = 0;
+
+	if (true == isRtuFraming) {
+		buffer[0] = unitId;
+		crc = modbusRTUCalculateCRC(buffer, 1 + pduSize);
+		buffer[1 + pduSize] = crc & 0xFF; /* CRC low byte */
+		buffer[2 + pduSize] = (crc >> 8) & 0xFF; /* CRC high byte */
+		result = 1 + pduSize + 2;
+	} else {
+		modbusRTUPutU16(&buffer[0], transactionId);
+		modbusRTUPutU16(&buffer[2], MODBUS_RTU_GATEWAY_PROTOCOL_ID);
+		modbusRTUPutU16(&buffer[4], (uint16_t) (1 + pduSize));
+		buffer[6] = unitId;
+		result = MODBUS_RTU_GATEWAY_MBAP_PDU + pduSize;
+	}
+
+	return result;
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -0,0 +1,207 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUGateway.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus TCP / RTU over TCP to RTU gateway.
+ ******************************************************************************
+ *
+ * This file provides a gateway from modBus TCP (MBAP header) and RTU over
+ * TCP clients to the RTU buses of the device. Every request becomes a one
+ * shot request on the scheduler of the bus its unit ID routes to, so
+ * concurrent transactions of any number of connections are queued,
+ * prioritised and merged per bus, and every bus runs on its own. The
+ * transaction table maps each answer back to its connection and MBAP
+ * transaction ID. The TCP stack stays with the application: it hands in
+ * received ADUs and sends what the reply callback gives it.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_GATEWAY_H
+#define MODBUS_RTU_GATEWAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUMaster.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def RTU buses behind one gateway */
+#ifndef MODBUS_RTU_GATEWAY_MAX_BUSES
+#define MODBUS_RTU_GATEWAY_MAX_BUSES 4
+#endif
+/*! @def Transactions in flight over all buses, up to 32 */
+#ifndef MODBUS_RTU_GATEWAY_MAX_TRANSACTIONS
+#define MODBUS_RTU_GATEWAY_MAX_TRANSACTIONS 8
+#endif
+#if (MODBUS_RTU_GATEWAY_MAX_TRANSACTIONS > 32)
+#error "MODBUS_RTU_GATEWAY_MAX_TRANSACTIONS must be up to 32"
+#endif
+/*! @defgroup MBAP header: transaction ID, protocol ID, length, unit ID */
+#define MODBUS_RTU_GATEWAY_MBAP_SIZE 7
+#define MODBUS_RTU_GATEWAY_PROTOCOL_ID 0x0000
+/*! @def Largest ADU, MBAP + function code + data */
+#define MODBUS_RTU_GATEWAY_MAX_ADU_SIZE (MODBUS_RTU_GATEWAY_MBAP_SIZE + 1 + 252)
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+struct _modbusGateway;
+
+/*!
+ * @typedef ModbusRTU_GatewayReplyT
+ * @brief answer for a connection, in the framing of its request.
+ *
+ * @param gateway The gateway.
+ * @param connection Connection the request came from.
+ * @param adu MBAP or RTU (with CRC) ADU to send, valid during the call.
+ * @param size Size of adu.
+ *
+ * @note : runs on the context of the scheduler of the bus (ISR included),
+ *         hand the ADU to the TCP stack without blocking.
+ */
+typedef void (*ModbusRTU_GatewayReplyT)(struct _modbusGateway *gateway,
+		void *connection, const uint8_t *adu, size_t size);
+
+/*!
+ * @typedef @struct  _modbusGatewayBus
+ * @brief one RTU bus and the unit IDs routed to it.
+ */
+typedef struct _modbusGatewayBus{
+	ModbusRTU_SchedulerT *scheduler; /*! scheduler of the bus */
+	uint8_t firstUnitId; /*! first unit ID of the bus */
+	uint8_t lastUnitId; /*! last unit ID of the bus */
+} ModbusRTU_GatewayBusT;
+
+/*!
+ * @typedef @struct  _modbusGatewayTransaction
+ * @brief one client request on its way through an RTU bus.
+ */
+typedef struct _modbusGatewayTransaction{
+	ModbusRTU_RequestT request; /*! one shot on the bus scheduler, context = this */
+	struct _modbusGateway *gateway; /*! owner */
+	void *connection; /*! NULL once the connection is gone */
+	uint16_t transactionId; /*! MBAP transaction ID */
+	bool isRtuFraming; /*! RTU over TCP: answer with address and CRC */
+	union {
+		uint16_t registers[MODBUS_RTU_MAX_WRITE_REGISTERS]; /*! request values */
+		uint8_t bits[(MODBUS_RTU_MAX_WRITE_BITS + 7) / 8]; /*! request values */
+		uint8_t adu[MODBUS_RTU_GATEWAY_MAX_ADU_SIZE]; /*! the reply, once the bus answered */
+	} buffer;
+} ModbusRTU_GatewayTransactionT;
+
+/*!
+ * @typedef @struct  _modbusGateway
+ * @brief gateway of several RTU buses.
+ */
+typedef struct _modbusGateway{
+	ModbusRTU_GatewayBusT buses[MODBUS_RTU_GATEWAY_MAX_BUSES]; /*! routes */
+	uint8_t busCount; /*! used entries of buses */
+	ModbusRTU_GatewayTransactionT transactions[MODBUS_RTU_GATEWAY_MAX_TRANSACTIONS]; /*! transaction table */
+	volatile uint32_t busyMask; /*! bit n: transactions[n] in use */
+	uint8_t priority; /*! scheduler priority of client requests, 0 by default */
+	ModbusRTU_GatewayReplyT replyCallback; /*! sends an answer */
+	void *context; /*! free for the application */
+} ModbusRTU_GatewayT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUGatewayInit(ModbusRTU_GatewayT *gateway, ModbusRTU_GatewayReplyT replyCallback)
+ * @brief Initialize a gateway without buses.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param replyCallback Sends the answers to the connections.
+ */
+void modbusRTUGatewayInit(ModbusRTU_GatewayT *gateway,
+		ModbusRTU_GatewayReplyT replyCallback);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUGatewayAddBus(ModbusRTU_GatewayT *gateway, ModbusRTU_SchedulerT *scheduler, uint8_t firstUnitId, uint8_t lastUnitId)
+ * @brief Route a range of unit IDs to the scheduler of an RTU bus.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param scheduler Scheduler of the bus, may carry its own polls as well.
+ * @param firstUnitId First unit ID of the range (0 routes broadcasts).
+ * @param lastUnitId Last unit ID of the range.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : the first matching range wins.
+ */
+ModbusRTU_ErrorT modbusRTUGatewayAddBus(ModbusRTU_GatewayT *gateway,
+		ModbusRTU_SchedulerT *scheduler, uint8_t firstUnitId,
+		uint8_t lastUnitId);
+
+/*!
+ * @fn    size_t modbusRTUGatewayFrameSize(const uint8_t *data, size_t size)
+ * @brief Size of the MBAP ADU at the start of a TCP stream.
+ *
+ * @param data Received stream bytes.
+ * @param size Bytes in data.
+ * @return ADU size, 0 while the MBAP length field is incomplete.
+ */
+size_t modbusRTUGatewayFrameSize(const uint8_t *data, size_t size);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUGatewayRequest(ModbusRTU_GatewayT *gateway, void *connection, const uint8_t *adu, size_t size)
+ * @brief Forward one modBus TCP ADU (MBAP header + PDU) to its bus.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param connection Identifies the client, given back to replyCallback.
+ * @param adu The ADU, may be reused as soon as this returns.
+ * @param size Size of adu.
+ * @return MODBUS_RTU_SUCCESS when queued, MODBUS_RTU_ERROR_INVALID_FRAME when
+ *         dropped, else the reason it was answered with an exception.
+ *
+ * @note : quantities past the MODBUS_RTU_HANDLE_MAX_* limits of the RTU
+ *         handles are answered with ILLEGAL_DATA_VALUE, not forwarded.
+ */
+ModbusRTU_ErrorT modbusRTUGatewayRequest(ModbusRTU_GatewayT *gateway,
+		void *connection, const uint8_t *adu, size_t size);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUGatewayRequestRtu(ModbusRTU_GatewayT *gateway, void *connection, const uint8_t *adu, size_t size)
+ * @brief Forward one RTU over TCP ADU (address + PDU + CRC) to its bus.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param connection Identifies the client, given back to replyCallback.
+ * @param adu The ADU, may be reused as soon as this returns.
+ * @param size Size of adu.
+ * @return see @ref modbusRTUGatewayRequest, a bad CRC drops the ADU.
+ */
+ModbusRTU_ErrorT modbusRTUGatewayRequestRtu(ModbusRTU_GatewayT *gateway,
+		void *connection, const uint8_t *adu, size_t size);
+
+/*!
+ * @fn    void modbusRTUGatewayDisconnect(ModbusRTU_GatewayT *gateway, void *connection)
+ * @brief Forget a closed connection, its transactions finish without a reply.
+ *
+ * @param gateway Pointer to the gateway.
+ * @param connection The closed connection.
+ */
+void modbusRTUGatewayDisconnect(ModbusRTU_GatewayT *gateway,
+		void *connection);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_GATEWAY_H
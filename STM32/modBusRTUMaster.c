@@ -0,0 +1,1297 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUMaster.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU master request scheduler.
+ ******************************************************************************
+ *
+ * This file provides the master side poll scheduler. It owns the bus of
+ * one ModbusRTU instance through its eventCallback and chains requests
+ * on the frame received / timeout / bus idle events, merging neighbouring
+ * register reads on the way and, with a cache, answering fresh reads
+ * without the bus. Broadcasts finish at TX complete, their turnaround
+ * delay keeps the bus busy instead of a response timeout. Every response
+ * updates the response time estimate of its slave, which sets the timeout
+ * of the next request to it.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUFrame.h"
+#ifdef MODBUS_RTU_USE_POOL
+#include "modBusRTUPool.h"
+#endif
+/* 3. Module Header File */
+#include <modBusRTUMaster.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+/* 2. Static Variables */
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_SchedulerEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event);
+static void ModbusRTU_SchedulerCollect(ModbusRTU_SchedulerT *scheduler);
+static void ModbusRTU_SchedulerIssue(ModbusRTU_SchedulerT *scheduler);
+static ModbusRTU_RequestT* ModbusRTU_SchedulerSelect(
+		ModbusRTU_SchedulerT *scheduler, uint32_t now);
+static void ModbusRTU_SchedulerDispatch(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_RequestT *request, ModbusRTU_ErrorT result,
+		const uint8_t *data, size_t dataSize);
+static void ModbusRTU_SchedulerFinish(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_RequestT *request, ModbusRTU_ErrorT result,
+		const uint8_t *data, size_t dataSize);
+static size_t ModbusRTU_BuildRequest(const ModbusRTU_RequestT *request,
+		uint8_t *pdu, size_t *responseSize);
+static bool ModbusRTU_IsReadFunction(uint8_t functionCode);
+static ModbusRTU_RequestT* ModbusRTU_SchedulerCoalesce(
+		ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *first,
+		uint32_t now);
+static ModbusRTU_ErrorT ModbusRTU_SchedulerQueue(
+		ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request);
+static ModbusRTU_SlaveHealthT* ModbusRTU_SchedulerHealth(
+		ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, bool isAdd);
+static void ModbusRTU_SchedulerLearn(ModbusRTU_SchedulerT *scheduler,
+		uint8_t slaveId, ModbusRTU_ErrorT result);
+static uint32_t ModbusRTU_SchedulerTimeout(ModbusRTU_SchedulerT *scheduler,
+		uint8_t slaveId);
+static bool ModbusRTU_SchedulerIsOffline(ModbusRTU_SchedulerT *scheduler,
+		uint8_t slaveId, uint32_t now);
+static bool ModbusRTU_SchedulerIsLate(ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_RequestT *request, uint32_t now);
+static uint8_t ModbusRTU_SchedulerRank(const ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_RequestT *request, uint32_t now);
+#ifdef MODBUS_RTU_USE_POOL
+static size_t ModbusRTU_RequestValuesSize(const ModbusRTU_RequestT *request);
+#endif
+#ifdef MODBUS_RTU_USE_CACHE
+static bool ModbusRTU_SchedulerServeCached(ModbusRTU_SchedulerT *scheduler,
+		uint32_t now);
+static void ModbusRTU_SchedulerInvalidate(ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_RequestT *request);
+#endif
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUSchedulerInit(ModbusRTU_SchedulerT *scheduler, ModbusRTU_HandleT *modbus)
+ * @brief Attach a scheduler to a modBus RTU instance.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param modbus Pointer to the ModbusRTU instance (uses its eventCallback).
+ */
+void modbusRTUSchedulerInit(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_HandleT *modbus) {
+	memset(scheduler, 0, sizeof(*scheduler));
+	scheduler->modbus = modbus;
+	scheduler->isCoalescing = true;
+	scheduler->coalesceGap = MODBUS_RTU_SCHEDULER_COALESCE_GAP;
+	scheduler->timeoutMinMs = MODBUS_RTU_SCHEDULER_TIMEOUT_MIN;
+	scheduler->timeoutMaxMs = modbus->responseTimeoutMs;
+	scheduler->offlineAfter = MODBUS_RTU_SCHEDULER_OFFLINE_AFTER;
+	scheduler->backoffMinMs = MODBUS_RTU_SCHEDULER_BACKOFF_MIN;
+	scheduler->backoffMaxMs = MODBUS_RTU_SCHEDULER_BACKOFF_MAX;
+	scheduler->starveMs = MODBUS_RTU_SCHEDULER_STARVE_MS;
+
+	/* chain the next request on the bus events */
+	modbus->userContext = scheduler;
+	modbus->eventCallback = ModbusRTU_SchedulerEvent;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSchedulerAdd(ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request)
+ * @brief Queue a request, due immediately.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request Request, must stay valid while queued.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : a broadcast (slaveId 0) finishes successfully once it is sent,
+ *         without data. With slaveIds the callback runs once per slave,
+ *         and the slaves follow each other with only requests of a more
+ *         urgent class in between; a period restarts the whole list. A
+ *         request that cannot be answered within deadlineMs finishes with
+ *         MODBUS_RTU_ERROR_LATE without the bus, e.g. an urgent write waits
+ *         for the transaction on the bus, never for the poll list.
+ */
+ModbusRTU_ErrorT modbusRTUSchedulerAdd(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_RequestT *request) {
+#ifdef MODBUS_RTU_USE_POOL
+	request->isPooled = false;
+#endif
+	return ModbusRTU_SchedulerQueue(scheduler, request);
+}
+
+#ifdef MODBUS_RTU_USE_POOL
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSchedulerSubmit(ModbusRTU_SchedulerT *scheduler, const ModbusRTU_RequestT *request)
+ * @brief Queue a one shot copy of a request and its values in a pool block.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request Request template, may be reused as soon as this returns.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : periodMs is ignored. The callback gets the copy, which is freed
+ *         when it returns: do not re-queue it or keep the pointer. A
+ *         fan-out list is not copied, it must stay valid.
+ */
+ModbusRTU_ErrorT modbusRTUSchedulerSubmit(ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_RequestT *request) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	size_t valuesSize = ModbusRTU_RequestValuesSize(request);
+	ModbusRTU_RequestT *copy = (ModbusRTU_RequestT*) modbusRTUPoolAlloc(
+			sizeof(ModbusRTU_RequestT) + valuesSize);
+
+	if (NULL == copy) {
+		result = MODBUS_RTU_ERROR_NO_BUFFER;
+	} else {
+		*copy = *request;
+		copy->periodMs = 0;
+		copy->isPooled = true;
+		if (0 != valuesSize) {
+			/* the values follow the request in the same block */
+			memcpy(copy + 1, request->values, valuesSize);
+			copy->values = copy + 1;
+		}
+
+		result = ModbusRTU_SchedulerQueue(scheduler, copy);
+		if (MODBUS_RTU_SUCCESS != result) {
+			modbusRTUPoolFree(copy);
+		}
+	}
+
+	return result;
+}
+#endif
+
+#ifdef MODBUS_RTU_USE_CACHE
+/*!
+ * @fn    void modbusRTUSchedulerSetCache(ModbusRTU_SchedulerT *scheduler, ModbusRTU_CacheT *cache)
+ * @brief Answer reads from a response cache, NULL to stop.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param cache Cache of this scheduler only, initialized by modbusRTUCacheInit.
+ *
+ * @note : due FC 0x01-0x04 requests whose values are all fresh finish at
+ *         once, even while the bus is busy. Responses fill the cache and
+ *         the writes of the scheduler drop the values they change; writes
+ *         of other masters are only covered by the TTL.
+ */
+void modbusRTUSchedulerSetCache(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_CacheT *cache) {
+	scheduler->cache = cache;
+}
+#endif
+
+/*!
+ * @fn    const ModbusRTU_SlaveHealthT* modbusRTUSchedulerGetHealth(ModbusRTU_SchedulerT *scheduler, uint8_t slaveId)
+ * @brief Response time estimate and reachability of a slave.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param slaveId The modBus slave ID.
+ * @return the entry, NULL when the slave was never polled or the table is full.
+ *
+ * @note : the timeout is srtt + 4 * rttvar (RFC 6298 smoothing) within
+ *         timeoutMinMs and timeoutMaxMs. After a timeout the next request
+ *         waits timeoutMaxMs. Requests to an offline slave finish with
+ *         MODBUS_RTU_ERROR_SLAVE_OFFLINE without the bus until retryMs.
+ */
+const ModbusRTU_SlaveHealthT* modbusRTUSchedulerGetHealth(
+		ModbusRTU_SchedulerT *scheduler, uint8_t slaveId) {
+	return ModbusRTU_SchedulerHealth(scheduler, slaveId, false);
+}
+
+/*!
+ * @fn    void modbusRTUSchedulerSetLine(ModbusRTU_SchedulerT *scheduler, uint32_t baudRate, uint8_t parity)
+ * @brief Move the bus to another baud rate and parity before the next request.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param baudRate The new baud rate.
+ * @param parity MODBUS_RTU_PARITY_xxx.
+ *
+ * @note : the step up of a bus once every slave was told to switch, e.g.
+ *         from the callback of a fan-out write of their line register. A
+ *         fan-out in progress ends first, the learned response timeouts
+ *         start again on the new line.
+ */
+void modbusRTUSchedulerSetLine(ModbusRTU_SchedulerT *scheduler,
+		uint32_t baudRate, uint8_t parity) {
+
+	/* local variable */
+	uint32_t lock = modbusRTUPortEnterCritical();
+
+	scheduler->lineParity = parity;
+	scheduler->lineBaudRate = baudRate;
+	modbusRTUPortExitCritical(lock);
+	modbusRTUSchedulerProcess(scheduler);
+}
+
+/*!
+ * @fn    void modbusRTUSchedulerRemove(ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request)
+ * @brief Remove a queued request (an active one still gets its callback).
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request Request to remove.
+ */
+void modbusRTUSchedulerRemove(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_RequestT *request) {
+
+	/* local variable */
+	uint32_t lock = 0;
+
+	lock = modbusRTUPortEnterCritical();
+	for (uint8_t i = 0; i < scheduler->requestCount; i++) {
+		if (scheduler->requests[i] == request) {
+			/* keep the queue order, the scan prefers earlier entries on ties */
+			memmove(&scheduler->requests[i], &scheduler->requests[i + 1],
+					(scheduler->requestCount - i - 1)
+							* sizeof(scheduler->requests[0]));
+			scheduler->requestCount--;
+			if (scheduler->fanOut == request) {
+				scheduler->fanOut = NULL;
+			}
+			break;
+		}
+	}
+	modbusRTUPortExitCritical(lock);
+}
+
+/*!
+ * @fn    void modbusRTUSchedulerProcess(ModbusRTU_SchedulerT *scheduler)
+ * @brief Collect the finished response and issue the next due request.
+ *
+ * @param scheduler Pointer to the scheduler.
+ *
+ * @note : runs by itself on every bus event (ISR context). Call it from the
+ *         main loop as well so periodic requests start when they fall due.
+ */
+void modbusRTUSchedulerProcess(ModbusRTU_SchedulerT *scheduler) {
+
+	/* local variable */
+	uint32_t lock = 0;
+	bool isOwner = false;
+	bool isAgain = false;
+
+	/* only one context runs the scheduler, the other one leaves a note */
+	lock = modbusRTUPortEnterCritical();
+	if (true == scheduler->isInProcess) {
+		scheduler->isPending = true;
+	} else {
+		scheduler->isInProcess = true;
+		isOwner = true;
+	}
+	modbusRTUPortExitCritical(lock);
+
+	while (true == isOwner) {
+		scheduler->isPending = false;
+
+		ModbusRTU_SchedulerCollect(scheduler);
+		ModbusRTU_SchedulerIssue(scheduler);
+
+		lock = modbusRTUPortEnterCritical();
+		isAgain = scheduler->isPending;
+		if (false == isAgain) {
+			scheduler->isInProcess = false;
+			isOwner = false;
+		}
+		modbusRTUPortExitCritical(lock);
+	}
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_SchedulerEvent(ModbusRTU_HandleT *modbus, ModbusRTU_EventT event)
+ * @brief eventCallback of the bus: every event may finish or allow a request.
+ *
+ * @param modbus Pointer to the ModbusRTU instance.
+ * @param event What happened.
+ */
+static void ModbusRTU_SchedulerEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event) {
+
+	/* local variable */
+	ModbusRTU_SchedulerT *scheduler = (ModbusRTU_SchedulerT*) modbus->userContext;
+
+	if (MODBUS_RTU_EVENT_TX_COMPLETE == event) {
+		/* the response time of the active request runs from here */
+		scheduler->txEndMs = modbusRTUPortGetTickMs();
+	}
+	modbusRTUSchedulerProcess(scheduler);
+}
+
+/*!
+ * @fn    static void ModbusRTU_SchedulerCollect(ModbusRTU_SchedulerT *scheduler)
+ * @brief Hand the response (or timeout) of the active request to its callback.
+ *
+ * @param scheduler Pointer to the scheduler.
+ */
+static void ModbusRTU_SchedulerCollect(ModbusRTU_SchedulerT *scheduler) {
+
+	/* local variable */
+	ModbusRTU_RequestT *request = scheduler->active;
+	ModbusRTU_FrameViewT frame = { 0 };
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	const uint8_t *data = NULL;
+	size_t dataSize = 0;
+	size_t responseSize = 0;
+	bool isBroadcast = false;
+
+	if (NULL != request) {
+		isBroadcast = (MODBUS_RTU_BROADCAST_ID == request->slaveId);
+		if (false == isBroadcast) {
+			result = modbusRTUGetRxFrame(scheduler->modbus, &frame);
+		} else if (MODBUS_RTU_TX_ACTIVE != scheduler->modbus->txState) {
+			/* nobody answers, done as soon as the frame is out */
+			result = (MODBUS_RTU_TX_DONE == scheduler->modbus->txState) ?
+					MODBUS_RTU_SUCCESS : MODBUS_RTU_ERROR_TX_FAILED;
+		}
+	}
+
+	if ((MODBUS_RTU_RX_BUSY != result) && (true == isBroadcast)) {
+		scheduler->active = NULL;
+		ModbusRTU_SchedulerDispatch(scheduler, request, result, NULL, 0);
+	} else if (MODBUS_RTU_RX_BUSY != result) {
+		if (MODBUS_RTU_SUCCESS == result) {
+			ModbusRTU_BuildRequest(request, NULL, &responseSize);
+			if (frame.functionCode != request->functionCode) {
+				result = MODBUS_RTU_ERROR_INVALID_FRAME;
+			} else if (MODBUS_FUNC_READ_FIFO_QUEUE == frame.functionCode) {
+				/* up to quantity registers, skip the byte count */
+				if ((frame.dataSize < MODBUS_RTU_READ_FIFO_RESPONSE_SIZE(0))
+						|| (frame.dataSize > responseSize)
+						|| (modbusRTUGetU16(&frame.data[0]) != frame.dataSize - 2)
+						|| (frame.dataSize
+								!= (size_t) MODBUS_RTU_READ_FIFO_RESPONSE_SIZE(
+										modbusRTUGetU16(&frame.data[2])))) {
+					result = MODBUS_RTU_ERROR_INVALID_FRAME;
+				} else {
+					data = &frame.data[2];
+					dataSize = frame.dataSize - 2;
+				}
+			} else if (frame.dataSize != responseSize) {
+				result = MODBUS_RTU_ERROR_INVALID_FRAME;
+			} else if (true == ModbusRTU_IsReadFunction(frame.functionCode)) {
+				/* skip the byte count */
+				if (frame.data[0] != responseSize - 1) {
+					result = MODBUS_RTU_ERROR_INVALID_FRAME;
+				} else {
+					data = &frame.data[1];
+					dataSize = responseSize - 1;
+				}
+			} else {
+				data = frame.data;
+				dataSize = frame.dataSize;
+			}
+		} else if (MODBUS_RTU_ERROR_EXCEPTION == result) {
+			data = frame.data;
+			dataSize = frame.dataSize;
+		}
+
+		ModbusRTU_SchedulerLearn(scheduler, request->slaveId, result);
+		scheduler->active = NULL;
+		ModbusRTU_SchedulerDispatch(scheduler, request, result, data, dataSize);
+		modbusRTUReleaseRxFrame(scheduler->modbus);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_SchedulerIssue(ModbusRTU_SchedulerT *scheduler)
+ * @brief Send the most urgent due request if the bus is free.
+ *
+ * @param scheduler Pointer to the scheduler.
+ */
+static void ModbusRTU_SchedulerIssue(ModbusRTU_SchedulerT *scheduler) {
+
+	/* local variable */
+	ModbusRTU_HandleT *modbus = scheduler->modbus;
+	ModbusRTU_RequestT *best = NULL;
+	uint32_t now = modbusRTUPortGetTickMs();
+	uint8_t *pdu = NULL;
+	size_t pduSize = 0;
+	size_t responseSize = 0;
+	ModbusRTU_ErrorT skipped = MODBUS_RTU_RX_BUSY; /* enters the skip loop */
+
+#ifdef MODBUS_RTU_USE_CACHE
+	/* one pass over the queue at most: a stalled poll stays due after a hit */
+	for (uint8_t i = 0; (NULL != scheduler->cache)
+			&& (i < MODBUS_RTU_SCHEDULER_MAX_REQUESTS)
+			&& (true == ModbusRTU_SchedulerServeCached(scheduler, now)); i++) {
+	}
+#endif
+
+	if ((0 != scheduler->lineBaudRate) && (NULL == scheduler->active)
+			&& (NULL == scheduler->fanOut)
+			&& (MODBUS_RTU_RX_BUSY
+					!= modbusRTUSetLine(modbus, scheduler->lineBaudRate,
+							scheduler->lineParity))) {
+		/* response times of the old line say nothing about the new one */
+		scheduler->lineBaudRate = 0;
+		for (uint8_t i = 0; i < MODBUS_RTU_SCHEDULER_SLAVES; i++) {
+			scheduler->health[i].isMeasured = false;
+		}
+	}
+
+	if ((NULL == scheduler->active) && (true == modbusRTUIsBusIdle(modbus))
+			&& (MODBUS_RTU_TX_ACTIVE != modbus->txState)) {
+		/* requests to offline slaves and late ones finish without the bus,
+		 * one pass over the queue at most */
+		for (uint8_t i = 0; (MODBUS_RTU_SUCCESS != skipped)
+				&& (i < MODBUS_RTU_SCHEDULER_MAX_REQUESTS); i++) {
+			best = ModbusRTU_SchedulerSelect(scheduler, now);
+			skipped = MODBUS_RTU_SUCCESS;
+			if (NULL == best) {
+				/* nothing due */
+			} else if (true
+					== ModbusRTU_SchedulerIsOffline(scheduler, best->slaveId, now)) {
+				skipped = MODBUS_RTU_ERROR_SLAVE_OFFLINE;
+			} else if (true == ModbusRTU_SchedulerIsLate(scheduler, best, now)) {
+				skipped = MODBUS_RTU_ERROR_LATE;
+			}
+			if (MODBUS_RTU_SUCCESS != skipped) {
+				ModbusRTU_SchedulerFinish(scheduler, best, skipped, NULL, 0);
+				best = NULL;
+			}
+		}
+	}
+
+	if (NULL != best) {
+		best = ModbusRTU_SchedulerCoalesce(scheduler, best, now);
+		pduSize = ModbusRTU_BuildRequest(best, NULL, &responseSize);
+
+		if ((0 == pduSize)
+				|| ((MODBUS_RTU_BROADCAST_ID == best->slaveId)
+						&& ((true == ModbusRTU_IsReadFunction(best->functionCode))
+								|| (MODBUS_FUNC_READ_FIFO_QUEUE
+										== best->functionCode)))) {
+			/* a broadcast read would never be answered */
+			ModbusRTU_SchedulerDispatch(scheduler, best,
+					MODBUS_RTU_ERROR_INVALID_FRAME, NULL, 0);
+		} else if (NULL == (pdu = modbusRTUAllocTxBuffer(modbus, pduSize))) {
+			/* pool exhausted, retried on the next event */
+			scheduler->memberCount = 0;
+		} else {
+			ModbusRTU_BuildRequest(best, pdu, &responseSize);
+			modbus->slaveId = best->slaveId;
+			scheduler->active = best;
+#ifdef MODBUS_RTU_USE_CACHE
+			/* no read is answered from values the write is changing */
+			ModbusRTU_SchedulerInvalidate(scheduler, best);
+#endif
+			if (MODBUS_RTU_SUCCESS
+					!= modbusRTUCommitTxDMA(modbus, best->functionCode,
+							pduSize)) {
+				scheduler->active = NULL;
+				ModbusRTU_SchedulerDispatch(scheduler, best,
+						MODBUS_RTU_ERROR_TX_FAILED, NULL, 0);
+			} else if (MODBUS_RTU_BROADCAST_ID != best->slaveId) {
+				/* response timeout of this slave, it starts at TC; a long
+				 * response is only seen after its first DMA half */
+				modbus->responseTimeoutMs = ModbusRTU_SchedulerTimeout(scheduler,
+						best->slaveId)
+						+ (MODBUS_RTU_FRAME_SIZE(responseSize) * modbus->charTicks
+								+ MODBUS_RTU_TIMER_TICK_HZ / 1000 - 1)
+								/ (MODBUS_RTU_TIMER_TICK_HZ / 1000);
+				if (MODBUS_RTU_SUCCESS
+						!= modbusRTUReciveData(modbus, responseSize)) {
+					/* no response wait armed, the request would hang the bus */
+					scheduler->active = NULL;
+					ModbusRTU_SchedulerDispatch(scheduler, best,
+							MODBUS_RTU_ERROR_INVALID_FRAME, NULL, 0);
+				}
+			}
+		}
+	}
+}
+
+/*!
+ * @fn    static ModbusRTU_RequestT* ModbusRTU_SchedulerSelect(ModbusRTU_SchedulerT *scheduler, uint32_t now)
+ * @brief Pick the request to send next.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param now modbusRTUPortGetTickMs() of this scheduling pass.
+ * @return the most urgent due request, NULL when none is due.
+ */
+static ModbusRTU_RequestT* ModbusRTU_SchedulerSelect(
+		ModbusRTU_SchedulerT *scheduler, uint32_t now) {
+
+	/* local variable */
+	ModbusRTU_RequestT *fanOut = scheduler->fanOut;
+	ModbusRTU_RequestT *result = fanOut;
+	ModbusRTU_RequestT *request = NULL;
+	uint8_t resultRank = (NULL == fanOut) ? 0 : fanOut->priority;
+	uint8_t rank = 0;
+
+	/* highest rank first, the longest overdue among equals; the rest of a
+	 * fan-out follows with only a more urgent class in between */
+	for (uint8_t i = 0; i < scheduler->requestCount; i++) {
+		request = scheduler->requests[i];
+		if (((int32_t) (now - request->nextDueMs) >= 0) && (request != fanOut)
+				&& ((NULL == fanOut) || (request->priority < fanOut->priority))) {
+			rank = ModbusRTU_SchedulerRank(scheduler, request, now);
+			if ((NULL == result) || (rank < resultRank)
+					|| ((rank == resultRank)
+							&& ((int32_t) (request->nextDueMs
+									- result->nextDueMs) < 0))) {
+				result = request;
+				resultRank = rank;
+			}
+		}
+	}
+
+	if ((NULL != result) && (NULL != result->slaveIds)) {
+		result->slaveId = result->slaveIds[result->slaveIndex];
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static ModbusRTU_RequestT* ModbusRTU_SchedulerCoalesce(ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *first, uint32_t now)
+ * @brief Merge the due reads next to first into one read of up to
+ *        MODBUS_RTU_HANDLE_MAX_READ_REGISTERS registers.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param first The request chosen to run next.
+ * @param now modbusRTUPortGetTickMs() of this scheduling pass.
+ * @return first when nothing could be merged, else the combined request.
+ */
+static ModbusRTU_RequestT* ModbusRTU_SchedulerCoalesce(
+		ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *first,
+		uint32_t now) {
+
+	/* local variable */
+	ModbusRTU_RequestT *result = first;
+	ModbusRTU_RequestT *request = NULL;
+	uint32_t spanStart = first->address;
+	uint32_t spanEnd = (uint32_t) first->address + first->quantity;
+	uint32_t start = 0, end = 0;
+	bool isGrown = true;
+	bool isMember = false;
+
+	scheduler->memberCount = 0;
+
+	/* a request with a deadline keeps the airtime it was planned with */
+	if ((true == scheduler->isCoalescing) && (NULL == first->slaveIds)
+			&& (0 == first->deadlineMs)
+			&& ((MODBUS_FUNC_READ_HOLDING_REGISTERS == first->functionCode)
+					|| (MODBUS_FUNC_READ_INPUT_REGISTERS == first->functionCode))
+			&& (first->quantity > 0)
+			&& (first->quantity <= MODBUS_RTU_HANDLE_MAX_READ_REGISTERS)) {
+		scheduler->members[scheduler->memberCount++] = first;
+
+		/* grow the span until no due neighbour fits any more */
+		while (true == isGrown) {
+			isGrown = false;
+			for (uint8_t i = 0; i < scheduler->requestCount; i++) {
+				request = scheduler->requests[i];
+				isMember = false;
+				for (uint8_t j = 0; j < scheduler->memberCount; j++) {
+					isMember |= (scheduler->members[j] == request);
+				}
+				if ((true == isMember) || (NULL != request->slaveIds)
+						|| (0 != request->deadlineMs)
+						|| (request->slaveId != first->slaveId)
+						|| (request->functionCode != first->functionCode)
+						|| (0 == request->quantity)
+						|| ((int32_t) (now - request->nextDueMs) < 0)) {
+					continue;
+				}
+
+				start = request->address;
+				end = start + request->quantity;
+				if ((start <= spanEnd + scheduler->coalesceGap)
+						&& (end + scheduler->coalesceGap >= spanStart)
+						&& ((((end > spanEnd) ? end : spanEnd)
+								- ((start < spanStart) ? start : spanStart))
+								<= MODBUS_RTU_HANDLE_MAX_READ_REGISTERS)) {
+					spanStart = (start < spanStart) ? start : spanStart;
+					spanEnd = (end > spanEnd) ? end : spanEnd;
+					scheduler->members[scheduler->memberCount++] = request;
+					isGrown = true;
+				}
+			}
+		}
+	}
+
+	if (scheduler->memberCount > 1) {
+		memset(&scheduler->merged, 0, sizeof(scheduler->merged));
+		scheduler->merged.slaveId = first->slaveId;
+		scheduler->merged.functionCode = first->functionCode;
+		scheduler->merged.address = (uint16_t) spanStart;
+		scheduler->merged.quantity = (uint16_t) (spanEnd - spanStart);
+		scheduler->merged.priority = first->priority;
+		result = &scheduler->merged;
+	} else {
+		scheduler->memberCount = 0;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_SchedulerDispatch(ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Finish a transaction, splitting a combined read back to its members.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request The request that was on the bus.
+ * @param result Result of the transaction.
+ * @param data Response values, see @ref ModbusRTU_RequestCallbackT.
+ * @param dataSize Size of data.
+ */
+static void ModbusRTU_SchedulerDispatch(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_RequestT *request, ModbusRTU_ErrorT result,
+		const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_RequestT *member = NULL;
+
+#ifdef MODBUS_RTU_USE_CACHE
+	if ((NULL != scheduler->cache) && (MODBUS_RTU_SUCCESS == result)
+			&& (request->functionCode >= MODBUS_FUNC_READ_COILS)
+			&& (request->functionCode <= MODBUS_FUNC_READ_INPUT_REGISTERS)) {
+		/* the requests waiting for the same values get them on the next pass */
+		modbusRTUCacheStore(scheduler->cache, request->slaveId,
+				request->functionCode, request->address, request->quantity,
+				data, modbusRTUPortGetTickMs());
+	}
+#endif
+
+	if (request == &scheduler->merged) {
+		for (uint8_t i = 0; i < scheduler->memberCount; i++) {
+			member = scheduler->members[i];
+			if (MODBUS_RTU_SUCCESS == result) {
+				/* 2 bytes per register from the start of the combined read */
+				ModbusRTU_SchedulerFinish(scheduler, member, result,
+						&data[2 * (member->address - request->address)],
+						2 * member->quantity);
+			} else {
+				ModbusRTU_SchedulerFinish(scheduler, member, result, data,
+						dataSize);
+			}
+		}
+		scheduler->memberCount = 0;
+	} else {
+		ModbusRTU_SchedulerFinish(scheduler, request, result, data, dataSize);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_SchedulerFinish(ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Plan the next run of a request (or drop a one shot) and report the result.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request The finished request.
+ * @param result Result of the transaction.
+ * @param data Response values, see @ref ModbusRTU_RequestCallbackT.
+ * @param dataSize Size of data.
+ */
+static void ModbusRTU_SchedulerFinish(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_RequestT *request, ModbusRTU_ErrorT result,
+		const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	uint32_t now = modbusRTUPortGetTickMs();
+
+	if ((NULL != request->slaveIds)
+			&& (++request->slaveIndex < request->slaveCount)) {
+		/* the next slave of the fan-out gets the bus right away */
+		scheduler->fanOut = request;
+	} else if (0 == request->periodMs) {
+		modbusRTUSchedulerRemove(scheduler, request);
+	} else {
+		request->slaveIndex = 0;
+		if (scheduler->fanOut == request) {
+			scheduler->fanOut = NULL;
+		}
+		/* keep the phase, but do not burst to catch up after a stall */
+		request->nextDueMs += request->periodMs;
+		if ((int32_t) (now - request->nextDueMs) > 0) {
+			request->nextDueMs = now;
+		}
+	}
+
+	/* last, the callback may re-queue or remove the request */
+	if (NULL != request->callback) {
+		request->callback(request, result, data, dataSize);
+	}
+#ifdef MODBUS_RTU_USE_POOL
+	if ((true == request->isPooled) && (scheduler->fanOut != request)) {
+		modbusRTUPoolFree(request);
+	}
+#endif
+}
+
+/*!
+ * @fn    static size_t ModbusRTU_BuildRequest(const ModbusRTU_RequestT *request, uint8_t *pdu, size_t *responseSize)
+ * @brief Write the request PDU data (after the function code) and size the response.
+ *
+ * @param request The request.
+ * @param pdu TX buffer data area, NULL to only compute responseSize.
+ * @param responseSize Expected response PDU data size.
+ * @return PDU data size, 0 for an unsupported function or quantity.
+ *
+ * @note : quantities are bounded by the MODBUS_RTU_HANDLE_MAX_* limits, the
+ *         request and the response both have to fit the frames of the handle.
+ */
+static size_t ModbusRTU_BuildRequest(const ModbusRTU_RequestT *request,
+		uint8_t *pdu, size_t *responseSize) {
+
+	/* local variable */
+	const uint8_t *bits = (const uint8_t*) request->values;
+	const uint16_t *registers = (const uint16_t*) request->values;
+	uint16_t quantity = request->quantity;
+	uint16_t groups = 0;
+	size_t pduSize = 0;
+
+	*responseSize = MODBUS_RTU_WRITE_RESPONSE_SIZE;
+
+	switch (request->functionCode) {
+	case MODBUS_FUNC_READ_COILS:
+	case MODBUS_FUNC_READ_DISCRETE_INPUTS:
+		if ((quantity > 0) && (quantity <= MODBUS_RTU_HANDLE_MAX_READ_BITS)) {
+			pduSize = MODBUS_RTU_READ_REQUEST_SIZE;
+			*responseSize = MODBUS_RTU_READ_BITS_RESPONSE_SIZE(quantity);
+			if (NULL != pdu) {
+				modbusRTUFrameRead(pdu, request->address, quantity);
+			}
+		}
+		break;
+	case MODBUS_FUNC_READ_HOLDING_REGISTERS:
+	case MODBUS_FUNC_READ_INPUT_REGISTERS:
+		if ((quantity > 0) && (quantity <= MODBUS_RTU_HANDLE_MAX_READ_REGISTERS)) {
+			pduSize = MODBUS_RTU_READ_REQUEST_SIZE;
+			*responseSize = MODBUS_RTU_READ_REGISTERS_RESPONSE_SIZE(quantity);
+			if (NULL != pdu) {
+				modbusRTUFrameRead(pdu, request->address, quantity);
+			}
+		}
+		break;
+	case MODBUS_FUNC_WRITE_SINGLE_COIL:
+		if (NULL != bits) {
+			pduSize = MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE;
+			if (NULL != pdu) {
+				modbusRTUFrameWriteSingleCoil(pdu, request->address,
+						0 != (bits[0] & 0x01));
+			}
+		}
+		break;
+	case MODBUS_FUNC_WRITE_SINGLE_REGISTER:
+		if (NULL != registers) {
+			pduSize = MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE;
+			if (NULL != pdu) {
+				modbusRTUFrameWriteSingleRegister(pdu, request->address,
+						registers[0]);
+			}
+		}
+		break;
+	case MODBUS_FUNC_WRITE_MULTY_COIL:
+		if ((NULL != bits) && (quantity > 0)
+				&& (quantity <= MODBUS_RTU_HANDLE_MAX_WRITE_BITS)) {
+			pduSize = MODBUS_RTU_WRITE_COILS_REQUEST_SIZE(quantity);
+			if (NULL != pdu) {
+				modbusRTUFrameWriteMultipleCoils(pdu, request->address,
+						quantity, bits);
+			}
+		}
+		break;
+	case MODBUS_FUNC_WRITE_MULTY_REGISTER:
+		if ((NULL != registers) && (quantity > 0)
+				&& (quantity <= MODBUS_RTU_HANDLE_MAX_WRITE_REGISTERS)) {
+			pduSize = MODBUS_RTU_WRITE_REGISTERS_REQUEST_SIZE(quantity);
+			if (NULL != pdu) {
+				modbusRTUFrameWriteMultipleRegisters(pdu, request->address,
+						quantity, registers);
+			}
+		}
+		break;
+	case MODBUS_FUNC_MASK_WRITE_REGISTER:
+		if (NULL != registers) {
+			pduSize = MODBUS_RTU_MASK_WRITE_REQUEST_SIZE;
+			*responseSize = MODBUS_RTU_MASK_WRITE_RESPONSE_SIZE;
+			if (NULL != pdu) {
+				modbusRTUFrameMaskWriteRegister(pdu, request->address,
+						registers[0], registers[1]);
+			}
+		}
+		break;
+	case MODBUS_FUNC_READ_WRITE_MULTY_REGISTER:
+		if ((NULL != registers) && (quantity > 0)
+				&& (quantity <= MODBUS_RTU_HANDLE_MAX_READ_REGISTERS)
+				&& (request->writeQuantity > 0)
+				&& (request->writeQuantity <= MODBUS_RTU_HANDLE_MAX_RW_WRITE_REGISTERS)) {
+			pduSize = MODBUS_RTU_READ_WRITE_REQUEST_SIZE(request->writeQuantity);
+			*responseSize = MODBUS_RTU_READ_REGISTERS_RESPONSE_SIZE(quantity);
+			if (NULL != pdu) {
+				modbusRTUFrameReadWriteRegisters(pdu, request->address,
+						quantity, request->writeAddress,
+						request->writeQuantity, registers);
+			}
+		}
+		break;
+	case MODBUS_FUNC_READ_FILE_RECORD:
+		if ((0 != request->address) && (quantity > 0)
+				&& (request->writeAddress < MODBUS_RTU_FILE_RECORDS)
+				&& (quantity
+						== modbusRTUFileRecordsFit(false, request->writeAddress,
+								quantity))) {
+			groups = modbusRTUFileGroups(request->writeAddress, quantity);
+			pduSize = MODBUS_RTU_READ_FILE_REQUEST_SIZE(groups);
+			*responseSize = MODBUS_RTU_READ_FILE_RESPONSE_SIZE(groups, quantity);
+			if (NULL != pdu) {
+				modbusRTUFrameReadFileRecord(pdu, request->address,
+						request->writeAddress, quantity);
+			}
+		}
+		break;
+	case MODBUS_FUNC_WRITE_FILE_RECORD:
+		if ((NULL != registers) && (0 != request->address) && (quantity > 0)
+				&& (request->writeAddress < MODBUS_RTU_FILE_RECORDS)
+				&& (quantity
+						== modbusRTUFileRecordsFit(true, request->writeAddress,
+								quantity))) {
+			groups = modbusRTUFileGroups(request->writeAddress, quantity);
+			pduSize = MODBUS_RTU_WRITE_FILE_REQUEST_SIZE(groups, quantity);
+			*responseSize = pduSize; /* echo */
+			if (NULL != pdu) {
+				modbusRTUFrameWriteFileRecord(pdu, request->address,
+						request->writeAddress, quantity, registers);
+			}
+		}
+		break;
+	case MODBUS_FUNC_READ_FIFO_QUEUE:
+		if ((quantity > 0) && (quantity <= MODBUS_RTU_MAX_FIFO_COUNT)) {
+			pduSize = MODBUS_RTU_READ_FIFO_REQUEST_SIZE;
+			/* the longest answer, the FIFO may hold fewer */
+			*responseSize = MODBUS_RTU_READ_FIFO_RESPONSE_SIZE(quantity);
+			if (NULL != pdu) {
+				modbusRTUFrameReadFifoQueue(pdu, request->address);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+
+	return pduSize;
+}
+
+/*!
+ * @fn    static ModbusRTU_ErrorT ModbusRTU_SchedulerQueue(ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request)
+ * @brief Append a request to the queue, due immediately.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request Request, must stay valid while queued.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ */
+static ModbusRTU_ErrorT ModbusRTU_SchedulerQueue(
+		ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	uint32_t lock = 0;
+
+	request->nextDueMs = modbusRTUPortGetTickMs();
+	request->slaveIndex = 0;
+
+	lock = modbusRTUPortEnterCritical();
+	if ((NULL != request->slaveIds) && (0 == request->slaveCount)) {
+		result = MODBUS_RTU_ERROR_INVALID_SLAVE_ID;
+	} else if (scheduler->requestCount >= MODBUS_RTU_SCHEDULER_MAX_REQUESTS) {
+		result = MODBUS_RTU_ERROR_QUEUE_FULL;
+	} else {
+		scheduler->requests[scheduler->requestCount++] = request;
+	}
+	modbusRTUPortExitCritical(lock);
+
+	return result;
+}
+
+/*!
+ * @fn    static ModbusRTU_SlaveHealthT* ModbusRTU_SchedulerHealth(ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, bool isAdd)
+ * @brief Find the estimate of a slave.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param slaveId The modBus slave ID.
+ * @param isAdd Take a free entry for a new slave.
+ * @return the entry, NULL for broadcasts, unknown slaves or a full table.
+ */
+static ModbusRTU_SlaveHealthT* ModbusRTU_SchedulerHealth(
+		ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, bool isAdd) {
+
+	/* local variable */
+	ModbusRTU_SlaveHealthT *result = NULL;
+	ModbusRTU_SlaveHealthT *unused = NULL;
+
+	for (uint8_t i = 0; (MODBUS_RTU_BROADCAST_ID != slaveId)
+			&& (NULL == result) && (i < MODBUS_RTU_SCHEDULER_SLAVES); i++) {
+		if (slaveId == scheduler->health[i].slaveId) {
+			result = &scheduler->health[i];
+		} else if ((NULL == unused)
+				&& (MODBUS_RTU_BROADCAST_ID == scheduler->health[i].slaveId)) {
+			unused = &scheduler->health[i];
+		}
+	}
+
+	if ((NULL == result) && (true == isAdd) && (NULL != unused)) {
+		memset(unused, 0, sizeof(*unused));
+		unused->slaveId = slaveId;
+		result = unused;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_SchedulerLearn(ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, ModbusRTU_ErrorT result)
+ * @brief Update the estimate of a slave with the outcome of a transaction.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param slaveId The modBus slave ID.
+ * @param result Result of the transaction.
+ */
+static void ModbusRTU_SchedulerLearn(ModbusRTU_SchedulerT *scheduler,
+		uint8_t slaveId, ModbusRTU_ErrorT result) {
+
+	/* local variable */
+	ModbusRTU_SlaveHealthT *health = ModbusRTU_SchedulerHealth(scheduler,
+			slaveId, true);
+	uint32_t now = modbusRTUPortGetTickMs();
+	uint32_t sample = now - scheduler->txEndMs;
+	int32_t delta = 0;
+	uint32_t timeout = 0;
+
+	if (NULL == health) {
+		/* broadcast or no free entry: the fixed timeoutMaxMs */
+	} else if (MODBUS_RTU_ERROR_RX_TIMEOUT == result) {
+		if (health->failures < UINT8_MAX) {
+			health->failures++;
+		}
+		if ((0 != scheduler->offlineAfter)
+				&& (health->failures >= scheduler->offlineAfter)) {
+			/* skip the slave, twice as long after every failed try */
+			if (0 == health->backoffMs) {
+				health->backoffMs = scheduler->backoffMinMs;
+			} else if (health->backoffMs > scheduler->backoffMaxMs / 2) {
+				health->backoffMs = scheduler->backoffMaxMs;
+			} else {
+				health->backoffMs *= 2;
+			}
+			health->retryMs = now + health->backoffMs;
+		}
+	} else {
+		/* any answer, even a broken one, shows the slave is there */
+		health->failures = 0;
+		health->backoffMs = 0;
+
+		if ((MODBUS_RTU_SUCCESS == result)
+				|| (MODBUS_RTU_ERROR_EXCEPTION == result)) {
+			/* srtt += (sample - srtt) / 8, rttvar += (|sample - srtt| - rttvar) / 4 */
+			if (false == health->isMeasured) {
+				health->srtt8 = sample << 3;
+				health->rttVar4 = sample << 1;
+				health->isMeasured = true;
+			} else {
+				delta = (int32_t) sample - (int32_t) (health->srtt8 >> 3);
+				health->srtt8 += delta;
+				health->rttVar4 += ((delta < 0) ? -delta : delta)
+						- (int32_t) (health->rttVar4 >> 2);
+			}
+			/* + 1 ms for the resolution of the tick */
+			timeout = (health->srtt8 >> 3) + health->rttVar4 + 1;
+			if (timeout < scheduler->timeoutMinMs) {
+				timeout = scheduler->timeoutMinMs;
+			}
+			if (timeout > scheduler->timeoutMaxMs) {
+				timeout = scheduler->timeoutMaxMs;
+			}
+			health->timeoutMs = timeout;
+		}
+	}
+}
+
+/*!
+ * @fn    static uint32_t ModbusRTU_SchedulerTimeout(ModbusRTU_SchedulerT *scheduler, uint8_t slaveId)
+ * @brief Response timeout of the next request to a slave.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param slaveId The modBus slave ID.
+ * @return the learned timeout, timeoutMaxMs without a sample or after a timeout.
+ */
+static uint32_t ModbusRTU_SchedulerTimeout(ModbusRTU_SchedulerT *scheduler,
+		uint8_t slaveId) {
+
+	/* local variable */
+	const ModbusRTU_SlaveHealthT *health = ModbusRTU_SchedulerHealth(scheduler,
+			slaveId, false);
+	uint32_t result = scheduler->timeoutMaxMs;
+
+	if ((NULL != health) && (true == health->isMeasured)
+			&& (0 == health->failures)) {
+		result = health->timeoutMs;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static bool ModbusRTU_SchedulerIsOffline(ModbusRTU_SchedulerT *scheduler, uint8_t slaveId, uint32_t now)
+ * @brief Check for a slave that is skipped after repeated timeouts.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param slaveId The modBus slave ID.
+ * @param now modbusRTUPortGetTickMs() of this scheduling pass.
+ * @return true until the retry time of the slave.
+ */
+static bool ModbusRTU_SchedulerIsOffline(ModbusRTU_SchedulerT *scheduler,
+		uint8_t slaveId, uint32_t now) {
+
+	/* local variable */
+	const ModbusRTU_SlaveHealthT *health = ModbusRTU_SchedulerHealth(scheduler,
+			slaveId, false);
+
+	return (NULL != health) && (0 != health->backoffMs)
+			&& ((int32_t) (now - health->retryMs) < 0);
+}
+
+/*!
+ * @fn    static bool ModbusRTU_SchedulerIsLate(ModbusRTU_SchedulerT *scheduler, const ModbusRTU_RequestT *request, uint32_t now)
+ * @brief Check for a request that would be answered after its deadline.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request The request chosen to run next.
+ * @param now modbusRTUPortGetTickMs() of this scheduling pass.
+ * @return true when both frames and the usual response time of the slave
+ *         end after nextDueMs + deadlineMs.
+ */
+static bool ModbusRTU_SchedulerIsLate(ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_RequestT *request, uint32_t now) {
+
+	/* local variable */
+	const ModbusRTU_SlaveHealthT *health = ModbusRTU_SchedulerHealth(scheduler,
+			request->slaveId, false);
+	uint32_t chars = 0;
+	uint32_t busyMs = 0;
+	size_t pduSize = 0;
+	size_t responseSize = 0;
+	bool result = false;
+
+	if (0 != request->deadlineMs) {
+		pduSize = ModbusRTU_BuildRequest(request, NULL, &responseSize);
+		chars = MODBUS_RTU_FRAME_SIZE(pduSize);
+		if (MODBUS_RTU_BROADCAST_ID != request->slaveId) {
+			chars += MODBUS_RTU_FRAME_SIZE(responseSize);
+		}
+		busyMs = (chars * scheduler->modbus->charTicks
+				+ MODBUS_RTU_TIMER_TICK_HZ / 1000 - 1)
+				/ (MODBUS_RTU_TIMER_TICK_HZ / 1000);
+		if ((NULL != health) && (true == health->isMeasured)) {
+			busyMs += health->srtt8 / 8;
+		}
+		result = ((int32_t) (now + busyMs
+				- (request->nextDueMs + request->deadlineMs)) > 0);
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SchedulerRank(const ModbusRTU_SchedulerT *scheduler, const ModbusRTU_RequestT *request, uint32_t now)
+ * @brief Priority a due request competes with, raised once it starves.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request A due request.
+ * @param now modbusRTUPortGetTickMs() of this scheduling pass.
+ * @return priority, at most MODBUS_RTU_PRIORITY_URGENT + 1 after starveMs overdue.
+ */
+static uint8_t ModbusRTU_SchedulerRank(const ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_RequestT *request, uint32_t now) {
+
+	/* local variable */
+	uint8_t result = request->priority;
+
+	/* never ahead of the urgent class, its latency stays one transaction */
+	if ((0 != scheduler->starveMs) && (result > MODBUS_RTU_PRIORITY_URGENT + 1)
+			&& ((uint32_t) (now - request->nextDueMs) >= scheduler->starveMs)) {
+		result = MODBUS_RTU_PRIORITY_URGENT + 1;
+	}
+
+	return result;
+}
+
+#ifdef MODBUS_RTU_USE_POOL
+/*!
+ * @fn    static size_t ModbusRTU_RequestValuesSize(const ModbusRTU_RequestT *request)
+ * @brief Bytes of the write source a request points to.
+ *
+ * @param request The request.
+ * @return size of values, 0 for reads.
+ */
+static size_t ModbusRTU_RequestValuesSize(const ModbusRTU_RequestT *request) {
+
+	/* local variable */
+	size_t result = 0;
+
+	if (NULL != request->values) {
+		switch (request->functionCode) {
+		case MODBUS_FUNC_WRITE_SINGLE_COIL:
+			result = 1;
+			break;
+		case MODBUS_FUNC_WRITE_SINGLE_REGISTER:
+			result = 2;
+			break;
+		case MODBUS_FUNC_WRITE_MULTY_COIL:
+			result = (request->quantity + 7) / 8;
+			break;
+		case MODBUS_FUNC_WRITE_MULTY_REGISTER:
+			result = 2 * request->quantity;
+			break;
+		case MODBUS_FUNC_MASK_WRITE_REGISTER:
+			result = 4; /* {and, or} */
+			break;
+		case MODBUS_FUNC_READ_WRITE_MULTY_REGISTER:
+			result = 2 * request->writeQuantity;
+			break;
+		case MODBUS_FUNC_WRITE_FILE_RECORD:
+			result = 2 * request->quantity;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return result;
+}
+#endif
+
+#ifdef MODBUS_RTU_USE_CACHE
+/*!
+ * @fn    static bool ModbusRTU_SchedulerServeCached(ModbusRTU_SchedulerT *scheduler, uint32_t now)
+ * @brief Finish the first due read the cache holds fresh values for.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param now modbusRTUPortGetTickMs() of this scheduling pass.
+ * @return true when a request was answered.
+ */
+static bool ModbusRTU_SchedulerServeCached(ModbusRTU_SchedulerT *scheduler,
+		uint32_t now) {
+
+	/* local variable */
+	ModbusRTU_RequestT *request = NULL;
+	size_t dataSize = 0;
+	bool result = false;
+	bool isActive = false;
+
+	for (uint8_t i = 0; (i < scheduler->requestCount) && (false == result);
+			i++) {
+		request = scheduler->requests[i];
+		/* the request on the bus finishes with its own response */
+		isActive = (request == scheduler->active);
+		for (uint8_t j = 0; j < scheduler->memberCount; j++) {
+			isActive |= (scheduler->members[j] == request);
+		}
+		if ((false == isActive) && (NULL == request->slaveIds)
+				&& (request->functionCode >= MODBUS_FUNC_READ_COILS)
+				&& (request->functionCode <= MODBUS_FUNC_READ_INPUT_REGISTERS)
+				&& ((int32_t) (now - request->nextDueMs) >= 0)
+				&& (true == modbusRTUCacheRead(scheduler->cache,
+						request->slaveId, request->functionCode,
+						request->address, request->quantity, now, &dataSize))) {
+			ModbusRTU_SchedulerFinish(scheduler, request, MODBUS_RTU_SUCCESS,
+					scheduler->cache->data, dataSize);
+			result = true;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_SchedulerInvalidate(ModbusRTU_SchedulerT *scheduler, const ModbusRTU_RequestT *request)
+ * @brief Drop the cached values a write request changes.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request The request going on the bus.
+ */
+static void ModbusRTU_SchedulerInvalidate(ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_RequestT *request) {
+
+	/* local variable */
+	uint8_t functionCode = MODBUS_FUNC_READ_HOLDING_REGISTERS;
+	uint16_t address = request->address;
+	uint16_t quantity = request->quantity;
+
+	switch (request->functionCode) {
+	case MODBUS_FUNC_WRITE_SINGLE_COIL:
+		functionCode = MODBUS_FUNC_READ_COILS;
+		quantity = 1;
+		break;
+	case MODBUS_FUNC_WRITE_MULTY_COIL:
+		functionCode = MODBUS_FUNC_READ_COILS;
+		break;
+	case MODBUS_FUNC_WRITE_SINGLE_REGISTER:
+	case MODBUS_FUNC_MASK_WRITE_REGISTER:
+		quantity = 1;
+		break;
+	case MODBUS_FUNC_WRITE_MULTY_REGISTER:
+		break;
+	case MODBUS_FUNC_READ_WRITE_MULTY_REGISTER:
+		address = request->writeAddress;
+		quantity = request->writeQuantity;
+		break;
+	default:
+		quantity = 0; /* a read */
+		break;
+	}
+
+	if ((NULL != scheduler->cache) && (0 != quantity)) {
+		modbusRTUCacheInvalidate(scheduler->cache, request->slaveId,
+				functionCode, address, quantity);
+	}
+}
+#endif
+
+/*!
+ * @fn    static bool ModbusRTU_IsReadFunction(uint8_t functionCode)
+ * @brief Check for a function whose response starts with a byte count.
+ *
+ * @param functionCode The modBus function code.
+ * @return true for the read functions.
+ */
+static bool ModbusRTU_IsReadFunction(uint8_t functionCode) {
+	return (MODBUS_FUNC_READ_COILS == functionCode)
+			|| (MODBUS_FUNC_READ_DISCRETE_INPUTS == functionCode)
+			|| (MODBUS_FUNC_READ_HOLDING_REGISTERS == functionCode)
+			|| (MODBUS_FUNC_READ_INPUT_REGISTERS == functionCode)
+			|| (MODBUS_FUNC_READ_WRITE_MULTY_REGISTER == functionCode)
+			|| (MODBUS_FUNC_READ_FILE_RECORD == functionCode);
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -0,0 +1,306 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUMaster.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU master request scheduler.
+ ******************************************************************************
+ *
+ * This file provides the master side poll scheduler: a per bus queue of
+ * periodic and one shot requests to any number of slaves, issued back to
+ * back as soon as t3.5 expires after the previous response or timeout.
+ * Due FC 0x03/0x04 reads of neighbouring ranges on the same slave are
+ * merged into one transaction and split back to their callbacks.
+ * File records (FC 0x14/0x15) of a range that crosses into the next file
+ * go as one sub-request per file. A FC 0x18 FIFO read answers with any
+ * count up to its quantity.
+ * Broadcasts hold the bus only for the turnaround delay, and a fan-out
+ * request takes the same write to a list of slaves one after another.
+ * The response timeout of every slave follows its measured response
+ * time, and a slave that stops answering is skipped for a growing time.
+ * The most urgent priority class goes first, a due request that waited
+ * too long ranks right after the urgent class, and a request that would
+ * miss its deadline is reported late instead of being sent stale.
+ * With MODBUS_RTU_USE_CACHE a scheduler may answer reads from a response
+ * cache.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_MASTER_H
+#define MODBUS_RTU_MASTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#ifdef MODBUS_RTU_USE_CACHE
+#include "modBusRTUCache.h"
+#endif
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Maximum requests queued on one bus */
+#ifndef MODBUS_RTU_SCHEDULER_MAX_REQUESTS
+#define MODBUS_RTU_SCHEDULER_MAX_REQUESTS 32
+#endif
+/*! @def Default registers allowed between two ranges merged into one read */
+#ifndef MODBUS_RTU_SCHEDULER_COALESCE_GAP
+#define MODBUS_RTU_SCHEDULER_COALESCE_GAP 8
+#endif
+/*! @def Slaves with their own response time estimate, first come */
+#ifndef MODBUS_RTU_SCHEDULER_SLAVES
+#define MODBUS_RTU_SCHEDULER_SLAVES 8
+#endif
+/*! @def Default shortest response timeout in milliseconds */
+#ifndef MODBUS_RTU_SCHEDULER_TIMEOUT_MIN
+#define MODBUS_RTU_SCHEDULER_TIMEOUT_MIN 10
+#endif
+/*! @def Default timeouts in a row that take a slave offline, 0 = never */
+#ifndef MODBUS_RTU_SCHEDULER_OFFLINE_AFTER
+#define MODBUS_RTU_SCHEDULER_OFFLINE_AFTER 3
+#endif
+/*! @defgroup Default first and longest time an offline slave is skipped, in milliseconds */
+#ifndef MODBUS_RTU_SCHEDULER_BACKOFF_MIN
+#define MODBUS_RTU_SCHEDULER_BACKOFF_MIN 1000
+#endif
+#ifndef MODBUS_RTU_SCHEDULER_BACKOFF_MAX
+#define MODBUS_RTU_SCHEDULER_BACKOFF_MAX 60000
+#endif
+/*! @def Default milliseconds a due request waits before it ranks right after the urgent class, 0 = never */
+#ifndef MODBUS_RTU_SCHEDULER_STARVE_MS
+#define MODBUS_RTU_SCHEDULER_STARVE_MS 1000
+#endif
+/*! @defgroup Priority classes of a request, any value in between is a class of its own */
+#define MODBUS_RTU_PRIORITY_URGENT 0 /*! alarm acknowledgements, setpoints: may cut into a fan-out */
+#define MODBUS_RTU_PRIORITY_NORMAL 128
+#define MODBUS_RTU_PRIORITY_BACKGROUND 255
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+struct _modbusRequest;
+
+/*!
+ * @typedef ModbusRTU_RequestCallbackT
+ * @brief result of one request, called from the context that ran the scheduler.
+ *
+ * @param request The finished request.
+ * @param result MODBUS_RTU_SUCCESS, MODBUS_RTU_ERROR_EXCEPTION (code in data[0]) or the error.
+ * @param data read functions: the values after the byte count (FC 0x14: the sub-responses, FC 0x18: FIFO count and registers), others: the response PDU data.
+ * @param dataSize Size of data.
+ */
+typedef void (*ModbusRTU_RequestCallbackT)(struct _modbusRequest *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+
+/*!
+ * @typedef @struct  _modbusRequest
+ * @brief one (periodic) master request, owned by the application.
+ */
+typedef struct _modbusRequest{
+	uint8_t slaveId; /*! modBus slave ID, fan-out: the slave of the current transaction */
+	const uint8_t *slaveIds; /*! optional fan-out: slaves (0 = broadcast) the request goes to in turn */
+	uint8_t slaveCount; /*! entries of slaveIds */
+	uint8_t functionCode; /*! MODBUS_FUNC_xxx */
+	uint16_t address; /*! first coil/register (FC 0x17: to read, FC 0x14/0x15: file, FC 0x18: FIFO pointer) */
+	uint16_t quantity; /*! coils/registers to read or write (FC 0x17: to read, FC 0x14/0x15: records, FC 0x18: most registers, 1..31) */
+	const void *values; /*! write source: uint16_t[] for registers and records, packed uint8_t[] for coils, {and, or} for FC 0x16 */
+	uint16_t writeAddress; /*! FC 0x17: first register to write, FC 0x14/0x15: first record */
+	uint16_t writeQuantity; /*! FC 0x17: registers to write */
+	uint32_t periodMs; /*! poll period, 0 = one shot */
+	uint8_t priority; /*! class, 0 = most urgent, see MODBUS_RTU_PRIORITY_xxx */
+	uint32_t deadlineMs; /*! result wanted within this time after falling due, 0 = none (fan-out: of the whole list) */
+	ModbusRTU_RequestCallbackT callback; /*! optional result callback */
+	void *context; /*! free for the application */
+	uint32_t nextDueMs; /*! private: next modbusRTUPortGetTickMs() to issue at */
+	uint8_t slaveIndex; /*! private: entry of slaveIds on the bus next */
+#ifdef MODBUS_RTU_USE_POOL
+	bool isPooled; /*! private: copy of modbusRTUSchedulerSubmit, freed when done */
+#endif
+} ModbusRTU_RequestT;
+
+/*!
+ * @typedef @struct  _modbusSlaveHealth
+ * @brief response time estimate and reachability of one slave.
+ */
+typedef struct _modbusSlaveHealth{
+	uint8_t slaveId; /*! 0 = free entry */
+	uint8_t failures; /*! timeouts in a row */
+	bool isMeasured; /*! srtt8 and rttVar4 hold a sample */
+	uint32_t srtt8; /*! smoothed response time, 1/8 ms */
+	uint32_t rttVar4; /*! smoothed mean deviation, 1/4 ms */
+	uint32_t timeoutMs; /*! response timeout of the next request */
+	uint32_t backoffMs; /*! time the slave is skipped, 0 = online */
+	uint32_t retryMs; /*! modbusRTUPortGetTickMs() of the next try while offline */
+} ModbusRTU_SlaveHealthT;
+
+/*!
+ * @typedef @struct  _modbusScheduler
+ * @brief request scheduler of one bus.
+ */
+typedef struct _modbusScheduler{
+	ModbusRTU_HandleT *modbus; /*! bus driven by this scheduler */
+	ModbusRTU_RequestT *requests[MODBUS_RTU_SCHEDULER_MAX_REQUESTS]; /*! queued requests */
+	uint8_t requestCount; /*! used entries of requests */
+	ModbusRTU_RequestT *active; /*! request waiting for its response */
+	bool isCoalescing; /*! merge neighbouring FC 0x03/0x04 reads, true by default */
+	uint16_t coalesceGap; /*! registers allowed between merged ranges (read but dropped) */
+	ModbusRTU_RequestT merged; /*! the combined read while members are active */
+	ModbusRTU_RequestT *members[MODBUS_RTU_SCHEDULER_MAX_REQUESTS]; /*! requests served by merged */
+	uint8_t memberCount; /*! used entries of members */
+	ModbusRTU_RequestT *fanOut; /*! fan-out request between two of its slaves, goes first */
+	ModbusRTU_SlaveHealthT health[MODBUS_RTU_SCHEDULER_SLAVES]; /*! per slave estimates, see modbusRTUSchedulerGetHealth */
+	uint32_t timeoutMinMs; /*! shortest response timeout, MODBUS_RTU_SCHEDULER_TIMEOUT_MIN by default */
+	uint32_t timeoutMaxMs; /*! longest response timeout, of unknown slaves too, responseTimeoutMs of the bus by default */
+	uint8_t offlineAfter; /*! timeouts in a row that take a slave offline, 0 = never */
+	uint32_t backoffMinMs; /*! first skip of an offline slave, doubled on every failed try */
+	uint32_t backoffMaxMs; /*! longest skip of an offline slave */
+	uint32_t starveMs; /*! a due request waiting this long ranks right after the urgent class, 0 = never */
+	uint32_t txEndMs; /*! modbusRTUPortGetTickMs() at the TX complete of the active request */
+	uint32_t lineBaudRate; /*! private: line to switch to before the next request, 0 = none */
+	uint8_t lineParity; /*! private: parity of lineBaudRate */
+#ifdef MODBUS_RTU_USE_CACHE
+	ModbusRTU_CacheT *cache; /*! optional response cache, see modbusRTUSchedulerSetCache */
+#endif
+	volatile bool isInProcess; /*! re-entrance guard main loop / ISR */
+	volatile bool isPending; /*! an event arrived during processing */
+} ModbusRTU_SchedulerT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUSchedulerInit(ModbusRTU_SchedulerT *scheduler, ModbusRTU_HandleT *modbus)
+ * @brief Attach a scheduler to a modBus RTU instance.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param modbus Pointer to the ModbusRTU instance (uses its eventCallback).
+ */
+void modbusRTUSchedulerInit(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSchedulerAdd(ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request)
+ * @brief Queue a request, due immediately.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request Request, must stay valid while queued.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : a broadcast (slaveId 0) finishes successfully once it is sent,
+ *         without data. With slaveIds the callback runs once per slave,
+ *         and the slaves follow each other with only requests of a more
+ *         urgent class in between; a period restarts the whole list. A
+ *         request that cannot be answered within deadlineMs finishes with
+ *         MODBUS_RTU_ERROR_LATE without the bus, e.g. an urgent write waits
+ *         for the transaction on the bus, never for the poll list.
+ */
+ModbusRTU_ErrorT modbusRTUSchedulerAdd(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_RequestT *request);
+
+#ifdef MODBUS_RTU_USE_POOL
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSchedulerSubmit(ModbusRTU_SchedulerT *scheduler, const ModbusRTU_RequestT *request)
+ * @brief Queue a one shot copy of a request and its values in a pool block.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request Request template, may be reused as soon as this returns.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : periodMs is ignored. The callback gets the copy, which is freed
+ *         when it returns: do not re-queue it or keep the pointer. A
+ *         fan-out list is not copied, it must stay valid.
+ */
+ModbusRTU_ErrorT modbusRTUSchedulerSubmit(ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_RequestT *request);
+#endif
+
+#ifdef MODBUS_RTU_USE_CACHE
+/*!
+ * @fn    void modbusRTUSchedulerSetCache(ModbusRTU_SchedulerT *scheduler, ModbusRTU_CacheT *cache)
+ * @brief Answer reads from a response cache, NULL to stop.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param cache Cache of this scheduler only, initialized by modbusRTUCacheInit.
+ *
+ * @note : due FC 0x01-0x04 requests whose values are all fresh finish at
+ *         once, even while the bus is busy. Responses fill the cache and
+ *         the writes of the scheduler drop the values they change; writes
+ *         of other masters are only covered by the TTL.
+ */
+void modbusRTUSchedulerSetCache(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_CacheT *cache);
+#endif
+
+/*!
+ * @fn    const ModbusRTU_SlaveHealthT* modbusRTUSchedulerGetHealth(ModbusRTU_SchedulerT *scheduler, uint8_t slaveId)
+ * @brief Response time estimate and reachability of a slave.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param slaveId The modBus slave ID.
+ * @return the entry, NULL when the slave was never polled or the table is full.
+ *
+ * @note : the timeout is srtt + 4 * rttvar (RFC 6298 smoothing) within
+ *         timeoutMinMs and timeoutMaxMs. After a timeout the next request
+ *         waits timeoutMaxMs. Requests to an offline slave finish with
+ *         MODBUS_RTU_ERROR_SLAVE_OFFLINE without the bus until retryMs.
+ */
+const ModbusRTU_SlaveHealthT* modbusRTUSchedulerGetHealth(
+		ModbusRTU_SchedulerT *scheduler, uint8_t slaveId);
+
+/*!
+ * @fn    void modbusRTUSchedulerSetLine(ModbusRTU_SchedulerT *scheduler, uint32_t baudRate, uint8_t parity)
+ * @brief Move the bus to another baud rate and parity before the next request.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param baudRate The new baud rate.
+ * @param parity MODBUS_RTU_PARITY_xxx.
+ *
+ * @note : the step up of a bus once every slave was told to switch, e.g.
+ *         from the callback of a fan-out write of their line register. A
+ *         fan-out in progress ends first, the learned response timeouts
+ *         start again on the new line.
+ */
+void modbusRTUSchedulerSetLine(ModbusRTU_SchedulerT *scheduler,
+		uint32_t baudRate, uint8_t parity);
+
+/*!
+ * @fn    void modbusRTUSchedulerRemove(ModbusRTU_SchedulerT *scheduler, ModbusRTU_RequestT *request)
+ * @brief Remove a queued request (an active one still gets its callback).
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param request Request to remove.
+ */
+void modbusRTUSchedulerRemove(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_RequestT *request);
+
+/*!
+ * @fn    void modbusRTUSchedulerProcess(ModbusRTU_SchedulerT *scheduler)
+ * @brief Collect the finished response and issue the next due request.
+ *
+ * @param scheduler Pointer to the scheduler.
+ *
+ * @note : runs by itself on every bus event (ISR context). Call it from the
+ *         main loop as well so periodic requests start when they fall due.
+ */
+void modbusRTUSchedulerProcess(ModbusRTU_SchedulerT *scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_MASTER_H
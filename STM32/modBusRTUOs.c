@@ -0,0 +1,275 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUOs.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU CMSIS-RTOS2 port.
+ ******************************************************************************
+ *
+ * This file provides the RTOS port: the core posts every bus event here
+ * from ISR context. With a worker the event only sets a thread flag and
+ * the worker runs eventCallback (scheduler, slave engine) as a task,
+ * without a worker eventCallback still runs in the ISR. Either way the
+ * event flags of the bus wake the tasks blocked on the event.
+ *
+ ******************************************************************************
+ */
+
+#ifdef MODBUS_RTU_USE_RTOS
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+/* 3. Module Header File */
+#include <modBusRTUOs.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+/* 2. Static Variables */
+
+/*! Dispatch order of events posted together, the order they happen on the bus */
+static const ModbusRTU_EventT ModbusRTU_OsEventOrder[] = {
+		MODBUS_RTU_EVENT_TX_COMPLETE, MODBUS_RTU_EVENT_FRAME_RECEIVED,
+		MODBUS_RTU_EVENT_RX_TIMEOUT, MODBUS_RTU_EVENT_BUS_IDLE };
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_OsWorker(void *argument);
+static uint32_t ModbusRTU_OsTicks(uint32_t timeoutMs);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUOsInit(ModbusRTU_OsT *os, ModbusRTU_HandleT *modbus)
+ * @brief Attach the RTOS objects to a modBus RTU instance.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param modbus Pointer to the ModbusRTU instance.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : call after modbusRTUInit, before the first frame.
+ */
+ModbusRTU_ErrorT modbusRTUOsInit(ModbusRTU_OsT *os, ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+
+	os->modbus = modbus;
+	os->worker = NULL;
+	os->pollMs = 0;
+	os->eventFlags = osEventFlagsNew(NULL);
+
+	if (NULL == os->eventFlags) {
+		result = MODBUS_RTU_ERROR_OS;
+	} else {
+		modbus->os = os;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUOsStartWorker(ModbusRTU_OsT *os, const char *name, osPriority_t priority, uint32_t pollMs)
+ * @brief Create the worker task that runs the layer above of this bus.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param name Task name.
+ * @param priority Task priority.
+ * @param pollMs Period of the BUS_IDLE poll that starts due scheduler requests, 0 = never.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : call after modbusRTUSchedulerInit/modbusRTUSlaveInit. The worker
+ *         then owns the scheduler, do not call modbusRTUSchedulerProcess
+ *         from other tasks.
+ */
+ModbusRTU_ErrorT modbusRTUOsStartWorker(ModbusRTU_OsT *os, const char *name,
+		osPriority_t priority, uint32_t pollMs) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	osThreadAttr_t attributes = { 0 };
+
+	attributes.name = name;
+	attributes.priority = priority;
+	attributes.stack_size = MODBUS_RTU_OS_WORKER_STACK_SIZE;
+	os->pollMs = pollMs;
+
+	os->worker = osThreadNew(ModbusRTU_OsWorker, os, &attributes);
+	if (NULL == os->worker) {
+		result = MODBUS_RTU_ERROR_OS;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    uint32_t modbusRTUOsWaitEvent(ModbusRTU_OsT *os, uint32_t events, uint32_t timeoutMs)
+ * @brief Block the calling task until one of the bus events happens.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param events MODBUS_RTU_OS_EVENT() flags to wait for.
+ * @param timeoutMs Maximum wait, osWaitForever to wait forever.
+ * @return the flags that woke the task (cleared), 0 on timeout.
+ */
+uint32_t modbusRTUOsWaitEvent(ModbusRTU_OsT *os, uint32_t events,
+		uint32_t timeoutMs) {
+
+	/* local variable */
+	uint32_t flags = osEventFlagsWait(os->eventFlags, events, osFlagsWaitAny,
+			ModbusRTU_OsTicks(timeoutMs));
+
+	if (0 != (flags & osFlagsError)) {
+		flags = 0;
+	}
+
+	return flags;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUOsWaitRxState(ModbusRTU_OsT *os, uint8_t *data, size_t dataSize)
+ * @brief Blocking modbusRTUCheckRxState: sleep until the frame or its timeout.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param data Pointer to store the received data.
+ * @param dataSize Size of the data buffer.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file, never MODBUS_RTU_RX_BUSY.
+ *
+ * @note : call after modbusRTUReciveData, replaces the polling loop.
+ */
+ModbusRTU_ErrorT modbusRTUOsWaitRxState(ModbusRTU_OsT *os, uint8_t *data,
+		size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_HandleT *modbus = os->modbus;
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	/* htim reports the timeout itself, this only covers a lost interrupt:
+	 * response timeout + one longest frame on the wire */
+	uint32_t limitMs = modbus->responseTimeoutMs + 1
+			+ (MODBUS_RTU_MAX_FRAME_SIZE * MODBUS_RTU_CHAR_BITS * 1000UL)
+					/ modbusRTUPortGetBaudRate(modbus->huart);
+
+	/* a flag left from an earlier frame only costs one more check */
+	while (MODBUS_RTU_RX_BUSY
+			== (result = modbusRTUCheckRxState(modbus, data, dataSize))) {
+		if (0 == modbusRTUOsWaitEvent(os,
+				MODBUS_RTU_OS_EVENT(MODBUS_RTU_EVENT_FRAME_RECEIVED)
+						| MODBUS_RTU_OS_EVENT(MODBUS_RTU_EVENT_RX_TIMEOUT),
+				limitMs)) {
+			result = modbusRTUCheckRxState(modbus, data, dataSize);
+			if (MODBUS_RTU_RX_BUSY == result) {
+				result = MODBUS_RTU_ERROR_RX_TIMEOUT;
+			}
+			break;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    void modbusRTUOsPostEvent(ModbusRTU_OsT *os, ModbusRTU_EventT event)
+ * @brief Hand a bus event to the worker or the waiting tasks, ISR context.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param event What happened.
+ *
+ * @note : called by the core for every event, not by the application.
+ */
+void modbusRTUOsPostEvent(ModbusRTU_OsT *os, ModbusRTU_EventT event) {
+	if (NULL != os->worker) {
+		/* the worker runs eventCallback and sets the event flags */
+		osThreadFlagsSet(os->worker, MODBUS_RTU_OS_EVENT(event));
+	} else {
+		if (NULL != os->modbus->eventCallback) {
+			os->modbus->eventCallback(os->modbus, event);
+		}
+		osEventFlagsSet(os->eventFlags, MODBUS_RTU_OS_EVENT(event));
+	}
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_OsWorker(void *argument)
+ * @brief Worker task of one bus: sleep until events, run the layer above.
+ *
+ * @param argument The ModbusRTU_OsT of the bus.
+ */
+static void ModbusRTU_OsWorker(void *argument) {
+
+	/* local variable */
+	ModbusRTU_OsT *os = (ModbusRTU_OsT*) argument;
+	ModbusRTU_HandleT *modbus = os->modbus;
+	uint32_t flags = 0;
+	uint32_t bit = 0;
+
+	for (;;) {
+		flags = osThreadFlagsWait(MODBUS_RTU_OS_ALL_EVENTS, osFlagsWaitAny,
+				(0 == os->pollMs) ? osWaitForever : ModbusRTU_OsTicks(os->pollMs));
+
+		if (0 != (flags & osFlagsError)) {
+			/* poll: a silent bus lets the scheduler start requests that fell due */
+			if ((NULL != modbus->eventCallback)
+					&& (true == modbusRTUIsBusIdle(modbus))) {
+				modbus->eventCallback(modbus, MODBUS_RTU_EVENT_BUS_IDLE);
+			}
+			continue;
+		}
+
+		for (uint8_t i = 0;
+				i < sizeof(ModbusRTU_OsEventOrder) / sizeof(ModbusRTU_OsEventOrder[0]);
+				i++) {
+			bit = MODBUS_RTU_OS_EVENT(ModbusRTU_OsEventOrder[i]);
+			if (0 != (flags & bit)) {
+				if (NULL != modbus->eventCallback) {
+					modbus->eventCallback(modbus, ModbusRTU_OsEventOrder[i]);
+				}
+				osEventFlagsSet(os->eventFlags, bit);
+			}
+		}
+	}
+}
+
+/*!
+ * @fn    static uint32_t ModbusRTU_OsTicks(uint32_t timeoutMs)
+ * @brief Convert milliseconds to kernel ticks, rounded up.
+ *
+ * @param timeoutMs Milliseconds, osWaitForever is kept.
+ * @return kernel ticks.
+ */
+static uint32_t ModbusRTU_OsTicks(uint32_t timeoutMs) {
+
+	/* local variable */
+	uint32_t ticks = osWaitForever;
+
+	if (osWaitForever != timeoutMs) {
+		ticks = (uint32_t) (((uint64_t) timeoutMs * osKernelGetTickFreq() + 999)
+				/ 1000);
+	}
+
+	return ticks;
+}
+
+#endif // MODBUS_RTU_USE_RTOS
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -0,0 +1,146 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUOs.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU CMSIS-RTOS2 port.
+ ******************************************************************************
+ *
+ * This file provides the optional RTOS port of the library, built when
+ * MODBUS_RTU_USE_RTOS is defined. Bus events raise thread flags (task
+ * notifications on FreeRTOS) instead of running the layer above in the
+ * interrupt: a worker task per bus runs the scheduler or slave engine,
+ * other tasks block on event flags until their frame completes.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_OS_H
+#define MODBUS_RTU_OS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef MODBUS_RTU_USE_RTOS
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include "cmsis_os2.h"
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Flag of one ModbusRTU_EventT in the thread and event flags */
+#define MODBUS_RTU_OS_EVENT(event) (1UL << (event))
+/*! @def Flags of every bus event */
+#define MODBUS_RTU_OS_ALL_EVENTS \
+	(MODBUS_RTU_OS_EVENT(MODBUS_RTU_EVENT_FRAME_RECEIVED) \
+			| MODBUS_RTU_OS_EVENT(MODBUS_RTU_EVENT_RX_TIMEOUT) \
+			| MODBUS_RTU_OS_EVENT(MODBUS_RTU_EVENT_TX_COMPLETE) \
+			| MODBUS_RTU_OS_EVENT(MODBUS_RTU_EVENT_BUS_IDLE))
+/*! @def Stack of a worker task in bytes, request callbacks run on it */
+#ifndef MODBUS_RTU_OS_WORKER_STACK_SIZE
+#define MODBUS_RTU_OS_WORKER_STACK_SIZE 1024
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusOs
+ * @brief RTOS objects of one bus.
+ */
+typedef struct _modbusOs{
+	ModbusRTU_HandleT *modbus; /*! bus of these objects */
+	osEventFlagsId_t eventFlags; /*! one flag per event, for tasks blocked in modbusRTUOsWaitEvent */
+	osThreadId_t worker; /*! runs eventCallback in task context, NULL = from the ISR */
+	uint32_t pollMs; /*! worker: BUS_IDLE poll period while nothing happens, 0 = never */
+} ModbusRTU_OsT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUOsInit(ModbusRTU_OsT *os, ModbusRTU_HandleT *modbus)
+ * @brief Attach the RTOS objects to a modBus RTU instance.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param modbus Pointer to the ModbusRTU instance.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : call after modbusRTUInit, before the first frame.
+ */
+ModbusRTU_ErrorT modbusRTUOsInit(ModbusRTU_OsT *os, ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUOsStartWorker(ModbusRTU_OsT *os, const char *name, osPriority_t priority, uint32_t pollMs)
+ * @brief Create the worker task that runs the layer above of this bus.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param name Task name.
+ * @param priority Task priority.
+ * @param pollMs Period of the BUS_IDLE poll that starts due scheduler requests, 0 = never.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : call after modbusRTUSchedulerInit/modbusRTUSlaveInit. The worker
+ *         then owns the scheduler, do not call modbusRTUSchedulerProcess
+ *         from other tasks.
+ */
+ModbusRTU_ErrorT modbusRTUOsStartWorker(ModbusRTU_OsT *os, const char *name,
+		osPriority_t priority, uint32_t pollMs);
+
+/*!
+ * @fn    uint32_t modbusRTUOsWaitEvent(ModbusRTU_OsT *os, uint32_t events, uint32_t timeoutMs)
+ * @brief Block the calling task until one of the bus events happens.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param events MODBUS_RTU_OS_EVENT() flags to wait for.
+ * @param timeoutMs Maximum wait, osWaitForever to wait forever.
+ * @return the flags that woke the task (cleared), 0 on timeout.
+ */
+uint32_t modbusRTUOsWaitEvent(ModbusRTU_OsT *os, uint32_t events,
+		uint32_t timeoutMs);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUOsWaitRxState(ModbusRTU_OsT *os, uint8_t *data, size_t dataSize)
+ * @brief Blocking modbusRTUCheckRxState: sleep until the frame or its timeout.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param data Pointer to store the received data.
+ * @param dataSize Size of the data buffer.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file, never MODBUS_RTU_RX_BUSY.
+ *
+ * @note : call after modbusRTUReciveData, replaces the polling loop.
+ */
+ModbusRTU_ErrorT modbusRTUOsWaitRxState(ModbusRTU_OsT *os, uint8_t *data,
+		size_t dataSize);
+
+/*!
+ * @fn    void modbusRTUOsPostEvent(ModbusRTU_OsT *os, ModbusRTU_EventT event)
+ * @brief Hand a bus event to the worker or the waiting tasks, ISR context.
+ *
+ * @param os Pointer to the RTOS objects of the bus.
+ * @param event What happened.
+ *
+ * @note : called by the core for every event, not by the application.
+ */
+void modbusRTUOsPostEvent(ModbusRTU_OsT *os, ModbusRTU_EventT event);
+
+#endif // MODBUS_RTU_USE_RTOS
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_OS_H
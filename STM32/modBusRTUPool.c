@@ -0,0 +1,268 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUPool.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU fixed block frame pool.
+ ******************************************************************************
+ *
+ * This file provides the fixed block allocator: every size class is a
+ * static array of blocks, each starting on its own D-cache line
+ * (MODBUS_RTU_DMA_ALIGN), and a 32 bit map of the used ones,
+ * so the pool needs no initialization and allocates in constant time.
+ *
+ ******************************************************************************
+ */
+
+#ifdef MODBUS_RTU_USE_POOL
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+/* 3. Module Header File */
+#include <modBusRTUPool.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def 32 bit words of one block */
+#define MODBUS_RTU_POOL_WORDS(size) (((size) + 3) / 4)
+/*! @def 32 bit words from one block to the next: whole DMA lines, so no
+ *  two blocks share a D-cache line */
+#define MODBUS_RTU_POOL_STRIDE(size) \
+	MODBUS_RTU_POOL_WORDS(((size) + MODBUS_RTU_DMA_ALIGN - 1) \
+			/ MODBUS_RTU_DMA_ALIGN * MODBUS_RTU_DMA_ALIGN)
+
+#if (MODBUS_RTU_DMA_ALIGN % 4) \
+	|| ((4 * MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_SMALL_SIZE)) % MODBUS_RTU_DMA_ALIGN) \
+	|| ((4 * MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_MEDIUM_SIZE)) % MODBUS_RTU_DMA_ALIGN) \
+	|| ((4 * MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_LARGE_SIZE)) % MODBUS_RTU_DMA_ALIGN)
+#error "modBusRTUPool: every block must start on a MODBUS_RTU_DMA_ALIGN boundary"
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusPoolClass
+ * @brief storage of one size class, constant.
+ */
+typedef struct _modbusPoolClass{
+	uint32_t *storage; /*! blockCount blocks */
+	uint16_t blockWords; /*! 32 bit words per block */
+	uint16_t blockStride; /*! 32 bit words from one block to the next */
+	uint8_t blockCount; /*! blocks of the class */
+} ModbusRTU_PoolClassT;
+
+/*!
+ * @typedef @struct  _modbusPoolState
+ * @brief allocation state of one size class.
+ */
+typedef struct _modbusPoolState{
+	uint32_t usedMask; /*! bit n = block n allocated */
+	uint8_t used; /*! blocks allocated now */
+	uint8_t highWater; /*! most blocks allocated at once */
+	uint32_t failures; /*! allocations that found no block */
+} ModbusRTU_PoolStateT;
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+/* 2. Static Variables */
+
+/*! TX frames are DMA buffers: every block aligned, in MODBUS_RTU_DMA_SECTION */
+static uint32_t ModbusRTU_PoolSmall[MODBUS_RTU_POOL_SMALL_COUNT
+		* MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_SMALL_SIZE)]
+		MODBUS_RTU_DMA_ALIGNED MODBUS_RTU_DMA_SECTION;
+static uint32_t ModbusRTU_PoolMedium[MODBUS_RTU_POOL_MEDIUM_COUNT
+		* MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_MEDIUM_SIZE)]
+		MODBUS_RTU_DMA_ALIGNED MODBUS_RTU_DMA_SECTION;
+static uint32_t ModbusRTU_PoolLarge[MODBUS_RTU_POOL_LARGE_COUNT
+		* MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_LARGE_SIZE)]
+		MODBUS_RTU_DMA_ALIGNED MODBUS_RTU_DMA_SECTION;
+
+/*! size classes, small to large */
+static const ModbusRTU_PoolClassT ModbusRTU_PoolClasses[MODBUS_RTU_POOL_CLASS_COUNT] = {
+		{ ModbusRTU_PoolSmall, MODBUS_RTU_POOL_WORDS(MODBUS_RTU_POOL_SMALL_SIZE),
+				MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_SMALL_SIZE),
+				MODBUS_RTU_POOL_SMALL_COUNT },
+		{ ModbusRTU_PoolMedium, MODBUS_RTU_POOL_WORDS(MODBUS_RTU_POOL_MEDIUM_SIZE),
+				MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_MEDIUM_SIZE),
+				MODBUS_RTU_POOL_MEDIUM_COUNT },
+		{ ModbusRTU_PoolLarge, MODBUS_RTU_POOL_WORDS(MODBUS_RTU_POOL_LARGE_SIZE),
+				MODBUS_RTU_POOL_STRIDE(MODBUS_RTU_POOL_LARGE_SIZE),
+				MODBUS_RTU_POOL_LARGE_COUNT } };
+
+static ModbusRTU_PoolStateT ModbusRTU_PoolStates[MODBUS_RTU_POOL_CLASS_COUNT];
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static int8_t ModbusRTU_PoolFind(const void *block, uint8_t *index);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    void* modbusRTUPoolAlloc(size_t size)
+ * @brief Take the smallest free block of at least size bytes.
+ *
+ * @param size Bytes needed.
+ * @return block on a MODBUS_RTU_DMA_ALIGN boundary, NULL when no class can serve it.
+ *
+ * @note : ISR safe, a full class falls back to the next larger one.
+ */
+void* modbusRTUPoolAlloc(size_t size) {
+
+	/* local variable */
+	void *result = NULL;
+	const ModbusRTU_PoolClassT *poolClass = NULL;
+	ModbusRTU_PoolStateT *state = NULL;
+	ModbusRTU_PoolStateT *first = NULL;
+	uint32_t allMask = 0, freeBit = 0;
+	uint8_t index = 0;
+	uint32_t lock = 0;
+
+	lock = modbusRTUPortEnterCritical();
+	for (uint8_t i = 0; (NULL == result) && (i < MODBUS_RTU_POOL_CLASS_COUNT);
+			i++) {
+		poolClass = &ModbusRTU_PoolClasses[i];
+		state = &ModbusRTU_PoolStates[i];
+		allMask = (32 == poolClass->blockCount) ?
+				0xFFFFFFFFu : ((1u << poolClass->blockCount) - 1);
+		if ((NULL == first) && (4u * poolClass->blockWords >= size)) {
+			first = state; /* the class the size belongs to */
+		}
+
+		if ((NULL != first) && (allMask != state->usedMask)) {
+			/* lowest clear bit */
+			freeBit = ~state->usedMask & (state->usedMask + 1);
+			index = 31 - __CLZ(freeBit);
+			state->usedMask |= freeBit;
+			if (++state->used > state->highWater) {
+				state->highWater = state->used;
+			}
+			result = &poolClass->storage[index * poolClass->blockStride];
+		}
+	}
+	if ((NULL == result) && (NULL != first)) {
+		first->failures++;
+	}
+	modbusRTUPortExitCritical(lock);
+
+	return result;
+}
+
+/*!
+ * @fn    void modbusRTUPoolFree(void *block)
+ * @brief Give a block back to its class.
+ *
+ * @param block Block of modbusRTUPoolAlloc, NULL is ignored.
+ *
+ * @note : ISR safe.
+ */
+void modbusRTUPoolFree(void *block) {
+
+	/* local variable */
+	uint8_t index = 0;
+	int8_t poolClass = ModbusRTU_PoolFind(block, &index);
+	ModbusRTU_PoolStateT *state = NULL;
+	uint32_t lock = 0;
+
+	if (poolClass >= 0) {
+		state = &ModbusRTU_PoolStates[poolClass];
+		lock = modbusRTUPortEnterCritical();
+		if (0 != (state->usedMask & (1u << index))) {
+			state->usedMask &= ~(1u << index);
+			state->used--;
+		}
+		modbusRTUPortExitCritical(lock);
+	}
+}
+
+/*!
+ * @fn    size_t modbusRTUPoolBlockSize(const void *block)
+ * @brief Usable bytes of a block.
+ *
+ * @param block Block of modbusRTUPoolAlloc.
+ * @return bytes, 0 for NULL or a foreign pointer.
+ */
+size_t modbusRTUPoolBlockSize(const void *block) {
+
+	/* local variable */
+	uint8_t index = 0;
+	int8_t poolClass = ModbusRTU_PoolFind(block, &index);
+
+	return (poolClass < 0) ?
+			0 : 4u * ModbusRTU_PoolClasses[poolClass].blockWords;
+}
+
+/*!
+ * @fn    void modbusRTUPoolGetStats(ModbusRTU_PoolStatsT *stats)
+ * @brief Read the usage and high water marks of every size class.
+ *
+ * @param stats Array of MODBUS_RTU_POOL_CLASS_COUNT entries, small to large.
+ */
+void modbusRTUPoolGetStats(ModbusRTU_PoolStatsT *stats) {
+
+	/* local variable */
+	uint32_t lock = 0;
+
+	lock = modbusRTUPortEnterCritical();
+	for (uint8_t i = 0; i < MODBUS_RTU_POOL_CLASS_COUNT; i++) {
+		stats[i].blockSize = 4u * ModbusRTU_PoolClasses[i].blockWords;
+		stats[i].blockCount = ModbusRTU_PoolClasses[i].blockCount;
+		stats[i].used = ModbusRTU_PoolStates[i].used;
+		stats[i].highWater = ModbusRTU_PoolStates[i].highWater;
+		stats[i].failures = ModbusRTU_PoolStates[i].failures;
+	}
+	modbusRTUPortExitCritical(lock);
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static int8_t ModbusRTU_PoolFind(const void *block, uint8_t *index)
+ * @brief Locate the class and block number of a pointer.
+ *
+ * @param block Block of modbusRTUPoolAlloc.
+ * @param index Block number inside the class.
+ * @return class number, -1 when block is not a block of the pool.
+ */
+static int8_t ModbusRTU_PoolFind(const void *block, uint8_t *index) {
+
+	/* local variable */
+	int8_t result = -1;
+	const ModbusRTU_PoolClassT *poolClass = NULL;
+	const uint32_t *word = (const uint32_t*) block;
+	size_t offset = 0;
+
+	for (uint8_t i = 0; (result < 0) && (i < MODBUS_RTU_POOL_CLASS_COUNT); i++) {
+		poolClass = &ModbusRTU_PoolClasses[i];
+		if ((NULL != word) && (word >= poolClass->storage)
+				&& (word < poolClass->storage
+						+ poolClass->blockCount * poolClass->blockStride)) {
+			offset = (size_t) (word - poolClass->storage);
+			if (0 == (offset % poolClass->blockStride)) {
+				*index = (uint8_t) (offset / poolClass->blockStride);
+				result = (int8_t) i;
+			}
+		}
+	}
+
+	return result;
+}
+
+#endif // MODBUS_RTU_USE_POOL
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
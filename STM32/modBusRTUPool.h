@@ -0,0 +1,137 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUPool.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU fixed block frame pool.
+ ******************************************************************************
+ *
+ * This file provides the optional buffer pool of the library, built when
+ * MODBUS_RTU_USE_POOL is defined: three size classes of fixed blocks
+ * shared by every bus. TX frames, the frames of a receive ring and pooled
+ * scheduler requests draw the smallest block that fits, so RAM scales
+ * with the frames in flight instead of buses x MODBUS_RTU_MAX_FRAME_SIZE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_POOL_H
+#define MODBUS_RTU_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef MODBUS_RTU_USE_POOL
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stddef.h>
+/* 2. Project Header Files */
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @defgroup Size classes: bytes per block and blocks (1..32) */
+#ifndef MODBUS_RTU_POOL_SMALL_SIZE
+#define MODBUS_RTU_POOL_SMALL_SIZE 16   /* requests, short replies */
+#endif
+#ifndef MODBUS_RTU_POOL_SMALL_COUNT
+#define MODBUS_RTU_POOL_SMALL_COUNT 8
+#endif
+#ifndef MODBUS_RTU_POOL_MEDIUM_SIZE
+#define MODBUS_RTU_POOL_MEDIUM_SIZE 64  /* replies up to ~30 registers, pooled requests */
+#endif
+#ifndef MODBUS_RTU_POOL_MEDIUM_COUNT
+#define MODBUS_RTU_POOL_MEDIUM_COUNT 8
+#endif
+#ifndef MODBUS_RTU_POOL_LARGE_SIZE
+#define MODBUS_RTU_POOL_LARGE_SIZE 256  /* full frames */
+#endif
+#ifndef MODBUS_RTU_POOL_LARGE_COUNT
+#define MODBUS_RTU_POOL_LARGE_COUNT 2
+#endif
+/*! @def Size classes */
+#define MODBUS_RTU_POOL_CLASS_COUNT 3
+
+#if (MODBUS_RTU_POOL_SMALL_COUNT < 1) || (MODBUS_RTU_POOL_SMALL_COUNT > 32) \
+	|| (MODBUS_RTU_POOL_MEDIUM_COUNT < 1) || (MODBUS_RTU_POOL_MEDIUM_COUNT > 32) \
+	|| (MODBUS_RTU_POOL_LARGE_COUNT < 1) || (MODBUS_RTU_POOL_LARGE_COUNT > 32)
+#error "MODBUS_RTU_POOL_xxx_COUNT must be 1..32 blocks per class"
+#endif
+#if (MODBUS_RTU_POOL_SMALL_SIZE > MODBUS_RTU_POOL_MEDIUM_SIZE) \
+	|| (MODBUS_RTU_POOL_MEDIUM_SIZE > MODBUS_RTU_POOL_LARGE_SIZE)
+#error "MODBUS_RTU_POOL size classes must be sorted small to large"
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusPoolStats
+ * @brief usage of one size class.
+ */
+typedef struct _modbusPoolStats{
+	uint16_t blockSize; /*! bytes per block */
+	uint8_t blockCount; /*! blocks of the class */
+	uint8_t used; /*! blocks allocated now */
+	uint8_t highWater; /*! most blocks allocated at once */
+	uint32_t failures; /*! allocations that found the class (and all larger) full */
+} ModbusRTU_PoolStatsT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    void* modbusRTUPoolAlloc(size_t size)
+ * @brief Take the smallest free block of at least size bytes.
+ *
+ * @param size Bytes needed.
+ * @return block on a MODBUS_RTU_DMA_ALIGN boundary, NULL when no class can serve it.
+ *
+ * @note : ISR safe, a full class falls back to the next larger one.
+ */
+void* modbusRTUPoolAlloc(size_t size);
+
+/*!
+ * @fn    void modbusRTUPoolFree(void *block)
+ * @brief Give a block back to its class.
+ *
+ * @param block Block of modbusRTUPoolAlloc, NULL is ignored.
+ *
+ * @note : ISR safe.
+ */
+void modbusRTUPoolFree(void *block);
+
+/*!
+ * @fn    size_t modbusRTUPoolBlockSize(const void *block)
+ * @brief Usable bytes of a block.
+ *
+ * @param block Block of modbusRTUPoolAlloc.
+ * @return bytes, 0 for NULL or a foreign pointer.
+ */
+size_t modbusRTUPoolBlockSize(const void *block);
+
+/*!
+ * @fn    void modbusRTUPoolGetStats(ModbusRTU_PoolStatsT *stats)
+ * @brief Read the usage and high water marks of every size class.
+ *
+ * @param stats Array of MODBUS_RTU_POOL_CLASS_COUNT entries, small to large.
+ */
+void modbusRTUPoolGetStats(ModbusRTU_PoolStatsT *stats);
+
+#endif // MODBUS_RTU_USE_POOL
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_POOL_H
@@ -0,0 +1,110 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUPort.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU hardware port selection.
+ ******************************************************************************
+ *
+ * This file pulls in the port of the target MCU. A port is one header,
+ * selected with MODBUS_RTU_PORT_HEADER, that gives the library its UART,
+ * timer, DE pin and core services. The library calls nothing else of the
+ * platform, so every port may use the fastest native path of its part
+ * (static inline register access, FIFO timeout interrupts, cache aware
+ * DMA) instead of a generic driver layer.
+ *
+ * A port header provides, as static inline functions, macros or prototypes
+ * of functions in a port source file:
+ *
+ *  types
+ *   - ModbusRTU_PortUartT   UART of a bus, passed to modbusRTUInit
+ *   - ModbusRTU_PortTimerT  one shot timer of a bus, passed to modbusRTUInit
+ *   - ModbusRTU_PortGpioT   port of the RS485 DE/RE pin
+ *
+ *  defines
+ *   - MODBUS_RTU_PORT_TIMER_MAX_TICKS  longest one shot, longer ones are chained
+ *   - MODBUS_RTU_PORT_DMA_ALIGN  alignment of DMA buffers, the D-cache line
+ *         on cores with a data cache
+ *
+ *  UART (true = started / done)
+ *   - uint32_t modbusRTUPortGetBaudRate(ModbusRTU_PortUartT *uart)
+ *   - bool modbusRTUPortTransmit(uart, const uint8_t *data, uint16_t size, uint32_t timeoutMs)
+ *         blocking, returns after the last stop bit
+ *   - bool modbusRTUPortTransmitDMA(uart, const uint8_t *data, uint16_t size)
+ *         returns at once, the end of the last stop bit calls modbusRTUTxCpltCallback
+ *   - bool modbusRTUPortReceiveIT(uart, uint8_t *data, uint16_t size)
+ *         size bytes into data, then modbusRTURxCpltCallback
+ *   - void modbusRTUPortAbortReceive(uart)
+ *         cancels modbusRTUPortReceiveIT
+ *   - bool modbusRTUPortReceiveToIdle(uart, uint8_t *buffer, uint16_t size)
+ *         fills buffer circularly and calls modbusRTURxEventCallback with the
+ *         write position on idle line, half and full buffer
+ *   - bool modbusRTUPortIsIdleEvent(uart, uint16_t position, uint16_t size)
+ *         inside modbusRTURxEventCallback: the event is the idle line
+ *   - bool modbusRTUPortSetLine(uart, uint32_t baudRate, uint8_t parity)
+ *         MODBUS_RTU_PARITY_xxx, 8 data bits, 2 stop bits without parity;
+ *         stops every transfer of the UART
+ *   - a character with a parity, framing or noise error calls
+ *     modbusRTUErrorCallback once it is stored (or the DMA has stopped)
+ *
+ *  low power (see modbusRTUSetLowPower)
+ *   - bool modbusRTUPortMute(uart)
+ *         ignore every character until the next idle line, the pending
+ *         modbusRTUPortReceiveIT waits for the byte after it; false when the
+ *         UART has no mute mode
+ *   - void modbusRTUPortSetWakeUp(uart, bool isEnabled)
+ *         a start bit wakes the core from STOP, a no-op where it cannot
+ *
+ *  timer (tick rate MODBUS_RTU_TIMER_TICK_HZ)
+ *   - void modbusRTUPortTimerInit(ModbusRTU_PortTimerT *timer)
+ *         one shot, stopped, every expiry calls modbusRTUTimerCallback
+ *   - void modbusRTUPortTimerStart(timer, uint32_t ticks)
+ *         (re)start, 1 to MODBUS_RTU_PORT_TIMER_MAX_TICKS
+ *   - void modbusRTUPortTimerStop(timer)
+ *         stop without an expiry
+ *
+ *  D-cache (no-ops on cores without a data cache)
+ *   - void modbusRTUPortCacheClean(const void *data, uint32_t size)
+ *         write the lines holding data back before a DMA reads them
+ *   - void modbusRTUPortCacheInvalidate(const void *data, uint32_t size)
+ *         drop the lines holding data after a DMA wrote them
+ *
+ *  DE pin
+ *   - void modbusRTUPortSetDe(ModbusRTU_PortGpioT *port, uint16_t pin, bool isTransmit)
+ *
+ *  core
+ *   - uint32_t modbusRTUPortEnterCritical(void) / void modbusRTUPortExitCritical(uint32_t lock)
+ *         nestable, against the UART and timer interrupts of every bus
+ *   - uint32_t modbusRTUPortGetTickMs(void)  millisecond clock of the scheduler
+ *   - void modbusRTUPortCyclesInit(void), uint32_t modbusRTUPortCycles(void),
+ *     uint32_t modbusRTUPortCoreHz(void)  free running cycle counter of the statistics
+ *   - the CMSIS intrinsics __weak, __IO, __DMB, __CLZ and __REV16
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_PORT_H
+#define MODBUS_RTU_PORT_H
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+/* 2. Project Header Files */
+
+/*! @defgroup Parity of modbusRTUPortSetLine */
+#define MODBUS_RTU_PARITY_NONE 0u
+#define MODBUS_RTU_PARITY_EVEN 1u
+#define MODBUS_RTU_PARITY_ODD 2u
+
+/*! @def Port of the target, override from the compiler command line */
+#ifndef MODBUS_RTU_PORT_HEADER
+#define MODBUS_RTU_PORT_HEADER "modBusRTUPortStm32.h"
+#endif
+#include MODBUS_RTU_PORT_HEADER
+
+#if !defined(MODBUS_RTU_PORT_TIMER_MAX_TICKS) || !defined(MODBUS_RTU_PORT_DMA_ALIGN)
+#error "MODBUS_RTU_PORT_HEADER must define MODBUS_RTU_PORT_TIMER_MAX_TICKS and MODBUS_RTU_PORT_DMA_ALIGN"
+#endif
+
+#endif // MODBUS_RTU_PORT_H
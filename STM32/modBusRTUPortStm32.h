@@ -0,0 +1,261 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUPortStm32.h
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU port of the STM32 HAL (F1, F4, H7, ...).
+ ******************************************************************************
+ *
+ * This file maps the port interface of modBusRTUPort.h on the STM32Cube HAL:
+ * UART blocking/DMA/IT transmission and reception, a basic timer run as
+ * one shot through its registers, a GPIO for DE/RE and the DWT cycle
+ * counter, and on Cortex-M7 (F7/H7) the D-cache maintenance of the DMA
+ * buffers. Everything is static inline, so the library costs no more than
+ * the HAL calls it had before the port layer. Select the HAL of the family
+ * with MODBUS_RTU_STM32_HAL_HEADER, forward the HAL callbacks of the UART
+ * and timer of every bus to the modbusRTUxxxCallback functions.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_PORT_STM32_H
+#define MODBUS_RTU_PORT_STM32_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+/*! @def HAL of the MCU family, e.g. "stm32h7xx_hal.h" */
+#ifndef MODBUS_RTU_STM32_HAL_HEADER
+#define MODBUS_RTU_STM32_HAL_HEADER "stm32f1xx_hal.h"
+#endif
+#include MODBUS_RTU_STM32_HAL_HEADER
+/* 2. Project Header Files */
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def 16 bit auto reload register */
+#define MODBUS_RTU_PORT_TIMER_MAX_TICKS 0xFFFFu
+/*! @def D-cache maintenance of the DMA buffers, skipped by MODBUS_RTU_DMA_UNCACHED */
+#if defined(__DCACHE_PRESENT) && (1U == __DCACHE_PRESENT) \
+	&& !defined(MODBUS_RTU_DMA_UNCACHED)
+#define MODBUS_RTU_PORT_CACHE_MAINTENANCE
+#endif
+/*! @def DMA buffers own whole cache lines, so invalidating them hits nothing else */
+#if defined(__DCACHE_PRESENT) && (1U == __DCACHE_PRESENT)
+#define MODBUS_RTU_PORT_DMA_ALIGN 32
+#else
+#define MODBUS_RTU_PORT_DMA_ALIGN 4
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+typedef UART_HandleTypeDef ModbusRTU_PortUartT;
+typedef TIM_HandleTypeDef ModbusRTU_PortTimerT;
+typedef GPIO_TypeDef ModbusRTU_PortGpioT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*! @defgroup UART */
+
+static inline uint32_t modbusRTUPortGetBaudRate(ModbusRTU_PortUartT *uart) {
+	return uart->Init.BaudRate;
+}
+
+static inline bool modbusRTUPortTransmit(ModbusRTU_PortUartT *uart,
+		const uint8_t *data, uint16_t size, uint32_t timeoutMs) {
+	return (HAL_OK
+			== HAL_UART_Transmit(uart, (uint8_t*) data, size, timeoutMs));
+}
+
+static inline bool modbusRTUPortTransmitDMA(ModbusRTU_PortUartT *uart,
+		const uint8_t *data, uint16_t size) {
+	return (HAL_OK == HAL_UART_Transmit_DMA(uart, (uint8_t*) data, size));
+}
+
+static inline bool modbusRTUPortReceiveIT(ModbusRTU_PortUartT *uart,
+		uint8_t *data, uint16_t size) {
+	return (HAL_OK == HAL_UART_Receive_IT(uart, data, size));
+}
+
+static inline void modbusRTUPortAbortReceive(ModbusRTU_PortUartT *uart) {
+	HAL_UART_AbortReceive(uart);
+}
+
+static inline bool modbusRTUPortReceiveToIdle(ModbusRTU_PortUartT *uart,
+		uint8_t *buffer, uint16_t size) {
+	return (HAL_OK == HAL_UARTEx_ReceiveToIdle_DMA(uart, buffer, size));
+}
+
+static inline bool modbusRTUPortIsIdleEvent(ModbusRTU_PortUartT *uart,
+		uint16_t position, uint16_t size) {
+#ifdef HAL_UART_RXEVENT_IDLE
+	(void) position;
+	(void) size;
+	return (HAL_UART_RXEVENT_IDLE == HAL_UARTEx_GetRxEventType(uart));
+#else
+	/* older HAL: half/full always land on these positions */
+	(void) uart;
+	return (position != size / 2) && (position != size);
+#endif
+}
+
+static inline bool modbusRTUPortSetLine(ModbusRTU_PortUartT *uart,
+		uint32_t baudRate, uint8_t parity) {
+	HAL_UART_Abort(uart);
+	uart->Init.BaudRate = baudRate;
+	/* the HAL counts the parity bit in the word length */
+	if (MODBUS_RTU_PARITY_NONE == parity) {
+		uart->Init.WordLength = UART_WORDLENGTH_8B;
+		uart->Init.StopBits = UART_STOPBITS_2;
+		uart->Init.Parity = UART_PARITY_NONE;
+	} else {
+		uart->Init.WordLength = UART_WORDLENGTH_9B;
+		uart->Init.StopBits = UART_STOPBITS_1;
+		uart->Init.Parity = (MODBUS_RTU_PARITY_EVEN == parity) ?
+				UART_PARITY_EVEN : UART_PARITY_ODD;
+	}
+	/* on an initialized handle only the line settings are written again */
+	return (HAL_OK == HAL_UART_Init(uart));
+}
+
+static inline bool modbusRTUPortMute(ModbusRTU_PortUartT *uart) {
+	/* WAKE = 0 after reset: the receiver wakes on the next idle line */
+#ifdef USART_CR1_MME
+	HAL_MultiProcessor_EnableMuteMode(uart);
+#endif
+	return (HAL_OK == HAL_MultiProcessor_EnterMuteMode(uart));
+}
+
+static inline void modbusRTUPortSetWakeUp(ModbusRTU_PortUartT *uart,
+		bool isEnabled) {
+#if defined(USART_CR3_WUS) && defined(USART_CR1_UESM)
+	/* a start bit wakes the core from STOP, the UART kernel clock on HSI */
+	UART_WakeUpTypeDef wakeUp = { .WakeUpEvent = UART_WAKEUP_ON_STARTBIT };
+
+	if (true == isEnabled) {
+		HAL_UARTEx_StopModeWakeUpSourceConfig(uart, wakeUp);
+		HAL_UARTEx_EnableStopMode(uart);
+	} else {
+		HAL_UARTEx_DisableStopMode(uart);
+	}
+#else
+	/* F1/F4: no UART wake-up from STOP, stay in SLEEP or wake by EXTI on RX */
+	(void) uart;
+	(void) isEnabled;
+#endif
+}
+
+/*! @defgroup one shot timer */
+
+static inline void modbusRTUPortTimerStop(ModbusRTU_PortTimerT *timer) {
+	__HAL_TIM_DISABLE(timer);
+	__HAL_TIM_CLEAR_FLAG(timer, TIM_FLAG_UPDATE);
+}
+
+static inline void modbusRTUPortTimerInit(ModbusRTU_PortTimerT *timer) {
+	/* every expiry is one end of frame / timeout event: OPM stops the
+	 * counter, URS keeps the UG reload from raising an interrupt */
+	modbusRTUPortTimerStop(timer);
+	timer->Instance->CR1 |= TIM_CR1_OPM | TIM_CR1_URS;
+	__HAL_TIM_CLEAR_FLAG(timer, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_IT(timer, TIM_IT_UPDATE);
+}
+
+static inline void modbusRTUPortTimerStart(ModbusRTU_PortTimerT *timer,
+		uint32_t ticks) {
+	__HAL_TIM_DISABLE(timer);
+	__HAL_TIM_SET_AUTORELOAD(timer, ticks - 1);
+	/* load ARR and clear CNT, URS keeps this from raising the interrupt */
+	timer->Instance->EGR = TIM_EGR_UG;
+	__HAL_TIM_CLEAR_FLAG(timer, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE(timer);
+}
+
+/*! @defgroup D-cache, the range grows to whole lines */
+
+static inline void modbusRTUPortCacheClean(const void *data, uint32_t size) {
+#ifdef MODBUS_RTU_PORT_CACHE_MAINTENANCE
+	uintptr_t start = (uintptr_t) data & ~(uintptr_t) (MODBUS_RTU_PORT_DMA_ALIGN - 1);
+	uintptr_t end = ((uintptr_t) data + size + MODBUS_RTU_PORT_DMA_ALIGN - 1)
+			& ~(uintptr_t) (MODBUS_RTU_PORT_DMA_ALIGN - 1);
+
+	SCB_CleanDCache_by_Addr((uint32_t*) start, (int32_t) (end - start));
+#else
+	(void) data;
+	(void) size;
+#endif
+}
+
+static inline void modbusRTUPortCacheInvalidate(const void *data,
+		uint32_t size) {
+#ifdef MODBUS_RTU_PORT_CACHE_MAINTENANCE
+	uintptr_t start = (uintptr_t) data & ~(uintptr_t) (MODBUS_RTU_PORT_DMA_ALIGN - 1);
+	uintptr_t end = ((uintptr_t) data + size + MODBUS_RTU_PORT_DMA_ALIGN - 1)
+			& ~(uintptr_t) (MODBUS_RTU_PORT_DMA_ALIGN - 1);
+
+	SCB_InvalidateDCache_by_Addr((uint32_t*) start, (int32_t) (end - start));
+#else
+	(void) data;
+	(void) size;
+#endif
+}
+
+/*! @defgroup DE pin */
+
+static inline void modbusRTUPortSetDe(ModbusRTU_PortGpioT *port, uint16_t pin,
+		bool isTransmit) {
+	HAL_GPIO_WritePin(port, pin,
+			(true == isTransmit) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+/*! @defgroup core */
+
+static inline uint32_t modbusRTUPortEnterCritical(void) {
+
+	/* local variable */
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	return primask;
+}
+
+static inline void modbusRTUPortExitCritical(uint32_t lock) {
+	__set_PRIMASK(lock);
+}
+
+static inline uint32_t modbusRTUPortGetTickMs(void) {
+	return HAL_GetTick();
+}
+
+static inline void modbusRTUPortCyclesInit(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t modbusRTUPortCycles(void) {
+	return DWT->CYCCNT;
+}
+
+static inline uint32_t modbusRTUPortCoreHz(void) {
+	return HAL_RCC_GetHCLKFreq();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_PORT_STM32_H
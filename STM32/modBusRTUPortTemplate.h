@@ -0,0 +1,242 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUPortTemplate.h
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU port skeleton for a new MCU.
+ ******************************************************************************
+ *
+ * This file is the starting point of a port (see modBusRTUPort.h): copy it,
+ * fill the bodies with the native driver of the part and build with
+ * -DMODBUS_RTU_PORT_HEADER=\"myPort.h\". It compiles as is and needs no
+ * vendor header, the host build uses it to check that the library reaches
+ * the hardware only through the port.
+ *
+ * Native paths worth taking:
+ *  - ESP32: RX FIFO full / rx_timeout interrupt (tout_thresh = 1 char)
+ *    copying the FIFO into the circular buffer, rx_timeout is the IDLE
+ *    event; TX done interrupt for modbusRTUTxCpltCallback; gptimer alarm
+ *    without auto reload as one shot; portENTER_CRITICAL for the lock.
+ *  - NXP LPUART: eDMA ring with the IDLE flag (IDLECFG = 1 char), TC
+ *    interrupt, a PIT or CTIMER match with stop on match.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_PORT_TEMPLATE_H
+#define MODBUS_RTU_PORT_TEMPLATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+/* 2. Project Header Files */
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Longest one shot of the timer */
+#define MODBUS_RTU_PORT_TIMER_MAX_TICKS 0xFFFFFFFFu
+/*! @def Alignment of DMA buffers, the cache line with a data cache */
+#define MODBUS_RTU_PORT_DMA_ALIGN 4
+
+/*! @defgroup CMSIS intrinsics for cores without CMSIS */
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif
+#ifndef __IO
+#define __IO volatile
+#endif
+#define __DMB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __CLZ(value) ((0u == (value)) ? 32u : (uint32_t) __builtin_clz(value))
+#define __REV16(value) ((((value) & 0x00FF00FFu) << 8) | (((value) >> 8) & 0x00FF00FFu))
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusPortUart
+ * @brief UART of a bus.
+ */
+typedef struct _modbusPortUart{
+	uint8_t number; /*! UART instance */
+	uint32_t baudRate;
+	uint8_t parity; /*! MODBUS_RTU_PARITY_xxx */
+} ModbusRTU_PortUartT;
+
+/*!
+ * @typedef @struct  _modbusPortTimer
+ * @brief one shot timer of a bus.
+ */
+typedef struct _modbusPortTimer{
+	uint8_t number; /*! timer instance */
+} ModbusRTU_PortTimerT;
+
+/*!
+ * @typedef @struct  _modbusPortGpio
+ * @brief GPIO port of the DE/RE pin.
+ */
+typedef struct _modbusPortGpio{
+	uint8_t number; /*! GPIO port */
+} ModbusRTU_PortGpioT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*! @defgroup UART */
+
+static inline uint32_t modbusRTUPortGetBaudRate(ModbusRTU_PortUartT *uart) {
+	return uart->baudRate;
+}
+
+static inline bool modbusRTUPortTransmit(ModbusRTU_PortUartT *uart,
+		const uint8_t *data, uint16_t size, uint32_t timeoutMs) {
+	/* write the FIFO, wait for the transmit complete flag */
+	(void) uart;
+	(void) data;
+	(void) size;
+	(void) timeoutMs;
+	return false;
+}
+
+static inline bool modbusRTUPortTransmitDMA(ModbusRTU_PortUartT *uart,
+		const uint8_t *data, uint16_t size) {
+	/* start DMA or FIFO refill interrupts, TC calls modbusRTUTxCpltCallback */
+	(void) uart;
+	(void) data;
+	(void) size;
+	return false;
+}
+
+static inline bool modbusRTUPortReceiveIT(ModbusRTU_PortUartT *uart,
+		uint8_t *data, uint16_t size) {
+	/* size bytes into data, then modbusRTURxCpltCallback */
+	(void) uart;
+	(void) data;
+	(void) size;
+	return false;
+}
+
+static inline void modbusRTUPortAbortReceive(ModbusRTU_PortUartT *uart) {
+	(void) uart;
+}
+
+static inline bool modbusRTUPortReceiveToIdle(ModbusRTU_PortUartT *uart,
+		uint8_t *buffer, uint16_t size) {
+	/* fill buffer circularly, modbusRTURxEventCallback on idle, half and full */
+	(void) uart;
+	(void) buffer;
+	(void) size;
+	return false;
+}
+
+static inline bool modbusRTUPortIsIdleEvent(ModbusRTU_PortUartT *uart,
+		uint16_t position, uint16_t size) {
+	/* report the event the port raised, an idle flag kept by its ISR */
+	(void) uart;
+	return (position != size / 2) && (position != size);
+}
+
+static inline bool modbusRTUPortSetLine(ModbusRTU_PortUartT *uart,
+		uint32_t baudRate, uint8_t parity) {
+	/* stop the transfers, program divider, parity and stop bits; parity,
+	 * framing and noise error interrupts call modbusRTUErrorCallback */
+	uart->baudRate = baudRate;
+	uart->parity = parity;
+	return true;
+}
+
+static inline bool modbusRTUPortMute(ModbusRTU_PortUartT *uart) {
+	/* ignore characters until the next idle line, false without mute mode */
+	(void) uart;
+	return false;
+}
+
+static inline void modbusRTUPortSetWakeUp(ModbusRTU_PortUartT *uart,
+		bool isEnabled) {
+	/* let a start bit wake the core from the deepest sleep the part offers */
+	(void) uart;
+	(void) isEnabled;
+}
+
+/*! @defgroup one shot timer */
+
+static inline void modbusRTUPortTimerInit(ModbusRTU_PortTimerT *timer) {
+	/* one shot at MODBUS_RTU_TIMER_TICK_HZ, expiry calls modbusRTUTimerCallback */
+	(void) timer;
+}
+
+static inline void modbusRTUPortTimerStart(ModbusRTU_PortTimerT *timer,
+		uint32_t ticks) {
+	(void) timer;
+	(void) ticks;
+}
+
+static inline void modbusRTUPortTimerStop(ModbusRTU_PortTimerT *timer) {
+	(void) timer;
+}
+
+/*! @defgroup D-cache, ESP32: esp_cache_msync() on PSRAM buffers */
+
+static inline void modbusRTUPortCacheClean(const void *data, uint32_t size) {
+	(void) data;
+	(void) size;
+}
+
+static inline void modbusRTUPortCacheInvalidate(const void *data,
+		uint32_t size) {
+	(void) data;
+	(void) size;
+}
+
+/*! @defgroup DE pin */
+
+static inline void modbusRTUPortSetDe(ModbusRTU_PortGpioT *port, uint16_t pin,
+		bool isTransmit) {
+	(void) port;
+	(void) pin;
+	(void) isTransmit;
+}
+
+/*! @defgroup core */
+
+static inline uint32_t modbusRTUPortEnterCritical(void) {
+	/* mask the UART and timer interrupts, return the previous state */
+	return 0;
+}
+
+static inline void modbusRTUPortExitCritical(uint32_t lock) {
+	(void) lock;
+}
+
+static inline uint32_t modbusRTUPortGetTickMs(void) {
+	return 0;
+}
+
+static inline void modbusRTUPortCyclesInit(void) {
+}
+
+static inline uint32_t modbusRTUPortCycles(void) {
+	return 0;
+}
+
+static inline uint32_t modbusRTUPortCoreHz(void) {
+	return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_PORT_TEMPLATE_H
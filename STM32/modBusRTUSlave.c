@@ -0,0 +1,1349 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUSlave.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU slave register map engine.
+ ******************************************************************************
+ *
+ * This file provides the slave side of the library. It owns the bus of
+ * one ModbusRTU instance through its eventCallback: the request is served
+ * when the frame is received and the reply is sent at the next bus idle
+ * event, so the answer leaves right after t3.5. Addresses are resolved by
+ * a binary search over the sorted segment tables of the application.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUFrame.h"
+#include "modBusRTUData.h"
+/* 3. Module Header File */
+#include <modBusRTUSlave.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Entries of the dispatch table, highest function code in modBusRTU.h + 1 */
+#define MODBUS_RTU_SLAVE_FUNC_COUNT (MODBUS_FUNC_READ_FIFO_QUEUE + 1)
+/*! @def FC 0x08 sub function echoing the request data */
+#define MODBUS_RTU_DIAG_RETURN_QUERY_DATA 0x0000
+/*! @defgroup FC 0x08 sub functions of the counters, MODBUS_RTU_ENABLE_STATS */
+#define MODBUS_RTU_DIAG_RESTART_COMM 0x0001
+#define MODBUS_RTU_DIAG_RETURN_REGISTER 0x0002
+#define MODBUS_RTU_DIAG_CLEAR_COUNTERS 0x000A
+#define MODBUS_RTU_DIAG_BUS_MESSAGE_COUNT 0x000B
+#define MODBUS_RTU_DIAG_BUS_ERROR_COUNT 0x000C
+#define MODBUS_RTU_DIAG_BUS_EXCEPTION_COUNT 0x000D
+#define MODBUS_RTU_DIAG_SERVER_MESSAGE_COUNT 0x000E
+#define MODBUS_RTU_DIAG_SERVER_NO_RESPONSE_COUNT 0x000F
+#define MODBUS_RTU_DIAG_SERVER_NAK_COUNT 0x0010
+#define MODBUS_RTU_DIAG_SERVER_BUSY_COUNT 0x0011
+#define MODBUS_RTU_DIAG_BUS_OVERRUN_COUNT 0x0012
+#define MODBUS_RTU_DIAG_CLEAR_OVERRUN 0x0014
+/*! @def Restart communications data that also clears the (absent) event log */
+#define MODBUS_RTU_DIAG_CLEAR_LOG 0xFF00
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef ModbusRTU_SlaveHandlerT
+ * @brief serve one request PDU.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area (after the function code).
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code to answer with.
+ */
+typedef uint8_t (*ModbusRTU_SlaveHandlerT)(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+/* 2. Static Variables */
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_SlaveEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event);
+static void ModbusRTU_SlaveServe(ModbusRTU_SlaveT *slave);
+static void ModbusRTU_SlaveApplyLine(ModbusRTU_SlaveT *slave);
+static uint8_t ModbusRTU_SlaveReadBits(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveReadRegisters(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveWriteSingleCoil(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveWriteSingleRegister(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveWriteMultipleCoils(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveWriteMultipleRegisters(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveMaskWriteRegister(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveReadWriteRegisters(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveReadExceptionStatus(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveDiagnostic(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveReportServerId(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveReadFileRecord(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveWriteFileRecord(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveCheckFile(const uint8_t *reference);
+static uint8_t ModbusRTU_SlaveReadFifoQueue(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+#ifdef MODBUS_RTU_ENABLE_STATS
+static uint8_t ModbusRTU_SlaveDiagnosticCounter(ModbusRTU_SlaveT *slave,
+		uint16_t subFunction, uint16_t value, uint8_t *response,
+		size_t *responseSize);
+static uint8_t ModbusRTU_SlaveGetCommEventCounter(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize);
+#endif
+static const ModbusRTU_SlaveSegmentT* ModbusRTU_SlaveResolve(
+		const ModbusRTU_SlaveMapT *map, uint16_t address, uint16_t quantity,
+		uint8_t access);
+static uint16_t ModbusRTU_SlaveChunk(const ModbusRTU_SlaveSegmentT *segment,
+		uint16_t address, uint16_t quantity);
+static void ModbusRTU_SlavePutRegisters(uint8_t *dst,
+		const ModbusRTU_SlaveSegmentT *segment, uint16_t address,
+		uint16_t quantity);
+static void ModbusRTU_SlaveGetRegisters(const ModbusRTU_SlaveSegmentT *segment,
+		uint16_t address, const uint8_t *src, uint16_t quantity);
+static void ModbusRTU_SlaveNotifyWrite(ModbusRTU_SlaveT *slave,
+		uint8_t functionCode, uint16_t address, uint16_t quantity);
+
+/*! @brief function code -> handler, zero entries answer ILLEGAL FUNCTION */
+static const ModbusRTU_SlaveHandlerT ModbusRTU_SlaveHandlers[MODBUS_RTU_SLAVE_FUNC_COUNT] =
+		{
+				[MODBUS_FUNC_READ_COILS] = ModbusRTU_SlaveReadBits,
+				[MODBUS_FUNC_READ_DISCRETE_INPUTS] = ModbusRTU_SlaveReadBits,
+				[MODBUS_FUNC_READ_HOLDING_REGISTERS] = ModbusRTU_SlaveReadRegisters,
+				[MODBUS_FUNC_READ_INPUT_REGISTERS] = ModbusRTU_SlaveReadRegisters,
+				[MODBUS_FUNC_WRITE_SINGLE_COIL] = ModbusRTU_SlaveWriteSingleCoil,
+				[MODBUS_FUNC_WRITE_SINGLE_REGISTER] = ModbusRTU_SlaveWriteSingleRegister,
+				[MODBUS_FUNC_READ_EXEPTION_STATUS] = ModbusRTU_SlaveReadExceptionStatus,
+				[MODBUS_FUNC_READ_DIAGNOSTIC] = ModbusRTU_SlaveDiagnostic,
+#ifdef MODBUS_RTU_ENABLE_STATS
+				[MODBUS_FUNC_GET_COM_EVENT_COUNTER] = ModbusRTU_SlaveGetCommEventCounter,
+#else
+				[MODBUS_FUNC_GET_COM_EVENT_COUNTER] = NULL,
+#endif
+				[MODBUS_FUNC_GET_COM_EVENT_LOG] = NULL,
+				[MODBUS_FUNC_WRITE_MULTY_COIL] = ModbusRTU_SlaveWriteMultipleCoils,
+				[MODBUS_FUNC_WRITE_MULTY_REGISTER] = ModbusRTU_SlaveWriteMultipleRegisters,
+				[MODBUS_FUNC_REPORT_SERVER_ID] = ModbusRTU_SlaveReportServerId,
+				[MODBUS_FUNC_READ_FILE_RECORD] = ModbusRTU_SlaveReadFileRecord,
+				[MODBUS_FUNC_WRITE_FILE_RECORD] = ModbusRTU_SlaveWriteFileRecord,
+				[MODBUS_FUNC_MASK_WRITE_REGISTER] = ModbusRTU_SlaveMaskWriteRegister,
+				[MODBUS_FUNC_READ_WRITE_MULTY_REGISTER] = ModbusRTU_SlaveReadWriteRegisters,
+				[MODBUS_FUNC_READ_FIFO_QUEUE] = ModbusRTU_SlaveReadFifoQueue, };
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUSlaveInit(ModbusRTU_SlaveT *slave, ModbusRTU_HandleT *modbus)
+ * @brief Attach a slave engine to a modBus RTU instance.
+ *
+ * @param slave Pointer to the slave engine.
+ * @param modbus Pointer to the ModbusRTU instance (uses its eventCallback and slaveId).
+ *
+ * @note : all blocks start empty, fill them before modbusRTUSlaveStart.
+ */
+void modbusRTUSlaveInit(ModbusRTU_SlaveT *slave, ModbusRTU_HandleT *modbus) {
+	memset(slave, 0, sizeof(*slave));
+	slave->modbus = modbus;
+
+	/* serve the requests on the bus events */
+	modbus->userContext = slave;
+	modbus->eventCallback = ModbusRTU_SlaveEvent;
+	modbus->isAddressFilter = true;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSlaveStart(ModbusRTU_SlaveT *slave)
+ * @brief Start listening for requests.
+ *
+ * @param slave Pointer to the slave engine.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : requests are answered from the UART/timer interrupts, at t3.5
+ *         after the end of the request. For the DMA engine call
+ *         modbusRTUStartReceiveToIdle first.
+ */
+ModbusRTU_ErrorT modbusRTUSlaveStart(ModbusRTU_SlaveT *slave) {
+	slave->isReplyPending = false;
+	return modbusRTUListen(slave->modbus);
+}
+
+/*!
+ * @fn    void modbusRTUSlaveSetLine(ModbusRTU_SlaveT *slave, uint32_t baudRate, uint8_t parity)
+ * @brief Switch the bus to another baud rate and parity after the pending reply.
+ *
+ * @param slave Pointer to the slave engine.
+ * @param baudRate The new baud rate.
+ * @param parity MODBUS_RTU_PARITY_xxx.
+ *
+ * @note : from the writeCallback of a line register the master writes, the
+ *         acknowledgement still goes out on the old line.
+ */
+void modbusRTUSlaveSetLine(ModbusRTU_SlaveT *slave, uint32_t baudRate,
+		uint8_t parity) {
+
+	/* local variable */
+	uint32_t lock = modbusRTUPortEnterCritical();
+
+	slave->lineParity = parity;
+	slave->lineBaudRate = baudRate;
+	ModbusRTU_SlaveApplyLine(slave);
+	modbusRTUPortExitCritical(lock);
+}
+
+/*!
+ * @fn    bool modbusRTUSlaveFifoPush(ModbusRTU_SlaveFifoT *fifo, uint16_t value)
+ * @brief Queue a sample for the next FC 0x18 read.
+ *
+ * @param fifo Pointer to the FIFO.
+ * @param value The sample.
+ * @return false when the FIFO holds 31 samples, the sample is dropped.
+ *
+ * @note : one producer, e.g. the ADC interrupt or the main loop, without a
+ *         lock. A read takes the samples off the FIFO when it is answered,
+ *         a reply the master misses does not bring them back.
+ */
+bool modbusRTUSlaveFifoPush(ModbusRTU_SlaveFifoT *fifo, uint16_t value) {
+
+	/* local variable */
+	uint8_t head = fifo->head;
+	bool result = (MODBUS_RTU_MAX_FIFO_COUNT > (uint8_t) (head - fifo->tail));
+
+	if (true == result) {
+		fifo->values[head & (MODBUS_RTU_SLAVE_FIFO_SIZE - 1)] = value;
+		/* the sample is stored before the engine may read it */
+		__DMB();
+		fifo->head = head + 1;
+	} else {
+		fifo->overruns++;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    uint8_t modbusRTUSlaveFifoCount(const ModbusRTU_SlaveFifoT *fifo)
+ * @brief Samples waiting for a FC 0x18 read.
+ *
+ * @param fifo Pointer to the FIFO.
+ * @return 0..MODBUS_RTU_MAX_FIFO_COUNT.
+ */
+uint8_t modbusRTUSlaveFifoCount(const ModbusRTU_SlaveFifoT *fifo) {
+	return (uint8_t) (fifo->head - fifo->tail);
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_SlaveEvent(ModbusRTU_HandleT *modbus, ModbusRTU_EventT event)
+ * @brief eventCallback of the bus: serve waiting frames, reply on idle, listen after TX.
+ *
+ * @param modbus Pointer to the ModbusRTU instance.
+ * @param event What happened.
+ */
+static void ModbusRTU_SlaveEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event) {
+
+	/* local variable */
+	ModbusRTU_SlaveT *slave = (ModbusRTU_SlaveT*) modbus->userContext;
+
+	switch (event) {
+	case MODBUS_RTU_EVENT_BUS_IDLE:
+		/* t3.5 after the request, the reply may go out */
+		if (true == slave->isReplyPending) {
+			slave->isReplyPending = false;
+			if (MODBUS_RTU_SUCCESS
+					!= modbusRTUCommitTxDMA(modbus, slave->replyFunctionCode,
+							slave->replySize)) {
+				modbusRTUListen(modbus);
+			}
+		}
+		break;
+	case MODBUS_RTU_EVENT_TX_COMPLETE:
+		modbusRTUListen(modbus);
+		break;
+	default:
+		break;
+	}
+
+	/* one request at a time, with a frame ring the next waits for the reply */
+	while ((false == slave->isReplyPending)
+			&& (MODBUS_RTU_TX_ACTIVE != modbus->txState)
+			&& (true == modbusRTUIsRxFrameReady(modbus))) {
+		ModbusRTU_SlaveServe(slave);
+	}
+	ModbusRTU_SlaveApplyLine(slave);
+}
+
+/*!
+ * @fn    static void ModbusRTU_SlaveApplyLine(ModbusRTU_SlaveT *slave)
+ * @brief Switch to the requested line once no request is served and no reply pending or on the wire.
+ *
+ * @param slave Pointer to the slave engine.
+ */
+static void ModbusRTU_SlaveApplyLine(ModbusRTU_SlaveT *slave) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+
+	if ((0 != slave->lineBaudRate) && (false == slave->isReplyPending)
+			&& (MODBUS_RTU_TX_ACTIVE != slave->modbus->txState)
+			&& (false == modbusRTUIsRxFrameReady(slave->modbus))) {
+		result = modbusRTUSetLine(slave->modbus, slave->lineBaudRate,
+				slave->lineParity);
+	}
+	if (MODBUS_RTU_RX_BUSY != result) {
+		slave->lineBaudRate = 0;
+		/* the next request on the new line */
+		modbusRTUListen(slave->modbus);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_SlaveServe(ModbusRTU_SlaveT *slave)
+ * @brief Validate the received request, run its handler and prepare the reply.
+ *
+ * @param slave Pointer to the slave engine.
+ */
+static void ModbusRTU_SlaveServe(ModbusRTU_SlaveT *slave) {
+
+	/* local variable */
+	ModbusRTU_HandleT *modbus = slave->modbus;
+	ModbusRTU_FrameViewT frame = { 0 };
+	ModbusRTU_SlaveHandlerT handler = NULL;
+	uint8_t *response = NULL;
+	size_t responseSize = 0;
+	uint8_t exception = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+
+	if (MODBUS_RTU_SUCCESS == modbusRTUGetRxFrame(modbus, &frame)) {
+		response = modbusRTUGetTxBuffer(modbus);
+	}
+
+	if (NULL != response) {
+		MODBUS_RTU_STATS_ADD(modbus, serverMessages, 1);
+		if (frame.functionCode < MODBUS_RTU_SLAVE_FUNC_COUNT) {
+			handler = ModbusRTU_SlaveHandlers[frame.functionCode];
+		}
+		if (NULL != handler) {
+			exception = handler(slave, &frame, response, &responseSize);
+		}
+		/* FC 0x0B counts completed requests, not its own polls */
+		MODBUS_RTU_STATS_ADD(modbus, commEventCount,
+				((MODBUS_EXCEPTION_NONE == exception)
+						&& (MODBUS_FUNC_GET_COM_EVENT_COUNTER
+								!= frame.functionCode)) ? 1 : 0);
+
+		/* broadcasts are executed, never answered */
+		if (MODBUS_RTU_BROADCAST_ID != frame.slaveId) {
+			if (MODBUS_EXCEPTION_NONE != exception) {
+				response[0] = exception;
+				responseSize = MODBUS_RTU_EXCEPTION_RESPONSE_SIZE;
+				slave->replyFunctionCode = frame.functionCode | 0x80;
+				MODBUS_RTU_STATS_ADD(modbus, txExceptions, 1);
+			} else {
+				slave->replyFunctionCode = frame.functionCode;
+			}
+			slave->replySize = responseSize;
+			slave->isReplyPending = true;
+		} else {
+			MODBUS_RTU_STATS_ADD(modbus, noResponses, 1);
+		}
+	}
+
+	/* the request is consumed, the reply lives in txFrame */
+	modbusRTUReleaseRxFrame(modbus);
+	if (false == slave->isReplyPending) {
+		modbusRTUListen(modbus);
+	}
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveReadBits(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x01 read coils, FC 0x02 read discrete inputs.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveReadBits(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const ModbusRTU_SlaveMapT *map =
+			(MODBUS_FUNC_READ_COILS == request->functionCode) ?
+					&slave->coils : &slave->discreteInputs;
+	const ModbusRTU_SlaveSegmentT *segment = NULL;
+	uint16_t address = 0, quantity = 0;
+
+	if (MODBUS_RTU_READ_REQUEST_SIZE != request->dataSize) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		address = modbusRTUGetU16(&request->data[0]);
+		quantity = modbusRTUGetU16(&request->data[2]);
+
+		if ((0 == quantity) || (quantity > MODBUS_RTU_HANDLE_MAX_READ_BITS)) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			segment = ModbusRTU_SlaveResolve(map, address, quantity,
+					MODBUS_RTU_SEGMENT_READ);
+		}
+
+		if ((MODBUS_EXCEPTION_NONE == result) && (NULL == segment)) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+		} else if (MODBUS_EXCEPTION_NONE == result) {
+			response[0] = (quantity + 7) / 8; /* byte count */
+			/* unused high bits of the last byte stay 0 */
+			memset(&response[1], 0, response[0]);
+			for (uint16_t bit = 0, chunk = 0; bit < quantity;
+					bit += chunk, segment++) {
+				chunk = ModbusRTU_SlaveChunk(segment, address + bit,
+						quantity - bit);
+				modbusRTUCopyBits(&response[1], bit,
+						(const uint8_t*) segment->data,
+						address + bit - segment->address, chunk);
+			}
+			*responseSize = 1 + response[0];
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveReadRegisters(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x03 read holding registers, FC 0x04 read input registers.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveReadRegisters(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const ModbusRTU_SlaveMapT *map =
+			(MODBUS_FUNC_READ_HOLDING_REGISTERS == request->functionCode) ?
+					&slave->holdingRegisters : &slave->inputRegisters;
+	const ModbusRTU_SlaveSegmentT *segment = NULL;
+	uint16_t address = 0, quantity = 0;
+
+	if (MODBUS_RTU_READ_REQUEST_SIZE != request->dataSize) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		address = modbusRTUGetU16(&request->data[0]);
+		quantity = modbusRTUGetU16(&request->data[2]);
+
+		if ((0 == quantity) || (quantity > MODBUS_RTU_HANDLE_MAX_READ_REGISTERS)) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			segment = ModbusRTU_SlaveResolve(map, address, quantity,
+					MODBUS_RTU_SEGMENT_READ);
+			if (NULL == segment) {
+				result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+			} else {
+				response[0] = 2 * quantity; /* byte count */
+				ModbusRTU_SlavePutRegisters(&response[1], segment, address,
+						quantity);
+				*responseSize = 1 + response[0];
+			}
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveWriteSingleCoil(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x05 write single coil.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveWriteSingleCoil(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const ModbusRTU_SlaveSegmentT *segment = NULL;
+	uint16_t address = 0, value = 0;
+	uint8_t bit = 0;
+
+	if (MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE != request->dataSize) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		address = modbusRTUGetU16(&request->data[0]);
+		value = modbusRTUGetU16(&request->data[2]);
+
+		if ((0x0000 != value) && (0xFF00 != value)) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			segment = ModbusRTU_SlaveResolve(&slave->coils, address, 1,
+					MODBUS_RTU_SEGMENT_WRITE);
+			if (NULL == segment) {
+				result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+			} else {
+				bit = (0xFF00 == value) ? 0x01 : 0x00;
+				modbusRTUCopyBits((uint8_t*) segment->data,
+						address - segment->address, &bit, 0, 1);
+				ModbusRTU_SlaveNotifyWrite(slave, request->functionCode,
+						address, 1);
+
+				/* echo of the request */
+				memcpy(response, request->data, MODBUS_RTU_WRITE_RESPONSE_SIZE);
+				*responseSize = MODBUS_RTU_WRITE_RESPONSE_SIZE;
+			}
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveWriteSingleRegister(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x06 write single holding register.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveWriteSingleRegister(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const ModbusRTU_SlaveSegmentT *segment = NULL;
+	uint16_t address = 0;
+
+	if (MODBUS_RTU_WRITE_SINGLE_REQUEST_SIZE != request->dataSize) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		address = modbusRTUGetU16(&request->data[0]);
+		segment = ModbusRTU_SlaveResolve(&slave->holdingRegisters, address, 1,
+				MODBUS_RTU_SEGMENT_WRITE);
+
+		if (NULL == segment) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+		} else {
+			ModbusRTU_SlaveGetRegisters(segment, address, &request->data[2], 1);
+			ModbusRTU_SlaveNotifyWrite(slave, request->functionCode, address, 1);
+
+			/* echo of the request */
+			memcpy(response, request->data, MODBUS_RTU_WRITE_RESPONSE_SIZE);
+			*responseSize = MODBUS_RTU_WRITE_RESPONSE_SIZE;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveWriteMultipleCoils(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x0F write multiple coils.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveWriteMultipleCoils(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const ModbusRTU_SlaveSegmentT *segment = NULL;
+	uint16_t address = 0, quantity = 0;
+
+	if (request->dataSize < 5) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		address = modbusRTUGetU16(&request->data[0]);
+		quantity = modbusRTUGetU16(&request->data[2]);
+
+		if ((0 == quantity) || (quantity > MODBUS_RTU_MAX_WRITE_BITS)
+				|| (request->data[4] != (quantity + 7) / 8)
+				|| (request->dataSize
+						!= (size_t) MODBUS_RTU_WRITE_COILS_REQUEST_SIZE(quantity))) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			segment = ModbusRTU_SlaveResolve(&slave->coils, address, quantity,
+					MODBUS_RTU_SEGMENT_WRITE);
+		}
+
+		if ((MODBUS_EXCEPTION_NONE == result) && (NULL == segment)) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+		} else if (MODBUS_EXCEPTION_NONE == result) {
+			for (uint16_t bit = 0, chunk = 0; bit < quantity;
+					bit += chunk, segment++) {
+				chunk = ModbusRTU_SlaveChunk(segment, address + bit,
+						quantity - bit);
+				modbusRTUCopyBits((uint8_t*) segment->data,
+						address + bit - segment->address, &request->data[5],
+						bit, chunk);
+			}
+			ModbusRTU_SlaveNotifyWrite(slave, request->functionCode, address,
+					quantity);
+
+			/* address + quantity */
+			memcpy(response, request->data, MODBUS_RTU_WRITE_RESPONSE_SIZE);
+			*responseSize = MODBUS_RTU_WRITE_RESPONSE_SIZE;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveWriteMultipleRegisters(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x10 write multiple holding registers.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveWriteMultipleRegisters(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const ModbusRTU_SlaveSegmentT *segment = NULL;
+	uint16_t address = 0, quantity = 0;
+
+	if (request->dataSize < 5) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		address = modbusRTUGetU16(&request->data[0]);
+		quantity = modbusRTUGetU16(&request->data[2]);
+
+		if ((0 == quantity) || (quantity > MODBUS_RTU_MAX_WRITE_REGISTERS)
+				|| (request->data[4] != 2 * quantity)
+				|| (request->dataSize
+						!= (size_t) MODBUS_RTU_WRITE_REGISTERS_REQUEST_SIZE(quantity))) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			segment = ModbusRTU_SlaveResolve(&slave->holdingRegisters, address,
+					quantity, MODBUS_RTU_SEGMENT_WRITE);
+			if (NULL == segment) {
+				result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+			} else {
+				ModbusRTU_SlaveGetRegisters(segment, address, &request->data[5],
+						quantity);
+				ModbusRTU_SlaveNotifyWrite(slave, request->functionCode,
+						address, quantity);
+
+				/* address + quantity */
+				memcpy(response, request->data, MODBUS_RTU_WRITE_RESPONSE_SIZE);
+				*responseSize = MODBUS_RTU_WRITE_RESPONSE_SIZE;
+			}
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveMaskWriteRegister(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x16 mask write holding register: (reg AND and) OR (or AND NOT and).
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveMaskWriteRegister(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const ModbusRTU_SlaveSegmentT *segment = NULL;
+	uint16_t address = 0, andMask = 0, orMask = 0;
+	uint16_t *target = NULL;
+
+	if (MODBUS_RTU_MASK_WRITE_REQUEST_SIZE != request->dataSize) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		address = modbusRTUGetU16(&request->data[0]);
+		andMask = modbusRTUGetU16(&request->data[2]);
+		orMask = modbusRTUGetU16(&request->data[4]);
+		/* read modify write, the segment needs both rights */
+		segment = ModbusRTU_SlaveResolve(&slave->holdingRegisters, address, 1,
+				MODBUS_RTU_SEGMENT_RW);
+
+		if (NULL == segment) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+		} else {
+			target = (uint16_t*) segment->data + (address - segment->address);
+			*target = (*target & andMask) | (orMask & (uint16_t) ~andMask);
+			ModbusRTU_SlaveNotifyWrite(slave, request->functionCode, address, 1);
+
+			/* echo of the request */
+			memcpy(response, request->data, MODBUS_RTU_MASK_WRITE_RESPONSE_SIZE);
+			*responseSize = MODBUS_RTU_MASK_WRITE_RESPONSE_SIZE;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveReadWriteRegisters(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x17 write then read multiple holding registers.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveReadWriteRegisters(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const ModbusRTU_SlaveSegmentT *readSegment = NULL;
+	const ModbusRTU_SlaveSegmentT *writeSegment = NULL;
+	uint16_t readAddress = 0, readQuantity = 0;
+	uint16_t writeAddress = 0, writeQuantity = 0;
+
+	if (request->dataSize < 9) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		readAddress = modbusRTUGetU16(&request->data[0]);
+		readQuantity = modbusRTUGetU16(&request->data[2]);
+		writeAddress = modbusRTUGetU16(&request->data[4]);
+		writeQuantity = modbusRTUGetU16(&request->data[6]);
+
+		if ((0 == readQuantity)
+				|| (readQuantity > MODBUS_RTU_HANDLE_MAX_READ_REGISTERS)
+				|| (0 == writeQuantity)
+				|| (writeQuantity > MODBUS_RTU_MAX_RW_WRITE_REGISTERS)
+				|| (request->data[8] != 2 * writeQuantity)
+				|| (request->dataSize
+						!= (size_t) MODBUS_RTU_READ_WRITE_REQUEST_SIZE(writeQuantity))) {
+			result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			readSegment = ModbusRTU_SlaveResolve(&slave->holdingRegisters,
+					readAddress, readQuantity, MODBUS_RTU_SEGMENT_READ);
+			writeSegment = ModbusRTU_SlaveResolve(&slave->holdingRegisters,
+					writeAddress, writeQuantity, MODBUS_RTU_SEGMENT_WRITE);
+			if ((NULL == readSegment) || (NULL == writeSegment)) {
+				result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+			} else {
+				/* the write is performed before the read */
+				ModbusRTU_SlaveGetRegisters(writeSegment, writeAddress,
+						&request->data[9], writeQuantity);
+				ModbusRTU_SlaveNotifyWrite(slave, request->functionCode,
+						writeAddress, writeQuantity);
+
+				response[0] = 2 * readQuantity; /* byte count */
+				ModbusRTU_SlavePutRegisters(&response[1], readSegment,
+						readAddress, readQuantity);
+				*responseSize = 1 + response[0];
+			}
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveReadExceptionStatus(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x07 read exception status.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveReadExceptionStatus(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+
+	if (0 != request->dataSize) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		response[0] = slave->exceptionStatus;
+		*responseSize = 1;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveDiagnostic(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x08 diagnostics, sub function 0x0000 return query data and,
+ *        with MODBUS_RTU_ENABLE_STATS, the counters of the bus.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveDiagnostic(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	uint16_t subFunction = 0;
+
+	(void) slave;
+
+	if (request->dataSize < 2) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else if (MODBUS_RTU_DIAG_RETURN_QUERY_DATA
+			== (subFunction = modbusRTUGetU16(&request->data[0]))) {
+		/* loop back of sub function and data */
+		memcpy(response, request->data, request->dataSize);
+		*responseSize = request->dataSize;
+#ifdef MODBUS_RTU_ENABLE_STATS
+	} else if (MODBUS_RTU_DIAG_REQUEST_SIZE == request->dataSize) {
+		result = ModbusRTU_SlaveDiagnosticCounter(slave, subFunction,
+				modbusRTUGetU16(&request->data[2]), response, responseSize);
+#endif
+	} else {
+		result = MODBUS_EXCEPTION_ILLEGAL_FUNCTION; /* unsupported sub function */
+	}
+
+	return result;
+}
+
+#ifdef MODBUS_RTU_ENABLE_STATS
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveDiagnosticCounter(ModbusRTU_SlaveT *slave, uint16_t subFunction, uint16_t value, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x08 counter sub functions, served from the ModbusRTU_StatsT of the bus.
+ *
+ * @param slave The slave engine.
+ * @param subFunction The sub function.
+ * @param value Data word of the request, 0x0000 (restart: or 0xFF00).
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ *
+ * @note : counters are sent modulo 65536 as the spec defines them.
+ */
+static uint8_t ModbusRTU_SlaveDiagnosticCounter(ModbusRTU_SlaveT *slave,
+		uint16_t subFunction, uint16_t value, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	ModbusRTU_HandleT *modbus = slave->modbus;
+	const ModbusRTU_StatsT *stats = &modbus->stats;
+	uint32_t counter = value; /* restart and clears echo the request */
+
+	if ((0 != value)
+			&& ((MODBUS_RTU_DIAG_RESTART_COMM != subFunction)
+					|| (MODBUS_RTU_DIAG_CLEAR_LOG != value))) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		switch (subFunction) {
+		case MODBUS_RTU_DIAG_RESTART_COMM:
+		case MODBUS_RTU_DIAG_CLEAR_COUNTERS:
+			modbusRTUResetStats(modbus);
+			break;
+		case MODBUS_RTU_DIAG_RETURN_REGISTER:
+		case MODBUS_RTU_DIAG_SERVER_NAK_COUNT:
+		case MODBUS_RTU_DIAG_SERVER_BUSY_COUNT:
+			counter = 0; /* no diagnostic register, never NAK or busy */
+			break;
+		case MODBUS_RTU_DIAG_BUS_MESSAGE_COUNT:
+			counter = stats->rxFrames + stats->rxFiltered;
+			break;
+		case MODBUS_RTU_DIAG_BUS_ERROR_COUNT:
+			counter = stats->crcErrors;
+			break;
+		case MODBUS_RTU_DIAG_BUS_EXCEPTION_COUNT:
+			counter = stats->txExceptions;
+			break;
+		case MODBUS_RTU_DIAG_SERVER_MESSAGE_COUNT:
+			counter = stats->serverMessages;
+			break;
+		case MODBUS_RTU_DIAG_SERVER_NO_RESPONSE_COUNT:
+			counter = stats->noResponses;
+			break;
+		case MODBUS_RTU_DIAG_BUS_OVERRUN_COUNT:
+			counter = stats->rxOverruns;
+			break;
+		case MODBUS_RTU_DIAG_CLEAR_OVERRUN:
+			modbus->stats.rxOverruns = 0;
+			break;
+		default:
+			result = MODBUS_EXCEPTION_ILLEGAL_FUNCTION; /* unsupported sub function */
+			break;
+		}
+	}
+
+	if (MODBUS_EXCEPTION_NONE == result) {
+		modbusRTUPutU16(&response[0], subFunction);
+		modbusRTUPutU16(&response[2], (uint16_t) counter);
+		*responseSize = MODBUS_RTU_DIAG_REQUEST_SIZE;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveGetCommEventCounter(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x0B get comm event counter, status word and event count.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveGetCommEventCounter(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+
+	if (0 != request->dataSize) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		/* requests are served one at a time, never busy when this runs */
+		modbusRTUPutU16(&response[0], 0x0000);
+		modbusRTUPutU16(&response[2], slave->modbus->stats.commEventCount);
+		*responseSize = MODBUS_RTU_COMM_EVENT_COUNTER_RESPONSE_SIZE;
+	}
+
+	return result;
+}
+#endif
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveReportServerId(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x11 report server ID, followed by the run indicator (ON).
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveReportServerId(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+
+	if (0 != request->dataSize) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else if ((NULL == slave->serverId)
+			|| (slave->serverIdSize > MODBUS_RTU_MAX_DATA_SIZE - 2)) {
+		result = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+	} else {
+		response[0] = slave->serverIdSize + 1; /* byte count */
+		memcpy(&response[1], slave->serverId, slave->serverIdSize);
+		response[1 + slave->serverIdSize] = 0xFF; /* run indicator */
+		*responseSize = 2 + slave->serverIdSize;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveReadFileRecord(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x14 read file record, every sub-request through the fileCallback.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveReadFileRecord(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	const uint8_t *reference = NULL;
+	uint16_t quantity = 0;
+	size_t size = 1;
+
+	if (NULL == slave->fileCallback) {
+		result = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+	} else if ((request->dataSize < 1 + 7)
+			|| (request->data[0] != request->dataSize - 1)
+			|| (0 != request->data[0] % 7)) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		/* the whole reply must fit before the first record is read */
+		for (size_t i = 1; (MODBUS_EXCEPTION_NONE == result)
+				&& (i < request->dataSize); i += 7) {
+			reference = &request->data[i];
+			quantity = modbusRTUGetU16(&reference[5]);
+			result = ModbusRTU_SlaveCheckFile(reference);
+			size += 2 + 2 * quantity;
+			if ((MODBUS_EXCEPTION_NONE == result)
+					&& (size > 1 + MODBUS_RTU_MAX_FILE_READ_SIZE)) {
+				result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+			}
+		}
+
+		size = 1;
+		for (size_t i = 1; (MODBUS_EXCEPTION_NONE == result)
+				&& (i < request->dataSize); i += 7) {
+			reference = &request->data[i];
+			quantity = modbusRTUGetU16(&reference[5]);
+			response[size] = 1 + 2 * quantity; /* sub-response length */
+			response[size + 1] = MODBUS_RTU_FILE_REFERENCE_TYPE;
+			result = slave->fileCallback(slave, request->functionCode,
+					modbusRTUGetU16(&reference[1]),
+					modbusRTUGetU16(&reference[3]), quantity,
+					&response[size + 2]);
+			size += 2 + 2 * quantity;
+		}
+		response[0] = (uint8_t) (size - 1); /* response data length */
+		*responseSize = size;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveWriteFileRecord(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x15 write file record, every sub-request through the fileCallback.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveWriteFileRecord(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	uint8_t *reference = NULL;
+	uint16_t quantity = 0;
+	size_t i = 1;
+
+	if (NULL == slave->fileCallback) {
+		result = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+	} else if ((request->dataSize < 1 + 7 + 2)
+			|| (request->data[0] != request->dataSize - 1)) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		/* every sub-request must be whole before the first record is written */
+		while ((MODBUS_EXCEPTION_NONE == result) && (i < request->dataSize)) {
+			quantity = (i + 7 <= request->dataSize) ?
+					modbusRTUGetU16(&request->data[i + 5]) : 0;
+			if ((0 == quantity) || (i + 7 + 2u * quantity > request->dataSize)) {
+				result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+			} else {
+				result = ModbusRTU_SlaveCheckFile(&request->data[i]);
+			}
+			i += 7 + 2u * quantity;
+		}
+
+		if (MODBUS_EXCEPTION_NONE == result) {
+			/* the reply is the echo, the records are handed over from there */
+			memcpy(response, request->data, request->dataSize);
+			*responseSize = request->dataSize;
+		}
+		for (i = 1; (MODBUS_EXCEPTION_NONE == result)
+				&& (i < request->dataSize); i += 7 + 2u * quantity) {
+			reference = &response[i];
+			quantity = modbusRTUGetU16(&reference[5]);
+			result = slave->fileCallback(slave, request->functionCode,
+					modbusRTUGetU16(&reference[1]),
+					modbusRTUGetU16(&reference[3]), quantity, &reference[7]);
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveCheckFile(const uint8_t *reference)
+ * @brief Check the reference of a file sub-request: type, file, record range.
+ *
+ * @param reference Reference type, file, record and record length of the sub-request.
+ * @return MODBUS_EXCEPTION_NONE, ILLEGAL DATA ADDRESS (ILLEGAL DATA VALUE for no record).
+ */
+static uint8_t ModbusRTU_SlaveCheckFile(const uint8_t *reference) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_NONE;
+	uint16_t file = modbusRTUGetU16(&reference[1]);
+	uint16_t record = modbusRTUGetU16(&reference[3]);
+	uint16_t quantity = modbusRTUGetU16(&reference[5]);
+
+	if (0 == quantity) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else if ((MODBUS_RTU_FILE_REFERENCE_TYPE != reference[0]) || (0 == file)
+			|| ((uint32_t) record + quantity > MODBUS_RTU_FILE_RECORDS)) {
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_SlaveReadFifoQueue(ModbusRTU_SlaveT *slave, const ModbusRTU_FrameViewT *request, uint8_t *response, size_t *responseSize)
+ * @brief FC 0x18 read, and drain, the FIFO at the pointer address.
+ *
+ * @param slave The slave engine.
+ * @param request The validated request.
+ * @param response Reply PDU data area.
+ * @param responseSize Reply PDU data size.
+ * @return MODBUS_EXCEPTION_NONE or the exception code.
+ */
+static uint8_t ModbusRTU_SlaveReadFifoQueue(ModbusRTU_SlaveT *slave,
+		const ModbusRTU_FrameViewT *request, uint8_t *response,
+		size_t *responseSize) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+	ModbusRTU_SlaveFifoT *fifo = NULL;
+	uint16_t address = 0;
+	uint8_t tail = 0;
+	uint8_t count = 0;
+
+	if (NULL == slave->fifos) {
+		result = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+	} else if ((MODBUS_RTU_READ_FIFO_REQUEST_SIZE != request->dataSize)
+			|| (MODBUS_RTU_BROADCAST_ID == request->slaveId)) {
+		/* a broadcast would drain samples nobody receives */
+		result = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+	} else {
+		address = modbusRTUGetU16(&request->data[0]);
+		for (uint8_t i = 0; (NULL == fifo) && (i < slave->fifoCount); i++) {
+			if (address == slave->fifos[i].address) {
+				fifo = &slave->fifos[i];
+			}
+		}
+	}
+
+	if (NULL != fifo) {
+		/* every sample pushed so far, oldest first */
+		tail = fifo->tail;
+		count = (uint8_t) (fifo->head - tail);
+		__DMB();
+		modbusRTUPutU16(&response[0], 2 + 2 * count); /* byte count */
+		modbusRTUPutU16(&response[2], count);
+		for (uint8_t i = 0; i < count; i++) {
+			modbusRTUPutU16(&response[4 + 2 * i],
+					fifo->values[(uint8_t) (tail + i)
+							& (MODBUS_RTU_SLAVE_FIFO_SIZE - 1)]);
+		}
+		/* the slots are read before the producer may reuse them */
+		__DMB();
+		fifo->tail = tail + count;
+		*responseSize = MODBUS_RTU_READ_FIFO_RESPONSE_SIZE(count);
+		result = MODBUS_EXCEPTION_NONE;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static const ModbusRTU_SlaveSegmentT* ModbusRTU_SlaveResolve(const ModbusRTU_SlaveMapT *map, uint16_t address, uint16_t quantity, uint8_t access)
+ * @brief Find the segment of the first address and check the whole range.
+ *
+ * @param map The segment table.
+ * @param address First coil/register.
+ * @param quantity Coils/registers (> 0).
+ * @param access MODBUS_RTU_SEGMENT_xxx rights every segment of the range needs.
+ * @return first segment of the range, NULL when a gap or a right is missing.
+ *
+ * @note : binary search for the first segment, then at most a walk over
+ *         the neighbours a 125 register request can span.
+ */
+static const ModbusRTU_SlaveSegmentT* ModbusRTU_SlaveResolve(
+		const ModbusRTU_SlaveMapT *map, uint16_t address, uint16_t quantity,
+		uint8_t access) {
+
+	/* local variable */
+	const ModbusRTU_SlaveSegmentT *result = NULL;
+	const ModbusRTU_SlaveSegmentT *segment = NULL;
+	uint32_t end = (uint32_t) address + quantity;
+	uint32_t next = address;
+	uint8_t low = 0, high = map->segmentCount, middle = 0;
+
+	/* last segment starting at or before address */
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		if (map->segments[middle].address <= address) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	if (low > 0) {
+		result = &map->segments[low - 1];
+		/* the range must be covered without a gap, with the rights */
+		for (segment = result; next < end; segment++) {
+			if ((segment == &map->segments[map->segmentCount])
+					|| (segment->address > next)
+					|| ((uint32_t) segment->address + segment->count <= next)
+					|| (access != (segment->flags & access))
+					|| (NULL == segment->data)) {
+				result = NULL;
+				break;
+			}
+			next = (uint32_t) segment->address + segment->count;
+		}
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static uint16_t ModbusRTU_SlaveChunk(const ModbusRTU_SlaveSegmentT *segment, uint16_t address, uint16_t quantity)
+ * @brief Part of a resolved range that lies in one segment.
+ *
+ * @param segment The segment holding address.
+ * @param address First coil/register of the rest of the range.
+ * @param quantity Coils/registers left in the range.
+ * @return coils/registers to access in this segment.
+ */
+static uint16_t ModbusRTU_SlaveChunk(const ModbusRTU_SlaveSegmentT *segment,
+		uint16_t address, uint16_t quantity) {
+
+	/* local variable */
+	uint16_t available = segment->count - (address - segment->address);
+
+	return (quantity < available) ? quantity : available;
+}
+
+/*!
+ * @fn    static void ModbusRTU_SlavePutRegisters(uint8_t *dst, const ModbusRTU_SlaveSegmentT *segment, uint16_t address, uint16_t quantity)
+ * @brief Copy a resolved register range to the wire, big endian.
+ *
+ * @param dst Destination, 2 * quantity bytes.
+ * @param segment First segment of the range.
+ * @param address First register.
+ * @param quantity Registers to copy.
+ */
+static void ModbusRTU_SlavePutRegisters(uint8_t *dst,
+		const ModbusRTU_SlaveSegmentT *segment, uint16_t address,
+		uint16_t quantity) {
+
+	/* local variable */
+	const uint16_t *src = NULL;
+	uint16_t chunk = 0;
+
+	for (uint16_t done = 0; done < quantity; done += chunk, segment++) {
+		chunk = ModbusRTU_SlaveChunk(segment, address + done, quantity - done);
+		src = (const uint16_t*) segment->data
+				+ (address + done - segment->address);
+		modbusRTURegistersToWire(&dst[2 * done], src, chunk);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_SlaveGetRegisters(const ModbusRTU_SlaveSegmentT *segment, uint16_t address, const uint8_t *src, uint16_t quantity)
+ * @brief Copy big endian registers from the wire to a resolved range.
+ *
+ * @param segment First segment of the range.
+ * @param address First register.
+ * @param src Source, 2 * quantity bytes.
+ * @param quantity Registers to copy.
+ */
+static void ModbusRTU_SlaveGetRegisters(const ModbusRTU_SlaveSegmentT *segment,
+		uint16_t address, const uint8_t *src, uint16_t quantity) {
+
+	/* local variable */
+	uint16_t *dst = NULL;
+	uint16_t chunk = 0;
+
+	for (uint16_t done = 0; done < quantity; done += chunk, segment++) {
+		chunk = ModbusRTU_SlaveChunk(segment, address + done, quantity - done);
+		dst = (uint16_t*) segment->data + (address + done - segment->address);
+		modbusRTURegistersFromWire(dst, &src[2 * done], chunk);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_SlaveNotifyWrite(ModbusRTU_SlaveT *slave, uint8_t functionCode, uint16_t address, uint16_t quantity)
+ * @brief Tell the application about a write of the master.
+ *
+ * @param slave The slave engine.
+ * @param functionCode The modBus function code of the write.
+ * @param address First written coil/register.
+ * @param quantity Written coils/registers.
+ */
+static void ModbusRTU_SlaveNotifyWrite(ModbusRTU_SlaveT *slave,
+		uint8_t functionCode, uint16_t address, uint16_t quantity) {
+	if (NULL != slave->writeCallback) {
+		slave->writeCallback(slave, functionCode, address, quantity);
+	}
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -0,0 +1,222 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUSlave.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU slave register map engine.
+ ******************************************************************************
+ *
+ * This file provides the slave side of the library: requests addressed to
+ * the instance are dispatched by function code through a constant table
+ * and served from application owned coil and register arrays, described
+ * by sorted segment tables that may be scattered over the address space.
+ * FC 0x18 drains sample FIFOs the application fills from its sampling
+ * context, up to 31 registers per transaction.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_SLAVE_H
+#define MODBUS_RTU_SLAVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @defgroup Segment access flags */
+#define MODBUS_RTU_SEGMENT_READ 0x01  /* served by the read functions */
+#define MODBUS_RTU_SEGMENT_WRITE 0x02 /* served by the write functions */
+#define MODBUS_RTU_SEGMENT_RW (MODBUS_RTU_SEGMENT_READ | MODBUS_RTU_SEGMENT_WRITE)
+
+/*! @def ModbusRTU_SlaveMapT initializer for a const segment array */
+#define MODBUS_RTU_SLAVE_MAP(segments) \
+	{ (segments), (uint8_t) (sizeof(segments) / sizeof((segments)[0])) }
+
+/*! @def Registers of a FIFO ring, power of two above MODBUS_RTU_MAX_FIFO_COUNT */
+#define MODBUS_RTU_SLAVE_FIFO_SIZE 32
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+struct _modbusSlave;
+
+/*!
+ * @typedef @struct  _modbusSlaveSegment
+ * @brief one contiguous range of coils or registers, owned by the application.
+ */
+typedef struct _modbusSlaveSegment{
+	uint16_t address; /*! first coil/register of the segment */
+	uint16_t count; /*! coils/registers in the segment */
+	void *data; /*! packed uint8_t[] (LSB = lowest address) for bits, uint16_t[] for registers */
+	uint8_t flags; /*! MODBUS_RTU_SEGMENT_xxx */
+} ModbusRTU_SlaveSegmentT;
+
+/*!
+ * @typedef @struct  _modbusSlaveMap
+ * @brief segment table of one object type, usually const in flash.
+ *
+ * @note : segments are sorted by address and must not overlap, a request
+ *         may span neighbouring segments without a gap.
+ */
+typedef struct _modbusSlaveMap{
+	const ModbusRTU_SlaveSegmentT *segments; /*! sorted segments, NULL = not served */
+	uint8_t segmentCount; /*! entries of segments */
+} ModbusRTU_SlaveMapT;
+
+/*!
+ * @typedef ModbusRTU_SlaveWriteCallbackT
+ * @brief coils or holding registers were written by the master, ISR context.
+ *
+ * @param slave The slave engine.
+ * @param functionCode The modBus function code of the write.
+ * @param address First written coil/register.
+ * @param quantity Written coils/registers.
+ */
+typedef void (*ModbusRTU_SlaveWriteCallbackT)(struct _modbusSlave *slave,
+		uint8_t functionCode, uint16_t address, uint16_t quantity);
+
+/*!
+ * @typedef ModbusRTU_SlaveFileCallbackT
+ * @brief records of one file sub-request (FC 0x14/0x15), ISR context.
+ *
+ * @param slave The slave engine.
+ * @param functionCode MODBUS_FUNC_READ_FILE_RECORD or MODBUS_FUNC_WRITE_FILE_RECORD.
+ * @param file The file (1..0xFFFF).
+ * @param record First record (0..9999).
+ * @param quantity Records, up to the end of the file.
+ * @param data 2 * quantity bytes, wire order: FC 0x14 fill them, FC 0x15 the new records.
+ * @return MODBUS_EXCEPTION_NONE or the exception code, e.g. ILLEGAL DATA ADDRESS.
+ *
+ * @note : data lies in the reply frame, no record is copied on the way.
+ *         Every sub-request of a frame is checked before the first call.
+ */
+typedef uint8_t (*ModbusRTU_SlaveFileCallbackT)(struct _modbusSlave *slave,
+		uint8_t functionCode, uint16_t file, uint16_t record,
+		uint16_t quantity, uint8_t *data);
+
+/*!
+ * @typedef @struct  _modbusSlaveFifo
+ * @brief sample queue read by FC 0x18, one producer and the slave engine.
+ *
+ * @note : zero it and set the address, e.g. { .address = 0x0400 }.
+ */
+typedef struct _modbusSlaveFifo{
+	uint16_t address; /*! FIFO pointer address of FC 0x18 */
+	uint16_t values[MODBUS_RTU_SLAVE_FIFO_SIZE]; /*! private: ring */
+	volatile uint8_t head; /*! private: pushes, by the producer */
+	volatile uint8_t tail; /*! private: registers read, by the slave engine */
+	uint32_t overruns; /*! samples dropped on a full FIFO */
+} ModbusRTU_SlaveFifoT;
+
+/*!
+ * @typedef @struct  _modbusSlave
+ * @brief slave engine of one bus.
+ */
+typedef struct _modbusSlave{
+	ModbusRTU_HandleT *modbus; /*! bus served by this engine */
+	ModbusRTU_SlaveMapT coils; /*! FC 0x01/0x05/0x0F */
+	ModbusRTU_SlaveMapT discreteInputs; /*! FC 0x02, read only */
+	ModbusRTU_SlaveMapT holdingRegisters; /*! FC 0x03/0x06/0x10/0x16/0x17 */
+	ModbusRTU_SlaveMapT inputRegisters; /*! FC 0x04, read only */
+	uint8_t exceptionStatus; /*! answer of FC 0x07 */
+	const uint8_t *serverId; /*! answer of FC 0x11, NULL = not served */
+	uint8_t serverIdSize; /*! bytes of serverId */
+	ModbusRTU_SlaveWriteCallbackT writeCallback; /*! optional, after every write */
+	ModbusRTU_SlaveFileCallbackT fileCallback; /*! FC 0x14/0x15, NULL = not served */
+	ModbusRTU_SlaveFifoT *fifos; /*! FC 0x18, NULL = not served */
+	uint8_t fifoCount; /*! entries of fifos */
+	void *context; /*! free for the application */
+	uint8_t replyFunctionCode; /*! private: function code of the pending reply */
+	uint16_t replySize; /*! private: PDU data size of the pending reply */
+	volatile bool isReplyPending; /*! private: reply built, waiting for t3.5 */
+	uint32_t lineBaudRate; /*! private: line to switch to after the reply, 0 = none */
+	uint8_t lineParity; /*! private: parity of lineBaudRate */
+} ModbusRTU_SlaveT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUSlaveInit(ModbusRTU_SlaveT *slave, ModbusRTU_HandleT *modbus)
+ * @brief Attach a slave engine to a modBus RTU instance.
+ *
+ * @param slave Pointer to the slave engine.
+ * @param modbus Pointer to the ModbusRTU instance (uses its eventCallback and slaveId).
+ *
+ * @note : all maps start empty, fill them before modbusRTUSlaveStart.
+ */
+void modbusRTUSlaveInit(ModbusRTU_SlaveT *slave, ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSlaveStart(ModbusRTU_SlaveT *slave)
+ * @brief Start listening for requests.
+ *
+ * @param slave Pointer to the slave engine.
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : requests are answered from the UART/timer interrupts, at t3.5
+ *         after the end of the request. For the DMA engine call
+ *         modbusRTUStartReceiveToIdle first. Reads longer than the
+ *         MODBUS_RTU_HANDLE_MAX_READ_* limits get ILLEGAL_DATA_VALUE.
+ */
+ModbusRTU_ErrorT modbusRTUSlaveStart(ModbusRTU_SlaveT *slave);
+
+/*!
+ * @fn    void modbusRTUSlaveSetLine(ModbusRTU_SlaveT *slave, uint32_t baudRate, uint8_t parity)
+ * @brief Switch the bus to another baud rate and parity after the pending reply.
+ *
+ * @param slave Pointer to the slave engine.
+ * @param baudRate The new baud rate.
+ * @param parity MODBUS_RTU_PARITY_xxx.
+ *
+ * @note : from the writeCallback of a line register the master writes, the
+ *         acknowledgement still goes out on the old line.
+ */
+void modbusRTUSlaveSetLine(ModbusRTU_SlaveT *slave, uint32_t baudRate,
+		uint8_t parity);
+
+/*!
+ * @fn    bool modbusRTUSlaveFifoPush(ModbusRTU_SlaveFifoT *fifo, uint16_t value)
+ * @brief Queue a sample for the next FC 0x18 read.
+ *
+ * @param fifo Pointer to the FIFO.
+ * @param value The sample.
+ * @return false when the FIFO holds 31 samples, the sample is dropped.
+ *
+ * @note : one producer, e.g. the ADC interrupt or the main loop, without a
+ *         lock. A read takes the samples off the FIFO when it is answered,
+ *         a reply the master misses does not bring them back.
+ */
+bool modbusRTUSlaveFifoPush(ModbusRTU_SlaveFifoT *fifo, uint16_t value);
+
+/*!
+ * @fn    uint8_t modbusRTUSlaveFifoCount(const ModbusRTU_SlaveFifoT *fifo)
+ * @brief Samples waiting for a FC 0x18 read.
+ *
+ * @param fifo Pointer to the FIFO.
+ * @return 0..MODBUS_RTU_MAX_FIFO_COUNT.
+ */
+uint8_t modbusRTUSlaveFifoCount(const ModbusRTU_SlaveFifoT *fifo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_SLAVE_H
@@ -0,0 +1,452 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUSniffer.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU passive bus capture.
+ ******************************************************************************
+ *
+ * This file provides the capture. Frames are stamped and written to the
+ * ring in the bus events (ISR context) as they end, the main loop only
+ * drains the ring. The microsecond clock is the cycle counter of the
+ * port, extended by the millisecond tick over gaps it cannot measure.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+/* 3. Module Header File */
+#include <modBusRTUSniffer.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*! @def Longest varint: a 64 bit value in 7 bit groups */
+#define MODBUS_RTU_SNIFFER_VARINT_SIZE 10
+
+/*! @def Longest record head: 64 bit varint delta, status, 16 bit varint length */
+#define MODBUS_RTU_SNIFFER_HEAD_SIZE 13
+
+/* Variables -----------------------------------------------------------------*/
+
+/*! @var Magic of the capture header */
+static const uint8_t ModbusRTU_SnifferMagic[4] = { 'M', 'B', 'S', 'N' };
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_SnifferEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event);
+static void ModbusRTU_SnifferCapture(ModbusRTU_SnifferT *sniffer,
+		const uint8_t *frame, size_t length, ModbusRTU_ErrorT result);
+static uint64_t ModbusRTU_SnifferNowUs(ModbusRTU_SnifferT *sniffer);
+static void ModbusRTU_SnifferWrite(ModbusRTU_SnifferT *sniffer,
+		const uint8_t *data, size_t size);
+static size_t ModbusRTU_SnifferPutVarint(uint8_t *data, uint64_t value);
+static ModbusRTU_ErrorT ModbusRTU_SnifferGetVarint(const uint8_t *data,
+		size_t size, uint64_t *value, size_t *count);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSnifferStart(ModbusRTU_SnifferT *sniffer, ModbusRTU_HandleT *modbus)
+ * @brief Capture every frame of the bus, starting with the header.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param modbus Pointer to the ModbusRTU instance (uses its eventCallback).
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : for the DMA engine call modbusRTUStartReceiveToIdle first, a
+ *         frame ring (modbusRTUSetRxQueue) keeps back to back frames.
+ */
+ModbusRTU_ErrorT modbusRTUSnifferStart(ModbusRTU_SnifferT *sniffer,
+		ModbusRTU_HandleT *modbus) {
+
+	/* local variable */
+	uint8_t header[MODBUS_RTU_SNIFFER_HEADER_SIZE];
+	uint32_t baudRate = modbusRTUPortGetBaudRate(modbus->huart);
+	uint32_t coreHz = 0;
+
+	modbusRTUPortCyclesInit();
+	coreHz = modbusRTUPortCoreHz();
+
+	sniffer->modbus = modbus;
+	sniffer->head = 0;
+	sniffer->tail = 0;
+	sniffer->nowUs = 0;
+	sniffer->lastUs = 0;
+	sniffer->lastCycles = modbusRTUPortCycles();
+	sniffer->lastMs = modbusRTUPortGetTickMs();
+	sniffer->cyclesPerUs = coreHz / 1000000u;
+	/* half the wrap of the cycle counter, longer gaps are counted in ms */
+	sniffer->wrapMs = (0 == coreHz) ? 0 : (UINT32_MAX / coreHz) * 500u;
+	sniffer->isLost = false;
+	sniffer->records = 0;
+	sniffer->lostRecords = 0;
+
+	memcpy(header, ModbusRTU_SnifferMagic, sizeof(ModbusRTU_SnifferMagic));
+	header[4] = MODBUS_RTU_SNIFFER_VERSION;
+	header[5] = (uint8_t) baudRate;
+	header[6] = (uint8_t) (baudRate >> 8);
+	header[7] = (uint8_t) (baudRate >> 16);
+	header[8] = (uint8_t) (baudRate >> 24);
+	ModbusRTU_SnifferWrite(sniffer, header, sizeof(header));
+
+	/* every frame on the bus counts, whatever its address */
+	modbus->userContext = sniffer;
+	modbus->eventCallback = ModbusRTU_SnifferEvent;
+	modbus->isPromiscuous = true;
+
+	return modbusRTUListen(modbus);
+}
+
+/*!
+ * @fn    void modbusRTUSnifferStop(ModbusRTU_SnifferT *sniffer)
+ * @brief Release the bus, the ring keeps the records not drained yet.
+ *
+ * @param sniffer Pointer to the capture.
+ */
+void modbusRTUSnifferStop(ModbusRTU_SnifferT *sniffer) {
+
+	/* local variable */
+	ModbusRTU_HandleT *modbus = sniffer->modbus;
+	uint32_t lock = modbusRTUPortEnterCritical();
+
+	if (sniffer == modbus->userContext) {
+		modbus->eventCallback = NULL;
+		modbus->userContext = NULL;
+		modbus->isPromiscuous = false;
+	}
+	modbusRTUPortExitCritical(lock);
+}
+
+/*!
+ * @fn    size_t modbusRTUSnifferPeek(ModbusRTU_SnifferT *sniffer, const uint8_t **data)
+ * @brief Oldest captured bytes in one piece, without a copy.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param data Set to the first byte.
+ * @return bytes at data, 0 when the ring is empty.
+ *
+ * @note : call from the main loop, e.g. CDC_Transmit_FS(data, size) or
+ *         f_write(), then modbusRTUSnifferConsume once they are sent.
+ */
+size_t modbusRTUSnifferPeek(ModbusRTU_SnifferT *sniffer, const uint8_t **data) {
+
+	/* local variable */
+	uint32_t tail = sniffer->tail;
+	uint32_t offset = tail & (MODBUS_RTU_SNIFFER_BUFFER_SIZE - 1);
+	size_t result = sniffer->head - tail;
+
+	/* read the bytes only after the ISR published them */
+	__DMB();
+	if (result > MODBUS_RTU_SNIFFER_BUFFER_SIZE - offset) {
+		/* up to the end of the ring, the rest on the next call */
+		result = MODBUS_RTU_SNIFFER_BUFFER_SIZE - offset;
+	}
+	*data = &sniffer->buffer[offset];
+
+	return result;
+}
+
+/*!
+ * @fn    void modbusRTUSnifferConsume(ModbusRTU_SnifferT *sniffer, size_t size)
+ * @brief Give drained bytes back to the ring.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param size Bytes of the last modbusRTUSnifferPeek sent.
+ */
+void modbusRTUSnifferConsume(ModbusRTU_SnifferT *sniffer, size_t size) {
+
+	/* the bytes are read completely before the ISR may overwrite them */
+	__DMB();
+	sniffer->tail += (uint32_t) size;
+}
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSnifferDecode(ModbusRTU_SnifferDecoderT *decoder, const uint8_t *data, size_t size, ModbusRTU_SnifferRecordT *record, size_t *used)
+ * @brief Decode the next record of a capture stream.
+ *
+ * @param decoder Pointer to the decoder state.
+ * @param data Capture bytes from where the previous call stopped.
+ * @param size Bytes of data.
+ * @param record Filled with the frame.
+ * @param used Bytes consumed, the header included.
+ * @return MODBUS_RTU_SUCCESS with a record, MODBUS_RTU_RX_BUSY when data
+ *         ends inside it, MODBUS_RTU_ERROR_INVALID_FRAME on anything but a
+ *         capture.
+ *
+ * @note : runs on the host as well, see the decoder of the host build.
+ */
+ModbusRTU_ErrorT modbusRTUSnifferDecode(ModbusRTU_SnifferDecoderT *decoder,
+		const uint8_t *data, size_t size, ModbusRTU_SnifferRecordT *record,
+		size_t *used) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	size_t position = 0;
+	size_t count = 0;
+	uint64_t delta = 0;
+	uint64_t length = 0;
+	uint8_t status = 0;
+
+	*used = 0;
+	if (false == decoder->isSynced) {
+		if ((size >= sizeof(ModbusRTU_SnifferMagic))
+				&& (0 != memcmp(data, ModbusRTU_SnifferMagic,
+								sizeof(ModbusRTU_SnifferMagic)))) {
+			result = MODBUS_RTU_ERROR_INVALID_FRAME;
+		} else if (size >= MODBUS_RTU_SNIFFER_HEADER_SIZE) {
+			if (MODBUS_RTU_SNIFFER_VERSION != data[4]) {
+				result = MODBUS_RTU_ERROR_INVALID_FRAME;
+			} else {
+				decoder->baudRate = (uint32_t) data[5]
+						| ((uint32_t) data[6] << 8) | ((uint32_t) data[7] << 16)
+						| ((uint32_t) data[8] << 24);
+				decoder->timeUs = 0;
+				decoder->isSynced = true;
+				position = MODBUS_RTU_SNIFFER_HEADER_SIZE;
+				*used = position;
+			}
+		}
+	}
+
+	if ((true == decoder->isSynced) && (MODBUS_RTU_RX_BUSY == result)) {
+		result = ModbusRTU_SnifferGetVarint(data + position, size - position,
+				&delta, &count);
+		position += count;
+		if ((MODBUS_RTU_SUCCESS == result) && (position >= size)) {
+			result = MODBUS_RTU_RX_BUSY;
+		} else if (MODBUS_RTU_SUCCESS == result) {
+			status = data[position++];
+			result = ModbusRTU_SnifferGetVarint(data + position,
+					size - position, &length, &count);
+			position += count;
+			if ((MODBUS_RTU_SUCCESS == result)
+					&& (length > MODBUS_RTU_MAX_FRAME_SIZE)) {
+				result = MODBUS_RTU_ERROR_INVALID_FRAME;
+			} else if ((MODBUS_RTU_SUCCESS == result)
+					&& (size - position < length)) {
+				result = MODBUS_RTU_RX_BUSY;
+			} else if (MODBUS_RTU_SUCCESS == result) {
+				decoder->timeUs += delta;
+				record->timeUs = decoder->timeUs;
+				record->deltaUs =
+						(delta > UINT32_MAX) ? UINT32_MAX : (uint32_t) delta;
+				record->result = (ModbusRTU_ErrorT) (status
+						& MODBUS_RTU_SNIFFER_RESULT_MASK);
+				record->isLost = (0 != (status & MODBUS_RTU_SNIFFER_LOST));
+				record->frame = data + position;
+				record->length = (uint16_t) length;
+				*used = position + (size_t) length;
+			}
+		}
+	}
+
+	return result;
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_SnifferEvent(ModbusRTU_HandleT *modbus, ModbusRTU_EventT event)
+ * @brief eventCallback of the bus: capture every frame that ended.
+ *
+ * @param modbus Pointer to the ModbusRTU instance.
+ * @param event What happened.
+ */
+static void ModbusRTU_SnifferEvent(ModbusRTU_HandleT *modbus,
+		ModbusRTU_EventT event) {
+
+	/* local variable */
+	ModbusRTU_SnifferT *sniffer = (ModbusRTU_SnifferT*) modbus->userContext;
+	ModbusRTU_FrameViewT frame = { 0 };
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	const uint8_t *bytes = NULL;
+	size_t length = 0;
+	bool isCaptured = false;
+
+	(void) event;
+
+	while (true == modbusRTUIsRxFrameReady(modbus)) {
+		isCaptured = true;
+		length = modbusRTUPeekRxFrame(modbus, &bytes);
+		result = modbusRTUGetRxFrame(modbus, &frame);
+		/* released when invalid, the bytes stay until this ISR receives again */
+		ModbusRTU_SnifferCapture(sniffer, bytes, length, result);
+		if ((MODBUS_RTU_SUCCESS == result)
+				|| (MODBUS_RTU_ERROR_EXCEPTION == result)) {
+			modbusRTUReleaseRxFrame(modbus);
+		}
+	}
+
+	if (true == isCaptured) {
+		modbusRTUListen(modbus);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_SnifferCapture(ModbusRTU_SnifferT *sniffer, const uint8_t *frame, size_t length, ModbusRTU_ErrorT result)
+ * @brief Stamp a frame and write its record, or count it lost on a full ring.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param frame Bytes as received.
+ * @param length Bytes of frame.
+ * @param result Check of the frame.
+ */
+static void ModbusRTU_SnifferCapture(ModbusRTU_SnifferT *sniffer,
+		const uint8_t *frame, size_t length, ModbusRTU_ErrorT result) {
+
+	/* local variable */
+	ModbusRTU_HandleT *modbus = sniffer->modbus;
+	uint8_t head[MODBUS_RTU_SNIFFER_HEAD_SIZE];
+	size_t headSize = 0;
+	/* the frame ended before its end was detected: one idle char (DMA) or t1.5 */
+	uint32_t lateTicks =
+			(MODBUS_RTU_RX_MODE_DMA_IDLE == modbus->rxMode) ?
+					modbus->charTicks : modbus->t15Ticks;
+	uint64_t lateUs = ((uint64_t) lateTicks * 1000000u)
+			/ MODBUS_RTU_TIMER_TICK_HZ;
+	uint64_t endUs = ModbusRTU_SnifferNowUs(sniffer);
+
+	endUs = (endUs > sniffer->lastUs + lateUs) ? endUs - lateUs : sniffer->lastUs;
+
+	headSize = ModbusRTU_SnifferPutVarint(head, endUs - sniffer->lastUs);
+	head[headSize++] = (uint8_t) result
+			| ((true == sniffer->isLost) ? MODBUS_RTU_SNIFFER_LOST : 0);
+	headSize += ModbusRTU_SnifferPutVarint(&head[headSize], length);
+
+	if (MODBUS_RTU_SNIFFER_BUFFER_SIZE - (sniffer->head - sniffer->tail)
+			>= headSize + length) {
+		ModbusRTU_SnifferWrite(sniffer, head, headSize);
+		ModbusRTU_SnifferWrite(sniffer, frame, length);
+		sniffer->lastUs = endUs;
+		sniffer->isLost = false;
+		sniffer->records++;
+	} else {
+		/* the next record carries the time and the loss */
+		sniffer->isLost = true;
+		sniffer->lostRecords++;
+	}
+}
+
+/*!
+ * @fn    static uint64_t ModbusRTU_SnifferNowUs(ModbusRTU_SnifferT *sniffer)
+ * @brief Microseconds since the start of the capture.
+ *
+ * @param sniffer Pointer to the capture.
+ * @return the time now.
+ */
+static uint64_t ModbusRTU_SnifferNowUs(ModbusRTU_SnifferT *sniffer) {
+
+	/* local variable */
+	uint32_t cycles = modbusRTUPortCycles();
+	uint32_t ms = modbusRTUPortGetTickMs();
+	uint32_t elapsedUs = 0;
+
+	if ((0 == sniffer->cyclesPerUs) || (ms - sniffer->lastMs >= sniffer->wrapMs)) {
+		/* no cycle counter, or it may have wrapped since the last frame */
+		sniffer->nowUs += (uint64_t) (ms - sniffer->lastMs) * 1000u;
+		sniffer->lastCycles = cycles;
+	} else {
+		/* keep the remainder of the division for the next frame */
+		elapsedUs = (cycles - sniffer->lastCycles) / sniffer->cyclesPerUs;
+		sniffer->nowUs += elapsedUs;
+		sniffer->lastCycles += elapsedUs * sniffer->cyclesPerUs;
+	}
+	sniffer->lastMs = ms;
+
+	return sniffer->nowUs;
+}
+
+/*!
+ * @fn    static void ModbusRTU_SnifferWrite(ModbusRTU_SnifferT *sniffer, const uint8_t *data, size_t size)
+ * @brief Append bytes to the ring, the caller checked the room.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param data Bytes to append.
+ * @param size Bytes of data.
+ */
+static void ModbusRTU_SnifferWrite(ModbusRTU_SnifferT *sniffer,
+		const uint8_t *data, size_t size) {
+
+	/* local variable */
+	uint32_t offset = sniffer->head & (MODBUS_RTU_SNIFFER_BUFFER_SIZE - 1);
+	size_t first = MODBUS_RTU_SNIFFER_BUFFER_SIZE - offset;
+
+	if (first > size) {
+		first = size;
+	}
+	memcpy(&sniffer->buffer[offset], data, first);
+	memcpy(sniffer->buffer, data + first, size - first);
+
+	/* the bytes are in the ring before the main loop sees them */
+	__DMB();
+	sniffer->head += (uint32_t) size;
+}
+
+/*!
+ * @fn    static size_t ModbusRTU_SnifferPutVarint(uint8_t *data, uint64_t value)
+ * @brief Write a LEB128 varint.
+ *
+ * @param data Destination, up to MODBUS_RTU_SNIFFER_VARINT_SIZE bytes.
+ * @param value The value.
+ * @return bytes written.
+ */
+static size_t ModbusRTU_SnifferPutVarint(uint8_t *data, uint64_t value) {
+
+	/* local variable */
+	size_t result = 0;
+
+	while (value >= 0x80u) {
+		data[result++] = (uint8_t) value | 0x80u;
+		value >>= 7;
+	}
+	data[result++] = (uint8_t) value;
+
+	return result;
+}
+
+/*!
+ * @fn    static ModbusRTU_ErrorT ModbusRTU_SnifferGetVarint(const uint8_t *data, size_t size, uint64_t *value, size_t *count)
+ * @brief Read a LEB128 varint.
+ *
+ * @param data Source.
+ * @param size Bytes of data.
+ * @param value The value.
+ * @param count Bytes read, 0 unless MODBUS_RTU_SUCCESS.
+ * @return MODBUS_RTU_SUCCESS, MODBUS_RTU_RX_BUSY when data ends inside the
+ *         varint, MODBUS_RTU_ERROR_INVALID_FRAME when it does not
+ *         end within MODBUS_RTU_SNIFFER_VARINT_SIZE bytes.
+ */
+static ModbusRTU_ErrorT ModbusRTU_SnifferGetVarint(const uint8_t *data,
+		size_t size, uint64_t *value, size_t *count) {
+
+	/* local variable */
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	size_t i = 0;
+
+	*value = 0;
+	*count = 0;
+	for (i = 0; (i < size) && (MODBUS_RTU_RX_BUSY == result); i++) {
+		if (i >= MODBUS_RTU_SNIFFER_VARINT_SIZE) {
+			/* longer than any 64 bit value: not a capture */
+			result = MODBUS_RTU_ERROR_INVALID_FRAME;
+		} else {
+			*value |= (uint64_t) (data[i] & 0x7Fu) << (7 * i);
+			if (0 == (data[i] & 0x80u)) {
+				*count = i + 1;
+				result = MODBUS_RTU_SUCCESS;
+			}
+		}
+	}
+
+	return result;
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -0,0 +1,189 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUSniffer.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU passive bus capture.
+ ******************************************************************************
+ *
+ * This file provides a listen-only capture of a bus. Every frame on the
+ * wire, whatever its address, is time stamped in microseconds at its last
+ * stop bit, checked like a received frame and stored as a compact record
+ * in a byte ring the main loop drains to USB CDC, an SD card file or a
+ * socket. The capture never transmits and never drives DE.
+ *
+ * Capture format, little endian, varint = LEB128 (7 bits per byte, bit 7
+ * set when another byte follows):
+ *
+ *   header  "MBSN" | version (1) | baud rate (u32)
+ *   record  delta us (varint) | status (u8) | length (varint) | frame
+ *
+ * delta is the time since the end of the previous record (the first one:
+ * since the start), the status is the ModbusRTU_ErrorT of the check in
+ * bits 0-4 and MODBUS_RTU_SNIFFER_LOST when records were dropped on a
+ * full ring before this one, the frame keeps its CRC. A poll of 8 byte
+ * frames takes about 12 bytes per frame, a 115200 baud bus fills at most
+ * 15 kB/s.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_SNIFFER_H
+#define MODBUS_RTU_SNIFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Bytes of the capture ring, power of two */
+#ifndef MODBUS_RTU_SNIFFER_BUFFER_SIZE
+#define MODBUS_RTU_SNIFFER_BUFFER_SIZE 4096
+#endif
+/*! @def Version of the capture format */
+#define MODBUS_RTU_SNIFFER_VERSION 1
+/*! @def Bytes of the capture header */
+#define MODBUS_RTU_SNIFFER_HEADER_SIZE 9
+/*! @def Status bit: records were dropped before this one */
+#define MODBUS_RTU_SNIFFER_LOST 0x80u
+/*! @def Status bits of the frame check, a ModbusRTU_ErrorT */
+#define MODBUS_RTU_SNIFFER_RESULT_MASK 0x1Fu
+
+#if (0 != (MODBUS_RTU_SNIFFER_BUFFER_SIZE & (MODBUS_RTU_SNIFFER_BUFFER_SIZE - 1)))
+#error "MODBUS_RTU_SNIFFER_BUFFER_SIZE must be a power of two"
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusSniffer
+ * @brief listen-only capture of one bus.
+ */
+typedef struct _modbusSniffer{
+	ModbusRTU_HandleT *modbus; /*! bus that listens */
+	uint8_t buffer[MODBUS_RTU_SNIFFER_BUFFER_SIZE]; /*! capture ring */
+	volatile uint32_t head; /*! bytes written, by the bus ISR */
+	volatile uint32_t tail; /*! bytes drained, by the main loop */
+	uint64_t nowUs; /*! private: clock since the start */
+	uint64_t lastUs; /*! private: end of the last record */
+	uint32_t lastCycles; /*! private: modbusRTUPortCycles() of nowUs */
+	uint32_t lastMs; /*! private: modbusRTUPortGetTickMs() of nowUs */
+	uint32_t cyclesPerUs; /*! private: 0 = no cycle counter, ms resolution */
+	uint32_t wrapMs; /*! private: gaps the cycle counter measures */
+	bool isLost; /*! private: a record was dropped since the last one */
+	uint32_t records; /*! frames captured */
+	uint32_t lostRecords; /*! frames dropped on a full ring */
+} ModbusRTU_SnifferT;
+
+/*!
+ * @typedef @struct  _modbusSnifferRecord
+ * @brief one decoded frame of a capture.
+ */
+typedef struct _modbusSnifferRecord{
+	uint64_t timeUs; /*! end of the frame since the start of the capture */
+	uint32_t deltaUs; /*! since the end of the previous record, saturated */
+	ModbusRTU_ErrorT result; /*! check of the frame, MODBUS_RTU_SUCCESS when valid */
+	bool isLost; /*! records were dropped before this one */
+	const uint8_t *frame; /*! bytes as received, CRC included, inside the decoded data */
+	uint16_t length; /*! bytes of frame */
+} ModbusRTU_SnifferRecordT;
+
+/*!
+ * @typedef @struct  _modbusSnifferDecoder
+ * @brief state of a capture decoder, zero it before the first call.
+ */
+typedef struct _modbusSnifferDecoder{
+	bool isSynced; /*! the header was read */
+	uint32_t baudRate; /*! line of the capture */
+	uint64_t timeUs; /*! end of the last record */
+} ModbusRTU_SnifferDecoderT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSnifferStart(ModbusRTU_SnifferT *sniffer, ModbusRTU_HandleT *modbus)
+ * @brief Capture every frame of the bus, starting with the header.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param modbus Pointer to the ModbusRTU instance (uses its eventCallback).
+ * @return result @ref ModbusRTU_ErrorT in modBus_RTU.h header file
+ *
+ * @note : for the DMA engine call modbusRTUStartReceiveToIdle first, a
+ *         frame ring (modbusRTUSetRxQueue) keeps back to back frames.
+ */
+ModbusRTU_ErrorT modbusRTUSnifferStart(ModbusRTU_SnifferT *sniffer,
+		ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    void modbusRTUSnifferStop(ModbusRTU_SnifferT *sniffer)
+ * @brief Release the bus, the ring keeps the records not drained yet.
+ *
+ * @param sniffer Pointer to the capture.
+ */
+void modbusRTUSnifferStop(ModbusRTU_SnifferT *sniffer);
+
+/*!
+ * @fn    size_t modbusRTUSnifferPeek(ModbusRTU_SnifferT *sniffer, const uint8_t **data)
+ * @brief Oldest captured bytes in one piece, without a copy.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param data Set to the first byte.
+ * @return bytes at data, 0 when the ring is empty.
+ *
+ * @note : call from the main loop, e.g. CDC_Transmit_FS(data, size) or
+ *         f_write(), then modbusRTUSnifferConsume once they are sent.
+ */
+size_t modbusRTUSnifferPeek(ModbusRTU_SnifferT *sniffer, const uint8_t **data);
+
+/*!
+ * @fn    void modbusRTUSnifferConsume(ModbusRTU_SnifferT *sniffer, size_t size)
+ * @brief Give drained bytes back to the ring.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param size Bytes of the last modbusRTUSnifferPeek sent.
+ */
+void modbusRTUSnifferConsume(ModbusRTU_SnifferT *sniffer, size_t size);
+
+/*!
+ * @fn    ModbusRTU_ErrorT modbusRTUSnifferDecode(ModbusRTU_SnifferDecoderT *decoder, const uint8_t *data, size_t size, ModbusRTU_SnifferRecordT *record, size_t *used)
+ * @brief Decode the next record of a capture stream.
+ *
+ * @param decoder Pointer to the decoder state.
+ * @param data Capture bytes from where the previous call stopped.
+ * @param size Bytes of data.
+ * @param record Filled with the frame.
+ * @param used Bytes consumed, the header included.
+ * @return MODBUS_RTU_SUCCESS with a record, MODBUS_RTU_RX_BUSY when data
+ *         ends inside it, MODBUS_RTU_ERROR_INVALID_FRAME on anything but a
+ *         capture.
+ *
+ * @note : runs on the host as well, see the decoder of the host build.
+ */
+ModbusRTU_ErrorT modbusRTUSnifferDecode(ModbusRTU_SnifferDecoderT *decoder,
+		const uint8_t *data, size_t size, ModbusRTU_SnifferRecordT *record,
+		size_t *used);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_SNIFFER_H
@@ -0,0 +1,435 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUBench.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU host benchmark suite.
+ ******************************************************************************
+ *
+ * This file measures the library off target, in three parts:
+ *  - CRC: throughput of the compiled CRC backend on host CPU time.
+ *  - bus: a scheduler master polls slave engines on one simulated bus as
+ *    fast as the protocol allows. Transactions and frames per second and
+ *    the bus utilization are virtual time figures, exact and repeatable;
+ *    efficiency compares the utilization with the limit of the frame
+ *    lengths and the t3.5 gaps.
+ *  - cpu: host time the master and the slaves spend in the library per
+ *    transaction (interrupt callbacks, scheduler process). Every measured
+ *    call includes the measurement cost, printed next to the figures.
+ *
+ * Built with MODBUS_RTU_CRC_BENCHMARK and MODBUS_RTU_DATA_BENCHMARK it runs
+ * the target microbenchmarks (modbusRTUCrcBenchmark, modbusRTUDataBenchmark)
+ * first. Their DWT figures follow the virtual clock of the simulator, which
+ * stands still while they run, so only the host time of each call means
+ * something here; on target the same calls report core cycles.
+ *
+ * usage: modBusRTUBench [--baud N] [--slaves N] [--registers N] [--ms N]
+ *                       [--dma] [--crc-bytes N] [--min-efficiency F]
+ *
+ * The exit code is 1 when a transaction failed, the bus saw a collision or
+ * the efficiency is below --min-efficiency, so CI catches a regression.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUCrc.h"
+#include "modBusRTUData.h"
+#include "modBusRTUFrame.h"
+#include "modBusRTUMaster.h"
+#include "modBusRTUSlave.h"
+#include "modBusRTUSim.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Most slaves of the bus benchmark, one port is the master */
+#define MODBUS_RTU_BENCH_MAX_SLAVES (MODBUS_RTU_SIM_PORTS - 1)
+/*! @def Holding registers of every slave */
+#define MODBUS_RTU_BENCH_REGISTERS 125
+/*! @def Frame of the CRC benchmark */
+#define MODBUS_RTU_BENCH_CRC_FRAME 256
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusBenchConfig
+ * @brief command line of the benchmark.
+ */
+typedef struct _modbusBenchConfig{
+	uint32_t baudRate;
+	uint8_t slaves;
+	uint16_t registers; /*! registers per read */
+	uint32_t runMs; /*! virtual time of the bus benchmark */
+	bool isDma; /*! slaves receive with DMA and IDLE line */
+	uint32_t crcBytes; /*! bytes of the CRC benchmark */
+	double minEfficiency; /*! fail below this bus efficiency */
+} ModbusRTU_BenchConfigT;
+
+/*!
+ * @typedef @struct  _modbusBenchResult
+ * @brief outcome of the polls.
+ */
+typedef struct _modbusBenchResult{
+	uint32_t answers;
+	uint32_t errors;
+} ModbusRTU_BenchResultT;
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 2. Static Variables */
+
+static ModbusRTU_BenchResultT ModbusRTU_BenchResult;
+static ModbusRTU_SimCpuT ModbusRTU_BenchCpuOverhead; /*! cost of one measurement */
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_BenchParse(ModbusRTU_BenchConfigT *config, int argc,
+		char **argv);
+static void ModbusRTU_BenchCalibrate(void);
+static void ModbusRTU_BenchCrc(const ModbusRTU_BenchConfigT *config);
+#if defined(MODBUS_RTU_CRC_BENCHMARK) || defined(MODBUS_RTU_DATA_BENCHMARK)
+static void ModbusRTU_BenchMicro(void);
+#endif
+static bool ModbusRTU_BenchBus(const ModbusRTU_BenchConfigT *config);
+static void ModbusRTU_BenchOnResult(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+
+/* 2. Global Function Declarations */
+
+int main(int argc, char **argv) {
+
+	/* local variable */
+	ModbusRTU_BenchConfigT config = { .baudRate = 115200, .slaves = 4,
+			.registers = 10, .runMs = 2000, .isDma = false, .crcBytes = 1u << 24,
+			.minEfficiency = 0.0 };
+	bool isPass = false;
+
+	ModbusRTU_BenchParse(&config, argc, argv);
+	ModbusRTU_BenchCalibrate();
+#if defined(MODBUS_RTU_CRC_BENCHMARK) || defined(MODBUS_RTU_DATA_BENCHMARK)
+	ModbusRTU_BenchMicro();
+#endif
+	ModbusRTU_BenchCrc(&config);
+	isPass = ModbusRTU_BenchBus(&config);
+	printf("result: %s\n", (true == isPass) ? "PASS" : "FAIL");
+
+	return (true == isPass) ? 0 : 1;
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_BenchParse(ModbusRTU_BenchConfigT *config, int argc, char **argv)
+ * @brief Read the command line, unknown options are ignored.
+ */
+static void ModbusRTU_BenchParse(ModbusRTU_BenchConfigT *config, int argc,
+		char **argv) {
+
+	/* local variable */
+	unsigned long value = 0;
+
+	for (int i = 1; i < argc; i++) {
+		value = (i + 1 < argc) ? strtoul(argv[i + 1], NULL, 10) : 0;
+		if (0 == strcmp(argv[i], "--dma")) {
+			config->isDma = true;
+		} else if (i + 1 >= argc) {
+			/* options below take a value */
+		} else if (0 == strcmp(argv[i], "--baud")) {
+			config->baudRate = (0 == value) ? config->baudRate : (uint32_t) value;
+			i++;
+		} else if (0 == strcmp(argv[i], "--slaves")) {
+			config->slaves = (value < 1) ? 1 :
+					(value > MODBUS_RTU_BENCH_MAX_SLAVES) ?
+							MODBUS_RTU_BENCH_MAX_SLAVES : (uint8_t) value;
+			i++;
+		} else if (0 == strcmp(argv[i], "--registers")) {
+			config->registers = (value < 1) ? 1 :
+					(value > MODBUS_RTU_BENCH_REGISTERS) ?
+							MODBUS_RTU_BENCH_REGISTERS : (uint16_t) value;
+			i++;
+		} else if (0 == strcmp(argv[i], "--ms")) {
+			config->runMs = (0 == value) ? config->runMs : (uint32_t) value;
+			i++;
+		} else if (0 == strcmp(argv[i], "--crc-bytes")) {
+			config->crcBytes = (uint32_t) value;
+			i++;
+		} else if (0 == strcmp(argv[i], "--min-efficiency")) {
+			config->minEfficiency = strtod(argv[i + 1], NULL);
+			i++;
+		}
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_BenchCalibrate(void)
+ * @brief Measure the cost of an empty modbusRTUSimCpuStart/Stop pair.
+ */
+static void ModbusRTU_BenchCalibrate(void) {
+
+	/* local variable */
+	ModbusRTU_SimCpuT total = { 0 }, start;
+
+	for (uint32_t i = 0; i < 100000u; i++) {
+		modbusRTUSimCpuStart(&start);
+		modbusRTUSimCpuStop(&total, &start);
+	}
+	ModbusRTU_BenchCpuOverhead.ns = total.ns / total.calls;
+	ModbusRTU_BenchCpuOverhead.cycles = total.cycles / total.calls;
+}
+
+/*!
+ * @fn    static void ModbusRTU_BenchCrc(const ModbusRTU_BenchConfigT *config)
+ * @brief Throughput of modbusRTUCrcUpdate over full size frames.
+ */
+static void ModbusRTU_BenchCrc(const ModbusRTU_BenchConfigT *config) {
+
+	/* local variable */
+	static const char *const backends[MODBUS_RTU_CRC_BACKEND_COUNT] = {
+			"bitwise", "table", "nibble", "hardware" };
+	static uint8_t frame[MODBUS_RTU_BENCH_CRC_FRAME];
+	ModbusRTU_SimCpuT total = { 0 }, start;
+	uint32_t seed = 0x12345678u, rounds = config->crcBytes / sizeof(frame);
+	uint16_t crc = 0;
+
+	for (size_t i = 0; i < sizeof(frame); i++) {
+		seed = seed * 1664525u + 1013904223u;
+		frame[i] = (uint8_t) (seed >> 24);
+	}
+	/* check value of the spec example: 01 03 00 00 00 0A -> C5 CD */
+	crc = modbusRTUCalculateCRC((const uint8_t[] ) { 0x01, 0x03, 0x00, 0x00,
+					0x00, 0x0A }, 6);
+
+	modbusRTUSimCpuStart(&start);
+	for (uint32_t i = 0; i < rounds; i++) {
+		frame[0] ^= (uint8_t) modbusRTUCrcUpdate(MODBUS_RTU_CRC_INIT, frame,
+				sizeof(frame));
+	}
+	modbusRTUSimCpuStop(&total, &start);
+
+	printf("crc: backend=%s check=%s bytes=%lu\n",
+			backends[MODBUS_RTU_CRC_BACKEND], (0xCDC5 == crc) ? "ok" : "BAD",
+			(unsigned long) (rounds * sizeof(frame)));
+	if (rounds > 0) {
+		printf("crc: ns_per_byte=%.3f cycles_per_byte=%.2f mbyte_per_s=%.1f\n",
+				(double) total.ns / ((double) rounds * sizeof(frame)),
+				(double) total.cycles / ((double) rounds * sizeof(frame)),
+				((double) rounds * sizeof(frame) * 1000.0)
+						/ (double) ((0 == total.ns) ? 1 : total.ns));
+	}
+}
+
+#if defined(MODBUS_RTU_CRC_BENCHMARK) || defined(MODBUS_RTU_DATA_BENCHMARK)
+/*!
+ * @fn    static void ModbusRTU_BenchMicro(void)
+ * @brief Run the target microbenchmarks of the library.
+ */
+static void ModbusRTU_BenchMicro(void) {
+
+	/* local variable */
+	ModbusRTU_SimCpuT total = { 0 }, start;
+#ifdef MODBUS_RTU_CRC_BENCHMARK
+	static const char *const backends[MODBUS_RTU_CRC_BACKEND_COUNT] = {
+			"bitwise", "table", "nibble", "hardware" };
+	ModbusRTU_CrcBenchmarkT crc[MODBUS_RTU_CRC_BACKEND_COUNT];
+#endif
+#ifdef MODBUS_RTU_DATA_BENCHMARK
+	static const char *const helpers[MODBUS_RTU_DATA_BENCH_COUNT] = {
+			"from_wire", "to_wire", "pack", "unpack" };
+	ModbusRTU_DataBenchmarkT data[MODBUS_RTU_DATA_BENCH_COUNT];
+#endif
+
+#ifdef MODBUS_RTU_CRC_BENCHMARK
+	modbusRTUSimCpuStart(&start);
+	modbusRTUCrcBenchmark(crc, MODBUS_RTU_MAX_FRAME_SIZE);
+	modbusRTUSimCpuStop(&total, &start);
+	printf("crc_benchmark: host_ns=%lu\n", (unsigned long) total.ns);
+	for (uint8_t i = 0; i < MODBUS_RTU_CRC_BACKEND_COUNT; i++) {
+		printf("crc_benchmark: backend=%s dwt_cycles=%lu cycles_per_byte=%.2f\n",
+				backends[i], (unsigned long) crc[i].cycles,
+				crc[i].cyclesPerByteX100 / 100.0);
+	}
+#endif
+#ifdef MODBUS_RTU_DATA_BENCHMARK
+	total = (ModbusRTU_SimCpuT) { 0 };
+	modbusRTUSimCpuStart(&start);
+	modbusRTUDataBenchmark(data);
+	modbusRTUSimCpuStop(&total, &start);
+	printf("data_benchmark: host_ns=%lu\n", (unsigned long) total.ns);
+	for (uint8_t i = 0; i < MODBUS_RTU_DATA_BENCH_COUNT; i++) {
+		printf("data_benchmark: helper=%s naive_cycles=%lu helper_cycles=%lu\n",
+				helpers[i], (unsigned long) data[i].naiveCycles,
+				(unsigned long) data[i].helperCycles);
+	}
+#endif
+}
+#endif
+
+/*!
+ * @fn    static void ModbusRTU_BenchOnResult(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Scheduler callback of the polls.
+ */
+static void ModbusRTU_BenchOnResult(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+	(void) data;
+	(void) dataSize;
+
+	if (MODBUS_RTU_SUCCESS == result) {
+		ModbusRTU_BenchResult.answers++;
+	} else {
+		if (0 == ModbusRTU_BenchResult.errors) {
+			printf("bus: first error %d from slave %u\n", result,
+					request->slaveId);
+		}
+		ModbusRTU_BenchResult.errors++;
+	}
+}
+
+/*!
+ * @fn    static bool ModbusRTU_BenchBus(const ModbusRTU_BenchConfigT *config)
+ * @brief Poll every slave back to back under the scheduler.
+ *
+ * @return true when every poll was answered, the bus stayed collision free
+ *         and the efficiency reached config->minEfficiency.
+ */
+static bool ModbusRTU_BenchBus(const ModbusRTU_BenchConfigT *config) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort;
+	static ModbusRTU_SimPortT slavePorts[MODBUS_RTU_BENCH_MAX_SLAVES];
+	static ModbusRTU_HandleT master;
+	static ModbusRTU_HandleT slaves[MODBUS_RTU_BENCH_MAX_SLAVES];
+	static ModbusRTU_SlaveT engines[MODBUS_RTU_BENCH_MAX_SLAVES];
+	static uint16_t registers[MODBUS_RTU_BENCH_MAX_SLAVES][MODBUS_RTU_BENCH_REGISTERS];
+	static ModbusRTU_SlaveSegmentT maps[MODBUS_RTU_BENCH_MAX_SLAVES][1];
+	static ModbusRTU_RequestT polls[MODBUS_RTU_BENCH_MAX_SLAVES];
+	static ModbusRTU_SchedulerT scheduler;
+	ModbusRTU_SimCpuT process = { 0 }, slaveCpu = { 0 }, wall = { 0 }, wallStart, start;
+	ModbusRTU_SimBusStatsT bus;
+	uint64_t endNs = (uint64_t) config->runMs * 1000000u;
+	double seconds = config->runMs / 1000.0, utilization = 0, ideal = 0;
+	double frameNs = 0, gapNs = 0, transactions = 0;
+	bool result = true;
+
+	memset(&ModbusRTU_BenchResult, 0, sizeof(ModbusRTU_BenchResult));
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, config->baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUStartReceiveToIdle(&master);
+	modbusRTUSchedulerInit(&scheduler, &master);
+
+	for (uint8_t i = 0; i < config->slaves; i++) {
+		modbusRTUSimPortInit(&slavePorts[i], 0, config->baudRate);
+		modbusRTUInit(&slaves[i], &slavePorts[i].huart, &slavePorts[i].htim,
+				i + 1);
+		modbusRTUSimPortAttach(&slavePorts[i], &slaves[i]);
+		if (true == config->isDma) {
+			modbusRTUStartReceiveToIdle(&slaves[i]);
+		}
+		maps[i][0] = (ModbusRTU_SlaveSegmentT ) { 0, MODBUS_RTU_BENCH_REGISTERS,
+						registers[i], MODBUS_RTU_SEGMENT_RW };
+		modbusRTUSlaveInit(&engines[i], &slaves[i]);
+		engines[i].holdingRegisters = (ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(
+				maps[i]);
+		modbusRTUSlaveStart(&engines[i]);
+
+		/* due every millisecond: always due when the bus is free */
+		polls[i] = (ModbusRTU_RequestT ) { .slaveId = i + 1, .functionCode =
+						MODBUS_FUNC_READ_HOLDING_REGISTERS, .address = 0,
+						.quantity = config->registers, .periodMs = 1,
+						.callback = ModbusRTU_BenchOnResult };
+		modbusRTUSchedulerAdd(&scheduler, &polls[i]);
+	}
+
+	modbusRTUSimCpuStart(&wallStart);
+	do {
+		modbusRTUSimCpuStart(&start);
+		modbusRTUSchedulerProcess(&scheduler);
+		modbusRTUSimCpuStop(&process, &start);
+	} while (true == modbusRTUSimStep(endNs));
+	modbusRTUSimCpuStop(&wall, &wallStart);
+
+	for (uint8_t i = 0; i < config->slaves; i++) {
+		slaveCpu.ns += slavePorts[i].cpu.ns;
+		slaveCpu.cycles += slavePorts[i].cpu.cycles;
+		slaveCpu.calls += slavePorts[i].cpu.calls;
+	}
+	modbusRTUSimGetBusStats(0, &bus);
+
+	/* limit: request + response back to back, t3.5 before each frame */
+	frameNs = (MODBUS_RTU_FRAME_SIZE(MODBUS_RTU_READ_REQUEST_SIZE)
+			+ MODBUS_RTU_FRAME_SIZE(
+					MODBUS_RTU_READ_REGISTERS_RESPONSE_SIZE(config->registers)))
+			* (double) modbusRTUSimCharNs(config->baudRate);
+	gapNs = 2.0 * master.t35Ticks * (1e9 / MODBUS_RTU_TIMER_TICK_HZ);
+	ideal = frameNs / (frameNs + gapNs);
+	utilization = (double) bus.busyNs / (double) endNs;
+	transactions = ModbusRTU_BenchResult.answers + ModbusRTU_BenchResult.errors;
+
+	printf("bus: baud=%lu slaves=%u registers=%u rx=%s virtual_ms=%lu\n",
+			(unsigned long) config->baudRate, config->slaves, config->registers,
+			config->isDma ? "dma" : "it", (unsigned long) config->runMs);
+	printf("bus: transactions=%.0f errors=%lu collisions=%lu\n", transactions,
+			(unsigned long) ModbusRTU_BenchResult.errors,
+			(unsigned long) bus.collisions);
+	printf("bus: transactions_per_s=%.1f frames_per_s=%.1f limit_per_s=%.1f\n",
+			transactions / seconds,
+			(masterPort.stats.txFrames + ModbusRTU_BenchResult.answers) / seconds,
+			1e9 / (frameNs + gapNs));
+	printf("bus: utilization=%.4f limit=%.4f efficiency=%.4f\n", utilization,
+			ideal, (ideal > 0) ? utilization / ideal : 0.0);
+	if (transactions > 0) {
+		printf("cpu: master_isr_ns=%.0f master_process_ns=%.0f slave_isr_ns=%.0f (per transaction)\n",
+				(double) masterPort.cpu.ns / transactions,
+				(double) process.ns / transactions,
+				(double) slaveCpu.ns / transactions);
+		printf("cpu: master_isr_cycles=%.0f slave_isr_cycles=%.0f (host counter, 0 = none)\n",
+				(double) masterPort.cpu.cycles / transactions,
+				(double) slaveCpu.cycles / transactions);
+		printf("cpu: interrupts_per_transaction master=%.1f slaves=%.1f\n",
+				masterPort.cpu.calls / transactions, slaveCpu.calls / transactions);
+		printf("cpu: measurement_ns=%lu measurement_cycles=%lu (included once per call)\n",
+				(unsigned long) ModbusRTU_BenchCpuOverhead.ns,
+				(unsigned long) ModbusRTU_BenchCpuOverhead.cycles);
+	}
+	printf("host: wall_ms=%.1f speed=%.1fx real time\n", wall.ns / 1e6,
+			(wall.ns > 0) ? (double) endNs / (double) wall.ns : 0.0);
+#ifdef MODBUS_RTU_ENABLE_STATS
+	{
+		ModbusRTU_StatsT stats;
+		modbusRTUGetStats(&master, &stats);
+		printf("stats: response_us=%lu response_max_us=%lu timeouts=%lu crc_errors=%lu\n",
+				(unsigned long) stats.responseTimeUs,
+				(unsigned long) stats.responseTimeMaxUs,
+				(unsigned long) stats.timeouts, (unsigned long) stats.crcErrors);
+	}
+#endif
+
+	if ((0 == ModbusRTU_BenchResult.answers) || (0 != ModbusRTU_BenchResult.errors)
+			|| (0 != bus.collisions)
+			|| ((ideal > 0) && (utilization / ideal < config->minEfficiency))) {
+		result = false;
+	}
+
+	return result;
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
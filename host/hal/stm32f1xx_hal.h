@@ -0,0 +1,240 @@
+/**
+ ******************************************************************************
+ * @file           : stm32f1xx_hal.h
+ * @author         : keyhanSalehi
+ * @brief          : host shim of the STM32 HAL used by the modBus RTU library.
+ ******************************************************************************
+ *
+ * This file stands in for the STM32Cube HAL on a PC: it declares only the
+ * types, registers, intrinsics and HAL functions the library touches. The
+ * UART, DMA and timer functions are implemented by the simulator in
+ * modBusRTUSim.c, the CMSIS intrinsics are portable C. The file name
+ * matches the real header so the library sources build unchanged.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_HOST_HAL_H
+#define MODBUS_RTU_HOST_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @defgroup CMSIS compiler attributes */
+#define __weak __attribute__((weak))
+#define __IO volatile
+
+/*! @defgroup DWT cycle counter enable bits */
+#define DWT_CTRL_CYCCNTENA_Msk (1u << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1u << 24)
+
+/*! @def DWT and CoreDebug registers, kept by the simulator */
+#define DWT (&modbusRTUHalDwt)
+#define CoreDebug (&modbusRTUHalCoreDebug)
+
+/*! @defgroup UARTEx reception event types */
+#define HAL_UART_RXEVENT_TC 0u
+#define HAL_UART_RXEVENT_HT 1u
+#define HAL_UART_RXEVENT_IDLE 2u
+
+/*! @defgroup UART line settings of UART_InitTypeDef */
+#define UART_WORDLENGTH_8B 0x0000u
+#define UART_WORDLENGTH_9B 0x1000u
+#define UART_STOPBITS_1 0x0000u
+#define UART_STOPBITS_2 0x2000u
+#define UART_PARITY_NONE 0x0000u
+#define UART_PARITY_EVEN 0x0400u
+#define UART_PARITY_ODD 0x0600u
+
+/*! @defgroup TIM register bits */
+#define TIM_CR1_CEN (1u << 0)
+#define TIM_CR1_URS (1u << 2)
+#define TIM_CR1_OPM (1u << 3)
+#define TIM_EGR_UG (1u << 0)
+#define TIM_FLAG_UPDATE (1u << 0)
+#define TIM_IT_UPDATE (1u << 0)
+
+/*! @defgroup TIM register macros */
+#define __HAL_TIM_ENABLE(htim) ((htim)->Instance->CR1 |= TIM_CR1_CEN)
+#define __HAL_TIM_DISABLE(htim) ((htim)->Instance->CR1 &= ~TIM_CR1_CEN)
+#define __HAL_TIM_SET_AUTORELOAD(htim, value) ((htim)->Instance->ARR = (value))
+#define __HAL_TIM_SET_COUNTER(htim, value) ((htim)->Instance->CNT = (value))
+#define __HAL_TIM_GET_COUNTER(htim) ((htim)->Instance->CNT)
+#define __HAL_TIM_CLEAR_FLAG(htim, flag) ((htim)->Instance->SR = ~(flag))
+#define __HAL_TIM_ENABLE_IT(htim, it) ((htim)->Instance->DIER |= (it))
+#define __HAL_TIM_DISABLE_IT(htim, it) ((htim)->Instance->DIER &= ~(it))
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @enum  HAL_StatusTypeDef
+ * @brief HAL function results.
+ */
+typedef enum {
+	HAL_OK = 0x00U,
+	HAL_ERROR = 0x01U,
+	HAL_BUSY = 0x02U,
+	HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+/*!
+ * @typedef @enum  GPIO_PinState
+ * @brief GPIO output level.
+ */
+typedef enum {
+	GPIO_PIN_RESET = 0U,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+/*! @typedef @struct  GPIO_TypeDef @brief GPIO port registers */
+typedef struct {
+	__IO uint32_t CRL, CRH, IDR, ODR, BSRR, BRR, LCKR;
+} GPIO_TypeDef;
+
+/*! @typedef @struct  USART_TypeDef @brief USART registers */
+typedef struct {
+	__IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+/*! @typedef @struct  TIM_TypeDef @brief Basic timer registers */
+typedef struct {
+	__IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC,
+			ARR;
+} TIM_TypeDef;
+
+/*! @typedef @struct  DWT_Type @brief Data watchpoint and trace registers */
+typedef struct {
+	__IO uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+/*! @typedef @struct  CoreDebug_Type @brief Core debug registers */
+typedef struct {
+	__IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+/*! @typedef @struct  UART_InitTypeDef @brief UART line settings */
+typedef struct {
+	uint32_t BaudRate, WordLength, StopBits, Parity, Mode, HwFlowCtl,
+			OverSampling;
+} UART_InitTypeDef;
+
+/*! @typedef @struct  UART_HandleTypeDef @brief UART handle */
+typedef struct {
+	USART_TypeDef *Instance;
+	UART_InitTypeDef Init;
+} UART_HandleTypeDef;
+
+/*! @typedef @struct  TIM_Base_InitTypeDef @brief Timer base settings */
+typedef struct {
+	uint32_t Prescaler, CounterMode, Period;
+} TIM_Base_InitTypeDef;
+
+/*! @typedef @struct  TIM_HandleTypeDef @brief Timer handle */
+typedef struct {
+	TIM_TypeDef *Instance;
+	TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+extern DWT_Type modbusRTUHalDwt;
+extern CoreDebug_Type modbusRTUHalCoreDebug;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*! @defgroup HAL functions, simulated in modBusRTUSim.c */
+uint32_t HAL_GetTick(void);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
+		GPIO_PinState PinState);
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart,
+		const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+		const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart,
+		uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart,
+		uint8_t *pData, uint16_t Size);
+uint32_t HAL_UARTEx_GetRxEventType(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_MultiProcessor_EnterMuteMode(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+
+#if defined(__DCACHE_PRESENT) && (1U == __DCACHE_PRESENT)
+/*! @defgroup Cortex-M7 D-cache maintenance, modelled in modBusRTUSim.c */
+void SCB_CleanDCache_by_Addr(volatile void *addr, int32_t dsize);
+void SCB_InvalidateDCache_by_Addr(volatile void *addr, int32_t dsize);
+#endif
+
+/*! @defgroup HAL callbacks, the application (modBusRTUSim.c) forwards them */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+/*! @defgroup CMSIS intrinsics, a single core without interrupts to mask */
+static inline void __disable_irq(void) {
+}
+static inline void __enable_irq(void) {
+}
+static inline uint32_t __get_PRIMASK(void) {
+	return 0;
+}
+static inline void __set_PRIMASK(uint32_t priMask) {
+	(void) priMask;
+}
+static inline void __DMB(void) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+static inline void __DSB(void) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+static inline uint32_t __REV(uint32_t value) {
+	return __builtin_bswap32(value);
+}
+static inline uint32_t __REV16(uint32_t value) {
+	return ((value & 0x00FF00FFu) << 8) | ((value >> 8) & 0x00FF00FFu);
+}
+static inline uint32_t __RBIT(uint32_t value) {
+	uint32_t result = 0;
+	for (uint8_t i = 0; i < 32; i++) {
+		result = (result << 1) | (value & 1u);
+		value >>= 1;
+	}
+	return result;
+}
+static inline uint8_t __CLZ(uint32_t value) {
+	return (0 == value) ? 32 : (uint8_t) __builtin_clz(value);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_HOST_HAL_H
@@ -0,0 +1,929 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUSim.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU host simulator.
+ ******************************************************************************
+ *
+ * This file implements the HAL functions of the host shim on top of a
+ * virtual clock. Nothing runs concurrently: an event (a character that
+ * completes, a timer update, a DMA transmit complete or an IDLE line) is
+ * taken from the ports in time order and its HAL callback runs to the end
+ * before the next one, like interrupts of equal priority on one core.
+ *
+ ******************************************************************************
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <time.h>
+#include "stm32f1xx_hal.h"
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+/* 3. Module Header File */
+#include <modBusRTUSim.h>
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def No event pending */
+#define MODBUS_RTU_SIM_NEVER UINT64_MAX
+/*! @def Next index of the receive FIFO */
+#define MODBUS_RTU_SIM_FIFO_NEXT(index) (((index) + 1) & (MODBUS_RTU_SIM_RX_FIFO - 1))
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @enum  _modbusSimEvent
+ * @brief what happens at the next point of time.
+ */
+typedef enum _modbusSimEvent{
+	MODBUS_RTU_SIM_EVENT_NONE, /*!< clock moves to the limit */
+	MODBUS_RTU_SIM_EVENT_RX_CHAR, /*!< a character is complete at a port */
+	MODBUS_RTU_SIM_EVENT_TIMER, /*!< update event of a port timer */
+	MODBUS_RTU_SIM_EVENT_TX_DONE, /*!< DMA transmit complete (TC) */
+	MODBUS_RTU_SIM_EVENT_IDLE /*!< one character of silence after a reception */
+} ModbusRTU_SimEventT;
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 1. Global Variables */
+
+DWT_Type modbusRTUHalDwt;
+CoreDebug_Type modbusRTUHalCoreDebug;
+
+/* 2. Static Variables */
+
+static ModbusRTU_SimPortT *ModbusRTU_SimPorts[MODBUS_RTU_SIM_PORTS];
+static uint8_t ModbusRTU_SimPortCount;
+static ModbusRTU_SimBusStatsT ModbusRTU_SimBuses[MODBUS_RTU_SIM_BUSES];
+static uint64_t ModbusRTU_SimBusyUntilNs[MODBUS_RTU_SIM_BUSES];
+static uint64_t ModbusRTU_SimNow;
+#if defined(__DCACHE_PRESENT) && (1U == __DCACHE_PRESENT)
+/*! D-cache model: last cleaned range, a transmit DMA must lie inside it */
+static uintptr_t ModbusRTU_SimCleanStart;
+static uintptr_t ModbusRTU_SimCleanEnd;
+static bool ModbusRTU_SimIsCleanUnaligned;
+#endif
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_SimSetNow(uint64_t nowNs);
+static void ModbusRTU_SimScanTimers(void);
+static uint64_t ModbusRTU_SimTimerExpiry(const ModbusRTU_SimPortT *port);
+static void ModbusRTU_SimPush(ModbusRTU_SimPortT *port, uint64_t atNs,
+		uint8_t data, const UART_InitTypeDef *line);
+static bool ModbusRTU_SimSample(const ModbusRTU_SimPortT *port,
+		uint16_t index, uint8_t *data);
+static bool ModbusRTU_SimParityBit(uint8_t data, uint32_t parity);
+static void ModbusRTU_SimWire(ModbusRTU_SimPortT *port, const uint8_t *data,
+		uint16_t length);
+static void ModbusRTU_SimDeliver(ModbusRTU_SimPortT *port);
+static void ModbusRTU_SimTimerUpdate(ModbusRTU_SimPortT *port);
+static ModbusRTU_SimPortT* ModbusRTU_SimPortOfTimer(TIM_HandleTypeDef *htim);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUSimReset(void)
+ * @brief Forget every port and bus and restart the clock at 0.
+ */
+void modbusRTUSimReset(void) {
+	memset(ModbusRTU_SimPorts, 0, sizeof(ModbusRTU_SimPorts));
+	memset(ModbusRTU_SimBuses, 0, sizeof(ModbusRTU_SimBuses));
+	memset(ModbusRTU_SimBusyUntilNs, 0, sizeof(ModbusRTU_SimBusyUntilNs));
+	ModbusRTU_SimPortCount = 0;
+	ModbusRTU_SimSetNow(0);
+}
+
+/*!
+ * @fn    bool modbusRTUSimPortInit(ModbusRTU_SimPortT *port, uint8_t bus, uint32_t baudRate)
+ * @brief Wire a port to a bus.
+ *
+ * @param port Port storage, lives as long as the simulation.
+ * @param bus Bus number, below MODBUS_RTU_SIM_BUSES.
+ * @param baudRate Baud rate of huart.Init.
+ * @return true when the port was added.
+ */
+bool modbusRTUSimPortInit(ModbusRTU_SimPortT *port, uint8_t bus,
+		uint32_t baudRate) {
+
+	/* local variable */
+	bool result = false;
+
+	if ((bus < MODBUS_RTU_SIM_BUSES) && (0 != baudRate)
+			&& (ModbusRTU_SimPortCount < MODBUS_RTU_SIM_PORTS)) {
+		memset(port, 0, sizeof(*port));
+		port->huart.Instance = &port->uartRegisters;
+		port->huart.Init.BaudRate = baudRate;
+		port->huart.Init.WordLength = UART_WORDLENGTH_8B;
+		port->huart.Init.StopBits = UART_STOPBITS_2;
+		port->huart.Init.Parity = UART_PARITY_NONE;
+		port->htim.Instance = &port->timRegisters;
+		port->bus = bus;
+		ModbusRTU_SimPorts[ModbusRTU_SimPortCount++] = port;
+		result = true;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    void modbusRTUSimPortAttach(ModbusRTU_SimPortT *port, ModbusRTU_HandleT *modbus)
+ * @brief Forward the HAL callbacks of the port to an instance.
+ *
+ * @param port Port of modbusRTUSimPortInit.
+ * @param modbus Instance initialized on &port->huart and &port->htim.
+ *
+ * @note : with MODBUS_RTU_USE_POOL it also gives the instance the DMA ring
+ *         of the port.
+ */
+void modbusRTUSimPortAttach(ModbusRTU_SimPortT *port, ModbusRTU_HandleT *modbus) {
+	port->modbus = modbus;
+#ifdef MODBUS_RTU_USE_POOL
+	/* the DMA ring comes with the UART, like a board support package gives it */
+	modbusRTUSetRxDmaBuffer(modbus, port->rxDmaBuffer,
+			sizeof(port->rxDmaBuffer));
+#endif
+}
+
+/*!
+ * @fn    void modbusRTUSimInject(ModbusRTU_SimPortT *port, const uint8_t *data, size_t length, uint32_t gapNs)
+ * @brief Put characters on the wire towards one port, as if another device sent them.
+ *
+ * @param port Receiving port.
+ * @param data Characters.
+ * @param length Number of characters.
+ * @param gapNs Extra silence between two characters.
+ */
+void modbusRTUSimInject(ModbusRTU_SimPortT *port, const uint8_t *data,
+		size_t length, uint32_t gapNs) {
+
+	/* local variable */
+	uint64_t charNs = modbusRTUSimCharNs(port->huart.Init.BaudRate);
+	uint64_t atNs = ModbusRTU_SimNow;
+
+	for (size_t i = 0; i < length; i++) {
+		atNs += charNs;
+		ModbusRTU_SimPush(port, atNs, data[i], &port->huart.Init);
+		atNs += gapNs;
+	}
+}
+
+/*!
+ * @fn    bool modbusRTUSimStep(uint64_t untilNs)
+ * @brief Run the next event if it is due at untilNs or before.
+ *
+ * @param untilNs Absolute limit of the virtual clock.
+ * @return true when an event ran, false when the clock was moved to untilNs.
+ */
+bool modbusRTUSimStep(uint64_t untilNs) {
+
+	/* local variable */
+	ModbusRTU_SimEventT event = MODBUS_RTU_SIM_EVENT_NONE;
+	ModbusRTU_SimPortT *port = NULL;
+	ModbusRTU_SimPortT *next = NULL;
+	uint64_t best = MODBUS_RTU_SIM_NEVER, atNs = 0;
+
+	/* the main loop may have (re)started a timer */
+	ModbusRTU_SimScanTimers();
+
+	/* at equal times characters go first, then timers, TC and IDLE */
+	for (uint8_t i = 0; i < ModbusRTU_SimPortCount; i++) {
+		port = ModbusRTU_SimPorts[i];
+		if ((port->fifoHead != port->fifoTail)
+				&& (port->fifoNs[port->fifoTail] < best)) {
+			best = port->fifoNs[port->fifoTail];
+			event = MODBUS_RTU_SIM_EVENT_RX_CHAR;
+			next = port;
+		}
+	}
+	for (uint8_t i = 0; i < ModbusRTU_SimPortCount; i++) {
+		port = ModbusRTU_SimPorts[i];
+		atNs = ModbusRTU_SimTimerExpiry(port);
+		if (atNs < best) {
+			best = atNs;
+			event = MODBUS_RTU_SIM_EVENT_TIMER;
+			next = port;
+		}
+	}
+	for (uint8_t i = 0; i < ModbusRTU_SimPortCount; i++) {
+		port = ModbusRTU_SimPorts[i];
+		if ((true == port->isTxPending) && (port->txDoneNs < best)) {
+			best = port->txDoneNs;
+			event = MODBUS_RTU_SIM_EVENT_TX_DONE;
+			next = port;
+		}
+	}
+	for (uint8_t i = 0; i < ModbusRTU_SimPortCount; i++) {
+		port = ModbusRTU_SimPorts[i];
+		if ((NULL != port->dmaBuffer) && (true == port->isIdlePending)) {
+			atNs = port->lastRxNs
+					+ modbusRTUSimCharNs(port->huart.Init.BaudRate);
+			if (atNs < best) {
+				best = atNs;
+				event = MODBUS_RTU_SIM_EVENT_IDLE;
+				next = port;
+			}
+		}
+	}
+	if (best > untilNs) {
+		best = untilNs;
+		event = MODBUS_RTU_SIM_EVENT_NONE;
+	}
+
+	/* a blocking transmit may have run the clock past the event */
+	ModbusRTU_SimSetNow(
+			(best > ModbusRTU_SimNow) ? best : ModbusRTU_SimNow);
+
+	switch (event) {
+	case MODBUS_RTU_SIM_EVENT_RX_CHAR:
+		ModbusRTU_SimDeliver(next);
+		break;
+	case MODBUS_RTU_SIM_EVENT_TIMER:
+		ModbusRTU_SimTimerUpdate(next);
+		break;
+	case MODBUS_RTU_SIM_EVENT_TX_DONE:
+		next->isTxPending = false;
+		HAL_UART_TxCpltCallback(&next->huart);
+		break;
+	case MODBUS_RTU_SIM_EVENT_IDLE:
+		next->isIdlePending = false;
+		next->rxEventType = HAL_UART_RXEVENT_IDLE;
+		HAL_UARTEx_RxEventCallback(&next->huart, next->dmaPosition);
+		break;
+	default:
+		break;
+	}
+	ModbusRTU_SimScanTimers();
+
+	return (MODBUS_RTU_SIM_EVENT_NONE != event);
+}
+
+/*!
+ * @fn    void modbusRTUSimRun(uint64_t untilNs)
+ * @brief Run every event up to untilNs and leave the clock there.
+ *
+ * @param untilNs Absolute limit of the virtual clock.
+ */
+void modbusRTUSimRun(uint64_t untilNs) {
+	while (true == modbusRTUSimStep(untilNs)) {
+		/* next event */
+	}
+}
+
+/*!
+ * @fn    uint64_t modbusRTUSimNowNs(void)
+ * @brief Virtual time.
+ *
+ * @return nanoseconds since modbusRTUSimReset.
+ */
+uint64_t modbusRTUSimNowNs(void) {
+	return ModbusRTU_SimNow;
+}
+
+/*!
+ * @fn    uint64_t modbusRTUSimCharNs(uint32_t baudRate)
+ * @brief Wire time of one character.
+ *
+ * @param baudRate Baud rate.
+ * @return nanoseconds.
+ */
+uint64_t modbusRTUSimCharNs(uint32_t baudRate) {
+	return (MODBUS_RTU_SIM_CHAR_BITS * 1000000000ull + baudRate - 1) / baudRate;
+}
+
+/*!
+ * @fn    void modbusRTUSimGetBusStats(uint8_t bus, ModbusRTU_SimBusStatsT *stats)
+ * @brief Read the usage of a bus.
+ *
+ * @param bus Bus number.
+ * @param stats Filled with the counters since modbusRTUSimReset.
+ */
+void modbusRTUSimGetBusStats(uint8_t bus, ModbusRTU_SimBusStatsT *stats) {
+	if (bus < MODBUS_RTU_SIM_BUSES) {
+		*stats = ModbusRTU_SimBuses[bus];
+	} else {
+		memset(stats, 0, sizeof(*stats));
+	}
+}
+
+/*!
+ * @fn    void modbusRTUSimCpuStart(ModbusRTU_SimCpuT *cpu)
+ * @brief Start a host CPU time measurement.
+ *
+ * @param cpu Measurement, continued by modbusRTUSimCpuStop.
+ */
+void modbusRTUSimCpuStart(ModbusRTU_SimCpuT *cpu) {
+
+	/* local variable */
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	cpu->ns = (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+#if defined(__x86_64__) || defined(__i386__)
+	cpu->cycles = __builtin_ia32_rdtsc();
+#else
+	cpu->cycles = 0;
+#endif
+	cpu->calls = 0;
+}
+
+/*!
+ * @fn    void modbusRTUSimCpuStop(ModbusRTU_SimCpuT *total, const ModbusRTU_SimCpuT *start)
+ * @brief Add the host CPU time since modbusRTUSimCpuStart to a total.
+ *
+ * @param total Accumulated time, calls is incremented.
+ * @param start Measurement of modbusRTUSimCpuStart.
+ */
+void modbusRTUSimCpuStop(ModbusRTU_SimCpuT *total, const ModbusRTU_SimCpuT *start) {
+
+	/* local variable */
+	ModbusRTU_SimCpuT stop;
+
+	modbusRTUSimCpuStart(&stop);
+	total->ns += stop.ns - start->ns;
+	total->cycles += stop.cycles - start->cycles;
+	total->calls++;
+}
+
+/*! @defgroup HAL functions of the host shim */
+
+uint32_t HAL_GetTick(void) {
+	return (uint32_t) (ModbusRTU_SimNow / 1000000u);
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void) {
+	return MODBUS_RTU_SIM_HCLK_HZ;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
+		GPIO_PinState PinState) {
+	(void) GPIOx;
+	(void) GPIO_Pin;
+	(void) PinState;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+	/* the line settings are read at every character */
+	return (0 != huart->Init.BaudRate) ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+
+	/* characters of a transmit already on the wire still arrive */
+	port->itBuffer = NULL;
+	port->dmaBuffer = NULL;
+	port->isIdlePending = false;
+	port->isTxPending = false;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart,
+		const uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+
+	(void) Timeout;
+
+	/* the CPU is held until the last stop bit (TC) */
+	ModbusRTU_SimWire(port, pData, Size);
+	ModbusRTU_SimSetNow(
+			ModbusRTU_SimNow
+					+ Size * modbusRTUSimCharNs(huart->Init.BaudRate));
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+		const uint8_t *pData, uint16_t Size) {
+
+	/* local variable */
+	HAL_StatusTypeDef result = HAL_OK;
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+
+	if (true == port->isTxPending) {
+		result = HAL_BUSY;
+	} else {
+#if defined(__DCACHE_PRESENT) && (1U == __DCACHE_PRESENT)
+		if ((true == ModbusRTU_SimIsCleanUnaligned)
+				|| ((uintptr_t) pData < ModbusRTU_SimCleanStart)
+				|| ((uintptr_t) pData + Size > ModbusRTU_SimCleanEnd)) {
+			port->stats.cacheViolations++; /* the DMA would send stale memory */
+		}
+		ModbusRTU_SimCleanStart = 0;
+		ModbusRTU_SimCleanEnd = 0;
+		ModbusRTU_SimIsCleanUnaligned = false;
+#endif
+		ModbusRTU_SimWire(port, pData, Size);
+		port->isTxPending = true;
+		port->txDoneNs = ModbusRTU_SimNow
+				+ Size * modbusRTUSimCharNs(huart->Init.BaudRate);
+	}
+
+	return result;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart,
+		uint8_t *pData, uint16_t Size) {
+
+	/* local variable */
+	HAL_StatusTypeDef result = HAL_OK;
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+
+	if ((NULL != port->itBuffer) || (NULL != port->dmaBuffer)) {
+		result = HAL_BUSY;
+	} else {
+		port->itBuffer = pData;
+		port->itSize = Size;
+		port->itCount = 0;
+	}
+
+	return result;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart,
+		uint8_t *pData, uint16_t Size) {
+
+	/* local variable */
+	HAL_StatusTypeDef result = HAL_OK;
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+
+	if ((NULL != port->itBuffer) || (NULL != port->dmaBuffer)) {
+		result = HAL_BUSY;
+	} else {
+		/* circular mode: HT at Size / 2, TC at Size, IDLE after a pause */
+		port->dmaBuffer = pData;
+		port->dmaSize = Size;
+		port->dmaPosition = 0;
+		port->isIdlePending = false;
+	}
+
+	return result;
+}
+
+uint32_t HAL_UARTEx_GetRxEventType(UART_HandleTypeDef *huart) {
+	return ((ModbusRTU_SimPortT*) huart)->rxEventType;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+
+	/* like the HAL, the DMA reception is aborted too */
+	port->itBuffer = NULL;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_MultiProcessor_EnterMuteMode(UART_HandleTypeDef *huart) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+
+	/* idle line wake-up, the reception armed stays armed */
+	port->isMuted = true;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+
+	port->dmaBuffer = NULL;
+	port->isIdlePending = false;
+	port->isTxPending = false;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+	htim->Instance->DIER |= TIM_IT_UPDATE;
+	htim->Instance->CR1 |= TIM_CR1_CEN;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim) {
+	htim->Instance->DIER &= ~TIM_IT_UPDATE;
+	htim->Instance->CR1 &= ~TIM_CR1_CEN;
+	return HAL_OK;
+}
+
+/*! @defgroup application side: HAL callbacks forwarded to the attached instance */
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+	ModbusRTU_SimCpuT start;
+
+	if (NULL != port->modbus) {
+		modbusRTUSimCpuStart(&start);
+		modbusRTURxCpltCallback(port->modbus);
+		modbusRTUSimCpuStop(&port->cpu, &start);
+	}
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+	ModbusRTU_SimCpuT start;
+
+	if (NULL != port->modbus) {
+		modbusRTUSimCpuStart(&start);
+		modbusRTUTxCpltCallback(port->modbus);
+		modbusRTUSimCpuStop(&port->cpu, &start);
+	}
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+	ModbusRTU_SimCpuT start;
+
+	if (NULL != port->modbus) {
+		modbusRTUSimCpuStart(&start);
+		modbusRTURxEventCallback(port->modbus, Size);
+		modbusRTUSimCpuStop(&port->cpu, &start);
+	}
+#if defined(__DCACHE_PRESENT) && (1U == __DCACHE_PRESENT)
+	/* every byte up to the event was read, its line must have been dropped */
+	for (uint8_t i = 0; i < MODBUS_RTU_SIM_CACHE_LINES; i++) {
+		if (true == port->dmaStale[i]) {
+			port->stats.cacheViolations++;
+			port->dmaStale[i] = false;
+		}
+	}
+#endif
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = (ModbusRTU_SimPortT*) huart;
+	ModbusRTU_SimCpuT start;
+
+	if (NULL != port->modbus) {
+		modbusRTUSimCpuStart(&start);
+		modbusRTUErrorCallback(port->modbus);
+		modbusRTUSimCpuStop(&port->cpu, &start);
+	}
+}
+
+#if defined(__DCACHE_PRESENT) && (1U == __DCACHE_PRESENT)
+void SCB_CleanDCache_by_Addr(volatile void *addr, int32_t dsize) {
+	ModbusRTU_SimCleanStart = (uintptr_t) addr;
+	ModbusRTU_SimCleanEnd = (uintptr_t) addr + (uintptr_t) dsize;
+	ModbusRTU_SimIsCleanUnaligned = (0 != (ModbusRTU_SimCleanStart
+			% MODBUS_RTU_SIM_CACHE_LINE))
+			|| (0 != ((uint32_t) dsize % MODBUS_RTU_SIM_CACHE_LINE));
+}
+
+void SCB_InvalidateDCache_by_Addr(volatile void *addr, int32_t dsize) {
+
+	/* local variable */
+	uintptr_t start = (uintptr_t) addr, end = start + (uintptr_t) dsize;
+	uintptr_t buffer = 0;
+	ModbusRTU_SimPortT *port = NULL;
+
+	for (uint8_t i = 0; i < ModbusRTU_SimPortCount; i++) {
+		port = ModbusRTU_SimPorts[i];
+		buffer = (uintptr_t) port->dmaBuffer;
+		if ((NULL != port->dmaBuffer) && (start >= buffer)
+				&& (end <= buffer + port->dmaSize)) {
+			if ((0 != (start % MODBUS_RTU_SIM_CACHE_LINE))
+					|| (0 != (end % MODBUS_RTU_SIM_CACHE_LINE))) {
+				/* would drop bytes of the neighbours */
+				port->stats.cacheViolations++;
+			}
+			for (uintptr_t line = (start - buffer) / MODBUS_RTU_SIM_CACHE_LINE;
+					(line * MODBUS_RTU_SIM_CACHE_LINE < end - buffer)
+							&& (line < MODBUS_RTU_SIM_CACHE_LINES); line++) {
+				port->dmaStale[line] = false;
+			}
+		}
+	}
+}
+#endif
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *port = ModbusRTU_SimPortOfTimer(htim);
+	ModbusRTU_SimCpuT start;
+
+	if ((NULL != port) && (NULL != port->modbus)) {
+		modbusRTUSimCpuStart(&start);
+		modbusRTUTimerCallback(port->modbus);
+		modbusRTUSimCpuStop(&port->cpu, &start);
+	}
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_SimSetNow(uint64_t nowNs)
+ * @brief Move the virtual clock, the DWT counter follows at the core clock.
+ *
+ * @param nowNs New time.
+ */
+static void ModbusRTU_SimSetNow(uint64_t nowNs) {
+	ModbusRTU_SimNow = nowNs;
+	modbusRTUHalDwt.CYCCNT = (uint32_t) ((nowNs
+			* (MODBUS_RTU_SIM_HCLK_HZ / 1000000u)) / 1000u);
+}
+
+/*!
+ * @fn    static void ModbusRTU_SimScanTimers(void)
+ * @brief Restart the count of timers whose update was generated (EGR) by software.
+ */
+static void ModbusRTU_SimScanTimers(void) {
+
+	/* local variable */
+	TIM_TypeDef *timer = NULL;
+
+	for (uint8_t i = 0; i < ModbusRTU_SimPortCount; i++) {
+		timer = ModbusRTU_SimPorts[i]->htim.Instance;
+		if (0 != (timer->EGR & TIM_EGR_UG)) {
+			timer->EGR = 0;
+			timer->CNT = 0;
+			ModbusRTU_SimPorts[i]->timerStartNs = ModbusRTU_SimNow;
+		}
+	}
+}
+
+/*!
+ * @fn    static uint64_t ModbusRTU_SimTimerExpiry(const ModbusRTU_SimPortT *port)
+ * @brief Time of the next update event of a port timer.
+ *
+ * @param port The port.
+ * @return absolute nanoseconds, MODBUS_RTU_SIM_NEVER when the timer is stopped.
+ */
+static uint64_t ModbusRTU_SimTimerExpiry(const ModbusRTU_SimPortT *port) {
+
+	/* local variable */
+	uint64_t result = MODBUS_RTU_SIM_NEVER;
+	const TIM_TypeDef *timer = port->htim.Instance;
+
+	if (0 != (timer->CR1 & TIM_CR1_CEN)) {
+		result = port->timerStartNs
+				+ ((uint64_t) timer->ARR + 1) * 1000000000ull
+						/ MODBUS_RTU_TIMER_TICK_HZ;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_SimPush(ModbusRTU_SimPortT *port, uint64_t atNs, uint8_t data, const UART_InitTypeDef *line)
+ * @brief Queue a character that completes at a port at atNs.
+ *
+ * @param port Receiving port.
+ * @param atNs End of the stop bit.
+ * @param data The character.
+ * @param line Line settings of the sender.
+ */
+static void ModbusRTU_SimPush(ModbusRTU_SimPortT *port, uint64_t atNs,
+		uint8_t data, const UART_InitTypeDef *line) {
+
+	/* local variable */
+	uint16_t next = MODBUS_RTU_SIM_FIFO_NEXT(port->fifoHead);
+
+	if (next == port->fifoTail) {
+		port->stats.rxDropped++; /* more in flight than the model holds */
+	} else {
+		port->fifo[port->fifoHead] = data;
+		port->fifoNs[port->fifoHead] = atNs;
+		port->fifoBaud[port->fifoHead] = line->BaudRate;
+		port->fifoNinth[port->fifoHead] = (UART_PARITY_NONE == line->Parity)
+				|| (true == ModbusRTU_SimParityBit(data, line->Parity));
+		port->fifoHead = next;
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_SimWire(ModbusRTU_SimPortT *port, const uint8_t *data, uint16_t length)
+ * @brief Send characters from a port to every other port on its bus, from now on.
+ *
+ * @param port Sending port.
+ * @param data Characters.
+ * @param length Number of characters.
+ */
+static void ModbusRTU_SimWire(ModbusRTU_SimPortT *port, const uint8_t *data,
+		uint16_t length) {
+
+	/* local variable */
+	uint64_t charNs = modbusRTUSimCharNs(port->huart.Init.BaudRate);
+	uint64_t endNs = ModbusRTU_SimNow + length * charNs;
+	uint64_t *busyUntil = &ModbusRTU_SimBusyUntilNs[port->bus];
+	ModbusRTU_SimBusStatsT *bus = &ModbusRTU_SimBuses[port->bus];
+	ModbusRTU_SimPortT *peer = NULL;
+
+	port->stats.txFrames++;
+	port->stats.txBytes += length;
+
+	/* busy time counts overlapping transmissions once */
+	if (ModbusRTU_SimNow < *busyUntil) {
+		bus->collisions++;
+		bus->busyNs += (endNs > *busyUntil) ? (endNs - *busyUntil) : 0;
+	} else {
+		bus->busyNs += endNs - ModbusRTU_SimNow;
+	}
+	if (endNs > *busyUntil) {
+		*busyUntil = endNs;
+	}
+
+	for (uint8_t i = 0; i < ModbusRTU_SimPortCount; i++) {
+		peer = ModbusRTU_SimPorts[i];
+		if ((peer != port) && (peer->bus == port->bus)) {
+			for (uint16_t j = 0; j < length; j++) {
+				ModbusRTU_SimPush(peer, ModbusRTU_SimNow + (j + 1) * charNs,
+						data[j], &port->huart.Init);
+			}
+		}
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_SimDeliver(ModbusRTU_SimPortT *port)
+ * @brief Store the oldest character in flight with the armed reception.
+ *
+ * @param port Receiving port.
+ */
+static void ModbusRTU_SimDeliver(ModbusRTU_SimPortT *port) {
+
+	/* local variable */
+	uint8_t data = port->fifo[port->fifoTail];
+	bool isError = ModbusRTU_SimSample(port, port->fifoTail, &data);
+	uint64_t charNs = modbusRTUSimCharNs(port->huart.Init.BaudRate);
+
+	/* an idle character before the start bit of this one wakes a mute receiver */
+	if ((true == port->isMuted)
+			&& (ModbusRTU_SimNow - port->lastRxNs >= 2 * charNs)) {
+		port->isMuted = false;
+	}
+	port->fifoTail = MODBUS_RTU_SIM_FIFO_NEXT(port->fifoTail);
+	port->lastRxNs = ModbusRTU_SimNow;
+	port->stats.lineErrors +=
+			((true == isError) && (false == port->isMuted)) ? 1 : 0;
+
+	if (true == port->isMuted) {
+		/* no RXNE, no error flags: the CPU is not disturbed */
+		port->stats.rxMuted++;
+	} else if (NULL != port->dmaBuffer) {
+		port->stats.rxBytes++;
+		port->isIdlePending = true;
+#if defined(__DCACHE_PRESENT) && (1U == __DCACHE_PRESENT)
+		if (port->dmaPosition / MODBUS_RTU_SIM_CACHE_LINE < MODBUS_RTU_SIM_CACHE_LINES) {
+			port->dmaStale[port->dmaPosition / MODBUS_RTU_SIM_CACHE_LINE] = true;
+		}
+#endif
+		port->dmaBuffer[port->dmaPosition++] = data;
+		if (port->dmaPosition == port->dmaSize / 2) {
+			port->rxEventType = HAL_UART_RXEVENT_HT;
+			HAL_UARTEx_RxEventCallback(&port->huart, port->dmaPosition);
+		} else if (port->dmaPosition == port->dmaSize) {
+			port->rxEventType = HAL_UART_RXEVENT_TC;
+			port->dmaPosition = 0;
+			HAL_UARTEx_RxEventCallback(&port->huart, port->dmaSize);
+		}
+		if ((true == isError) && (NULL != port->dmaBuffer)) {
+			/* like the HAL, an error stops a DMA reception */
+			port->dmaBuffer = NULL;
+			port->isIdlePending = false;
+			HAL_UART_ErrorCallback(&port->huart);
+		}
+	} else if (NULL != port->itBuffer) {
+		port->stats.rxBytes++;
+		port->itBuffer[port->itCount++] = data;
+		if (port->itCount == port->itSize) {
+			port->itBuffer = NULL;
+			HAL_UART_RxCpltCallback(&port->huart);
+		}
+		if (true == isError) {
+			/* interrupt mode goes on, the error is reported after the byte */
+			HAL_UART_ErrorCallback(&port->huart);
+		}
+	} else {
+		port->stats.rxDropped++;
+	}
+}
+
+/*!
+ * @fn    static bool ModbusRTU_SimSample(const ModbusRTU_SimPortT *port, uint16_t index, uint8_t *data)
+ * @brief Sample a character in flight with the line settings of the receiver.
+ *
+ * @param port Receiving port.
+ * @param index FIFO entry of the character.
+ * @param data The character as sent, replaced by what the receiver reads.
+ * @return true on a parity or framing error.
+ */
+static bool ModbusRTU_SimSample(const ModbusRTU_SimPortT *port,
+		uint16_t index, uint8_t *data) {
+
+	/* local variable */
+	bool result = false;
+	uint32_t sent = port->fifoBaud[index];
+	uint32_t baudRate = port->huart.Init.BaudRate;
+	uint32_t diff = (sent > baudRate) ? (sent - baudRate) : (baudRate - sent);
+
+	if (diff * 50u > baudRate) {
+		/* more than 2 % off: the bits are sampled at the wrong places */
+		*data = (uint8_t) ((*data * 0x1Du) ^ (sent / baudRate) ^ 0x5Bu);
+		result = true;
+	} else if (UART_PARITY_NONE == port->huart.Init.Parity) {
+		/* the bit after the data is taken as the stop bit */
+		result = (false == port->fifoNinth[index]);
+	} else {
+		/* the stop bit after the parity bit is always there */
+		result = (port->fifoNinth[index]
+				!= ModbusRTU_SimParityBit(*data, port->huart.Init.Parity));
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static bool ModbusRTU_SimParityBit(uint8_t data, uint32_t parity)
+ * @brief Parity bit of a character.
+ *
+ * @param data The character.
+ * @param parity UART_PARITY_EVEN or UART_PARITY_ODD.
+ * @return the bit sent after the data.
+ */
+static bool ModbusRTU_SimParityBit(uint8_t data, uint32_t parity) {
+
+	/* local variable */
+	bool result = (0 != (__builtin_popcount(data) & 1));
+
+	return (UART_PARITY_ODD == parity) ? !result : result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_SimTimerUpdate(ModbusRTU_SimPortT *port)
+ * @brief Update event of a port timer.
+ *
+ * @param port Port of the timer.
+ */
+static void ModbusRTU_SimTimerUpdate(ModbusRTU_SimPortT *port) {
+
+	/* local variable */
+	TIM_TypeDef *timer = port->htim.Instance;
+
+	timer->SR |= TIM_FLAG_UPDATE;
+	if (0 != (timer->CR1 & TIM_CR1_OPM)) {
+		timer->CR1 &= ~TIM_CR1_CEN;
+	} else {
+		port->timerStartNs = ModbusRTU_SimNow;
+	}
+	if (0 != (timer->DIER & TIM_IT_UPDATE)) {
+		HAL_TIM_PeriodElapsedCallback(&port->htim);
+	}
+}
+
+/*!
+ * @fn    static ModbusRTU_SimPortT* ModbusRTU_SimPortOfTimer(TIM_HandleTypeDef *htim)
+ * @brief Find the port a timer handle belongs to.
+ *
+ * @param htim Timer handle.
+ * @return the port, NULL for a foreign handle.
+ */
+static ModbusRTU_SimPortT* ModbusRTU_SimPortOfTimer(TIM_HandleTypeDef *htim) {
+
+	/* local variable */
+	ModbusRTU_SimPortT *result = NULL;
+
+	for (uint8_t i = 0; (NULL == result) && (i < ModbusRTU_SimPortCount); i++) {
+		if (&ModbusRTU_SimPorts[i]->htim == htim) {
+			result = ModbusRTU_SimPorts[i];
+		}
+	}
+
+	return result;
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
@@ -0,0 +1,263 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUSim.h
+ * @author         : keyhanSalehi
+ * @brief          : header of modBus RTU host simulator.
+ ******************************************************************************
+ *
+ * This file provides a discrete event model of the MCU side the library
+ * runs on: UARTs (interrupt and circular DMA with IDLE line reception,
+ * blocking and DMA transmit), the one shot timers and the DWT counter,
+ * all driven by a virtual nanosecond clock. Ports joined to the same bus
+ * see each other's characters like on an RS485 line, 11 bits per
+ * character at the baud rate of the sending port. A port on other line
+ * settings samples them like a UART would: garbage with a framing error
+ * at another baud rate, a parity or framing error where the bit after
+ * the data does not fit its parity.
+ *
+ * The simulator also plays the application: it forwards the HAL callbacks
+ * of a port to the attached ModbusRTU_HandleT and measures the host CPU
+ * time the library spends in them.
+ *
+ * Built with __DCACHE_PRESENT=1 it models the Cortex-M7 D-cache of the DMA
+ * buffers: a transmit DMA must read lines cleaned just before, and every
+ * line the receive DMA wrote must be invalidated by the time the library
+ * returns from the RX event. Misses count as cacheViolations.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MODBUS_RTU_SIM_H
+#define MODBUS_RTU_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "stm32f1xx_hal.h"
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Ports the simulator can hold */
+#ifndef MODBUS_RTU_SIM_PORTS
+#define MODBUS_RTU_SIM_PORTS 16
+#endif
+/*! @def Buses the ports can join */
+#ifndef MODBUS_RTU_SIM_BUSES
+#define MODBUS_RTU_SIM_BUSES 4
+#endif
+/*! @def Characters in flight towards one port, power of two */
+#define MODBUS_RTU_SIM_RX_FIFO 1024
+/*! @def Bits of one RTU character: start, 8 data, parity or 2nd stop, stop */
+#define MODBUS_RTU_SIM_CHAR_BITS 11u
+/*! @def Core clock of the simulated MCU, the DWT counter runs at it */
+#define MODBUS_RTU_SIM_HCLK_HZ 72000000u
+/*! @defgroup D-cache model: line size and lines of a receive DMA buffer */
+#define MODBUS_RTU_SIM_CACHE_LINE 32u
+#define MODBUS_RTU_SIM_CACHE_LINES 64
+
+/* Typedefs ------------------------------------------------------------------*/
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @struct  _modbusSimCpu
+ * @brief host CPU time spent in library code.
+ */
+typedef struct _modbusSimCpu{
+	uint64_t ns; /*! monotonic host nanoseconds */
+	uint64_t cycles; /*! host cycle counter, 0 where the CPU has none */
+	uint32_t calls; /*! measured calls */
+} ModbusRTU_SimCpuT;
+
+/*!
+ * @typedef @struct  _modbusSimPortStats
+ * @brief traffic of one port.
+ */
+typedef struct _modbusSimPortStats{
+	uint32_t txFrames; /*! transmit calls */
+	uint64_t txBytes; /*! characters sent */
+	uint64_t rxBytes; /*! characters stored by a reception */
+	uint64_t rxDropped; /*! characters that found no reception armed */
+	uint64_t rxMuted; /*! characters ignored in mute mode */
+	uint32_t lineErrors; /*! characters sampled with a parity or framing error */
+	uint32_t cacheViolations; /*! D-cache model: DMA on uncleaned lines, stale lines read, unaligned maintenance */
+} ModbusRTU_SimPortStatsT;
+
+/*!
+ * @typedef @struct  _modbusSimBusStats
+ * @brief usage of one bus.
+ */
+typedef struct _modbusSimBusStats{
+	uint64_t busyNs; /*! time with at least one character on the wire */
+	uint32_t collisions; /*! transmissions started while the bus was busy */
+} ModbusRTU_SimBusStatsT;
+
+/*!
+ * @typedef @struct  _modbusSimPort
+ * @brief one simulated UART and timer pair, pass huart/htim to modbusRTUInit.
+ */
+typedef struct _modbusSimPort{
+	UART_HandleTypeDef huart; /*! first member, the UART callbacks find the port by it */
+	TIM_HandleTypeDef htim;
+	USART_TypeDef uartRegisters;
+	TIM_TypeDef timRegisters;
+	ModbusRTU_HandleT *modbus; /*! attached instance, NULL = callbacks are dropped */
+	uint8_t bus; /*! bus the port is wired to */
+#ifdef MODBUS_RTU_USE_POOL
+	uint8_t rxDmaBuffer[MODBUS_RTU_RX_DMA_BUFFER_SIZE] MODBUS_RTU_DMA_ALIGNED; /*! DMA ring the board gives the attached instance */
+#endif
+
+	/* reception */
+	uint8_t *itBuffer; /*! HAL_UART_Receive_IT target, NULL = not armed */
+	uint16_t itSize;
+	uint16_t itCount;
+	uint8_t *dmaBuffer; /*! HAL_UARTEx_ReceiveToIdle_DMA target, NULL = stopped */
+	uint16_t dmaSize;
+	uint16_t dmaPosition;
+	uint32_t rxEventType; /*! HAL_UARTEx_GetRxEventType */
+	bool isIdlePending; /*! a character arrived since the last IDLE event */
+	bool isMuted; /*! mute mode, the next idle line wakes the receiver */
+	uint64_t lastRxNs; /*! end of the last character */
+	uint64_t fifoNs[MODBUS_RTU_SIM_RX_FIFO]; /*! arrival time of the characters in flight */
+	uint32_t fifoBaud[MODBUS_RTU_SIM_RX_FIFO]; /*! baud rate they were sent at */
+	bool fifoNinth[MODBUS_RTU_SIM_RX_FIFO]; /*! bit after the data: parity, else the 2nd stop bit */
+	uint8_t fifo[MODBUS_RTU_SIM_RX_FIFO];
+	uint16_t fifoHead;
+	uint16_t fifoTail;
+	bool dmaStale[MODBUS_RTU_SIM_CACHE_LINES]; /*! D-cache model: written by the DMA, not invalidated yet */
+
+	/* transmission and timer */
+	bool isTxPending; /*! HAL_UART_Transmit_DMA on the wire */
+	uint64_t txDoneNs;
+	uint64_t timerStartNs; /*! last update event (EGR) */
+
+	ModbusRTU_SimPortStatsT stats;
+	ModbusRTU_SimCpuT cpu; /*! library time in the callbacks of this port */
+} ModbusRTU_SimPortT;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/* 1. Global Function Declarations */
+
+/*!
+ * @fn    void modbusRTUSimReset(void)
+ * @brief Forget every port and bus and restart the clock at 0.
+ */
+void modbusRTUSimReset(void);
+
+/*!
+ * @fn    bool modbusRTUSimPortInit(ModbusRTU_SimPortT *port, uint8_t bus, uint32_t baudRate)
+ * @brief Wire a port to a bus.
+ *
+ * @param port Port storage, lives as long as the simulation.
+ * @param bus Bus number, below MODBUS_RTU_SIM_BUSES.
+ * @param baudRate Baud rate of huart.Init.
+ * @return true when the port was added.
+ */
+bool modbusRTUSimPortInit(ModbusRTU_SimPortT *port, uint8_t bus,
+		uint32_t baudRate);
+
+/*!
+ * @fn    void modbusRTUSimPortAttach(ModbusRTU_SimPortT *port, ModbusRTU_HandleT *modbus)
+ * @brief Forward the HAL callbacks of the port to an instance.
+ *
+ * @param port Port of modbusRTUSimPortInit.
+ * @param modbus Instance initialized on &port->huart and &port->htim.
+ *
+ * @note : with MODBUS_RTU_USE_POOL it also gives the instance the DMA ring
+ *         of the port.
+ */
+void modbusRTUSimPortAttach(ModbusRTU_SimPortT *port, ModbusRTU_HandleT *modbus);
+
+/*!
+ * @fn    void modbusRTUSimInject(ModbusRTU_SimPortT *port, const uint8_t *data, size_t length, uint32_t gapNs)
+ * @brief Put characters on the wire towards one port, as if another device sent them.
+ *
+ * @param port Receiving port.
+ * @param data Characters.
+ * @param length Number of characters.
+ * @param gapNs Extra silence between two characters.
+ */
+void modbusRTUSimInject(ModbusRTU_SimPortT *port, const uint8_t *data,
+		size_t length, uint32_t gapNs);
+
+/*!
+ * @fn    bool modbusRTUSimStep(uint64_t untilNs)
+ * @brief Run the next event if it is due at untilNs or before.
+ *
+ * @param untilNs Absolute limit of the virtual clock.
+ * @return true when an event ran, false when the clock was moved to untilNs.
+ */
+bool modbusRTUSimStep(uint64_t untilNs);
+
+/*!
+ * @fn    void modbusRTUSimRun(uint64_t untilNs)
+ * @brief Run every event up to untilNs and leave the clock there.
+ *
+ * @param untilNs Absolute limit of the virtual clock.
+ */
+void modbusRTUSimRun(uint64_t untilNs);
+
+/*!
+ * @fn    uint64_t modbusRTUSimNowNs(void)
+ * @brief Virtual time.
+ *
+ * @return nanoseconds since modbusRTUSimReset.
+ */
+uint64_t modbusRTUSimNowNs(void);
+
+/*!
+ * @fn    uint64_t modbusRTUSimCharNs(uint32_t baudRate)
+ * @brief Wire time of one character.
+ *
+ * @param baudRate Baud rate.
+ * @return nanoseconds.
+ */
+uint64_t modbusRTUSimCharNs(uint32_t baudRate);
+
+/*!
+ * @fn    void modbusRTUSimGetBusStats(uint8_t bus, ModbusRTU_SimBusStatsT *stats)
+ * @brief Read the usage of a bus.
+ *
+ * @param bus Bus number.
+ * @param stats Filled with the counters since modbusRTUSimReset.
+ */
+void modbusRTUSimGetBusStats(uint8_t bus, ModbusRTU_SimBusStatsT *stats);
+
+/*!
+ * @fn    void modbusRTUSimCpuStart(ModbusRTU_SimCpuT *cpu)
+ * @brief Start a host CPU time measurement.
+ *
+ * @param cpu Measurement, continued by modbusRTUSimCpuStop.
+ */
+void modbusRTUSimCpuStart(ModbusRTU_SimCpuT *cpu);
+
+/*!
+ * @fn    void modbusRTUSimCpuStop(ModbusRTU_SimCpuT *total, const ModbusRTU_SimCpuT *start)
+ * @brief Add the host CPU time since modbusRTUSimCpuStart to a total.
+ *
+ * @param total Accumulated time, calls is incremented.
+ * @param start Measurement of modbusRTUSimCpuStart.
+ */
+void modbusRTUSimCpuStop(ModbusRTU_SimCpuT *total, const ModbusRTU_SimCpuT *start);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_RTU_SIM_H
@@ -0,0 +1,2537 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUTestLoopback.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU master/slave loopback regression test.
+ ******************************************************************************
+ *
+ * The coil bit helpers are checked against a bit at a time reference
+ * first. A scheduler master and a slave engine share one simulated bus for one
+ * second of virtual time. Every request has a fixed expected outcome
+ * (answers, exceptions or timeouts), the register image is checked at
+ * the end. A gateway scenario then runs modBus TCP and RTU over TCP
+ * clients against two such buses, a fan-out scenario writes to several
+ * slaves and a broadcast, an autobaud scenario finds the line of a bus
+ * and steps it up, a sniffer scenario captures and decodes a polled bus,
+ * a file scenario streams a blob through the file records of a slave,
+ * a FIFO scenario drains the sample queue of a slave with FC 0x18,
+ * a low power scenario lets a slave sleep through the frames of another,
+ * a priority scenario sends urgent writes through a saturated poll list,
+ * a coalescing scenario merges neighbouring reads and splits the answer,
+ * a read limit scenario asks the slave for more than a handle receives,
+ * an oversize scenario drops a frame longer than the RX buffer,
+ * and with MODBUS_RTU_USE_CACHE a cache scenario counts
+ * the transactions a response cache saves. The exit code is the number
+ * of failed checks.
+ *
+ * usage: modBusRTUTestLoopback [it|dma] [ring] [baudRate]
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUMaster.h"
+#include "modBusRTUSlave.h"
+#include "modBusRTUFrame.h"
+#include "modBusRTUCrc.h"
+#include "modBusRTUData.h"
+#include "modBusRTUGateway.h"
+#include "modBusRTUAutobaud.h"
+#include "modBusRTUSniffer.h"
+#include "modBusRTUFile.h"
+#ifdef MODBUS_RTU_USE_POOL
+#include "modBusRTUPool.h"
+#endif
+#include "modBusRTUSim.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Virtual run time of the scenario at MODBUS_RTU_TEST_BAUD_RATE */
+#define MODBUS_RTU_TEST_RUN_MS 1000
+/*! @def Baud rate the poll periods are made for, slower buses stretch them */
+#define MODBUS_RTU_TEST_BAUD_RATE 115200
+/*! @def Slave address of the slave engine */
+#define MODBUS_RTU_TEST_SLAVE_ID 1
+/*! @def Address nobody answers */
+#define MODBUS_RTU_TEST_ABSENT_ID 7
+/*! @def Slave address of the slave engine on the second gateway bus */
+#define MODBUS_RTU_TEST_SECOND_ID 2
+/*! @def Holding register the slaves of the autobaud scenario take as line command */
+#define MODBUS_RTU_TEST_LINE_REGISTER 130
+/*! @def Line the autobaud scenario steps its bus up to */
+#define MODBUS_RTU_TEST_FAST_BAUD_RATE 115200
+/*! @defgroup Blob of the file scenario: bytes, file and record it starts at (crosses into file 2) */
+#define MODBUS_RTU_TEST_FILE_SIZE 3001
+#define MODBUS_RTU_TEST_FILE_NUMBER 1
+#define MODBUS_RTU_TEST_FILE_RECORD 9000
+/*! @def Files the slave of the file scenario serves, 1.. */
+#define MODBUS_RTU_TEST_FILES 2
+/*! @def Byte of the blob of the file scenario at an offset */
+#define MODBUS_RTU_TEST_FILE_BYTE(offset) ((uint8_t) ((offset) * 7u + 3u))
+/*! @def FIFO pointer address of the FIFO scenario slave */
+#define MODBUS_RTU_TEST_FIFO_ADDRESS 0x0400
+/*! @def Holding registers of the slave, one more than the longest read of a handle */
+#define MODBUS_RTU_TEST_WIDE_ADDRESS 0x1000
+/*! @def Replies a gateway scenario keeps */
+#define MODBUS_RTU_TEST_MAX_REPLIES 16
+
+/*! @def Record a failed check with its line */
+#define MODBUS_RTU_TEST_CHECK(condition) \
+	ModbusRTU_TestCheck((condition), #condition, __LINE__)
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/*!
+ * @typedef
+ * @brief Typedefs for global use.
+ */
+
+/*!
+ * @typedef @enum  _modbusTestExpect
+ * @brief outcome a request must have.
+ */
+typedef enum _modbusTestExpect{
+	MODBUS_RTU_TEST_ANSWER, /*!< only successful answers */
+	MODBUS_RTU_TEST_EXCEPTION, /*!< only exception answers */
+	MODBUS_RTU_TEST_TIMEOUT /*!< only response timeouts, then offline skips */
+} ModbusRTU_TestExpectT;
+
+/*!
+ * @typedef @struct  _modbusTestTally
+ * @brief results seen by one request.
+ */
+typedef struct _modbusTestTally{
+	ModbusRTU_TestExpectT expect;
+	uint32_t answers;
+	uint32_t exceptions;
+	uint32_t timeouts;
+	uint32_t offline; /*! skipped without the bus */
+	uint32_t late; /*! deadline missed, not sent */
+	uint32_t others; /*! any other error */
+} ModbusRTU_TestTallyT;
+
+/*!
+ * @typedef @struct  _modbusTestReply
+ * @brief one answer of the gateway.
+ */
+typedef struct _modbusTestReply{
+	void *connection;
+	uint8_t adu[MODBUS_RTU_GATEWAY_MAX_ADU_SIZE];
+	size_t size;
+	uint64_t atNs; /*! virtual time of the reply */
+} ModbusRTU_TestReplyT;
+
+/*!
+ * @typedef @struct  _modbusTestSlice
+ * @brief what one member of a coalesced read was given.
+ */
+typedef struct _modbusTestSlice{
+	uint32_t calls;
+	ModbusRTU_ErrorT result;
+	uint8_t data[2 * 16]; /*! start of the values, the exception code */
+	size_t dataSize;
+} ModbusRTU_TestSliceT;
+
+/* Variables -----------------------------------------------------------------*/
+
+/* 2. Static Variables */
+
+static uint32_t ModbusRTU_TestFailures;
+static uint32_t ModbusRTU_TestWrites;
+
+static uint16_t ModbusRTU_TestHolding[32];
+static uint16_t ModbusRTU_TestHoldingB[16];
+static uint16_t ModbusRTU_TestWide[MODBUS_RTU_HANDLE_MAX_READ_REGISTERS + 1];
+static uint16_t ModbusRTU_TestIdentity[4] = { 0xAAAA, 0xBBBB, 0xCCCC, 0xDDDD };
+static uint16_t ModbusRTU_TestInput[8] = { 10, 11, 12, 13, 14, 15, 16, 17 };
+static uint8_t ModbusRTU_TestCoils[4] = { 0xA5, 0x3C, 0xFF, 0x01 };
+static uint8_t ModbusRTU_TestCoilsB[3] = { 0xFF, 0xFF, 0xFF };
+static uint8_t ModbusRTU_TestInputs[2] = { 0x0F, 0xF0 };
+static ModbusRTU_TestReplyT ModbusRTU_TestReplies[MODBUS_RTU_TEST_MAX_REPLIES];
+static uint8_t ModbusRTU_TestReplyCount;
+static uint8_t ModbusRTU_TestLastData[16]; /*! start of the last successful response */
+static uint8_t ModbusRTU_TestFanOutIds[8]; /*! fan-out: slave of every result, in order */
+static ModbusRTU_ErrorT ModbusRTU_TestFanOutResults[8]; /*! fan-out: every result */
+static uint64_t ModbusRTU_TestFanOutNs[8]; /*! fan-out: virtual time of every result */
+static uint8_t ModbusRTU_TestFanOutCount;
+static ModbusRTU_SchedulerT *ModbusRTU_TestStepUpScheduler; /*! autobaud: steps up once every slave acknowledged */
+static uint8_t ModbusRTU_TestStepUpAcks;
+static uint8_t ModbusRTU_TestFileImage[MODBUS_RTU_TEST_FILES * MODBUS_RTU_FILE_RECORDS * 2]; /*! file records of the file scenario slave */
+static uint32_t ModbusRTU_TestFileMismatches; /*! store callback: bytes not of the blob */
+static uint32_t ModbusRTU_TestFileDone; /*! transfers ended */
+static uint16_t ModbusRTU_TestFifoPushed; /*! FIFO: samples queued by the producer */
+static uint16_t ModbusRTU_TestFifoNext; /*! FIFO: next sample the master expects */
+static uint32_t ModbusRTU_TestFifoGaps; /*! FIFO: samples out of sequence */
+static uint64_t ModbusRTU_TestUrgentNs; /*! priority: virtual time the urgent write was queued */
+static uint64_t ModbusRTU_TestUrgentMaxNs; /*! priority: longest urgent write latency */
+static bool ModbusRTU_TestIsUrgentQueued; /*! priority: the urgent write waits for its result */
+
+static const ModbusRTU_SlaveSegmentT ModbusRTU_TestHoldingMap[] = {
+		{ 100, 16, ModbusRTU_TestHolding, MODBUS_RTU_SEGMENT_RW },
+		{ 116, 16, ModbusRTU_TestHoldingB, MODBUS_RTU_SEGMENT_RW },
+		{ MODBUS_RTU_TEST_WIDE_ADDRESS, MODBUS_RTU_HANDLE_MAX_READ_REGISTERS + 1,
+				ModbusRTU_TestWide, MODBUS_RTU_SEGMENT_READ },
+		{ 0x9C40, 4, ModbusRTU_TestIdentity, MODBUS_RTU_SEGMENT_READ } };
+static const ModbusRTU_SlaveSegmentT ModbusRTU_TestInputMap[] = {
+		{ 0, 8, ModbusRTU_TestInput, MODBUS_RTU_SEGMENT_READ } };
+static const ModbusRTU_SlaveSegmentT ModbusRTU_TestCoilMap[] = {
+		{ 0, 12, ModbusRTU_TestCoils, MODBUS_RTU_SEGMENT_RW },
+		{ 12, 20, ModbusRTU_TestCoilsB, MODBUS_RTU_SEGMENT_RW } };
+static const ModbusRTU_SlaveSegmentT ModbusRTU_TestInputBitMap[] = {
+		{ 8, 16, ModbusRTU_TestInputs, MODBUS_RTU_SEGMENT_READ } };
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_TestCheck(bool condition, const char *text, int line);
+static void ModbusRTU_TestOnResult(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+static void ModbusRTU_TestOnWrite(ModbusRTU_SlaveT *slave,
+		uint8_t functionCode, uint16_t address, uint16_t quantity);
+static void ModbusRTU_TestBits(void);
+static void ModbusRTU_TestScheduler(bool isDma, bool isRing, uint32_t baudRate);
+#ifdef MODBUS_RTU_ENABLE_STATS
+static void ModbusRTU_TestDiagnostics(uint32_t baudRate);
+#endif
+static void ModbusRTU_TestOnReply(ModbusRTU_GatewayT *gateway,
+		void *connection, const uint8_t *adu, size_t size);
+static const ModbusRTU_TestReplyT* ModbusRTU_TestFindReply(void *connection,
+		const uint8_t *head, size_t headSize);
+static void ModbusRTU_TestGateway(uint32_t baudRate);
+static void ModbusRTU_TestOnFanOut(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+static void ModbusRTU_TestFanOut(uint32_t baudRate);
+static void ModbusRTU_TestOnLineWrite(ModbusRTU_SlaveT *slave,
+		uint8_t functionCode, uint16_t address, uint16_t quantity);
+static void ModbusRTU_TestOnStepUp(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+static void ModbusRTU_TestAutobaud(bool isDma);
+static void ModbusRTU_TestSniffer(bool isRing, uint32_t baudRate);
+static size_t ModbusRTU_TestDrain(ModbusRTU_SnifferT *sniffer,
+		uint8_t *capture, size_t size, size_t captured);
+static uint8_t ModbusRTU_TestOnFile(ModbusRTU_SlaveT *slave,
+		uint8_t functionCode, uint16_t file, uint16_t record,
+		uint16_t quantity, uint8_t *data);
+static void ModbusRTU_TestOnFileFill(ModbusRTU_FileTransferT *transfer,
+		uint32_t offset, uint8_t *data, uint16_t size);
+static void ModbusRTU_TestOnFileStore(ModbusRTU_FileTransferT *transfer,
+		uint32_t offset, const uint8_t *data, uint16_t size);
+static void ModbusRTU_TestOnFileDone(ModbusRTU_FileTransferT *transfer,
+		ModbusRTU_ErrorT result);
+static uint32_t ModbusRTU_TestRunFile(ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_FileTransferT *transfer, uint32_t ms, uint32_t limitMs);
+static void ModbusRTU_TestFile(uint32_t baudRate);
+static void ModbusRTU_TestOnFifo(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+static uint32_t ModbusRTU_TestRunFifo(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_SlaveFifoT *fifo, uint32_t ms, uint32_t runMs,
+		uint32_t everyMs);
+static void ModbusRTU_TestFifo(uint32_t baudRate);
+static void ModbusRTU_TestLowPower(uint32_t baudRate);
+static void ModbusRTU_TestOnUrgent(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+static void ModbusRTU_TestPriority(uint32_t baudRate);
+static void ModbusRTU_TestOnSlice(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize);
+static void ModbusRTU_TestCoalesce(uint32_t baudRate);
+static void ModbusRTU_TestReadLimit(uint32_t baudRate);
+static void ModbusRTU_TestOversize(bool isDma, uint32_t baudRate);
+#ifdef MODBUS_RTU_USE_CACHE
+static void ModbusRTU_TestCache(uint32_t baudRate);
+#endif
+
+/* 2. Global Function Declarations */
+
+int main(int argc, char **argv) {
+
+	/* local variable */
+	bool isDma = false, isRing = false;
+	uint32_t baudRate = 115200;
+
+	for (int i = 1; i < argc; i++) {
+		if (0 == strcmp(argv[i], "dma")) {
+			isDma = true;
+		} else if (0 == strcmp(argv[i], "ring")) {
+			isRing = true;
+		} else if (0 != strcmp(argv[i], "it")) {
+			baudRate = (uint32_t) strtoul(argv[i], NULL, 10);
+		}
+	}
+
+	ModbusRTU_TestBits();
+	ModbusRTU_TestScheduler(isDma, isRing, baudRate);
+#ifdef MODBUS_RTU_ENABLE_STATS
+	ModbusRTU_TestDiagnostics(baudRate);
+#endif
+	ModbusRTU_TestGateway(baudRate);
+	ModbusRTU_TestFanOut(baudRate);
+	ModbusRTU_TestAutobaud(isDma);
+	ModbusRTU_TestSniffer(isRing, baudRate);
+	ModbusRTU_TestFile(baudRate);
+	ModbusRTU_TestFifo(baudRate);
+	ModbusRTU_TestLowPower(baudRate);
+	ModbusRTU_TestPriority(baudRate);
+	ModbusRTU_TestCoalesce(baudRate);
+	ModbusRTU_TestReadLimit(baudRate);
+	ModbusRTU_TestOversize(false, baudRate);
+	ModbusRTU_TestOversize(true, baudRate);
+#ifdef MODBUS_RTU_USE_CACHE
+	ModbusRTU_TestCache(baudRate); /* last, it writes coils the gateway reads */
+#endif
+
+	printf("%s: %lu failed checks\n", (0 == ModbusRTU_TestFailures) ?
+			"PASS" : "FAIL", (unsigned long) ModbusRTU_TestFailures);
+
+	return (ModbusRTU_TestFailures > 0) ? 1 : 0;
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_TestCheck(bool condition, const char *text, int line)
+ * @brief Count and report a failed check.
+ *
+ * @param condition Result of the check.
+ * @param text The checked expression.
+ * @param line Source line.
+ */
+static void ModbusRTU_TestCheck(bool condition, const char *text, int line) {
+	if (false == condition) {
+		ModbusRTU_TestFailures++;
+		printf("line %d: check failed: %s\n", line, text);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnResult(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Scheduler callback, tallies the outcome of the request.
+ */
+static void ModbusRTU_TestOnResult(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_TestTallyT *tally = (ModbusRTU_TestTallyT*) request->context;
+
+	if (MODBUS_RTU_SUCCESS == result) {
+		memcpy(ModbusRTU_TestLastData, data,
+				(dataSize < sizeof(ModbusRTU_TestLastData)) ?
+						dataSize : sizeof(ModbusRTU_TestLastData));
+		tally->answers++;
+		if (MODBUS_FUNC_READ_HOLDING_REGISTERS == request->functionCode) {
+			MODBUS_RTU_TEST_CHECK(
+					MODBUS_RTU_READ_REGISTERS_RESPONSE_SIZE(request->quantity) - 1
+							== dataSize);
+		}
+	} else if (MODBUS_RTU_ERROR_EXCEPTION == result) {
+		tally->exceptions++;
+	} else if (MODBUS_RTU_ERROR_RX_TIMEOUT == result) {
+		tally->timeouts++;
+	} else if (MODBUS_RTU_ERROR_SLAVE_OFFLINE == result) {
+		tally->offline++;
+	} else if (MODBUS_RTU_ERROR_LATE == result) {
+		tally->late++;
+	} else {
+		tally->others++;
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnWrite(ModbusRTU_SlaveT *slave, uint8_t functionCode, uint16_t address, uint16_t quantity)
+ * @brief Slave write callback, counts the executed writes.
+ */
+static void ModbusRTU_TestOnWrite(ModbusRTU_SlaveT *slave,
+		uint8_t functionCode, uint16_t address, uint16_t quantity) {
+	(void) slave;
+	(void) functionCode;
+	(void) address;
+	(void) quantity;
+	ModbusRTU_TestWrites++;
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestBits(void)
+ * @brief Pack, unpack and copy coil bits: odd counts, odd offsets, the edges.
+ */
+static void ModbusRTU_TestBits(void) {
+
+	/* local variable */
+	static const size_t counts[] = { 0, 1, 3, 7, 8, 9, 13, 15, 16, 17, 2000 };
+	static uint8_t coils[2000 + 8];
+	static uint8_t unpacked[2000 + 8];
+	static uint8_t bits[2000 / 8 + 2];
+	static uint8_t copied[2000 / 8 + 2];
+	size_t count = 0, bytes = 0, mismatches = 0;
+
+	for (size_t i = 0; i < sizeof(coils); i++) {
+		coils[i] = ((i * 7u) % 3u == 0) ? 1 : 0;
+	}
+
+	/* every count at an odd source and destination address, a guard byte
+	 * behind both outputs */
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		count = counts[c];
+		bytes = (count + 7) / 8;
+		for (size_t offset = 0; offset < 4; offset++) {
+			memset(bits, 0xFF, sizeof(bits));
+			modbusRTUPackBits(&bits[offset % 2], &coils[offset], count);
+			for (size_t i = 0; i < 8 * bytes; i++) {
+				mismatches += (((bits[offset % 2 + i / 8] >> (i % 8)) & 0x01)
+						!= ((i < count) ? coils[offset + i] : 0)) ? 1 : 0;
+			}
+			MODBUS_RTU_TEST_CHECK(0xFF == bits[offset % 2 + bytes]);
+
+			memset(unpacked, 0xEE, sizeof(unpacked));
+			modbusRTUUnpackBits(&unpacked[offset], &bits[offset % 2], count);
+			MODBUS_RTU_TEST_CHECK(
+					0 == memcmp(&unpacked[offset], &coils[offset], count));
+			MODBUS_RTU_TEST_CHECK(0xEE == unpacked[offset + count]);
+		}
+	}
+	MODBUS_RTU_TEST_CHECK(0 == mismatches);
+
+	/* copies from and to non zero bit offsets keep the bits around them */
+	modbusRTUPackBits(bits, coils, 2000);
+	for (size_t dstBit = 0; dstBit < 10; dstBit += 3) {
+		for (size_t srcBit = 0; srcBit < 10; srcBit++) {
+			memset(copied, 0xA5, sizeof(copied));
+			modbusRTUCopyBits(copied, dstBit, bits, srcBit, 1013);
+			for (size_t i = 0; i < 8 * sizeof(copied); i++) {
+				mismatches += (((copied[i / 8] >> (i % 8)) & 0x01)
+						!= (((i >= dstBit) && (i < dstBit + 1013)) ?
+								coils[srcBit + i - dstBit] :
+								((0xA5 >> (i % 8)) & 0x01))) ? 1 : 0;
+			}
+		}
+	}
+	MODBUS_RTU_TEST_CHECK(0 == mismatches);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestScheduler(bool isDma, bool isRing, uint32_t baudRate)
+ * @brief Run the scheduler scenario against the slave engine and check every request.
+ *
+ * @param isDma Slave receives with circular DMA and IDLE line instead of per byte interrupts.
+ * @param isRing Both instances receive into a frame ring.
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestScheduler(bool isDma, bool isRing, uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePort;
+	static ModbusRTU_HandleT master, slave;
+	static ModbusRTU_RxQueueT masterRing, slaveRing;
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engine;
+	static const uint16_t words[4] = { 0x1111, 0x2222, 0x3333, 0x4444 };
+	static const uint16_t masks[2] = { 0x00F2, 0x0025 };
+	static const uint8_t bits[2] = { 0x01, 0x02 };
+	static const uint8_t on = 1;
+	static ModbusRTU_RequestT requests[] = {
+			{ .slaveId = 1, .functionCode = 0x10, .address = 100, .quantity = 4, .values = words },
+			{ .slaveId = 1, .functionCode = 0x03, .address = 101, .quantity = 3, .periodMs = 50, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x04, .address = 2, .quantity = 3, .periodMs = 50, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x01, .address = 3, .quantity = 13, .periodMs = 50, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x02, .address = 12, .quantity = 8, .periodMs = 50, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x05, .address = 31, .quantity = 1, .values = &on },
+			{ .slaveId = 1, .functionCode = 0x0F, .address = 24, .quantity = 9, .values = bits },
+			{ .slaveId = 1, .functionCode = 0x03, .address = 140, .quantity = 2, .periodMs = 100, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x10, .address = 114, .quantity = 4, .values = words },
+			{ .slaveId = 1, .functionCode = 0x03, .address = 113, .quantity = 5, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x03, .address = 0x9C41, .quantity = 3, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x06, .address = 0x9C41, .quantity = 1, .values = words, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x03, .address = 0x9C41, .quantity = 4, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x01, .address = 8, .quantity = 10, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x16, .address = 100, .values = masks, .priority = 1 },
+			{ .slaveId = 1, .functionCode = 0x17, .address = 100, .quantity = 2, .writeAddress = 101, .writeQuantity = 1, .values = words, .priority = 1 },
+			{ .slaveId = MODBUS_RTU_TEST_ABSENT_ID, .functionCode = 0x03, .address = 0, .quantity = 1, .periodMs = 100, .priority = 2 },
+			{ .slaveId = MODBUS_RTU_BROADCAST_ID, .functionCode = 0x06, .address = 110, .quantity = 1, .values = &words[3], .priority = 2 } };
+	static ModbusRTU_TestTallyT tallies[sizeof(requests) / sizeof(requests[0])];
+	const size_t count = sizeof(requests) / sizeof(requests[0]);
+	const ModbusRTU_SlaveHealthT *health = NULL;
+#ifdef MODBUS_RTU_USE_POOL
+	uint8_t *blocks[2] = { NULL, NULL };
+#endif
+	/* same bus load at every baud rate */
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+
+	printf("scheduler scenario: slave %s%s, %lu baud\n", isDma ? "dma" : "it",
+			isRing ? ", ring" : "", (unsigned long) baudRate);
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+#ifdef MODBUS_RTU_USE_POOL
+	/* no DMA ring in the handle, the DMA engine waits for the caller's */
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_ERROR_NO_BUFFER == modbusRTUStartReceiveToIdle(&master));
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_RX_MODE_IT == master.rxMode);
+	/* neighbouring blocks of a class never share a D-cache line */
+	for (uint8_t i = 0; i < 2; i++) {
+		blocks[i] = modbusRTUPoolAlloc(1);
+		MODBUS_RTU_TEST_CHECK(NULL != blocks[i]);
+		MODBUS_RTU_TEST_CHECK(0 == (uintptr_t) blocks[i] % MODBUS_RTU_DMA_ALIGN);
+	}
+	modbusRTUPoolFree(blocks[0]);
+	modbusRTUPoolFree(blocks[1]);
+#endif
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	if (true == isRing) {
+		modbusRTUSetRxQueue(&master, &masterRing);
+		modbusRTUSetRxQueue(&slave, &slaveRing);
+	}
+	modbusRTUStartReceiveToIdle(&master);
+	if (true == isDma) {
+		modbusRTUStartReceiveToIdle(&slave);
+	}
+
+	modbusRTUSlaveInit(&engine, &slave);
+	engine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	engine.inputRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestInputMap);
+	engine.coils = (ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestCoilMap);
+	engine.discreteInputs =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestInputBitMap);
+	engine.writeCallback = ModbusRTU_TestOnWrite;
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+
+	modbusRTUSchedulerInit(&scheduler, &master);
+	scheduler.isCoalescing = false;
+	scheduler.backoffMinMs *= scale;
+	for (size_t i = 0; i < count; i++) {
+		tallies[i].expect = MODBUS_RTU_TEST_ANSWER;
+		requests[i].callback = ModbusRTU_TestOnResult;
+		requests[i].context = &tallies[i];
+		requests[i].periodMs *= scale;
+	}
+	/* outside the map, wider than the map, read only */
+	tallies[6].expect = MODBUS_RTU_TEST_EXCEPTION;
+	tallies[7].expect = MODBUS_RTU_TEST_EXCEPTION;
+	tallies[11].expect = MODBUS_RTU_TEST_EXCEPTION;
+	tallies[12].expect = MODBUS_RTU_TEST_EXCEPTION;
+	tallies[16].expect = MODBUS_RTU_TEST_TIMEOUT;
+	for (size_t i = 0; i < count; i++) {
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &requests[i]));
+	}
+
+	/* main loop: the scheduler polls between two events */
+	for (uint32_t ms = 0; ms < MODBUS_RTU_TEST_RUN_MS * scale; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+	/* nothing new starts, the transaction on the bus still completes */
+	for (size_t i = 0; i < count; i++) {
+		modbusRTUSchedulerRemove(&scheduler, &requests[i]);
+	}
+	for (uint32_t ms = MODBUS_RTU_TEST_RUN_MS * scale;
+			ms < (MODBUS_RTU_TEST_RUN_MS + 200) * scale; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const ModbusRTU_TestTallyT *tally = &tallies[i];
+		uint32_t total = tally->answers + tally->exceptions + tally->timeouts
+				+ tally->offline + tally->others;
+		bool isOk = (0 == tally->others) && (total > 0);
+
+		if (MODBUS_RTU_TEST_ANSWER == tally->expect) {
+			isOk = isOk && (total == tally->answers);
+		} else if (MODBUS_RTU_TEST_EXCEPTION == tally->expect) {
+			isOk = isOk && (total == tally->exceptions);
+		} else {
+			/* a few timeouts, then the slave is skipped */
+			isOk = isOk && (total == tally->timeouts + tally->offline)
+					&& (tally->timeouts >= MODBUS_RTU_SCHEDULER_OFFLINE_AFTER)
+					&& (tally->offline > tally->timeouts);
+		}
+		/* one shot requests complete once, 50 ms polls about 20 times */
+		if (0 == requests[i].periodMs) {
+			isOk = isOk && (1 == total);
+		} else {
+			isOk = isOk
+					&& (total
+							>= MODBUS_RTU_TEST_RUN_MS * scale / requests[i].periodMs / 2);
+		}
+		if (false == isOk) {
+			printf("request %u fc%02X: answers=%lu exceptions=%lu timeouts=%lu offline=%lu others=%lu\n",
+					(unsigned) i, requests[i].functionCode,
+					(unsigned long) tally->answers, (unsigned long) tally->exceptions,
+					(unsigned long) tally->timeouts, (unsigned long) tally->offline,
+					(unsigned long) tally->others);
+		}
+		MODBUS_RTU_TEST_CHECK(true == isOk);
+	}
+
+	/* FC 0x10, FC 0x05, FC 0x10, FC 0x16, FC 0x17 and the broadcast */
+	MODBUS_RTU_TEST_CHECK(6 == ModbusRTU_TestWrites);
+	MODBUS_RTU_TEST_CHECK(0x0015 == ModbusRTU_TestHolding[0]); /* (0x1111 & 0x00F2) | (0x0025 & ~0x00F2) */
+	MODBUS_RTU_TEST_CHECK(0x1111 == ModbusRTU_TestHolding[1]);
+	MODBUS_RTU_TEST_CHECK(0x4444 == ModbusRTU_TestHolding[10]); /* broadcast */
+	MODBUS_RTU_TEST_CHECK(0x1111 == ModbusRTU_TestHolding[14]);
+	MODBUS_RTU_TEST_CHECK(0x2222 == ModbusRTU_TestHolding[15]);
+	MODBUS_RTU_TEST_CHECK(0x3333 == ModbusRTU_TestHoldingB[0]);
+	MODBUS_RTU_TEST_CHECK(0x4444 == ModbusRTU_TestHoldingB[1]);
+	MODBUS_RTU_TEST_CHECK(0xBBBB == ModbusRTU_TestIdentity[1]);
+	MODBUS_RTU_TEST_CHECK(0xA5 == ModbusRTU_TestCoils[0]);
+	MODBUS_RTU_TEST_CHECK(0xFF == ModbusRTU_TestCoilsB[2]);
+	MODBUS_RTU_TEST_CHECK(NULL == scheduler.active);
+	/* the learned timeout of the slave is below the default one */
+	health = modbusRTUSchedulerGetHealth(&scheduler, MODBUS_RTU_TEST_SLAVE_ID);
+	MODBUS_RTU_TEST_CHECK((NULL != health) && (true == health->isMeasured)
+			&& (0 == health->failures)
+			&& (health->timeoutMs < scheduler.timeoutMaxMs));
+	health = modbusRTUSchedulerGetHealth(&scheduler, MODBUS_RTU_TEST_ABSENT_ID);
+	MODBUS_RTU_TEST_CHECK((NULL != health) && (false == health->isMeasured)
+			&& (health->backoffMs >= scheduler.backoffMinMs));
+	MODBUS_RTU_TEST_CHECK(
+			NULL == modbusRTUSchedulerGetHealth(&scheduler, MODBUS_RTU_BROADCAST_ID));
+	/* D-cache model: every DMA buffer maintained as the DMA used it */
+	MODBUS_RTU_TEST_CHECK(0 == masterPort.stats.cacheViolations);
+	MODBUS_RTU_TEST_CHECK(0 == slavePort.stats.cacheViolations);
+}
+
+#ifdef MODBUS_RTU_ENABLE_STATS
+/*!
+ * @fn    static void ModbusRTU_TestDiagnostics(uint32_t baudRate)
+ * @brief FC 0x08 counters and FC 0x0B of the slave engine, through the raw master API.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestDiagnostics(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePort;
+	static ModbusRTU_HandleT master, slave;
+	static ModbusRTU_SlaveT engine;
+	uint8_t request[4] = { 0x00, 0x0E, 0x00, 0x00 }; /* server message count */
+	uint8_t response[4] = { 0 };
+	ModbusRTU_StatsT stats;
+	uint64_t nowNs = 0;
+
+	printf("diagnostics scenario\n");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	modbusRTUSlaveInit(&engine, &slave);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+
+	for (uint8_t i = 0; i < 3; i++) {
+		modbusRTUReciveData(&master, sizeof(response));
+		modbusRTUSendData(&master, MODBUS_FUNC_READ_DIAGNOSTIC, request,
+				sizeof(request));
+		modbusRTUSimRun(nowNs += 50000000u);
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS
+						== modbusRTUCheckRxState(&master, response, sizeof(response)));
+		MODBUS_RTU_TEST_CHECK(i + 1 == modbusRTUGetU16(&response[2]));
+	}
+
+	modbusRTUReciveData(&master, sizeof(response));
+	modbusRTUSendData(&master, MODBUS_FUNC_GET_COM_EVENT_COUNTER, request, 0);
+	modbusRTUSimRun(nowNs += 50000000u);
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUCheckRxState(&master, response, sizeof(response)));
+	MODBUS_RTU_TEST_CHECK(0x0000 == modbusRTUGetU16(&response[0]));
+	MODBUS_RTU_TEST_CHECK(3 == modbusRTUGetU16(&response[2]));
+
+	modbusRTUGetStats(&slave, &stats);
+	MODBUS_RTU_TEST_CHECK(4 == stats.serverMessages);
+	MODBUS_RTU_TEST_CHECK(0 == stats.crcErrors);
+	modbusRTUGetStats(&master, &stats);
+	MODBUS_RTU_TEST_CHECK(4 == stats.txFrames);
+	MODBUS_RTU_TEST_CHECK(4 == stats.rxFrames);
+	MODBUS_RTU_TEST_CHECK(stats.responseTimeUs > 0);
+}
+#endif
+
+/*!
+ * @fn    static void ModbusRTU_TestOnReply(ModbusRTU_GatewayT *gateway, void *connection, const uint8_t *adu, size_t size)
+ * @brief Gateway reply callback, keeps the answer and its time.
+ */
+static void ModbusRTU_TestOnReply(ModbusRTU_GatewayT *gateway,
+		void *connection, const uint8_t *adu, size_t size) {
+
+	/* local variable */
+	ModbusRTU_TestReplyT *reply = NULL;
+
+	(void) gateway;
+
+	MODBUS_RTU_TEST_CHECK(ModbusRTU_TestReplyCount < MODBUS_RTU_TEST_MAX_REPLIES);
+	if (ModbusRTU_TestReplyCount < MODBUS_RTU_TEST_MAX_REPLIES) {
+		reply = &ModbusRTU_TestReplies[ModbusRTU_TestReplyCount++];
+		reply->connection = connection;
+		memcpy(reply->adu, adu, size);
+		reply->size = size;
+		reply->atNs = modbusRTUSimNowNs();
+	}
+}
+
+/*!
+ * @fn    static const ModbusRTU_TestReplyT* ModbusRTU_TestFindReply(void *connection, const uint8_t *head, size_t headSize)
+ * @brief The reply of a connection that starts with head (MBAP: the transaction ID).
+ *
+ * @return the only such reply, NULL for none or more than one.
+ */
+static const ModbusRTU_TestReplyT* ModbusRTU_TestFindReply(void *connection,
+		const uint8_t *head, size_t headSize) {
+
+	/* local variable */
+	const ModbusRTU_TestReplyT *result = NULL;
+	uint8_t matches = 0;
+
+	for (uint8_t i = 0; i < ModbusRTU_TestReplyCount; i++) {
+		if ((connection == ModbusRTU_TestReplies[i].connection)
+				&& (ModbusRTU_TestReplies[i].size >= headSize)
+				&& (0 == memcmp(ModbusRTU_TestReplies[i].adu, head, headSize))) {
+			result = &ModbusRTU_TestReplies[i];
+			matches++;
+		}
+	}
+
+	return (1 == matches) ? result : NULL;
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestGateway(uint32_t baudRate)
+ * @brief modBus TCP and RTU over TCP clients through the gateway to two buses.
+ *
+ * @param baudRate Baud rate of both buses.
+ */
+static void ModbusRTU_TestGateway(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPorts[2], slavePorts[2];
+	static ModbusRTU_HandleT masters[2], slaves[2];
+	static ModbusRTU_SchedulerT schedulers[2];
+	static ModbusRTU_SlaveT engines[2];
+	static ModbusRTU_GatewayT gateway;
+	static int connA, connB, connC, connD;
+	static const uint8_t readIdentity[] = { 0x01, 0x01, 0x00, 0x00, 0x00, 0x06,
+			MODBUS_RTU_TEST_SLAVE_ID, 0x03, 0x9C, 0x40, 0x00, 0x04 };
+	static const uint8_t readInputs[] = { 0x02, 0x02, 0x00, 0x00, 0x00, 0x06,
+			MODBUS_RTU_TEST_SECOND_ID, 0x04, 0x00, 0x00, 0x00, 0x02 };
+	static const uint8_t writeHolding[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0B,
+			MODBUS_RTU_TEST_SLAVE_ID, 0x10, 0x00, 0x6E, 0x00, 0x02, 0x04, 0x12,
+			0x34, 0x56, 0x78 };
+	static const uint8_t noRoute[] = { 0x02, 0x04, 0x00, 0x00, 0x00, 0x06, 9,
+			0x03, 0x00, 0x00, 0x00, 0x01 };
+	static const uint8_t noFunction[] = { 0x02, 0x05, 0x00, 0x00, 0x00, 0x03,
+			MODBUS_RTU_TEST_SECOND_ID, 0x2B, 0x0E };
+	static const uint8_t tooLong[] = { 0x02, 0x06, 0x00, 0x00, 0x00, 0x06,
+			MODBUS_RTU_TEST_SECOND_ID, 0x03, 0x9C, 0x40, 0x00,
+			MODBUS_RTU_HANDLE_MAX_READ_REGISTERS + 1 };
+	static const uint8_t absent[] = { 0x01, 0x06, 0x00, 0x00, 0x00, 0x06,
+			MODBUS_RTU_TEST_ABSENT_ID, 0x03, 0x00, 0x00, 0x00, 0x01 };
+	static const uint8_t closed[] = { 0x04, 0x01, 0x00, 0x00, 0x00, 0x06,
+			MODBUS_RTU_TEST_SECOND_ID, 0x03, 0x9C, 0x40, 0x00, 0x01 };
+	static const uint8_t badProtocol[] = { 0x01, 0x07, 0x00, 0x01, 0x00, 0x06,
+			MODBUS_RTU_TEST_SLAVE_ID, 0x03, 0x00, 0x00, 0x00, 0x01 };
+	uint8_t readCoils[8] = { MODBUS_RTU_TEST_SECOND_ID, 0x01, 0x00, 0x00, 0x00,
+			0x08 };
+	const ModbusRTU_TestReplyT *reply = NULL, *first = NULL;
+	uint16_t crc = modbusRTUCalculateCRC(readCoils, 6);
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+
+	printf("gateway scenario\n");
+
+	modbusRTUSimReset();
+	for (uint8_t bus = 0; bus < 2; bus++) {
+		modbusRTUSimPortInit(&masterPorts[bus], bus, baudRate);
+		modbusRTUSimPortInit(&slavePorts[bus], bus, baudRate);
+		modbusRTUInit(&masters[bus], &masterPorts[bus].huart,
+				&masterPorts[bus].htim, 0);
+		modbusRTUInit(&slaves[bus], &slavePorts[bus].huart,
+				&slavePorts[bus].htim,
+				(0 == bus) ? MODBUS_RTU_TEST_SLAVE_ID : MODBUS_RTU_TEST_SECOND_ID);
+		modbusRTUSimPortAttach(&masterPorts[bus], &masters[bus]);
+		modbusRTUSimPortAttach(&slavePorts[bus], &slaves[bus]);
+		modbusRTUStartReceiveToIdle(&masters[bus]);
+
+		modbusRTUSlaveInit(&engines[bus], &slaves[bus]);
+		engines[bus].holdingRegisters =
+				(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+		engines[bus].inputRegisters =
+				(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestInputMap);
+		engines[bus].coils =
+				(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestCoilMap);
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engines[bus]));
+		modbusRTUSchedulerInit(&schedulers[bus], &masters[bus]);
+	}
+
+	/* unit 2 on the second bus, the rest of 1..7 on the first */
+	modbusRTUGatewayInit(&gateway, ModbusRTU_TestOnReply);
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUGatewayAddBus(&gateway, &schedulers[1],
+							MODBUS_RTU_TEST_SECOND_ID, MODBUS_RTU_TEST_SECOND_ID));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUGatewayAddBus(&gateway, &schedulers[0], 1,
+							MODBUS_RTU_TEST_ABSENT_ID));
+	ModbusRTU_TestReplyCount = 0;
+
+	/* all at once, from four connections */
+	readCoils[6] = crc & 0xFF;
+	readCoils[7] = (crc >> 8) & 0xFF;
+	MODBUS_RTU_TEST_CHECK(sizeof(readIdentity) == modbusRTUGatewayFrameSize(readIdentity, 6));
+	MODBUS_RTU_TEST_CHECK(0 == modbusRTUGatewayFrameSize(readIdentity, 5));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUGatewayRequest(&gateway, &connA, readIdentity,
+							sizeof(readIdentity)));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUGatewayRequest(&gateway, &connB, readInputs,
+							sizeof(readInputs)));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUGatewayRequestRtu(&gateway, &connC, readCoils,
+							sizeof(readCoils)));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUGatewayRequest(&gateway, &connA, writeHolding,
+							sizeof(writeHolding)));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_ERROR_INVALID_SLAVE_ID
+					== modbusRTUGatewayRequest(&gateway, &connB, noRoute,
+							sizeof(noRoute)));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_ERROR_EXCEPTION
+					== modbusRTUGatewayRequest(&gateway, &connB, noFunction,
+							sizeof(noFunction)));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_ERROR_EXCEPTION
+					== modbusRTUGatewayRequest(&gateway, &connB, tooLong,
+							sizeof(tooLong)));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUGatewayRequest(&gateway, &connA, absent,
+							sizeof(absent)));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUGatewayRequest(&gateway, &connD, closed,
+							sizeof(closed)));
+	modbusRTUGatewayDisconnect(&gateway, &connD);
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_ERROR_INVALID_FRAME
+					== modbusRTUGatewayRequest(&gateway, &connA, badProtocol,
+							sizeof(badProtocol)));
+	readCoils[7] ^= 0x01;
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_ERROR_INVALID_FRAME
+					== modbusRTUGatewayRequestRtu(&gateway, &connC, readCoils,
+							sizeof(readCoils)));
+
+	for (uint32_t ms = 0; ms < 500 * scale; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&schedulers[0]);
+			modbusRTUSchedulerProcess(&schedulers[1]);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+
+	/* answers in the framing of their request, with their transaction ID */
+	reply = ModbusRTU_TestFindReply(&connA, readIdentity, 2);
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (17 == reply->size)
+			&& (0 == memcmp(reply->adu, (const uint8_t[]) { 0x01, 0x01, 0x00, 0x00,
+					0x00, 0x0B, MODBUS_RTU_TEST_SLAVE_ID, 0x03, 0x08, 0xAA, 0xAA,
+					0xBB, 0xBB, 0xCC, 0xCC, 0xDD, 0xDD }, 17)));
+	first = reply;
+	reply = ModbusRTU_TestFindReply(&connB, readInputs, 2);
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (13 == reply->size)
+			&& (0 == memcmp(reply->adu, (const uint8_t[]) { 0x02, 0x02, 0x00, 0x00,
+					0x00, 0x07, MODBUS_RTU_TEST_SECOND_ID, 0x04, 0x04, 0x00, 0x0A,
+					0x00, 0x0B }, 13)));
+	/* queued after the first one, but on its own bus */
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (NULL != first)
+			&& (reply->atNs < first->atNs));
+	reply = ModbusRTU_TestFindReply(&connC, readCoils, 1);
+	crc = modbusRTUCalculateCRC((const uint8_t[]) { MODBUS_RTU_TEST_SECOND_ID,
+			0x01, 0x01, 0xA5 }, 4);
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (6 == reply->size)
+			&& (0 == memcmp(reply->adu, (const uint8_t[]) {
+					MODBUS_RTU_TEST_SECOND_ID, 0x01, 0x01, 0xA5, crc & 0xFF,
+					(crc >> 8) & 0xFF }, 6)));
+	reply = ModbusRTU_TestFindReply(&connA, writeHolding, 2);
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (12 == reply->size)
+			&& (0 == memcmp(&reply->adu[4], (const uint8_t[]) { 0x00, 0x06,
+					MODBUS_RTU_TEST_SLAVE_ID, 0x10, 0x00, 0x6E, 0x00, 0x02 }, 8)));
+	MODBUS_RTU_TEST_CHECK(0x1234 == ModbusRTU_TestHolding[10]);
+	MODBUS_RTU_TEST_CHECK(0x5678 == ModbusRTU_TestHolding[11]);
+
+	/* path unavailable, illegal function, a read longer than a handle
+	 * receives, target failed to respond */
+	reply = ModbusRTU_TestFindReply(&connB, noRoute, 2);
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (9 == reply->size)
+			&& (0x83 == reply->adu[7])
+			&& (MODBUS_EXCEPTION_GATEWAY_PATH_UNAVAILABLE == reply->adu[8]));
+	reply = ModbusRTU_TestFindReply(&connB, noFunction, 2);
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (9 == reply->size)
+			&& (0xAB == reply->adu[7])
+			&& (MODBUS_EXCEPTION_ILLEGAL_FUNCTION == reply->adu[8]));
+	reply = ModbusRTU_TestFindReply(&connB, tooLong, 2);
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (9 == reply->size)
+			&& (0x83 == reply->adu[7])
+			&& (MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE == reply->adu[8]));
+	reply = ModbusRTU_TestFindReply(&connA, absent, 2);
+	MODBUS_RTU_TEST_CHECK((NULL != reply) && (9 == reply->size)
+			&& (0x83 == reply->adu[7])
+			&& (MODBUS_EXCEPTION_GATEWAY_TARGET_FAILED == reply->adu[8]));
+
+	/* nothing for the closed connection and the dropped ADUs */
+	MODBUS_RTU_TEST_CHECK(8 == ModbusRTU_TestReplyCount);
+	MODBUS_RTU_TEST_CHECK(0 == gateway.busyMask);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnFanOut(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Scheduler callback, logs the slave, result and time of every fan-out step.
+ */
+static void ModbusRTU_TestOnFanOut(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+	(void) data;
+	(void) dataSize;
+	if (ModbusRTU_TestFanOutCount < sizeof(ModbusRTU_TestFanOutIds)) {
+		ModbusRTU_TestFanOutIds[ModbusRTU_TestFanOutCount] = request->slaveId;
+		ModbusRTU_TestFanOutResults[ModbusRTU_TestFanOutCount] = result;
+		ModbusRTU_TestFanOutNs[ModbusRTU_TestFanOutCount] = modbusRTUSimNowNs();
+	}
+	ModbusRTU_TestFanOutCount++;
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestFanOut(uint32_t baudRate)
+ * @brief One write to two slaves, an absent one and a broadcast, then a read behind it.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestFanOut(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePorts[2];
+	static ModbusRTU_HandleT master, slaves[2];
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engines[2];
+	static const uint16_t value = 0x5A5A;
+	static const uint8_t targets[] = { MODBUS_RTU_TEST_SLAVE_ID,
+			MODBUS_RTU_TEST_SECOND_ID, MODBUS_RTU_TEST_ABSENT_ID,
+			MODBUS_RTU_BROADCAST_ID };
+	static ModbusRTU_RequestT write = { .slaveIds = targets, .slaveCount =
+			sizeof(targets), .functionCode = 0x06, .address = 131, .values =
+			&value, .callback = ModbusRTU_TestOnFanOut };
+	static ModbusRTU_RequestT read = { .slaveId = MODBUS_RTU_TEST_SECOND_ID,
+			.functionCode = 0x03, .address = 131, .quantity = 1, .priority = 1,
+			.callback = ModbusRTU_TestOnFanOut };
+	ModbusRTU_SimBusStatsT bus;
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+
+	printf("fan-out scenario\n");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUStartReceiveToIdle(&master);
+	for (uint8_t i = 0; i < 2; i++) {
+		modbusRTUSimPortInit(&slavePorts[i], 0, baudRate);
+		modbusRTUInit(&slaves[i], &slavePorts[i].huart, &slavePorts[i].htim,
+				(0 == i) ? MODBUS_RTU_TEST_SLAVE_ID : MODBUS_RTU_TEST_SECOND_ID);
+		modbusRTUSimPortAttach(&slavePorts[i], &slaves[i]);
+		modbusRTUSlaveInit(&engines[i], &slaves[i]);
+		engines[i].holdingRegisters =
+				(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+		engines[i].writeCallback = ModbusRTU_TestOnWrite;
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engines[i]));
+	}
+	modbusRTUSchedulerInit(&scheduler, &master);
+	ModbusRTU_TestWrites = 0;
+	ModbusRTU_TestFanOutCount = 0;
+
+	/* the read is due as well, but has to wait for the whole list */
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &write));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &read));
+	for (uint32_t ms = 0; ms < 500 * scale; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+
+	MODBUS_RTU_TEST_CHECK(5 == ModbusRTU_TestFanOutCount);
+	MODBUS_RTU_TEST_CHECK(
+			0 == memcmp(ModbusRTU_TestFanOutIds, (const uint8_t[]) {
+					MODBUS_RTU_TEST_SLAVE_ID, MODBUS_RTU_TEST_SECOND_ID,
+					MODBUS_RTU_TEST_ABSENT_ID, MODBUS_RTU_BROADCAST_ID,
+					MODBUS_RTU_TEST_SECOND_ID }, 5));
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == ModbusRTU_TestFanOutResults[0]);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == ModbusRTU_TestFanOutResults[1]);
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_ERROR_RX_TIMEOUT == ModbusRTU_TestFanOutResults[2]);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == ModbusRTU_TestFanOutResults[3]);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == ModbusRTU_TestFanOutResults[4]);
+	/* the broadcast is done once sent, the next frame waits for the turnaround */
+	MODBUS_RTU_TEST_CHECK(
+			ModbusRTU_TestFanOutNs[3] - ModbusRTU_TestFanOutNs[2]
+					< (uint64_t) master.responseTimeoutMs * 1000000u / 2);
+	MODBUS_RTU_TEST_CHECK(
+			ModbusRTU_TestFanOutNs[4] - ModbusRTU_TestFanOutNs[3]
+					>= (uint64_t) master.turnaroundMs * 1000000u);
+	/* both slaves executed their write and the broadcast */
+	MODBUS_RTU_TEST_CHECK(4 == ModbusRTU_TestWrites);
+	MODBUS_RTU_TEST_CHECK(0x5A5A == ModbusRTU_TestHoldingB[15]);
+	MODBUS_RTU_TEST_CHECK(5 == masterPort.stats.txFrames);
+	MODBUS_RTU_TEST_CHECK(1 == slavePorts[0].stats.txFrames);
+	MODBUS_RTU_TEST_CHECK(2 == slavePorts[1].stats.txFrames);
+	modbusRTUSimGetBusStats(0, &bus);
+	MODBUS_RTU_TEST_CHECK(0 == bus.collisions);
+	MODBUS_RTU_TEST_CHECK((NULL == scheduler.active)
+			&& (NULL == scheduler.fanOut) && (0 == scheduler.requestCount));
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnLineWrite(ModbusRTU_SlaveT *slave, uint8_t functionCode, uint16_t address, uint16_t quantity)
+ * @brief Slave write callback, a write of the line register switches to the fast line.
+ */
+static void ModbusRTU_TestOnLineWrite(ModbusRTU_SlaveT *slave,
+		uint8_t functionCode, uint16_t address, uint16_t quantity) {
+	(void) functionCode;
+	if ((address <= MODBUS_RTU_TEST_LINE_REGISTER)
+			&& (address + quantity > MODBUS_RTU_TEST_LINE_REGISTER)) {
+		modbusRTUSlaveSetLine(slave, MODBUS_RTU_TEST_FAST_BAUD_RATE,
+				MODBUS_RTU_PARITY_NONE);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnStepUp(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Scheduler callback of the line command fan-out, the master follows the last acknowledgement.
+ */
+static void ModbusRTU_TestOnStepUp(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+	(void) data;
+	(void) dataSize;
+	if ((MODBUS_RTU_SUCCESS == result)
+			&& (++ModbusRTU_TestStepUpAcks == request->slaveCount)) {
+		modbusRTUSchedulerSetLine(ModbusRTU_TestStepUpScheduler,
+				MODBUS_RTU_TEST_FAST_BAUD_RATE, MODBUS_RTU_PARITY_NONE);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestAutobaud(bool isDma)
+ * @brief A slave finds the 19200 8E1 line of a polled bus, then the bus steps up to 115200.
+ *
+ * @param isDma The detecting slave receives with circular DMA and IDLE line.
+ */
+static void ModbusRTU_TestAutobaud(bool isDma) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePorts[2];
+	static ModbusRTU_HandleT master, slaves[2];
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engines[2];
+	static ModbusRTU_AutobaudT autobaud;
+	static const ModbusRTU_LineT lines[] = {
+			{ 115200, MODBUS_RTU_PARITY_NONE },
+			{ 19200, MODBUS_RTU_PARITY_ODD },
+			{ 19200, MODBUS_RTU_PARITY_NONE },
+			{ 19200, MODBUS_RTU_PARITY_EVEN },
+			{ 9600, MODBUS_RTU_PARITY_EVEN } };
+	static const uint16_t command = 1;
+	static const uint8_t targets[] = { MODBUS_RTU_TEST_SLAVE_ID,
+			MODBUS_RTU_TEST_SECOND_ID };
+	static ModbusRTU_TestTallyT tallies[2];
+	static ModbusRTU_RequestT polls[2];
+	static ModbusRTU_RequestT stepUp = { .slaveIds = targets, .slaveCount =
+			sizeof(targets), .functionCode = 0x06, .address =
+			MODBUS_RTU_TEST_LINE_REGISTER, .values = &command, .priority = 1,
+			.callback = ModbusRTU_TestOnStepUp };
+	ModbusRTU_TestTallyT before[2];
+	ModbusRTU_SimBusStatsT bus;
+	uint32_t slowT35Ticks = 0;
+	uint32_t ms = 0;
+
+	printf("autobaud scenario\n");
+
+	/* slave 1 and the master run 19200 8E1, slave 2 starts at 115200 8N2 */
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, MODBUS_RTU_TEST_FAST_BAUD_RATE);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUStartReceiveToIdle(&master);
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUSetLine(&master, 19200, MODBUS_RTU_PARITY_EVEN));
+	master.responseTimeoutMs = 50;
+	slowT35Ticks = master.t35Ticks;
+	for (uint8_t i = 0; i < 2; i++) {
+		modbusRTUSimPortInit(&slavePorts[i], 0, MODBUS_RTU_TEST_FAST_BAUD_RATE);
+		modbusRTUInit(&slaves[i], &slavePorts[i].huart, &slavePorts[i].htim,
+				(0 == i) ? MODBUS_RTU_TEST_SLAVE_ID : MODBUS_RTU_TEST_SECOND_ID);
+		modbusRTUSimPortAttach(&slavePorts[i], &slaves[i]);
+	}
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUSetLine(&slaves[0], 19200, MODBUS_RTU_PARITY_EVEN));
+	for (uint8_t i = 0; i < 2; i++) {
+		modbusRTUSlaveInit(&engines[i], &slaves[i]);
+		engines[i].holdingRegisters =
+				(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+		engines[i].writeCallback = ModbusRTU_TestOnLineWrite;
+	}
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engines[0]));
+
+	/* slave 2 listens to the polls of both slaves and the answers of slave 1 */
+	if (true == isDma) {
+		modbusRTUStartReceiveToIdle(&slaves[1]);
+	}
+	slaves[1].eventCallback = NULL; /* the engine starts once the line is known */
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS
+					== modbusRTUAutobaudStart(&autobaud, &slaves[1],
+							MODBUS_RTU_AUTOBAUD_LINES(lines)));
+	autobaud.dwellMs = 100;
+
+	modbusRTUSchedulerInit(&scheduler, &master);
+	scheduler.offlineAfter = 0; /* keep polling slave 2 while it is deaf */
+	memset(tallies, 0, sizeof(tallies));
+	for (uint8_t i = 0; i < 2; i++) {
+		polls[i] = (ModbusRTU_RequestT) { .slaveId = targets[i],
+				.functionCode = 0x03, .address = 100, .quantity = 2,
+				.periodMs = 50, .callback = ModbusRTU_TestOnResult,
+				.context = &tallies[i] };
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &polls[i]));
+	}
+
+	/* every wrong candidate is dropped after its dwell time */
+	for (; (ms < 2000) && (MODBUS_RTU_SUCCESS
+			!= modbusRTUAutobaudProcess(&autobaud)); ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+	MODBUS_RTU_TEST_CHECK(true == autobaud.isLocked);
+	MODBUS_RTU_TEST_CHECK(3 == autobaud.lineIndex);
+	MODBUS_RTU_TEST_CHECK(ms < (sizeof(lines) + 1) * autobaud.dwellMs);
+	MODBUS_RTU_TEST_CHECK(autobaud.frames >= autobaud.lockFrames);
+	MODBUS_RTU_TEST_CHECK((true == isDma) || (autobaud.badFrames > 0));
+	MODBUS_RTU_TEST_CHECK(
+			(19200 == slavePorts[1].huart.Init.BaudRate)
+					&& (UART_PARITY_EVEN == slavePorts[1].huart.Init.Parity));
+	MODBUS_RTU_TEST_CHECK(0 == slavePorts[0].stats.lineErrors);
+	MODBUS_RTU_TEST_CHECK(0 == tallies[0].timeouts);
+	MODBUS_RTU_TEST_CHECK(0 == tallies[1].answers);
+	MODBUS_RTU_TEST_CHECK(false == slaves[1].isPromiscuous);
+
+	/* slave 2 serves on the found line */
+	slaves[1].eventCallback = NULL;
+	modbusRTUSlaveInit(&engines[1], &slaves[1]);
+	engines[1].holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	engines[1].writeCallback = ModbusRTU_TestOnLineWrite;
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engines[1]));
+	for (uint32_t end = ms + 200; ms < end; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+	MODBUS_RTU_TEST_CHECK(tallies[1].answers > 0);
+
+	/* both slaves acknowledge the line command on 19200, then all go 115200 */
+	ModbusRTU_TestStepUpScheduler = &scheduler;
+	ModbusRTU_TestStepUpAcks = 0;
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &stepUp));
+	for (uint32_t end = ms + 100; ms < end; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+	MODBUS_RTU_TEST_CHECK(2 == ModbusRTU_TestStepUpAcks);
+	MODBUS_RTU_TEST_CHECK(
+			(MODBUS_RTU_TEST_FAST_BAUD_RATE == masterPort.huart.Init.BaudRate)
+					&& (UART_PARITY_NONE == masterPort.huart.Init.Parity));
+	for (uint8_t i = 0; i < 2; i++) {
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_TEST_FAST_BAUD_RATE
+						== slavePorts[i].huart.Init.BaudRate);
+	}
+	MODBUS_RTU_TEST_CHECK(master.t35Ticks < slowT35Ticks);
+
+	/* every poll on the fast line is answered */
+	memcpy(before, tallies, sizeof(before));
+	for (uint32_t end = ms + 200; ms < end; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+	for (uint8_t i = 0; i < 2; i++) {
+		MODBUS_RTU_TEST_CHECK(tallies[i].answers >= before[i].answers + 3);
+		MODBUS_RTU_TEST_CHECK(tallies[i].timeouts == before[i].timeouts);
+		MODBUS_RTU_TEST_CHECK(0 == tallies[i].others);
+	}
+	modbusRTUSimGetBusStats(0, &bus);
+	MODBUS_RTU_TEST_CHECK(0 == bus.collisions);
+
+	/* one stray frame and silence do not hold the search on a candidate,
+	 * polls further apart than dwellMs / lockFrames still lock the line */
+	for (uint8_t round = 0; round < 2; round++) {
+		modbusRTUSimReset();
+		modbusRTUSimPortInit(&masterPort, 0, lines[0].baudRate);
+		modbusRTUSimPortInit(&slavePorts[1], 0, lines[0].baudRate);
+		modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+		modbusRTUInit(&slaves[1], &slavePorts[1].huart, &slavePorts[1].htim,
+				MODBUS_RTU_TEST_SECOND_ID);
+		modbusRTUSimPortAttach(&masterPort, &master);
+		modbusRTUSimPortAttach(&slavePorts[1], &slaves[1]);
+		modbusRTUStartReceiveToIdle(&master);
+		if (true == isDma) {
+			modbusRTUStartReceiveToIdle(&slaves[1]);
+		}
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS
+						== modbusRTUAutobaudStart(&autobaud, &slaves[1],
+								MODBUS_RTU_AUTOBAUD_LINES(lines)));
+		modbusRTUSchedulerInit(&scheduler, &master);
+		if (0 == round) {
+			autobaud.dwellMs = 100;
+			polls[0].periodMs = 0; /* one frame half a dwell in, nobody answers */
+			for (ms = 0; ms < autobaud.dwellMs / 2; ms++) {
+				modbusRTUAutobaudProcess(&autobaud);
+				modbusRTUSimRun((uint64_t) (ms + 1) * 1000000u);
+			}
+		} else {
+			ms = 0;
+			autobaud.dwellMs = 200;
+			autobaud.lockFrames = 3; /* 3 frames take longer than dwellMs */
+			polls[0].periodMs = 150;
+		}
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS
+						== modbusRTUSchedulerAdd(&scheduler, &polls[0]));
+		for (; (ms < 3 * autobaud.dwellMs)
+				&& (MODBUS_RTU_SUCCESS != modbusRTUAutobaudProcess(&autobaud))
+				&& ((0 != round) || (0 == autobaud.lineIndex)); ms++) {
+			do {
+				modbusRTUSchedulerProcess(&scheduler);
+			} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+		}
+		if (0 == round) {
+			MODBUS_RTU_TEST_CHECK(1 == autobaud.frames);
+			MODBUS_RTU_TEST_CHECK(false == autobaud.isLocked);
+			MODBUS_RTU_TEST_CHECK(1 == autobaud.lineIndex);
+			MODBUS_RTU_TEST_CHECK(0 == autobaud.validFrames);
+			/* left a dwell after the frame, not after the start */
+			MODBUS_RTU_TEST_CHECK(ms >= autobaud.dwellMs / 2 + autobaud.dwellMs);
+		} else {
+			MODBUS_RTU_TEST_CHECK(true == autobaud.isLocked);
+			MODBUS_RTU_TEST_CHECK(0 == autobaud.lineIndex);
+			MODBUS_RTU_TEST_CHECK(3 == autobaud.frames);
+			MODBUS_RTU_TEST_CHECK(ms > autobaud.dwellMs);
+		}
+		modbusRTUSchedulerRemove(&scheduler, &polls[0]);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestSniffer(bool isRing, uint32_t baudRate)
+ * @brief A listen-only port captures a polled bus, the capture decodes to every frame.
+ *
+ * @param isRing The capture receives into a frame ring.
+ * @param baudRate Bus speed.
+ */
+static void ModbusRTU_TestSniffer(bool isRing, uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePort, snifferPort;
+	static ModbusRTU_HandleT master, slave, capturer;
+	static ModbusRTU_RxQueueT snifferRing;
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engine;
+	static ModbusRTU_SnifferT sniffer;
+	static uint8_t capture[32768];
+	static ModbusRTU_TestTallyT tallies[3];
+	static ModbusRTU_RequestT polls[3];
+	static const uint8_t noise[] = { MODBUS_RTU_TEST_SLAVE_ID, 0x03, 0x00,
+			0x64, 0x00, 0x02, 0x00, 0x00 }; /* wrong CRC */
+	ModbusRTU_SnifferDecoderT decoder = { 0 };
+	ModbusRTU_SnifferRecordT record = { 0 };
+	ModbusRTU_ErrorT result = MODBUS_RTU_SUCCESS;
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+	uint32_t counts[MODBUS_RTU_SNIFFER_RESULT_MASK + 1] = { 0 };
+	uint32_t records = 0;
+	uint32_t shortGaps = 0;
+	uint64_t startNs = 0;
+	uint64_t noiseEndNs = 0;
+	uint64_t lastUs = 0;
+	uint64_t wireBytes = 0;
+	size_t captured = 0;
+	size_t position = 0;
+	size_t used = 0;
+	uint32_t ms = 0;
+
+	printf("sniffer scenario%s\n", isRing ? ", ring" : "");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUSimPortInit(&snifferPort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUInit(&capturer, &snifferPort.huart, &snifferPort.htim, 0);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	modbusRTUSimPortAttach(&snifferPort, &capturer);
+	modbusRTUStartReceiveToIdle(&master);
+	if (true == isRing) {
+		modbusRTUSetRxQueue(&capturer, &snifferRing);
+	}
+	modbusRTUStartReceiveToIdle(&capturer);
+	modbusRTUSlaveInit(&engine, &slave);
+	engine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+	startNs = modbusRTUSimNowNs();
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSnifferStart(&sniffer, &capturer));
+
+	/* answers, exceptions and requests nobody answers */
+	master.responseTimeoutMs = 20 * scale;
+	modbusRTUSchedulerInit(&scheduler, &master);
+	scheduler.offlineAfter = 0;
+	memset(tallies, 0, sizeof(tallies));
+	polls[0] = (ModbusRTU_RequestT) { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x03, .address = 100, .quantity = 2, .periodMs = 10
+					* scale, .callback = ModbusRTU_TestOnResult, .context =
+					&tallies[0] };
+	polls[1] = (ModbusRTU_RequestT) { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x03, .address = 500, .quantity = 1, .periodMs = 50
+					* scale, .callback = ModbusRTU_TestOnResult, .context =
+					&tallies[1] };
+	polls[2] = (ModbusRTU_RequestT) { .slaveId = MODBUS_RTU_TEST_ABSENT_ID,
+			.functionCode = 0x03, .address = 100, .quantity = 1, .periodMs = 100
+					* scale, .callback = ModbusRTU_TestOnResult, .context =
+					&tallies[2] };
+	for (uint8_t i = 0; i < 3; i++) {
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &polls[i]));
+	}
+	for (; ms < 300 * scale; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+		captured = ModbusRTU_TestDrain(&sniffer, capture, sizeof(capture),
+				captured);
+	}
+
+	/* the master stops, a frame with a broken CRC follows on a quiet bus */
+	for (uint8_t i = 0; i < 3; i++) {
+		modbusRTUSchedulerRemove(&scheduler, &polls[i]);
+	}
+	for (uint32_t end = ms + 50 * scale; ms < end; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+	modbusRTUSimInject(&snifferPort, noise, sizeof(noise), 0);
+	noiseEndNs = modbusRTUSimNowNs()
+			+ sizeof(noise) * modbusRTUSimCharNs(baudRate);
+	modbusRTUSimRun((uint64_t) (ms + 50 * scale) * 1000000u);
+	captured = ModbusRTU_TestDrain(&sniffer, capture, sizeof(capture), captured);
+	modbusRTUSnifferStop(&sniffer);
+	MODBUS_RTU_TEST_CHECK(NULL == capturer.eventCallback);
+
+	/* every frame decodes in order, stamped at its last stop bit */
+	while ((position < captured)
+			&& (MODBUS_RTU_SUCCESS
+					== (result = modbusRTUSnifferDecode(&decoder,
+							capture + position, captured - position, &record,
+							&used)))) {
+		position += used;
+		records++;
+		counts[record.result]++;
+		MODBUS_RTU_TEST_CHECK(false == record.isLost);
+		MODBUS_RTU_TEST_CHECK(record.timeUs >= lastUs);
+		shortGaps += ((records > 1) && ((record.timeUs - lastUs) * 1000u
+				< record.length * modbusRTUSimCharNs(baudRate))) ? 1 : 0;
+		lastUs = record.timeUs;
+	}
+
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == result);
+	MODBUS_RTU_TEST_CHECK(position == captured);
+	MODBUS_RTU_TEST_CHECK(baudRate == decoder.baudRate);
+	MODBUS_RTU_TEST_CHECK(records == sniffer.records);
+	MODBUS_RTU_TEST_CHECK(0 == sniffer.lostRecords);
+	MODBUS_RTU_TEST_CHECK(0 == shortGaps);
+
+	/* requests and answers of both slaves, the exceptions, the broken frame */
+	MODBUS_RTU_TEST_CHECK(tallies[0].answers > 0);
+	MODBUS_RTU_TEST_CHECK(tallies[1].exceptions > 0);
+	MODBUS_RTU_TEST_CHECK(tallies[2].timeouts > 0);
+	MODBUS_RTU_TEST_CHECK(
+			counts[MODBUS_RTU_SUCCESS]
+					== 2 * tallies[0].answers + tallies[1].exceptions
+							+ tallies[2].timeouts);
+	MODBUS_RTU_TEST_CHECK(counts[MODBUS_RTU_ERROR_EXCEPTION]
+			== tallies[1].exceptions);
+	MODBUS_RTU_TEST_CHECK(1 == counts[MODBUS_RTU_ERROR_CRC]);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_ERROR_CRC == record.result);
+	MODBUS_RTU_TEST_CHECK(
+			(record.timeUs + startNs / 1000u + 2 >= noiseEndNs / 1000u)
+					&& (record.timeUs + startNs / 1000u <= noiseEndNs / 1000u + 2));
+
+	/* listen only, and small enough to stream the bus continuously */
+	MODBUS_RTU_TEST_CHECK(0 == snifferPort.stats.txFrames);
+	wireBytes = masterPort.stats.txBytes + slavePort.stats.txBytes
+			+ sizeof(noise);
+	MODBUS_RTU_TEST_CHECK(
+			captured <= MODBUS_RTU_SNIFFER_HEADER_SIZE + wireBytes + 5 * records);
+	printf("sniffer: records=%lu bytes=%lu wire_bytes=%lu\n",
+			(unsigned long) records, (unsigned long) captured,
+			(unsigned long) wireBytes);
+
+	/* a delta cut short waits for more bytes, one that never ends fails */
+	memset(&capture[MODBUS_RTU_SNIFFER_HEADER_SIZE], 0x80, 11);
+	decoder = (ModbusRTU_SnifferDecoderT) { 0 };
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_RX_BUSY
+					== modbusRTUSnifferDecode(&decoder, capture,
+							MODBUS_RTU_SNIFFER_HEADER_SIZE + 10, &record, &used));
+	decoder = (ModbusRTU_SnifferDecoderT) { 0 };
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_ERROR_INVALID_FRAME
+					== modbusRTUSnifferDecode(&decoder, capture,
+							MODBUS_RTU_SNIFFER_HEADER_SIZE + 11, &record, &used));
+}
+
+/*!
+ * @fn    static size_t ModbusRTU_TestDrain(ModbusRTU_SnifferT *sniffer, uint8_t *capture, size_t size, size_t captured)
+ * @brief Drain the capture ring like a USB or SD card writer would.
+ *
+ * @param sniffer Pointer to the capture.
+ * @param capture Destination.
+ * @param size Bytes of capture.
+ * @param captured Bytes already in capture.
+ * @return bytes in capture.
+ */
+static size_t ModbusRTU_TestDrain(ModbusRTU_SnifferT *sniffer,
+		uint8_t *capture, size_t size, size_t captured) {
+
+	/* local variable */
+	const uint8_t *data = NULL;
+	size_t length = 0;
+
+	while (0 != (length = modbusRTUSnifferPeek(sniffer, &data))) {
+		if (length > size - captured) {
+			length = size - captured;
+		}
+		memcpy(capture + captured, data, length);
+		captured += length;
+		modbusRTUSnifferConsume(sniffer, length);
+	}
+
+	return captured;
+}
+
+/*!
+ * @fn    static uint8_t ModbusRTU_TestOnFile(ModbusRTU_SlaveT *slave, uint8_t functionCode, uint16_t file, uint16_t record, uint16_t quantity, uint8_t *data)
+ * @brief Slave file callback, the records of files 1..MODBUS_RTU_TEST_FILES in RAM.
+ */
+static uint8_t ModbusRTU_TestOnFile(ModbusRTU_SlaveT *slave,
+		uint8_t functionCode, uint16_t file, uint16_t record,
+		uint16_t quantity, uint8_t *data) {
+
+	/* local variable */
+	uint8_t result = MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+	uint8_t *image = &ModbusRTU_TestFileImage[2u
+			* ((file - 1u) * MODBUS_RTU_FILE_RECORDS + record)];
+
+	(void) slave;
+	if (file <= MODBUS_RTU_TEST_FILES) {
+		if (MODBUS_FUNC_WRITE_FILE_RECORD == functionCode) {
+			memcpy(image, data, 2u * quantity);
+		} else {
+			memcpy(data, image, 2u * quantity);
+		}
+		result = MODBUS_EXCEPTION_NONE;
+	}
+
+	return result;
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnFileFill(ModbusRTU_FileTransferT *transfer, uint32_t offset, uint8_t *data, uint16_t size)
+ * @brief Fill callback, the blob is generated like a flash reader would copy it.
+ */
+static void ModbusRTU_TestOnFileFill(ModbusRTU_FileTransferT *transfer,
+		uint32_t offset, uint8_t *data, uint16_t size) {
+	(void) transfer;
+	for (uint16_t i = 0; i < size; i++) {
+		data[i] = MODBUS_RTU_TEST_FILE_BYTE(offset + i);
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnFileStore(ModbusRTU_FileTransferT *transfer, uint32_t offset, const uint8_t *data, uint16_t size)
+ * @brief Store callback, counts the bytes that differ from the blob.
+ */
+static void ModbusRTU_TestOnFileStore(ModbusRTU_FileTransferT *transfer,
+		uint32_t offset, const uint8_t *data, uint16_t size) {
+	(void) transfer;
+	for (uint16_t i = 0; i < size; i++) {
+		ModbusRTU_TestFileMismatches +=
+				(MODBUS_RTU_TEST_FILE_BYTE(offset + i) != data[i]) ? 1 : 0;
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnFileDone(ModbusRTU_FileTransferT *transfer, ModbusRTU_ErrorT result)
+ * @brief Done callback, counts the ended transfers.
+ */
+static void ModbusRTU_TestOnFileDone(ModbusRTU_FileTransferT *transfer,
+		ModbusRTU_ErrorT result) {
+	MODBUS_RTU_TEST_CHECK(result == transfer->result);
+	ModbusRTU_TestFileDone++;
+}
+
+/*!
+ * @fn    static uint32_t ModbusRTU_TestRunFile(ModbusRTU_SchedulerT *scheduler, const ModbusRTU_FileTransferT *transfer, uint32_t ms, uint32_t limitMs)
+ * @brief Run the bus until a transfer ends.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param transfer The transfer.
+ * @param ms Virtual time reached so far.
+ * @param limitMs Longest run.
+ * @return virtual time reached.
+ */
+static uint32_t ModbusRTU_TestRunFile(ModbusRTU_SchedulerT *scheduler,
+		const ModbusRTU_FileTransferT *transfer, uint32_t ms, uint32_t limitMs) {
+	for (uint32_t end = ms + limitMs;
+			(MODBUS_RTU_RX_BUSY == transfer->result) && (ms < end); ms++) {
+		do {
+			modbusRTUSchedulerProcess(scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+
+	return ms;
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestFile(uint32_t baudRate)
+ * @brief A blob written and read back in full frames while a poll runs, then failing transfers.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestFile(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePort;
+	static ModbusRTU_HandleT master, slave;
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engine;
+	static ModbusRTU_FileTransferT transfer;
+	static ModbusRTU_TestTallyT tally;
+	static ModbusRTU_RequestT poll;
+	static uint8_t blob[MODBUS_RTU_TEST_FILE_SIZE];
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+	uint32_t charRate = (uint32_t) (1000000000u / modbusRTUSimCharNs(baudRate));
+	uint32_t frames = (MODBUS_RTU_TEST_FILE_SIZE / 2 + MODBUS_RTU_FILE_FRAME_RECORDS)
+			/ MODBUS_RTU_FILE_FRAME_RECORDS;
+	uint32_t writeRate = 0;
+	uint32_t readRate = 0;
+	uint32_t ms = 0;
+	uint32_t mismatches = 0;
+
+	printf("file scenario\n");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	modbusRTUStartReceiveToIdle(&master);
+	modbusRTUSlaveInit(&engine, &slave);
+	engine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	engine.fileCallback = ModbusRTU_TestOnFile;
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+	master.responseTimeoutMs = 20 * scale;
+	modbusRTUSchedulerInit(&scheduler, &master);
+	memset(ModbusRTU_TestFileImage, 0, sizeof(ModbusRTU_TestFileImage));
+	ModbusRTU_TestFileDone = 0;
+
+	/* the poll keeps its period while the frames of the blob go back to back */
+	memset(&tally, 0, sizeof(tally));
+	poll = (ModbusRTU_RequestT) { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x03, .address = 100, .quantity = 2, .periodMs = 20
+					* scale, .callback = ModbusRTU_TestOnResult, .context =
+					&tally };
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &poll));
+
+	modbusRTUFileInit(&transfer, &scheduler, MODBUS_RTU_TEST_SLAVE_ID,
+			MODBUS_RTU_TEST_FILE_NUMBER, MODBUS_RTU_TEST_FILE_RECORD);
+	transfer.fillCallback = ModbusRTU_TestOnFileFill;
+	transfer.doneCallback = ModbusRTU_TestOnFileDone;
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_ERROR_INVALID_FRAME
+			== modbusRTUFileRead(&transfer, NULL, MODBUS_RTU_TEST_FILE_SIZE));
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS
+			== modbusRTUFileWrite(&transfer, NULL, MODBUS_RTU_TEST_FILE_SIZE));
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_TX_BUSY
+			== modbusRTUFileWrite(&transfer, NULL, MODBUS_RTU_TEST_FILE_SIZE));
+	ms = ModbusRTU_TestRunFile(&scheduler, &transfer, ms, 5000 * scale);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == transfer.result);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_TEST_FILE_SIZE == transfer.offset);
+	/* full frames, one more where the blob crosses into the next file */
+	MODBUS_RTU_TEST_CHECK(
+			(transfer.frames >= frames) && (transfer.frames <= frames + 1));
+	MODBUS_RTU_TEST_CHECK(0 == transfer.retried);
+	writeRate = modbusRTUFileGetThroughput(&transfer);
+	for (uint32_t i = 0; i < MODBUS_RTU_TEST_FILE_SIZE; i++) {
+		mismatches += (MODBUS_RTU_TEST_FILE_BYTE(i)
+				!= ModbusRTU_TestFileImage[2u * MODBUS_RTU_TEST_FILE_RECORD + i]) ?
+				1 : 0;
+	}
+	MODBUS_RTU_TEST_CHECK(0 == mismatches);
+	/* an odd blob pads its last record */
+	MODBUS_RTU_TEST_CHECK(0 == ModbusRTU_TestFileImage[2u
+			* MODBUS_RTU_TEST_FILE_RECORD + MODBUS_RTU_TEST_FILE_SIZE]);
+
+	/* read back into a region */
+	memset(blob, 0, sizeof(blob));
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS
+			== modbusRTUFileRead(&transfer, blob, sizeof(blob)));
+	ms = ModbusRTU_TestRunFile(&scheduler, &transfer, ms, 5000 * scale);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == transfer.result);
+	MODBUS_RTU_TEST_CHECK(
+			(transfer.frames >= frames) && (transfer.frames <= frames + 1));
+	MODBUS_RTU_TEST_CHECK(
+			0 == memcmp(blob, &ModbusRTU_TestFileImage[2u
+					* MODBUS_RTU_TEST_FILE_RECORD], sizeof(blob)));
+	readRate = modbusRTUFileGetThroughput(&transfer);
+
+	/* and through the store callback */
+	ModbusRTU_TestFileMismatches = 0;
+	transfer.storeCallback = ModbusRTU_TestOnFileStore;
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS
+			== modbusRTUFileRead(&transfer, NULL, MODBUS_RTU_TEST_FILE_SIZE));
+	ms = ModbusRTU_TestRunFile(&scheduler, &transfer, ms, 5000 * scale);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == transfer.result);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_TEST_FILE_SIZE == transfer.offset);
+	MODBUS_RTU_TEST_CHECK(0 == ModbusRTU_TestFileMismatches);
+
+	/* frames carry the blob near the line rate, a write pays for its echo */
+	MODBUS_RTU_TEST_CHECK(writeRate > charRate / 3);
+	MODBUS_RTU_TEST_CHECK(readRate > charRate * 2 / 3);
+	MODBUS_RTU_TEST_CHECK(tally.answers > 0);
+	MODBUS_RTU_TEST_CHECK(0 == tally.exceptions + tally.timeouts + tally.others);
+
+	/* an unknown file ends at its exception, an absent slave after the retries */
+	modbusRTUFileInit(&transfer, &scheduler, MODBUS_RTU_TEST_SLAVE_ID,
+			MODBUS_RTU_TEST_FILES + 1, 0);
+	transfer.doneCallback = ModbusRTU_TestOnFileDone;
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS
+			== modbusRTUFileRead(&transfer, blob, sizeof(blob)));
+	ms = ModbusRTU_TestRunFile(&scheduler, &transfer, ms, 1000 * scale);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_ERROR_EXCEPTION == transfer.result);
+	MODBUS_RTU_TEST_CHECK((1 == transfer.frames) && (0 == transfer.offset));
+
+	modbusRTUFileInit(&transfer, &scheduler, MODBUS_RTU_TEST_ABSENT_ID,
+			MODBUS_RTU_TEST_FILE_NUMBER, 0);
+	transfer.doneCallback = ModbusRTU_TestOnFileDone;
+	transfer.retries = 1;
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS
+			== modbusRTUFileWrite(&transfer, blob, sizeof(blob)));
+	ms = ModbusRTU_TestRunFile(&scheduler, &transfer, ms, 1000 * scale);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_ERROR_RX_TIMEOUT == transfer.result);
+	MODBUS_RTU_TEST_CHECK((2 == transfer.frames) && (1 == transfer.retried));
+	MODBUS_RTU_TEST_CHECK(5 == ModbusRTU_TestFileDone);
+
+	modbusRTUSchedulerRemove(&scheduler, &poll);
+	printf("file: write=%lu B/s read=%lu B/s line=%lu chars/s\n",
+			(unsigned long) writeRate, (unsigned long) readRate,
+			(unsigned long) charRate);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnFifo(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief FC 0x18 callback, checks the samples follow each other, then tallies.
+ */
+static void ModbusRTU_TestOnFifo(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	uint16_t count = 0;
+
+	if (MODBUS_RTU_SUCCESS == result) {
+		count = modbusRTUGetU16(&data[0]);
+		MODBUS_RTU_TEST_CHECK((size_t) (2 + 2 * count) == dataSize);
+		MODBUS_RTU_TEST_CHECK(count <= request->quantity);
+		for (uint16_t i = 0; i < count; i++) {
+			ModbusRTU_TestFifoGaps +=
+					(ModbusRTU_TestFifoNext++ != modbusRTUGetU16(&data[2 + 2 * i])) ?
+							1 : 0;
+		}
+	}
+	ModbusRTU_TestOnResult(request, result, data, dataSize);
+}
+
+/*!
+ * @fn    static uint32_t ModbusRTU_TestRunFifo(ModbusRTU_SchedulerT *scheduler, ModbusRTU_SlaveFifoT *fifo, uint32_t ms, uint32_t runMs, uint32_t everyMs)
+ * @brief Run the bus while a producer queues samples.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param fifo FIFO of the slave.
+ * @param ms Virtual time reached so far.
+ * @param runMs Run time.
+ * @param everyMs One sample every everyMs, 0 for none.
+ * @return virtual time reached.
+ */
+static uint32_t ModbusRTU_TestRunFifo(ModbusRTU_SchedulerT *scheduler,
+		ModbusRTU_SlaveFifoT *fifo, uint32_t ms, uint32_t runMs,
+		uint32_t everyMs) {
+	for (uint32_t end = ms + runMs; ms < end; ms++) {
+		if ((0 != everyMs) && (0 == ms % everyMs)
+				&& (true == modbusRTUSlaveFifoPush(fifo, ModbusRTU_TestFifoPushed))) {
+			ModbusRTU_TestFifoPushed++;
+		}
+		do {
+			modbusRTUSchedulerProcess(scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+
+	return ms;
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestFifo(uint32_t baudRate)
+ * @brief A full FIFO drained in one transaction, a poll that keeps up with a producer, a wrong FIFO.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestFifo(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePort;
+	static ModbusRTU_HandleT master, slave;
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engine;
+	static ModbusRTU_SlaveFifoT fifo = { .address = MODBUS_RTU_TEST_FIFO_ADDRESS };
+	static ModbusRTU_TestTallyT tally, wrongTally;
+	static ModbusRTU_RequestT drain = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = MODBUS_FUNC_READ_FIFO_QUEUE, .address =
+					MODBUS_RTU_TEST_FIFO_ADDRESS, .quantity =
+					MODBUS_RTU_MAX_FIFO_COUNT, .callback = ModbusRTU_TestOnFifo,
+			.context = &tally };
+	static ModbusRTU_RequestT wrong = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = MODBUS_FUNC_READ_FIFO_QUEUE, .address =
+					MODBUS_RTU_TEST_FIFO_ADDRESS + 1, .quantity =
+					MODBUS_RTU_MAX_FIFO_COUNT, .callback = ModbusRTU_TestOnFifo,
+			.context = &wrongTally };
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+	uint32_t txFrames = 0;
+	uint32_t ms = 0;
+	uint8_t count = 0;
+
+	printf("fifo scenario\n");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	modbusRTUStartReceiveToIdle(&master);
+	modbusRTUSlaveInit(&engine, &slave);
+	engine.fifos = &fifo;
+	engine.fifoCount = 1;
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+	modbusRTUSchedulerInit(&scheduler, &master);
+
+	/* a full FIFO drains in one transaction, the 32nd sample is refused */
+	for (uint8_t i = 0; i <= MODBUS_RTU_MAX_FIFO_COUNT; i++) {
+		if (true == modbusRTUSlaveFifoPush(&fifo, ModbusRTU_TestFifoPushed)) {
+			ModbusRTU_TestFifoPushed++;
+		}
+	}
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_MAX_FIFO_COUNT == ModbusRTU_TestFifoPushed);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_MAX_FIFO_COUNT == modbusRTUSlaveFifoCount(&fifo));
+	MODBUS_RTU_TEST_CHECK(1 == fifo.overruns);
+	txFrames = masterPort.stats.txFrames;
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &drain));
+	ms = ModbusRTU_TestRunFifo(&scheduler, &fifo, ms, 100 * scale, 0);
+	MODBUS_RTU_TEST_CHECK(1 == masterPort.stats.txFrames - txFrames);
+	MODBUS_RTU_TEST_CHECK(1 == tally.answers);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_MAX_FIFO_COUNT == ModbusRTU_TestFifoNext);
+	MODBUS_RTU_TEST_CHECK(0 == modbusRTUSlaveFifoCount(&fifo));
+
+	/* a poll every 10 samples keeps up with the producer */
+	drain.periodMs = 10 * scale;
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &drain));
+	ms = ModbusRTU_TestRunFifo(&scheduler, &fifo, ms, 1000 * scale, scale);
+	modbusRTUSchedulerRemove(&scheduler, &drain);
+	ms = ModbusRTU_TestRunFifo(&scheduler, &fifo, ms, 100 * scale, 0);
+	MODBUS_RTU_TEST_CHECK(ModbusRTU_TestFifoPushed
+			== ModbusRTU_TestFifoNext + modbusRTUSlaveFifoCount(&fifo));
+	MODBUS_RTU_TEST_CHECK(ModbusRTU_TestFifoPushed >= MODBUS_RTU_MAX_FIFO_COUNT + 1000);
+	MODBUS_RTU_TEST_CHECK(0 == ModbusRTU_TestFifoGaps);
+	MODBUS_RTU_TEST_CHECK(1 == fifo.overruns);
+	MODBUS_RTU_TEST_CHECK(tally.answers >= 1 + 1000 / 10 - 1);
+	MODBUS_RTU_TEST_CHECK(0 == tally.exceptions + tally.timeouts + tally.others);
+
+	/* an unknown FIFO pointer is an exception, nothing is drained */
+	count = modbusRTUSlaveFifoCount(&fifo);
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &wrong));
+	ms = ModbusRTU_TestRunFifo(&scheduler, &fifo, ms, 100 * scale, 0);
+	MODBUS_RTU_TEST_CHECK(count == modbusRTUSlaveFifoCount(&fifo));
+	MODBUS_RTU_TEST_CHECK(1 == wrongTally.exceptions);
+	MODBUS_RTU_TEST_CHECK(0 == wrongTally.answers + wrongTally.timeouts + wrongTally.others);
+	printf("fifo: samples=%u transactions=%lu\n",
+			(unsigned) ModbusRTU_TestFifoNext, (unsigned long) tally.answers);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestLowPower(uint32_t baudRate)
+ * @brief A low power slave muted through the frames of a busier one, sleep only with the timer stopped.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestLowPower(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, sleeperPort, busyPort;
+	static ModbusRTU_HandleT master, sleeper, busy;
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT sleeperEngine, busyEngine;
+	static ModbusRTU_TestTallyT sleeperTally, busyTally;
+	static ModbusRTU_RequestT requests[] = {
+			{ .slaveId = MODBUS_RTU_TEST_SLAVE_ID, .functionCode = 0x03, .address = 100, .quantity = 4, .periodMs = 50 },
+			{ .slaveId = MODBUS_RTU_TEST_SECOND_ID, .functionCode = 0x03, .address = 100, .quantity = 8, .periodMs = 10 } };
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+	uint32_t samples = 0;
+	uint32_t asleep = 0, busyAsleep = 0;
+	uint32_t timerRunning = 0;
+
+	printf("low power scenario\n");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&sleeperPort, 0, baudRate);
+	modbusRTUSimPortInit(&busyPort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUInit(&sleeper, &sleeperPort.huart, &sleeperPort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUInit(&busy, &busyPort.huart, &busyPort.htim,
+			MODBUS_RTU_TEST_SECOND_ID);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&sleeperPort, &sleeper);
+	modbusRTUSimPortAttach(&busyPort, &busy);
+	modbusRTUStartReceiveToIdle(&master);
+
+	/* both on the IT engine, only one mutes */
+	modbusRTUSlaveInit(&sleeperEngine, &sleeper);
+	sleeperEngine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	modbusRTUSlaveInit(&busyEngine, &busy);
+	busyEngine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	modbusRTUSetLowPower(&sleeper, true);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&sleeperEngine));
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&busyEngine));
+
+	modbusRTUSchedulerInit(&scheduler, &master);
+	requests[0].context = &sleeperTally;
+	requests[1].context = &busyTally;
+	for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+		requests[i].callback = ModbusRTU_TestOnResult;
+		requests[i].periodMs *= scale;
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &requests[i]));
+	}
+
+	/* main loop, the slaves are sampled every 100 us like a sleep decision */
+	for (uint64_t us = 0; us < (uint64_t) MODBUS_RTU_TEST_RUN_MS * scale * 1000;
+			us += 100) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((us + 100) * 1000u));
+		samples++;
+		if (true == modbusRTUIsSleepAllowed(&sleeper)) {
+			asleep++;
+			timerRunning += (0 != (sleeperPort.timRegisters.CR1 & TIM_CR1_CEN)) ? 1 : 0;
+		}
+		busyAsleep += (true == modbusRTUIsSleepAllowed(&busy)) ? 1 : 0;
+	}
+	for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+		modbusRTUSchedulerRemove(&scheduler, &requests[i]);
+	}
+	modbusRTUSimRun(modbusRTUSimNowNs() + 200u * scale * 1000000u);
+
+	/* every request answered, the foreign frames never reached the sleeper */
+	MODBUS_RTU_TEST_CHECK(sleeperTally.answers >= MODBUS_RTU_TEST_RUN_MS / 50 - 1);
+	MODBUS_RTU_TEST_CHECK(busyTally.answers >= MODBUS_RTU_TEST_RUN_MS / 10 - 1);
+	MODBUS_RTU_TEST_CHECK(0 == sleeperTally.exceptions + sleeperTally.timeouts
+			+ sleeperTally.others);
+	MODBUS_RTU_TEST_CHECK(0 == busyTally.exceptions + busyTally.timeouts
+			+ busyTally.others);
+	MODBUS_RTU_TEST_CHECK(0 == busyPort.stats.rxMuted);
+	MODBUS_RTU_TEST_CHECK(sleeperPort.stats.rxMuted > 0);
+	MODBUS_RTU_TEST_CHECK(
+			sleeperPort.stats.rxBytes + sleeperPort.stats.rxMuted
+					== busyPort.stats.rxBytes - sleeperPort.stats.txBytes
+							+ busyPort.stats.txBytes);
+	MODBUS_RTU_TEST_CHECK(3 * sleeperPort.stats.rxBytes < busyPort.stats.rxBytes);
+
+	/* STOP only with the timer stopped, and for most of the time */
+	MODBUS_RTU_TEST_CHECK(0 == timerRunning);
+	MODBUS_RTU_TEST_CHECK(asleep > busyAsleep);
+	MODBUS_RTU_TEST_CHECK(5 * asleep >= 4 * samples); /* awake for its own polls */
+	printf("low power: rx=%lu muted=%lu (neighbour rx=%lu) asleep=%lu%% (neighbour %lu%%)\n",
+			(unsigned long) sleeperPort.stats.rxBytes,
+			(unsigned long) sleeperPort.stats.rxMuted,
+			(unsigned long) busyPort.stats.rxBytes,
+			(unsigned long) (100u * asleep / samples),
+			(unsigned long) (100u * busyAsleep / samples));
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnUrgent(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Urgent write callback, keeps the longest latency, then tallies.
+ */
+static void ModbusRTU_TestOnUrgent(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	uint64_t latencyNs = modbusRTUSimNowNs() - ModbusRTU_TestUrgentNs;
+
+	if (latencyNs > ModbusRTU_TestUrgentMaxNs) {
+		ModbusRTU_TestUrgentMaxNs = latencyNs;
+	}
+	ModbusRTU_TestIsUrgentQueued = false;
+	ModbusRTU_TestOnResult(request, result, data, dataSize);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestPriority(uint32_t baudRate)
+ * @brief Starvation of a background poll with and without starveMs, urgent write latency, a late request.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestPriority(uint32_t baudRate) {
+
+	/* local variable */
+	static const uint16_t value = 0x5A5A;
+	static ModbusRTU_SimPortT masterPort, slavePort;
+	static ModbusRTU_HandleT master, slave;
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engine;
+	static ModbusRTU_TestTallyT pollTally, backgroundTally, urgentTally,
+			lateTally;
+	static ModbusRTU_RequestT polls[4];
+	static ModbusRTU_RequestT background = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x03, .address = 116, .quantity = 4, .periodMs = 100,
+			.priority = MODBUS_RTU_PRIORITY_BACKGROUND,
+			.callback = ModbusRTU_TestOnResult, .context = &backgroundTally };
+	static ModbusRTU_RequestT urgent = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x06, .address = 120, .quantity = 1, .values = &value,
+			.priority = MODBUS_RTU_PRIORITY_URGENT, .deadlineMs = 50,
+			.callback = ModbusRTU_TestOnUrgent, .context = &urgentTally };
+	static ModbusRTU_RequestT stale = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x03, .address = 100, .quantity = 16, .deadlineMs = 1,
+			.priority = MODBUS_RTU_PRIORITY_URGENT,
+			.callback = ModbusRTU_TestOnResult, .context = &lateTally };
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+	uint64_t charNs = modbusRTUSimCharNs(baudRate);
+	uint64_t t35Ns = 0;
+	uint64_t boundNs = 0;
+	uint32_t ms = 0;
+
+	printf("priority scenario\n");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	modbusRTUStartReceiveToIdle(&master);
+	modbusRTUSlaveInit(&engine, &slave);
+	engine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+	t35Ns = (uint64_t) master.t35Ticks * (1000000000u / MODBUS_RTU_TIMER_TICK_HZ);
+
+	/* a poll list that is always due keeps the bus busy */
+	modbusRTUSchedulerInit(&scheduler, &master);
+	scheduler.isCoalescing = false;
+	scheduler.starveMs = 0;
+	for (size_t i = 0; i < sizeof(polls) / sizeof(polls[0]); i++) {
+		polls[i] = (ModbusRTU_RequestT) { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+				.functionCode = 0x03, .address = 100, .quantity = 16,
+				.periodMs = 1, .priority = MODBUS_RTU_PRIORITY_NORMAL,
+				.callback = ModbusRTU_TestOnResult, .context = &pollTally };
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &polls[i]));
+	}
+	background.periodMs *= scale;
+	urgent.deadlineMs *= scale;
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &background));
+
+	/* strict priority: without starveMs the background poll never gets the bus */
+	for (; ms < 200 * scale; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+	MODBUS_RTU_TEST_CHECK(0 == backgroundTally.answers);
+
+	/* bounded starvation, an urgent write every 37 ms */
+	scheduler.starveMs = 50 * scale;
+	for (; ms < 1200 * scale; ms++) {
+		if ((0 == ms % (37 * scale)) && (false == ModbusRTU_TestIsUrgentQueued)) {
+			ModbusRTU_TestIsUrgentQueued = true;
+			ModbusRTU_TestUrgentNs = modbusRTUSimNowNs();
+			MODBUS_RTU_TEST_CHECK(
+					MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &urgent));
+		}
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+
+	/* a result that cannot come in time is late, not stale */
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &stale));
+	for (uint32_t end = ms + 10 * scale; ms < end; ms++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+	}
+	for (size_t i = 0; i < sizeof(polls) / sizeof(polls[0]); i++) {
+		modbusRTUSchedulerRemove(&scheduler, &polls[i]);
+	}
+	modbusRTUSchedulerRemove(&scheduler, &background);
+	modbusRTUSimRun(modbusRTUSimNowNs() + 100u * scale * 1000000u);
+
+	/* the poll on the bus, t3.5, then the write: not the length of the list */
+	boundNs = (MODBUS_RTU_FRAME_SIZE(4) + MODBUS_RTU_FRAME_SIZE(33)) * charNs
+			+ 2 * t35Ns + 2 * MODBUS_RTU_FRAME_SIZE(4) * charNs + 2 * t35Ns
+			+ 1000000u;
+	MODBUS_RTU_TEST_CHECK(urgentTally.answers >= 1000 / 37 - 1);
+	MODBUS_RTU_TEST_CHECK(0 == urgentTally.exceptions + urgentTally.timeouts
+			+ urgentTally.late + urgentTally.others);
+	MODBUS_RTU_TEST_CHECK(ModbusRTU_TestUrgentMaxNs <= boundNs);
+	MODBUS_RTU_TEST_CHECK(0x5A5A == ModbusRTU_TestHoldingB[4]);
+	MODBUS_RTU_TEST_CHECK(backgroundTally.answers >= 1000 / (100 + 50) - 1);
+	MODBUS_RTU_TEST_CHECK(0 == backgroundTally.exceptions
+			+ backgroundTally.timeouts + backgroundTally.late
+			+ backgroundTally.others);
+	MODBUS_RTU_TEST_CHECK(pollTally.answers > 0);
+	MODBUS_RTU_TEST_CHECK(1 == lateTally.late);
+	MODBUS_RTU_TEST_CHECK(0 == lateTally.answers + lateTally.others);
+	printf("priority: urgent=%lu max_latency_us=%lu (bound %lu) background=%lu polls=%lu\n",
+			(unsigned long) urgentTally.answers,
+			(unsigned long) (ModbusRTU_TestUrgentMaxNs / 1000u),
+			(unsigned long) (boundNs / 1000u),
+			(unsigned long) backgroundTally.answers,
+			(unsigned long) pollTally.answers);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOnSlice(ModbusRTU_RequestT *request, ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize)
+ * @brief Scheduler callback of the coalescing scenario, keeps what the member was given.
+ */
+static void ModbusRTU_TestOnSlice(ModbusRTU_RequestT *request,
+		ModbusRTU_ErrorT result, const uint8_t *data, size_t dataSize) {
+
+	/* local variable */
+	ModbusRTU_TestSliceT *slice = (ModbusRTU_TestSliceT*) request->context;
+
+	slice->calls++;
+	slice->result = result;
+	slice->dataSize = dataSize;
+	memset(slice->data, 0, sizeof(slice->data));
+	if (NULL != data) {
+		memcpy(slice->data, data,
+				(dataSize < sizeof(slice->data)) ? dataSize : sizeof(slice->data));
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestCoalesce(uint32_t baudRate)
+ * @brief Neighbouring reads share one transaction, each member gets its own registers,
+ *        reads are bounded by what the handle receives.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestCoalesce(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePort;
+	static ModbusRTU_HandleT master, slave;
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engine;
+	static ModbusRTU_TestSliceT slices[3];
+	static ModbusRTU_RequestT reads[3];
+	/* address and quantity of the reads of every case, 0 = unused */
+	static const struct {
+		uint16_t address[3];
+		uint16_t quantity[3];
+		uint32_t transactions;
+	} cases[] = {
+		/* overlapping, adjacent and 2 registers apart: one read of 100..112 */
+		{ { 100, 103, 110 }, { 4, 4, 3 }, 1 },
+		/* 9 registers apart, over coalesceGap */
+		{ { 100, 111, 0 }, { 2, 2, 0 }, 2 },
+		/* adjacent, but 130 registers together */
+		{ { 10, 110, 0 }, { 100, 30, 0 }, 2 },
+		/* 0x9C44 is not mapped: the exception goes to both */
+		{ { 0x9C40, 0x9C44, 0 }, { 4, 2, 0 }, 1 },
+		/* adjacent, the longest read a handle receives: one read */
+		{ { MODBUS_RTU_TEST_WIDE_ADDRESS, MODBUS_RTU_TEST_WIDE_ADDRESS + 100, 0 },
+				{ 100, MODBUS_RTU_HANDLE_MAX_READ_REGISTERS - 100, 0 }, 1 },
+		/* adjacent, one register more than that: two reads */
+		{ { MODBUS_RTU_TEST_WIDE_ADDRESS, MODBUS_RTU_TEST_WIDE_ADDRESS + 99, 0 },
+				{ 99, MODBUS_RTU_HANDLE_MAX_READ_REGISTERS + 1 - 99, 0 }, 2 } };
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+	uint32_t txFrames = 0;
+	uint32_t ms = 0;
+	uint16_t value = 0;
+
+	printf("coalesce scenario\n");
+
+	for (uint8_t i = 0; i < 16; i++) {
+		ModbusRTU_TestHolding[i] = (uint16_t) (0x1100 + i);
+	}
+	for (uint8_t i = 0; i <= MODBUS_RTU_HANDLE_MAX_READ_REGISTERS; i++) {
+		ModbusRTU_TestWide[i] = (uint16_t) (0x2000 + i);
+	}
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	modbusRTUStartReceiveToIdle(&master);
+	modbusRTUSlaveInit(&engine, &slave);
+	engine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+	modbusRTUSchedulerInit(&scheduler, &master);
+	MODBUS_RTU_TEST_CHECK(true == scheduler.isCoalescing);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SCHEDULER_COALESCE_GAP == scheduler.coalesceGap);
+
+	for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+		/* every read is due at once, before the first process call */
+		memset(slices, 0, sizeof(slices));
+		for (uint8_t i = 0; (i < 3) && (0 != cases[c].quantity[i]); i++) {
+			reads[i] = (ModbusRTU_RequestT) { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+					.functionCode = MODBUS_FUNC_READ_HOLDING_REGISTERS,
+					.address = cases[c].address[i], .quantity =
+							cases[c].quantity[i], .callback =
+							ModbusRTU_TestOnSlice, .context = &slices[i] };
+			MODBUS_RTU_TEST_CHECK(
+					MODBUS_RTU_SUCCESS
+							== modbusRTUSchedulerAdd(&scheduler, &reads[i]));
+		}
+		txFrames = masterPort.stats.txFrames;
+		for (uint32_t end = ms + 100 * scale; ms < end; ms++) {
+			do {
+				modbusRTUSchedulerProcess(&scheduler);
+			} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+		}
+		MODBUS_RTU_TEST_CHECK(
+				cases[c].transactions == masterPort.stats.txFrames - txFrames);
+
+		for (uint8_t i = 0; (i < 3) && (0 != cases[c].quantity[i]); i++) {
+			MODBUS_RTU_TEST_CHECK(1 == slices[i].calls);
+			if (0 == c) {
+				/* its own registers only, from its own start */
+				MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == slices[i].result);
+				MODBUS_RTU_TEST_CHECK(2u * cases[c].quantity[i] == slices[i].dataSize);
+				for (uint16_t r = 0; r < cases[c].quantity[i]; r++) {
+					value = ModbusRTU_TestHolding[cases[c].address[i] - 100 + r];
+					MODBUS_RTU_TEST_CHECK(
+							value == modbusRTUGetU16(&slices[i].data[2 * r]));
+				}
+			} else if (1 == c) {
+				MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == slices[i].result);
+				MODBUS_RTU_TEST_CHECK(4 == slices[i].dataSize);
+			} else if (c >= 4) {
+				/* the wide registers, each read from its own start */
+				MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == slices[i].result);
+				MODBUS_RTU_TEST_CHECK(2u * cases[c].quantity[i] == slices[i].dataSize);
+				MODBUS_RTU_TEST_CHECK(
+						0x2000 + cases[c].address[i] - MODBUS_RTU_TEST_WIDE_ADDRESS
+								== modbusRTUGetU16(&slices[i].data[0]));
+			} else {
+				/* 10..109 and 0x9C44 are not mapped: exceptions */
+				MODBUS_RTU_TEST_CHECK(MODBUS_RTU_ERROR_EXCEPTION == slices[i].result);
+				MODBUS_RTU_TEST_CHECK(
+						MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS == slices[i].data[0]);
+			}
+		}
+	}
+
+	/* one read at the handle limit is answered, one register more does not
+	 * fit rxPacket and fails at once, without a frame on the bus */
+	for (uint16_t quantity = MODBUS_RTU_HANDLE_MAX_READ_REGISTERS;
+			quantity <= MODBUS_RTU_HANDLE_MAX_READ_REGISTERS + 1; quantity++) {
+		memset(slices, 0, sizeof(slices));
+		reads[0] = (ModbusRTU_RequestT) { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+				.functionCode = MODBUS_FUNC_READ_HOLDING_REGISTERS,
+				.address = MODBUS_RTU_TEST_WIDE_ADDRESS, .quantity = quantity,
+				.callback = ModbusRTU_TestOnSlice, .context = &slices[0] };
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &reads[0]));
+		txFrames = masterPort.stats.txFrames;
+		for (uint32_t end = ms + 100 * scale; ms < end; ms++) {
+			do {
+				modbusRTUSchedulerProcess(&scheduler);
+			} while (true == modbusRTUSimStep((uint64_t) (ms + 1) * 1000000u));
+		}
+		MODBUS_RTU_TEST_CHECK(1 == slices[0].calls);
+		MODBUS_RTU_TEST_CHECK(NULL == scheduler.active);
+		if (MODBUS_RTU_HANDLE_MAX_READ_REGISTERS == quantity) {
+			MODBUS_RTU_TEST_CHECK(1 == masterPort.stats.txFrames - txFrames);
+			MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == slices[0].result);
+			MODBUS_RTU_TEST_CHECK(2u * quantity == slices[0].dataSize);
+			MODBUS_RTU_TEST_CHECK(0x2000 == modbusRTUGetU16(&slices[0].data[0]));
+		} else {
+			MODBUS_RTU_TEST_CHECK(0 == masterPort.stats.txFrames - txFrames);
+			MODBUS_RTU_TEST_CHECK(MODBUS_RTU_ERROR_INVALID_FRAME == slices[0].result);
+		}
+	}
+	MODBUS_RTU_TEST_CHECK(0 == scheduler.requestCount);
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestReadLimit(uint32_t baudRate)
+ * @brief The slave engine answers reads up to the handle limit, longer ones with an exception.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestReadLimit(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePort;
+	static ModbusRTU_HandleT master, slave;
+	static ModbusRTU_SlaveT engine;
+	static const struct {
+		uint8_t functionCode;
+		uint16_t quantity;
+		uint8_t exception; /* MODBUS_EXCEPTION_NONE: answered */
+	} cases[] = {
+		{ MODBUS_FUNC_READ_HOLDING_REGISTERS, MODBUS_RTU_HANDLE_MAX_READ_REGISTERS, MODBUS_EXCEPTION_NONE },
+		{ MODBUS_FUNC_READ_HOLDING_REGISTERS, MODBUS_RTU_MAX_READ_REGISTERS, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE },
+		{ MODBUS_FUNC_READ_COILS, MODBUS_RTU_HANDLE_MAX_READ_BITS + 1, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE },
+		{ MODBUS_FUNC_READ_WRITE_MULTY_REGISTER, MODBUS_RTU_MAX_READ_REGISTERS, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE } };
+	uint32_t scale = (baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1;
+	uint8_t request[MODBUS_RTU_READ_WRITE_REQUEST_SIZE(1)] = { 0 };
+	uint8_t response[MODBUS_RTU_MAX_DATA_SIZE] = { 0 };
+	uint16_t value = 0;
+	size_t requestSize = 0, responseSize = 0;
+	uint64_t nowNs = 0;
+
+	printf("read limit scenario\n");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	modbusRTUSlaveInit(&engine, &slave);
+	engine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	engine.coils = (ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestCoilMap);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+
+	for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+		if (MODBUS_FUNC_READ_WRITE_MULTY_REGISTER == cases[c].functionCode) {
+			requestSize = modbusRTUFrameReadWriteRegisters(request,
+					MODBUS_RTU_TEST_WIDE_ADDRESS, cases[c].quantity, 100, 1,
+					&value);
+		} else {
+			requestSize = modbusRTUFrameRead(request,
+					MODBUS_RTU_TEST_WIDE_ADDRESS, cases[c].quantity);
+		}
+		responseSize = (MODBUS_EXCEPTION_NONE == cases[c].exception) ?
+				MODBUS_RTU_READ_REGISTERS_RESPONSE_SIZE(cases[c].quantity) :
+				MODBUS_RTU_EXCEPTION_RESPONSE_SIZE;
+		memset(response, 0, sizeof(response));
+		modbusRTUReciveData(&master, responseSize);
+		modbusRTUSendData(&master, cases[c].functionCode, request, requestSize);
+		modbusRTUSimRun(nowNs += 50000000u * scale);
+		if (MODBUS_EXCEPTION_NONE == cases[c].exception) {
+			MODBUS_RTU_TEST_CHECK(
+					MODBUS_RTU_SUCCESS
+							== modbusRTUCheckRxState(&master, response, responseSize));
+			MODBUS_RTU_TEST_CHECK(2 * cases[c].quantity == response[0]);
+			MODBUS_RTU_TEST_CHECK(0x2000 == modbusRTUGetU16(&response[1]));
+		} else {
+			MODBUS_RTU_TEST_CHECK(
+					MODBUS_RTU_ERROR_EXCEPTION
+							== modbusRTUCheckRxState(&master, response, responseSize));
+			MODBUS_RTU_TEST_CHECK(cases[c].exception == response[0]);
+		}
+	}
+}
+
+/*!
+ * @fn    static void ModbusRTU_TestOversize(bool isDma, uint32_t baudRate)
+ * @brief A frame longer than rxPacket is dropped, the handle receives the next one.
+ *
+ * @param isDma true: circular DMA + IDLE line engine, false: interrupt engine.
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestOversize(bool isDma, uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT slavePort;
+	static ModbusRTU_HandleT slave;
+	static uint8_t burst[MODBUS_RTU_MAX_FRAME_SIZE + 44];
+	uint8_t request[8] = { MODBUS_RTU_TEST_SLAVE_ID, 0x03, 0x00, 0x64, 0x00, 0x02 };
+	uint16_t crc = modbusRTUCalculateCRC(request, 6);
+	ModbusRTU_FrameViewT frame = { 0 };
+#ifdef MODBUS_RTU_ENABLE_STATS
+	ModbusRTU_StatsT stats;
+#endif
+
+	printf("oversize scenario (%s)\n", (true == isDma) ? "dma" : "it");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	if (true == isDma) {
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUStartReceiveToIdle(&slave));
+	} else {
+		MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUListen(&slave));
+	}
+
+	/* every length past rxPacket up to past the DMA ring, addressed to the slave */
+	memset(burst, 0x55, sizeof(burst));
+	burst[0] = MODBUS_RTU_TEST_SLAVE_ID;
+	for (size_t length = MODBUS_RTU_MAX_RX_SIZE + 1; length <= sizeof(burst);
+			length += (length < MODBUS_RTU_MAX_FRAME_SIZE + 1) ? 1 : 43) {
+		modbusRTUSimInject(&slavePort, burst, length, 0);
+		modbusRTUSimRun(modbusRTUSimNowNs()
+				+ length * modbusRTUSimCharNs(baudRate) + 5000000u); /* + t3.5 */
+		MODBUS_RTU_TEST_CHECK(&slave.rxPacket == slave.rxFrame);
+		MODBUS_RTU_TEST_CHECK(false == modbusRTUIsRxFrameReady(&slave));
+		MODBUS_RTU_TEST_CHECK(0 == slave.rxLength);
+	}
+
+	/* the handle still takes a regular request */
+	request[6] = crc & 0xFF;
+	request[7] = (crc >> 8) & 0xFF;
+	modbusRTUSimInject(&slavePort, request, sizeof(request), 0);
+	modbusRTUSimRun(modbusRTUSimNowNs()
+			+ sizeof(request) * modbusRTUSimCharNs(baudRate) + 5000000u);
+	MODBUS_RTU_TEST_CHECK(true == modbusRTUIsRxFrameReady(&slave));
+	MODBUS_RTU_TEST_CHECK(
+			MODBUS_RTU_SUCCESS == modbusRTUGetRxFrame(&slave, &frame));
+	MODBUS_RTU_TEST_CHECK(0x03 == frame.functionCode);
+	MODBUS_RTU_TEST_CHECK(4 == frame.dataSize);
+	modbusRTUReleaseRxFrame(&slave);
+#ifdef MODBUS_RTU_ENABLE_STATS
+	modbusRTUGetStats(&slave, &stats);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_MAX_FRAME_SIZE - MODBUS_RTU_MAX_RX_SIZE + 2
+			== stats.rxOverruns);
+#endif
+}
+
+#ifdef MODBUS_RTU_USE_CACHE
+/*!
+ * @fn    static void ModbusRTU_TestCache(uint32_t baudRate)
+ * @brief Reads answered by one transaction, from the cache, after writes and expiry.
+ *
+ * @param baudRate Baud rate of the bus.
+ */
+static void ModbusRTU_TestCache(uint32_t baudRate) {
+
+	/* local variable */
+	static ModbusRTU_SimPortT masterPort, slavePort;
+	static ModbusRTU_HandleT master, slave;
+	static ModbusRTU_SchedulerT scheduler;
+	static ModbusRTU_SlaveT engine;
+	static ModbusRTU_CacheT cache;
+	static const ModbusRTU_CacheTtlT ttls[] = {
+			{ .functionCode = MODBUS_FUNC_READ_HOLDING_REGISTERS, .address = 100, .quantity = 4, .ttlMs = 0 } };
+	static const uint16_t value = 0x4242;
+	static const uint8_t on = 1;
+	static ModbusRTU_RequestT identity = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x03, .address = 0x9C40, .quantity = 4 };
+	static ModbusRTU_RequestT requests[] = {
+			{ .slaveId = MODBUS_RTU_TEST_SLAVE_ID, .functionCode = 0x03, .address = 0x9C40, .quantity = 4 },
+			{ .slaveId = MODBUS_RTU_TEST_SLAVE_ID, .functionCode = 0x03, .address = 0x9C40, .quantity = 4 },
+			{ .slaveId = MODBUS_RTU_TEST_SLAVE_ID, .functionCode = 0x03, .address = 0x9C41, .quantity = 2 } };
+	static ModbusRTU_RequestT readHolding = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x03, .address = 104, .quantity = 4 };
+	static ModbusRTU_RequestT writeHolding = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x06, .address = 105, .quantity = 1, .values = &value };
+	static ModbusRTU_RequestT readShort = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x03, .address = 100, .quantity = 2 };
+	static ModbusRTU_RequestT readCoils = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x01, .address = 0, .quantity = 8 };
+	static ModbusRTU_RequestT writeCoil = { .slaveId = MODBUS_RTU_TEST_SLAVE_ID,
+			.functionCode = 0x05, .address = 3, .values = &on };
+	static ModbusRTU_TestTallyT tally;
+	/* one slot of the scenario, long enough for a transaction at any test rate */
+	uint32_t stepMs = 20 * ((baudRate < MODBUS_RTU_TEST_BAUD_RATE) ?
+			(MODBUS_RTU_TEST_BAUD_RATE + baudRate - 1) / baudRate : 1);
+	uint32_t nowMs = 0;
+	/* each step: queue a request, run a slot, count the slave answers */
+	struct {
+		ModbusRTU_RequestT *request;
+		uint32_t frames; /*! slave answers so far */
+	} steps[] = {
+			{ &identity, 1 }, /* the three above ran as one, this one is a hit */
+			{ &readHolding, 2 },
+			{ &writeHolding, 3 },
+			{ &readHolding, 4 }, /* the write dropped 105 */
+			{ &readShort, 5 },
+			{ &readShort, 6 }, /* TTL 0 */
+			{ &readCoils, 7 },
+			{ &readCoils, 7 },
+			{ &writeCoil, 8 },
+			{ &readCoils, 9 } };
+
+	printf("cache scenario\n");
+
+	modbusRTUSimReset();
+	modbusRTUSimPortInit(&masterPort, 0, baudRate);
+	modbusRTUSimPortInit(&slavePort, 0, baudRate);
+	modbusRTUInit(&master, &masterPort.huart, &masterPort.htim, 0);
+	modbusRTUInit(&slave, &slavePort.huart, &slavePort.htim,
+			MODBUS_RTU_TEST_SLAVE_ID);
+	modbusRTUSimPortAttach(&masterPort, &master);
+	modbusRTUSimPortAttach(&slavePort, &slave);
+	modbusRTUStartReceiveToIdle(&master);
+	modbusRTUSlaveInit(&engine, &slave);
+	engine.holdingRegisters =
+			(ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestHoldingMap);
+	engine.coils = (ModbusRTU_SlaveMapT) MODBUS_RTU_SLAVE_MAP(ModbusRTU_TestCoilMap);
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSlaveStart(&engine));
+
+	modbusRTUSchedulerInit(&scheduler, &master);
+	scheduler.isCoalescing = false; /* only the cache may save transactions */
+	modbusRTUCacheInit(&cache, 5 * stepMs / 2);
+	modbusRTUCacheSetTtls(&cache, MODBUS_RTU_CACHE_TTLS(ttls));
+	modbusRTUSchedulerSetCache(&scheduler, &cache);
+	memset(&tally, 0, sizeof(tally));
+
+	/* three reads of one range at once: one transaction */
+	for (uint8_t i = 0; i < 3; i++) {
+		requests[i].callback = ModbusRTU_TestOnResult;
+		requests[i].context = &tally;
+		MODBUS_RTU_TEST_CHECK(
+				MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &requests[i]));
+	}
+	for (uint8_t i = 0; i <= sizeof(steps) / sizeof(steps[0]); i++) {
+		for (uint32_t ms = 0; ms < stepMs; ms++, nowMs++) {
+			do {
+				modbusRTUSchedulerProcess(&scheduler);
+			} while (true == modbusRTUSimStep((uint64_t) (nowMs + 1) * 1000000u));
+		}
+		if (0 == i) {
+			MODBUS_RTU_TEST_CHECK(3 == tally.answers);
+			MODBUS_RTU_TEST_CHECK(1 == slavePort.stats.txFrames);
+			MODBUS_RTU_TEST_CHECK(0xBB == ModbusRTU_TestLastData[0]); /* 0x9C41 */
+		} else {
+			MODBUS_RTU_TEST_CHECK(steps[i - 1].frames == slavePort.stats.txFrames);
+			MODBUS_RTU_TEST_CHECK(3u + i == tally.answers);
+		}
+		if (i < sizeof(steps) / sizeof(steps[0])) {
+			steps[i].request->callback = ModbusRTU_TestOnResult;
+			steps[i].request->context = &tally;
+			MODBUS_RTU_TEST_CHECK(
+					MODBUS_RTU_SUCCESS
+							== modbusRTUSchedulerAdd(&scheduler, steps[i].request));
+		}
+		if (1 == i) {
+			MODBUS_RTU_TEST_CHECK(0xAA == ModbusRTU_TestLastData[0]); /* cached 0x9C40 */
+		} else if (4 == i) {
+			MODBUS_RTU_TEST_CHECK(0x4242 == modbusRTUGetU16(&ModbusRTU_TestLastData[2]));
+		}
+	}
+	MODBUS_RTU_TEST_CHECK(0x08 == (ModbusRTU_TestLastData[0] & 0x08)); /* coil 3 read back */
+
+	/* past the TTL the values go to the bus again */
+	MODBUS_RTU_TEST_CHECK(MODBUS_RTU_SUCCESS == modbusRTUSchedulerAdd(&scheduler, &identity));
+	for (uint32_t ms = 0; ms < stepMs; ms++, nowMs++) {
+		do {
+			modbusRTUSchedulerProcess(&scheduler);
+		} while (true == modbusRTUSimStep((uint64_t) (nowMs + 1) * 1000000u));
+	}
+	MODBUS_RTU_TEST_CHECK(10 == slavePort.stats.txFrames);
+	MODBUS_RTU_TEST_CHECK(4 == cache.hits);
+}
+#endif
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/
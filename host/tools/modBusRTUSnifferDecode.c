@@ -0,0 +1,151 @@
+/**
+ ******************************************************************************
+ * @file           : modBusRTUSnifferDecode.c
+ * @author         : keyhanSalehi
+ * @brief          : modBus RTU capture decoder.
+ ******************************************************************************
+ *
+ * This file prints a capture of modBusRTUSniffer.h, one frame per line:
+ * time since the start and since the previous frame in seconds, the check
+ * of the frame and its bytes. Records dropped on a full capture ring are
+ * marked on the frame that follows them, a summary ends the listing.
+ *
+ *      0.000763   0.000763  ok         01 03 00 64 00 02 85 D4
+ *      0.003372   0.002609  ok         01 03 04 00 01 00 02 2A 32
+ *      0.350763   0.008254  crc        01 03 00 64 00 02 00 00
+ *
+ * usage: modBusRTUSnifferDecode [capture]   (stdin without a file)
+ *
+ * The exit code is 1 when the input is not a capture or ends inside a
+ * record.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+/* 1. System Header Files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/* 2. Project Header Files */
+#include "modBusRTU.h"
+#include "modBusRTUSniffer.h"
+
+/* Defines & Macros ----------------------------------------------------------*/
+
+/*!
+ * @defgroup
+ * @brief Constants and macros available globally.
+ */
+/*! @def Bytes read from the input at a time */
+#define MODBUS_RTU_DECODE_CHUNK 4096
+
+/* Variables -----------------------------------------------------------------*/
+
+/*! @var Names of the frame checks, by ModbusRTU_ErrorT */
+static const char *const ModbusRTU_DecodeResults[] = { "ok", "crc", "timeout",
+		"tx-failed", "slave-id", "invalid", "busy", "exception", "rx-failed",
+		"tx-busy", "queue-full", "os", "no-buffer", "offline", "late" };
+
+/* Function Declarations -----------------------------------------------------*/
+
+/* 1. Local Prototype Functions */
+
+/*! @fn @private */
+static void ModbusRTU_DecodePrint(const ModbusRTU_SnifferRecordT *record);
+
+/* 2. Global Function Declarations */
+
+/*!
+ * @fn    int main(int argc, char **argv)
+ * @brief Print every frame of a capture.
+ *
+ * @param argc Number of arguments.
+ * @param argv [capture].
+ * @return 0 on a complete capture.
+ */
+int main(int argc, char **argv) {
+
+	/* local variable */
+	FILE *input = stdin;
+	uint8_t buffer[2 * MODBUS_RTU_DECODE_CHUNK];
+	ModbusRTU_SnifferDecoderT decoder = { 0 };
+	ModbusRTU_SnifferRecordT record = { 0 };
+	ModbusRTU_ErrorT result = MODBUS_RTU_RX_BUSY;
+	size_t size = 0;
+	size_t used = 0;
+	size_t count = 0;
+	unsigned long frames = 0, invalid = 0, losses = 0;
+
+	if ((argc > 1) && (NULL == (input = fopen(argv[1], "rb")))) {
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	do {
+		count = fread(buffer + size, 1, sizeof(buffer) - size, input);
+		size += count;
+
+		/* every complete record, the rest waits for the next read */
+		used = 0;
+		while (MODBUS_RTU_SUCCESS
+				== (result = modbusRTUSnifferDecode(&decoder, buffer + used,
+						size - used, &record, &count))) {
+			frames++;
+			invalid += ((MODBUS_RTU_SUCCESS != record.result)
+					&& (MODBUS_RTU_ERROR_EXCEPTION != record.result)) ? 1 : 0;
+			losses += (true == record.isLost) ? 1 : 0;
+			ModbusRTU_DecodePrint(&record);
+			used += count;
+		}
+		used += count; /* a header without a record yet */
+		memmove(buffer, buffer + used, size - used);
+		size -= used;
+	} while ((MODBUS_RTU_RX_BUSY == result) && (0 == feof(input))
+			&& (0 == ferror(input)));
+
+	if (stdin != input) {
+		fclose(input);
+	}
+	printf("baud=%lu frames=%lu invalid=%lu losses=%lu\n",
+			(unsigned long) decoder.baudRate, frames, invalid, losses);
+
+	if (MODBUS_RTU_ERROR_INVALID_FRAME == result) {
+		fprintf(stderr, "not a modBus RTU capture\n");
+	} else if (0 != size) {
+		fprintf(stderr, "capture ends inside a record\n");
+	}
+
+	return ((MODBUS_RTU_RX_BUSY != result) || (0 != size)) ? 1 : 0;
+}
+
+/* 3. Local Function Declarations */
+
+/*!
+ * @fn    static void ModbusRTU_DecodePrint(const ModbusRTU_SnifferRecordT *record)
+ * @brief Print one frame.
+ *
+ * @param record The decoded record.
+ */
+static void ModbusRTU_DecodePrint(const ModbusRTU_SnifferRecordT *record) {
+
+	/* local variable */
+	const char *name = "?";
+
+	if ((size_t) record->result
+			< sizeof(ModbusRTU_DecodeResults) / sizeof(ModbusRTU_DecodeResults[0])) {
+		name = ModbusRTU_DecodeResults[record->result];
+	}
+	if (true == record->isLost) {
+		printf("-- frames lost --\n");
+	}
+	printf("%13.6f %10.6f  %-10s", record->timeUs / 1e6, record->deltaUs / 1e6,
+			name);
+	for (uint16_t i = 0; i < record->length; i++) {
+		printf(" %02X", record->frame[i]);
+	}
+	printf("\n");
+}
+
+/************************ (C) COPYRIGHT [KeyhanSalehi] *****END OF FILE****/